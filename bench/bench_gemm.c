@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "matrix.h"
+#include "gann_simd.h"
+#include "gann_threads.h"
+#include "gann_backend.h"
+
+// Benchmarks dot_product against the original naive kernel on the layer shapes of
+// the 784-128-64-10 MNIST network used in examples/training.c.
+//
+// It then measures how the 256x784 by 784x128 minibatch product scales with the
+// number of threads, from 1 up to max_threads (default: the library's default),
+// and compares one call of dot_product_batch_into with a loop of single products
+// for the first layer of a 50-network population evaluated on the same inputs.
+//
+// Usage: ./bench/bench_gemm [min_seconds_per_case] [max_threads]
+// Set GANN_GEMM_BACKEND=builtin or cblas to compare backends in a `make BLAS=1` build.
+
+typedef struct {
+    int k; // Inputs of the layer (rows of the weight matrix)
+    int n; // Outputs of the layer (cols of the weight matrix)
+} LayerShape;
+
+static const LayerShape SHAPES[] = { {784, 128}, {128, 64}, {64, 10} };
+static const int BATCH_ROWS[] = { 1, 32, 256 };
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// The i-k-j triple loop over row pointers that dot_product used originally.
+static Matrix* naive_dot_product(const Matrix* m1, const Matrix* m2) {
+    Matrix* result = create_matrix(m1->rows, m2->cols);
+    for (int i = 0; i < m1->rows; i++) {
+        for (int k = 0; k < m1->cols; k++) {
+            for (int j = 0; j < m2->cols; j++) {
+                result->data[i][j] += m1->data[i][k] * m2->data[k][j];
+            }
+        }
+    }
+    return result;
+}
+
+static void fill_random(Matrix* m) {
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            m->data[i][j] = (double)rand() / RAND_MAX - 0.5;
+        }
+    }
+}
+
+// Runs `kernel` until at least `min_seconds` have elapsed and returns GFLOPS.
+static double measure(Matrix* (*kernel)(const Matrix*, const Matrix*), const Matrix* a, const Matrix* b, double min_seconds) {
+    double flops_per_call = 2.0 * a->rows * a->cols * b->cols;
+    long iterations = 0;
+    double start = now_seconds();
+    double elapsed = 0.0;
+    do {
+        free_matrix(kernel(a, b));
+        iterations++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < min_seconds);
+    return flops_per_call * iterations / elapsed * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    double min_seconds = (argc > 1) ? atof(argv[1]) : 0.3;
+    int max_threads = (argc > 2) ? atoi(argv[2]) : gann_get_num_threads();
+    srand(1234);
+    gann_set_num_threads(1);
+    printf("kernels: %s, backend: %s\n", gann_simd_level_name(gann_simd_get_level()),
+           gann_gemm_backend_name(gann_gemm_get_backend()));
+
+    printf("%-14s %6s %12s %12s %8s %10s\n", "shape (KxN)", "M", "naive GF/s", "gemm GF/s", "speedup", "max |err|");
+    for (size_t s = 0; s < sizeof(SHAPES) / sizeof(SHAPES[0]); s++) {
+        for (size_t r = 0; r < sizeof(BATCH_ROWS) / sizeof(BATCH_ROWS[0]); r++) {
+            Matrix* a = create_matrix(BATCH_ROWS[r], SHAPES[s].k);
+            Matrix* b = create_matrix(SHAPES[s].k, SHAPES[s].n);
+            fill_random(a);
+            fill_random(b);
+
+            Matrix* expected = naive_dot_product(a, b);
+            Matrix* actual = dot_product(a, b);
+            double max_err = 0.0;
+            for (int i = 0; i < expected->rows; i++) {
+                for (int j = 0; j < expected->cols; j++) {
+                    double err = fabs(expected->data[i][j] - actual->data[i][j]);
+                    if (err > max_err) max_err = err;
+                }
+            }
+            free_matrix(expected);
+            free_matrix(actual);
+
+            double naive = measure(naive_dot_product, a, b, min_seconds);
+            double gemm = measure(dot_product, a, b, min_seconds);
+
+            char label[32];
+            snprintf(label, sizeof(label), "%dx%d", SHAPES[s].k, SHAPES[s].n);
+            printf("%-14s %6d %12.2f %12.2f %7.2fx %10.2e\n", label, BATCH_ROWS[r], naive, gemm, gemm / naive, max_err);
+
+            free_matrix(a);
+            free_matrix(b);
+        }
+    }
+
+    printf("\n%-8s %12s %8s\n", "threads", "gemm GF/s", "scaling");
+    Matrix* a = create_matrix(256, 784);
+    Matrix* b = create_matrix(784, 128);
+    fill_random(a);
+    fill_random(b);
+    double single = 0.0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        if (!gann_set_num_threads(threads)) break;
+        double gflops = measure(dot_product, a, b, min_seconds);
+        if (threads == 1) single = gflops;
+        printf("%-8d %12.2f %7.2fx\n", threads, gflops, gflops / single);
+    }
+    free_matrix(a);
+    free_matrix(b);
+
+    // One layer of a population: the same input batch times every network's weights.
+    enum { POPULATION = 50 };
+    printf("\n%d x 784x128 products, max threads %d\n", POPULATION, max_threads);
+    printf("%6s %12s %12s %8s\n", "M", "loop GF/s", "batch GF/s", "speedup");
+    Matrix* weights[POPULATION];
+    Matrix* outputs[POPULATION];
+    for (int t = 0; t < POPULATION; t++) {
+        weights[t] = create_matrix(784, 128);
+        fill_random(weights[t]);
+    }
+    for (size_t r = 0; r < sizeof(BATCH_ROWS) / sizeof(BATCH_ROWS[0]); r++) {
+        int rows = BATCH_ROWS[r];
+        Matrix* input = create_matrix(rows, 784);
+        fill_random(input);
+        MatrixView a_views[POPULATION], b_views[POPULATION];
+        for (int t = 0; t < POPULATION; t++) {
+            outputs[t] = create_matrix(rows, 128);
+            a_views[t] = matrix_view(input);
+            b_views[t] = matrix_view(weights[t]);
+        }
+        double flops = 2.0 * POPULATION * rows * 784 * 128;
+        double timing[2];
+        for (int batched = 0; batched < 2; batched++) {
+            long iterations = 0;
+            double start = now_seconds();
+            do {
+                if (batched) {
+                    dot_product_batch_into(POPULATION, outputs, a_views, b_views);
+                } else {
+                    for (int t = 0; t < POPULATION; t++) dot_product_view_into(outputs[t], a_views[t], b_views[t]);
+                }
+                iterations++;
+            } while (now_seconds() - start < min_seconds);
+            timing[batched] = flops * iterations / (now_seconds() - start) * 1e-9;
+        }
+        printf("%6d %12.2f %12.2f %7.2fx\n", rows, timing[0], timing[1], timing[1] / timing[0]);
+        for (int t = 0; t < POPULATION; t++) free_matrix(outputs[t]);
+        free_matrix(input);
+    }
+    for (int t = 0; t < POPULATION; t++) free_matrix(weights[t]);
+    return 0;
+}
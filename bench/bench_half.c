@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+#include "evolution.h"
+
+// Compares the weight storages on a 784-128-64-10 network: the parameter
+// memory a population of them occupies, and the time of a batch forward pass and of a
+// single-row one.
+//
+// Usage: ./bench/bench_half [population_size]
+
+static const char* const STORAGE_NAMES[] = { "native", "fp16", "bf16" };
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// The bytes of a network's parameter block: its gann_real values, plus the
+// 16-bit weights that follow them with 16-bit storage.
+static size_t parameter_bytes(const NeuralNetwork* net) {
+    size_t bytes = net->num_parameters * sizeof(gann_real);
+    if (net->weight_storage != NN_STORAGE_NATIVE) {
+        for (int i = 0; i < net->num_layers - 1; i++) {
+            bytes += (size_t)net->architecture[i] * net->architecture[i + 1] * sizeof(uint16_t);
+        }
+    }
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    int population_size = argc > 1 ? atoi(argv[1]) : 1000;
+    const int architecture[] = {784, 128, 64, 10};
+    printf("gann_real is %zu bytes; %d networks of 784-128-64-10\n", sizeof(gann_real), population_size);
+
+    for (int s = NN_STORAGE_NATIVE; s <= NN_STORAGE_BF16; s++) {
+        NeuralNetwork** population = evo_create_initial_population_with_storage(population_size, 4, architecture, RELU, SIGMOID,
+                                                                                (NNWeightStorage)s);
+        if (!population) {
+            fprintf(stderr, "Failed to create the population: %s\n", gann_error_to_string(gann_get_last_error()));
+            return 1;
+        }
+        size_t bytes = 0;
+        for (int i = 0; i < population_size; i++) {
+            bytes += parameter_bytes(population[i]);
+            nn_free(population[i]);
+        }
+        printf("%-7s population %8.1f MB\n", STORAGE_NAMES[s], (double)bytes / (1 << 20));
+        free(population);
+    }
+
+    gann_seed_rng(42);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    nn_init(net);
+    Matrix* batch = create_matrix(256, 784);
+    for (int i = 0; i < 256; i++) {
+        for (int j = 0; j < 784; j++) batch->data[i][j] = (gann_real)rand() / RAND_MAX;
+    }
+    Matrix* row = matrix_get_row(batch, 0);
+    for (int s = NN_STORAGE_NATIVE; s <= NN_STORAGE_BF16; s++) {
+        NeuralNetwork* copy = nn_clone(net);
+        if (!copy || !nn_set_weight_storage(copy, (NNWeightStorage)s)) {
+            fprintf(stderr, "Failed to convert the network: %s\n", gann_error_to_string(gann_get_last_error()));
+            return 1;
+        }
+        const int batch_runs = 50, row_runs = 2000;
+        double start = now_seconds();
+        for (int r = 0; r < batch_runs; r++) free_matrix(nn_forward_pass(copy, batch));
+        double batch_time = (now_seconds() - start) / batch_runs;
+        start = now_seconds();
+        for (int r = 0; r < row_runs; r++) free_matrix(nn_forward_pass(copy, row));
+        double row_time = (now_seconds() - start) / row_runs;
+        printf("%-7s forward 256 rows %8.1f us   1 row %7.2f us\n", STORAGE_NAMES[s], batch_time * 1e6, row_time * 1e6);
+        nn_free(copy);
+    }
+
+    free_matrix(row);
+    free_matrix(batch);
+    nn_free(net);
+    return 0;
+}
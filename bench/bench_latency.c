@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+
+// Per-call latency of single-sample prediction on the 784-128-64-10 MNIST
+// network: through nn_forward_pass (a new output matrix per call), through
+// gann_predict (scratch arena), and through a preallocated inference context.
+//
+// Usage: ./bench/bench_latency [calls]
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char* name, double* latencies, int calls) {
+    qsort(latencies, calls, sizeof(double), compare_doubles);
+    printf("%-18s %10.2f %10.2f\n", name, latencies[calls / 2] * 1e6, latencies[(int)(calls * 0.99)] * 1e6);
+}
+
+int main(int argc, char** argv) {
+    int calls = argc > 1 ? atoi(argv[1]) : 20000;
+    const int architecture[] = {784, 128, 64, 10};
+    gann_seed_rng(42);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    nn_init(net);
+    GannInferenceContext* ctx = gann_inference_context_create(net);
+    Matrix* inputs = create_matrix(64, 784);
+    double* latencies = (double*)malloc((size_t)calls * sizeof(double));
+    if (!ctx || !inputs || !latencies) {
+        fprintf(stderr, "Setup failed: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+    // MNIST-like rows: about a fifth of the pixels lit
+    for (int i = 0; i < 64; i++) {
+        for (int j = 0; j < 784; j++) inputs->data[i][j] = (rand() % 5 == 0) ? (gann_real)rand() / RAND_MAX : 0;
+    }
+
+    printf("%-18s %10s %10s\n", "path", "p50 us", "p99 us");
+    volatile int sink = 0;
+    for (int c = 0; c < calls; c++) {
+        Matrix* row = matrix_get_row(inputs, c % 64);
+        double start = now_seconds();
+        Matrix* output = nn_forward_pass(net, row);
+        latencies[c] = now_seconds() - start;
+        free_matrix(output);
+        free_matrix(row);
+    }
+    report("nn_forward_pass", latencies, calls);
+    for (int c = 0; c < calls; c++) {
+        double start = now_seconds();
+        sink += gann_predict(net, inputs->data[c % 64]);
+        latencies[c] = now_seconds() - start;
+    }
+    report("gann_predict", latencies, calls);
+    for (int c = 0; c < calls; c++) {
+        double start = now_seconds();
+        sink += gann_predict_ctx(ctx, inputs->data[c % 64]);
+        latencies[c] = now_seconds() - start;
+    }
+    report("gann_predict_ctx", latencies, calls);
+
+    free(latencies);
+    free_matrix(inputs);
+    gann_inference_context_free(ctx);
+    nn_free(net);
+    return 0;
+}
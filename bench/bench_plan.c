@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+#include "gann_plan.h"
+
+// Compares a compiled plan with nn_forward_pass on the 784-128-64-10 MNIST
+// network, at several batch sizes. Each plan is compiled for the batch size it
+// runs and uses a workspace allocated once.
+//
+// Usage: ./bench/bench_plan [seconds_per_case]
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    double budget = argc > 1 ? atof(argv[1]) : 0.5;
+    const int architecture[] = {784, 128, 64, 10};
+    const int batch_sizes[] = {1, 8, 64, 256};
+    gann_seed_rng(42);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    nn_init(net);
+    Matrix* inputs = create_matrix(256, 784);
+    if (!net || !inputs) {
+        fprintf(stderr, "Setup failed: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+    // MNIST-like rows: about a fifth of the pixels lit
+    for (int i = 0; i < 256; i++) {
+        for (int j = 0; j < 784; j++) inputs->data[i][j] = (rand() % 5 == 0) ? (gann_real)rand() / RAND_MAX : 0;
+    }
+
+    printf("%6s %22s %22s %8s   kernels\n", "batch", "nn_forward_pass us", "gann_plan_run us", "speedup");
+    for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+        int rows = batch_sizes[b];
+        Matrix* batch = create_matrix(rows, 784);
+        matrix_copy_view_into(batch, matrix_view_rows(inputs, 0, rows));
+        Matrix* outputs = create_matrix(rows, 10);
+        GannPlan* plan = nn_compile(net, &(GannPlanOptions){ .max_batch_size = rows });
+        void* workspace = plan ? malloc(gann_plan_workspace_size(plan)) : NULL;
+        if (!batch || !outputs || !plan || !workspace) {
+            fprintf(stderr, "Setup failed: %s\n", gann_error_to_string(gann_get_last_error()));
+            return 1;
+        }
+
+        long runs = 0;
+        double start = now_seconds(), elapsed;
+        do {
+            free_matrix(nn_forward_pass(net, batch));
+            runs++;
+        } while ((elapsed = now_seconds() - start) < budget);
+        double forward_time = elapsed / runs;
+
+        runs = 0;
+        start = now_seconds();
+        do {
+            gann_plan_run(plan, matrix_view(batch), outputs, workspace);
+            runs++;
+        } while ((elapsed = now_seconds() - start) < budget);
+        double plan_time = elapsed / runs;
+
+        printf("%6d %22.2f %22.2f %7.2fx   %s/%s/%s\n", rows, forward_time * 1e6, plan_time * 1e6, forward_time / plan_time,
+               gann_plan_layer_kernel(plan, 0), gann_plan_layer_kernel(plan, 1), gann_plan_layer_kernel(plan, 2));
+
+        free(workspace);
+        gann_plan_free(plan);
+        free_matrix(outputs);
+        free_matrix(batch);
+    }
+
+    free_matrix(inputs);
+    nn_free(net);
+    return 0;
+}
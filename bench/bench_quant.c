@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+#include "gann_quant.h"
+#include "data_loader.h"
+#include "backpropagation.h"
+#include "gann_simd.h"
+
+// Compares int8 quantized inference with the floating-point network on the
+// MNIST t10k set: accuracy, agreement of the predicted digits, per-image
+// latency of gann_predict and qnn_predict, and the size of the saved files.
+//
+// Usage: ./bench/bench_quant [network.dat]
+// Without a network file a 784-128-64-10 network is trained for one epoch.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static long file_size(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Times one call per test image and prints the median and 99th percentile.
+#define TIME_LATENCY(label, n, expr) do {                                 \
+        for (int i_ = 0; i_ < (n); i_++) {                                \
+            double start_ = now_seconds();                                \
+            expr;                                                         \
+            latencies[i_] = (now_seconds() - start_) * 1e6;               \
+        }                                                                 \
+        qsort(latencies, (n), sizeof(double), compare_doubles);           \
+        printf("%-14s p50 %7.2f us   p99 %7.2f us\n", (label),            \
+               latencies[(n) / 2], latencies[(int)((n) * 0.99)]);         \
+    } while (0)
+
+int main(int argc, char** argv) {
+    Dataset* train = load_mnist_dataset("data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte");
+    Dataset* test = load_mnist_dataset("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte");
+    if (!train || !test) {
+        fprintf(stderr, "Failed to load MNIST from data/: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+
+    NeuralNetwork* net = NULL;
+    if (argc > 1) {
+        net = nn_load(argv[1]);
+    } else {
+        const int architecture[] = {MNIST_IMAGE_SIZE, 128, 64, MNIST_NUM_CLASSES};
+        GannBackpropParams params = {
+            .architecture = architecture, .num_layers = 4, .learning_rate = 0.001, .epochs = 1, .batch_size = 32,
+            .activation_hidden = RELU, .activation_output = SIGMOID, .optimizer_type = ADAM,
+            .beta1 = 0.9, .beta2 = 0.999, .epsilon = 1e-8, .logging = false
+        };
+        gann_seed_rng(42);
+        net = gann_train_with_backprop(&params, train, NULL);
+    }
+    if (!net) {
+        fprintf(stderr, "No network: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+
+    double start = now_seconds();
+    QuantizedNetwork* qnet = qnn_quantize(net, train, 1000);
+    double calibration = now_seconds() - start;
+    if (!qnet) {
+        fprintf(stderr, "qnn_quantize failed: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+    printf("kernels: %s, int8 kernel: %s, elements: %s\n", gann_simd_level_name(gann_simd_get_level()),
+           qnn_kernel_name(), GANN_REAL_NAME);
+    printf("calibration on 1000 images: %.1f ms\n\n", calibration * 1e3);
+
+    const int n = test->images->rows;
+    int agree = 0;
+    for (int i = 0; i < n; i++) agree += gann_predict(net, test->images->data[i]) == qnn_predict(qnet, test->images->data[i]);
+    printf("%-14s %.2f%%\n", "accuracy", gann_evaluate(net, test) * 100);
+    printf("%-14s %.2f%%\n", "int8 accuracy", qnn_evaluate(qnet, test) * 100);
+    printf("%-14s %d of %d\n\n", "agreement", agree, n);
+
+    double* latencies = malloc(sizeof(double) * n);
+    volatile int sink = 0;
+    TIME_LATENCY("gann_predict", n, sink += gann_predict(net, test->images->data[i_]));
+    TIME_LATENCY("qnn_predict", n, sink += qnn_predict(qnet, test->images->data[i_]));
+    free(latencies);
+
+    nn_save_as(net, "bench_quant.dat", NN_FILE_FLOAT64);
+    qnn_save(qnet, "bench_quant.q8");
+    printf("\nfile size: float64 %ld bytes, int8 %ld bytes\n", file_size("bench_quant.dat"), file_size("bench_quant.q8"));
+    remove("bench_quant.dat");
+    remove("bench_quant.q8");
+
+    qnn_free(qnet);
+    nn_free(net);
+    free_dataset(train);
+    free_dataset(test);
+    return 0;
+}
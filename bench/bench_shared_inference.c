@@ -0,0 +1,92 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "gann.h"
+
+// Aggregate prediction throughput of threads sharing one 784-128-64-10 MNIST
+// network, each through its own inference context, for 1, 2, 4, ... threads.
+// Scaling stays near linear until the threads outnumber the cores.
+//
+// Usage: ./bench/bench_shared_inference [max_threads] [seconds_per_case]
+
+typedef struct {
+    const NeuralNetwork* net;
+    const Matrix* inputs;
+    double seconds;
+    long predictions;
+    int sink;
+} Worker;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void* predict_until_done(void* arg) {
+    Worker* worker = (Worker*)arg;
+    GannInferenceContext* ctx = gann_inference_context_create(worker->net);
+    if (!ctx) return NULL;
+    double end = now_seconds() + worker->seconds;
+    int row = 0;
+    do {
+        for (int i = 0; i < 64; i++) {
+            worker->sink += gann_predict_ctx(ctx, worker->inputs->data[row]);
+            row = (row + 1) % worker->inputs->rows;
+        }
+        worker->predictions += 64;
+    } while (now_seconds() < end);
+    gann_inference_context_free(ctx);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 1 ? atoi(argv[1]) : (int)(cores > 1 ? 2 * cores : 2);
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    if (max_threads < 1) max_threads = 1;
+    const int architecture[] = {784, 128, 64, 10};
+    gann_seed_rng(42);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    nn_init(net);
+    Matrix* inputs = create_matrix(256, 784);
+    Worker* workers = (Worker*)calloc(max_threads, sizeof(Worker));
+    pthread_t* threads = (pthread_t*)malloc(max_threads * sizeof(pthread_t));
+    if (!net || !inputs || !workers || !threads) {
+        fprintf(stderr, "Setup failed: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+    // MNIST-like rows: about a fifth of the pixels lit
+    for (int i = 0; i < 256; i++) {
+        for (int j = 0; j < 784; j++) inputs->data[i][j] = (rand() % 5 == 0) ? (gann_real)rand() / RAND_MAX : 0;
+    }
+
+    printf("%ld cores online\n", cores);
+    printf("%8s %18s %9s\n", "threads", "predictions/s", "scaling");
+    double single = 0;
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        for (int t = 0; t < num_threads; t++) {
+            workers[t] = (Worker){ net, inputs, seconds, 0, 0 };
+            if (pthread_create(&threads[t], NULL, predict_until_done, &workers[t]) != 0) {
+                fprintf(stderr, "Failed to start thread %d\n", t);
+                return 1;
+            }
+        }
+        long predictions = 0;
+        for (int t = 0; t < num_threads; t++) {
+            pthread_join(threads[t], NULL);
+            predictions += workers[t].predictions;
+        }
+        double rate = predictions / seconds;
+        if (num_threads == 1) single = rate;
+        printf("%8d %18.0f %8.2fx\n", num_threads, rate, rate / single);
+    }
+
+    free(threads);
+    free(workers);
+    free_matrix(inputs);
+    nn_free(net);
+    return 0;
+}
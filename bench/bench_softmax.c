@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+#include "data_loader.h"
+
+// Trains the 784-128-64-10 MNIST network with a sigmoid output layer on the
+// squared error and with a softmax output layer on the cross-entropy, and
+// reports the epochs and training time each takes to reach a target test
+// accuracy. Run from the repository root, with the MNIST files in data/.
+// Each epoch is its own backpropagate() call, as it is for any caller that
+// evaluates between epochs.
+//
+// Usage: ./bench/bench_softmax [target_accuracy] [max_epochs]
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void time_to_accuracy(const char* name, ActivationType output, const Dataset* train, const Dataset* test,
+                             double target, int max_epochs) {
+    const int architecture[] = {784, 128, 64, 10};
+    gann_seed_rng(42);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, output);
+    if (!net) {
+        fprintf(stderr, "Setup failed: %s\n", gann_error_to_string(gann_get_last_error()));
+        return;
+    }
+    nn_init(net);
+    nn_init_optimizer_state(net);
+    GannBackpropParams params = {
+        .learning_rate = 0.001, .epochs = 1, .batch_size = 32,
+        .optimizer_type = ADAM, .beta1 = 0.9, .beta2 = 0.999, .epsilon = 1e-8,
+    };
+
+    double training_time = 0, accuracy = 0;
+    int epoch = 0;
+    while (epoch < max_epochs && accuracy < target) {
+        double start = now_seconds();
+        backpropagate(net, train, &params, NULL);
+        training_time += now_seconds() - start;
+        accuracy = gann_evaluate(net, test);
+        epoch++;
+    }
+    printf("%-28s %8d %12.1f %10.2f%%%s\n", name, epoch, training_time, accuracy * 100.0,
+           accuracy < target ? "  (target not reached)" : "");
+    nn_free(net);
+}
+
+int main(int argc, char** argv) {
+    double target = argc > 1 ? atof(argv[1]) : 0.97;
+    int max_epochs = argc > 2 ? atoi(argv[2]) : 20;
+    Dataset* train = load_mnist_dataset("data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte");
+    Dataset* test = load_mnist_dataset("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte");
+    if (!train || !test) {
+        fprintf(stderr, "Failed to load MNIST from data/: %s\n", gann_error_to_string(gann_get_last_error()));
+        return 1;
+    }
+
+    printf("Time to %.1f%% test accuracy\n", target * 100.0);
+    printf("%-28s %8s %12s %11s\n", "output layer", "epochs", "seconds", "accuracy");
+    time_to_accuracy("sigmoid, squared error", SIGMOID, train, test, target, max_epochs);
+    time_to_accuracy("softmax, cross-entropy", SOFTMAX, train, test, target, max_epochs);
+
+    free_dataset(train);
+    free_dataset(test);
+    return 0;
+}
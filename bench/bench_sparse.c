@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+#include "data_loader.h"
+#include "backpropagation.h"
+#include "gann_simd.h"
+
+// Benchmarks the sparse first-layer path against the dense one.
+//
+// Part 1 sweeps the input density of a single 784-input row through the
+// 784x128 first layer of the MNIST network, which is where the adaptive switch
+// (NN_SPARSE_MAX_DENSITY) is chosen. Part 2 times gann_evaluate and one SGD
+// epoch on MNIST-like images (19% nonzero pixels, as in the real data set)
+// against a copy whose zero pixels are replaced by a negligible value, which
+// keeps every image dense.
+//
+// Usage: ./bench/bench_sparse [num_samples]
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Fills `row` with `count` nonzero values at random positions and lists their columns.
+static int make_sparse_row(gann_real* row, int cols, double density, int* columns) {
+    int count = 0;
+    for (int j = 0; j < cols; j++) {
+        row[j] = ((double)rand() / RAND_MAX < density) ? (gann_real)(0.1 + (rand() % 230) / 255.0) : 0;
+        if (row[j] != 0) columns[count++] = j;
+    }
+    return count;
+}
+
+static void sweep_density(void) {
+    const int architecture[] = {784, 128, 64, 10};
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    nn_init(net);
+    Matrix* input = create_matrix(1, 784);
+    Matrix* output = create_matrix(1, 128);
+    int columns[784];
+    const int reps = 20000;
+
+    printf("first layer 1x784 * 784x128 (us per row); sparse switches to dense above %.0f%%\n", NN_SPARSE_MAX_DENSITY * 100);
+    printf("%8s %10s %10s %8s\n", "density", "dense", "sparse", "speedup");
+    const double densities[] = {0.05, 0.10, 0.19, 0.30, 0.50, 0.60, 0.70, 0.75, 0.80, 0.90, 1.00};
+    for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++) {
+        int count = make_sparse_row(input->values, 784, densities[d], columns);
+        double start = now_seconds();
+        for (int r = 0; r < reps; r++) nn_layer_forward_into(net, 0, matrix_view(input), output, NULL);
+        double dense = (now_seconds() - start) / reps;
+        start = now_seconds();
+        for (int r = 0; r < reps; r++) nn_layer_forward_sparse_into(net, matrix_view(input), columns, count, output, NULL);
+        double sparse = (now_seconds() - start) / reps;
+        printf("%7.0f%% %10.2f %10.2f %7.2fx\n", 100.0 * count / 784, dense * 1e6, sparse * 1e6, dense / sparse);
+    }
+    free_matrix(input);
+    free_matrix(output);
+    nn_free(net);
+}
+
+static void time_dataset(int num_samples) {
+    Dataset* dataset = create_dummy_dataset(num_samples);
+    int columns[784];
+    for (int i = 0; i < num_samples; i++) {
+        make_sparse_row(dataset->images->values + (size_t)i * dataset->images->stride, 784, 0.19, columns);
+    }
+    const int architecture[] = {784, 128, 64, 10};
+    GannBackpropParams params = {
+        .architecture = architecture, .num_layers = 4, .learning_rate = 0.01, .epochs = 1, .batch_size = 32,
+        .activation_hidden = RELU, .activation_output = SIGMOID, .optimizer_type = SGD, .logging = false
+    };
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    nn_init(net);
+
+    printf("\n%d MNIST-like samples, 784-128-64-10 (ms)\n", num_samples);
+    printf("%-16s %10s %10s\n", "case", "dense", "sparse");
+    double times[2][2];
+    Dataset* dense = create_dummy_dataset(num_samples);
+    matrix_copy_data(dense->labels, dataset->labels);
+    for (int i = 0; i < num_samples; i++) {
+        for (int j = 0; j < 784; j++) {
+            gann_real pixel = dataset->images->data[i][j];
+            dense->images->data[i][j] = pixel != 0 ? pixel : (gann_real)1e-30;
+        }
+    }
+    for (int sparse = 0; sparse <= 1; sparse++) {
+        Dataset* data = sparse ? dataset : dense;
+        double start = now_seconds();
+        gann_evaluate(net, data);
+        times[0][sparse] = now_seconds() - start;
+        start = now_seconds();
+        backpropagate(net, data, &params, NULL);
+        times[1][sparse] = now_seconds() - start;
+    }
+    printf("%-16s %10.1f %10.1f\n", "gann_evaluate", times[0][0] * 1e3, times[0][1] * 1e3);
+    printf("%-16s %10.1f %10.1f\n", "SGD epoch", times[1][0] * 1e3, times[1][1] * 1e3);
+    nn_free(net);
+    free_dataset(dense);
+    free_dataset(dataset);
+}
+
+int main(int argc, char** argv) {
+    int num_samples = (argc > 1) ? atoi(argv[1]) : 10000;
+    srand(42);
+    printf("kernels: %s, elements: %s\n\n", gann_simd_level_name(gann_simd_get_level()), GANN_REAL_NAME);
+    sweep_density();
+    time_dataset(num_samples);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "matrix.h"
+#include "gann_simd.h"
+
+// Finds the density below which the CSR products beat the dense GEMM on the
+// layer shapes of the MNIST network (784-128-64-10) with a 32-row minibatch:
+//   sparse x dense   X_s * W     (sparse inputs)
+//   dense x sparse   A * W_s     (pruned weights)
+//   sparse^T x dense dW += X_s^T * delta (weight gradient of sparse inputs)
+// Each column pair is the dense and the sparse time in microseconds.
+//
+// Usage: ./bench/bench_spmm [batch]
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void fill(Matrix* m, double density) {
+    for (int i = 0; i < m->rows; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            m->data[i][j] = ((double)rand() / RAND_MAX < density) ? (gann_real)((double)rand() / RAND_MAX - 0.5) : 0;
+        }
+    }
+}
+
+// Stores the mean time of `expr` over `reps` runs, in microseconds, in `result`.
+#define TIME_REPS(result, reps, expr) do {             \
+        double start_ = now_seconds();                 \
+        for (int r_ = 0; r_ < (reps); r_++) { expr; }  \
+        (result) = (now_seconds() - start_) / (reps) * 1e6; \
+    } while (0)
+
+int main(int argc, char** argv) {
+    const int batch = (argc > 1) ? atoi(argv[1]) : 32;
+    const int shapes[][2] = {{784, 128}, {128, 64}, {64, 10}};
+    const double densities[] = {0.01, 0.02, 0.05, 0.10, 0.20, 0.30, 0.50, 0.70, 0.90};
+    const int num_densities = sizeof(densities) / sizeof(densities[0]);
+    srand(42);
+    printf("kernels: %s, elements: %s, batch %d\n", gann_simd_level_name(gann_simd_get_level()), GANN_REAL_NAME, batch);
+
+    for (int s = 0; s < 3; s++) {
+        const int in = shapes[s][0], out = shapes[s][1];
+        const int reps = 1 + (int)(2e8 / ((double)batch * in * out));
+        Matrix* x = create_matrix(batch, in);
+        Matrix* w = create_matrix(in, out);
+        Matrix* y = create_matrix(batch, out);
+        Matrix* delta = create_matrix(batch, out);
+        Matrix* grad = create_matrix(in, out);
+        fill(w, 1.0);
+        fill(delta, 1.0);
+        double crossover[3] = {0, 0, 0};
+
+        printf("\n%dx%d layer (us)   %19s %19s %19s\n", in, out, "X_s * W", "A * W_s", "X_s^T * delta");
+        printf("%8s %21s %19s %19s\n", "density", "dense  sparse", "dense  sparse", "dense  sparse");
+        for (int d = 0; d < num_densities; d++) {
+            double t[3][2];
+            // Sparse inputs against dense weights, and the matching gradient.
+            fill(x, densities[d]);
+            SparseMatrix* xs = sparse_matrix_from_dense(x, 0.0);
+            TIME_REPS(t[0][0], reps, dot_product_view_into(y, matrix_view(x), matrix_view(w)));
+            TIME_REPS(t[0][1], reps, sparse_dot_product_into(y, xs, matrix_view(w)));
+            TIME_REPS(t[2][0], reps, dot_product_tn_view_accumulate(grad, matrix_view(x), matrix_view(delta)));
+            TIME_REPS(t[2][1], reps, sparse_dot_product_tn_accumulate(grad, xs, matrix_view(delta)));
+            free_sparse_matrix(xs);
+
+            // Dense activations against pruned weights.
+            fill(x, 1.0);
+            Matrix* pruned = create_matrix(in, out);
+            fill(pruned, densities[d]);
+            SparseMatrix* ws = sparse_matrix_from_dense(pruned, 0.0);
+            TIME_REPS(t[1][0], reps, dot_product_view_into(y, matrix_view(x), matrix_view(pruned)));
+            TIME_REPS(t[1][1], reps, dot_product_sparse_into(y, matrix_view(x), ws));
+            free_sparse_matrix(ws);
+            free_matrix(pruned);
+
+            printf("%7.0f%% ", densities[d] * 100);
+            for (int op = 0; op < 3; op++) {
+                printf("%10.1f %8.1f", t[op][0], t[op][1]);
+                if (t[op][1] < t[op][0]) crossover[op] = densities[d];
+            }
+            printf("\n");
+        }
+        printf("sparse wins up to: X_s * W %.0f%%, A * W_s %.0f%%, X_s^T * delta %.0f%%\n",
+               crossover[0] * 100, crossover[1] * 100, crossover[2] * 100);
+        free_matrix(x);
+        free_matrix(w);
+        free_matrix(y);
+        free_matrix(delta);
+        free_matrix(grad);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "gann.h"
+#include "gann_simd.h"
+
+// Times backpropagation epochs and full-dataset inference on the 784-128-64-10
+// MNIST network. Build once with `make bench` and once with `make bench FLOAT32=1`
+// to compare the double and float element types.
+//
+// Usage: ./bench/bench_train [num_samples] [epochs]
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// MNIST-shaped synthetic data: pixel intensities in [0, 1], one-hot labels.
+static Dataset* create_benchmark_dataset(int num_samples) {
+    Dataset* dataset = (Dataset*)malloc(sizeof(Dataset));
+    dataset->num_items = num_samples;
+    dataset->images = create_matrix(num_samples, 784);
+    dataset->labels = create_matrix(num_samples, 10);
+    for (int i = 0; i < num_samples; i++) {
+        for (int j = 0; j < 784; j++) {
+            dataset->images->data[i][j] = (gann_real)((rand() % 256) / 255.0);
+        }
+        dataset->labels->data[i][rand() % 10] = 1;
+    }
+    return dataset;
+}
+
+static double time_training(const Dataset* dataset, OptimizerType optimizer, int epochs) {
+    const int architecture[] = {784, 128, 64, 10};
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    GannBackpropParams params = {
+        .learning_rate = 0.01, .epochs = epochs, .batch_size = 32,
+        .optimizer_type = optimizer, .beta1 = 0.9, .beta2 = 0.999, .epsilon = 1e-8,
+    };
+    double start = now_seconds();
+    backpropagate(net, dataset, &params, NULL);
+    double elapsed = now_seconds() - start;
+    nn_free(net);
+    return elapsed / epochs;
+}
+
+int main(int argc, char** argv) {
+    int num_samples = (argc > 1) ? atoi(argv[1]) : 4000;
+    int epochs = (argc > 2) ? atoi(argv[2]) : 3;
+    srand(1234);
+    printf("elements: %s, kernels: %s\n", GANN_REAL_NAME, gann_simd_level_name(gann_simd_get_level()));
+
+    Dataset* dataset = create_benchmark_dataset(num_samples);
+
+    printf("%-24s %12s\n", "case", "ms");
+    printf("%-24s %12.1f\n", "SGD epoch", time_training(dataset, SGD, epochs) * 1e3);
+    printf("%-24s %12.1f\n", "Adam epoch", time_training(dataset, ADAM, epochs) * 1e3);
+
+    const int architecture[] = {784, 128, 64, 10};
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    // Evaluation one sample at a time, then in batches of the default size.
+    const int batch_sizes[] = {1, NN_DEFAULT_FORWARD_BATCH_SIZE};
+    for (int b = 0; b < 2; b++) {
+        char label[32];
+        snprintf(label, sizeof(label), "gann_evaluate (batch %d)", batch_sizes[b]);
+        nn_set_forward_batch_size(batch_sizes[b]);
+        double start = now_seconds();
+        for (int r = 0; r < epochs; r++) gann_evaluate(net, dataset);
+        printf("%-24s %12.1f\n", label, (now_seconds() - start) / epochs * 1e3);
+    }
+    nn_free(net);
+
+    free_dataset(dataset);
+    return 0;
+}
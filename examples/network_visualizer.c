@@ -49,6 +49,11 @@ static void load_network(const char* filename) {
     render_as_image = FALSE;
 
     net = nn_load(filename);
+    // The drawing code reads the weight matrices, which 16-bit networks do not have
+    if (net && !nn_set_weight_storage(net, NN_STORAGE_NATIVE)) {
+        nn_free(net);
+        net = NULL;
+    }
 
     if (net) {
         char status_text[1024];
@@ -19,24 +19,34 @@ static GtkWidget *drawing_area;
 static GtkWidget *prediction_label;
 static GtkWidget *model_status_label;
 static NeuralNetwork* net = NULL;
+static GannInferenceContext* inference_ctx = NULL; // Preallocated buffers for predicting with `net`
 
 // --- Function Prototypes ---
 static void clear_grid();
 static void process_and_predict();
 static void load_network(const char* filename);
 static void load_model_button_clicked(GtkWidget *widget, gpointer data);
-static void save_grid_as_pgm(const char* filename, double* data);
-static void preprocess_and_center_image(double* network_input);
+static void save_grid_as_pgm(const char* filename, const gann_real* data);
+static void preprocess_and_center_image(gann_real* network_input);
 
 // --- GUI Callbacks ---
 
 static void load_network(const char* filename) {
     if (net) {
+        gann_inference_context_free(inference_ctx);
+        inference_ctx = NULL;
         nn_free(net);
         net = NULL;
     }
 
     net = nn_load(filename);
+    if (net) {
+        inference_ctx = gann_inference_context_create(net);
+        if (!inference_ctx) {
+            nn_free(net);
+            net = NULL;
+        }
+    }
 
     if (net) {
         char status_text[1024];
@@ -185,7 +195,7 @@ typedef struct {
  *        then translates the digit to center it in the grid.
  * @param network_input The output array to be filled with the centered image data.
  */
-static void preprocess_and_center_image(double* network_input) {
+static void preprocess_and_center_image(gann_real* network_input) {
     // 1. Find bounding box and center of mass
     BoundingBox bbox = {GRID_SIZE, -1, GRID_SIZE, -1};
     double total_mass = 0;
@@ -247,9 +257,9 @@ static void preprocess_and_center_image(double* network_input) {
 
 
 /**
- * @brief Saves a grid represented by a double array to a PGM file.
+ * @brief Saves a grid represented by a flat array of network inputs to a PGM file.
  */
-static void save_grid_as_pgm(const char* filename, double* data) {
+static void save_grid_as_pgm(const char* filename, const gann_real* data) {
     FILE* fp = fopen(filename, "w");
     if (!fp) {
         fprintf(stderr, "Error: Could not open %s for writing.\n", filename);
@@ -273,13 +283,13 @@ static void save_grid_as_pgm(const char* filename, double* data) {
  * @brief Processes the grid data and runs prediction.
  */
 static void process_and_predict() {
-    double network_input[NETWORK_INPUT_SIZE];
+    gann_real network_input[NETWORK_INPUT_SIZE];
 
     // 1. Save the raw drawing before processing
-    double raw_input[NETWORK_INPUT_SIZE];
+    gann_real raw_input[NETWORK_INPUT_SIZE];
     for (int i = 0; i < GRID_SIZE; i++) {
         for (int j = 0; j < GRID_SIZE; j++) {
-            raw_input[i * GRID_SIZE + j] = (double)grid[i][j];
+            raw_input[i * GRID_SIZE + j] = (gann_real)grid[i][j];
         }
     }
     save_grid_as_pgm("drawn_digit_raw.pgm", raw_input);
@@ -296,7 +306,8 @@ static void process_and_predict() {
         return;
     }
 
-    int prediction = gann_predict(net, network_input);
+    // Predictions run on every stroke, so they go through the preallocated context.
+    int prediction = gann_predict_ctx(inference_ctx, network_input);
     GannError err = gann_get_last_error();
     if (err != GANN_SUCCESS) {
         fprintf(stderr, "Error during prediction: %s\n", gann_error_to_string(err));
@@ -378,6 +389,7 @@ int main(int argc, char *argv[]) {
     gtk_main();
 
     // --- Cleanup ---
+    gann_inference_context_free(inference_ctx);
     if (net) {
         nn_free(net);
     }
@@ -27,7 +27,7 @@ typedef struct {
     int epochs;                     /**< The number of times the training algorithm will iterate over the entire dataset. */
     int batch_size;                 /**< The number of training samples to process before making a weight update. */
     ActivationType activation_hidden; /**< The activation function to use for all hidden layers (e.g., `RELU`). */
-    ActivationType activation_output; /**< The activation function to use for the output layer (e.g., `SIGMOID`). */
+    ActivationType activation_output; /**< The activation function to use for the output layer (e.g., `SIGMOID`, or `SOFTMAX` to train a classifier on cross-entropy). */
     OptimizerType optimizer_type;   /**< The optimization algorithm to use (e.g., `ADAM`, `SGD`). */
     double beta1;                   /**< The exponential decay rate for the first moment estimates. Used by the Adam optimizer. Default is 0.9. */
     double beta2;                   /**< The exponential decay rate for the second-moment estimates. Used by Adam and RMSprop. Default is 0.999. */
@@ -43,7 +43,8 @@ typedef struct {
  * @details This is the core function for backpropagation training. It iterates
  * over the dataset for a specified number of epochs, processing the data in
  * batches. In each batch, it computes gradients and updates the network's
- * weights and biases using the chosen optimizer.
+ * weights and biases using the chosen optimizer. The network must have
+ * `NN_STORAGE_NATIVE` weights; any other storage sets `GANN_ERROR_INVALID_PARAM`.
  * @param net The neural network to be trained (will be modified in place).
  * @param train_dataset The dataset used for training.
  * @param params The parameters for the backpropagation algorithm, including learning rate, epochs, etc.
@@ -94,5 +95,17 @@ void update_weights_adam(NeuralNetwork* net, Matrix** weight_gradients, Matrix**
  */
 double calculate_mse(const NeuralNetwork* net, const Dataset* dataset);
 
+/**
+ * @brief Calculates the mean cross-entropy of a network's outputs on a given dataset.
+ * @details The sibling of `calculate_mse()` for classifiers with a `SOFTMAX`
+ * output layer, the loss backpropagation minimizes for them: the mean over the
+ * items of `-sum(label[j] * log(output[j]))`. Outputs below 1e-12 count as 1e-12,
+ * so one confidently wrong item adds at most about 27.6.
+ * @param net The neural network to evaluate.
+ * @param dataset The dataset to evaluate the network on.
+ * @return The average cross-entropy across all items in the dataset. Returns -1.0 on error.
+ */
+double calculate_cross_entropy(const NeuralNetwork* net, const Dataset* dataset);
+
 
 #endif // BACKPROPAGATION_H
@@ -39,6 +39,19 @@ typedef struct {
  */
 NeuralNetwork** evo_create_initial_population(int population_size, int num_layers, const int* architecture, ActivationType activation_hidden, ActivationType activation_output);
 
+/**
+ * @brief Like `evo_create_initial_population()`, with every network keeping its weights in `storage`.
+ * @details With a 16-bit storage the networks never hold `gann_real` weights,
+ * so a population of 1000 784-128-64-10 networks takes about 210 MB instead of
+ * 845 MB (double build; see `bench/bench_half`). Crossover and mutation produce
+ * children in their parents' storage, so the whole evolution stays in it.
+ * @param storage The weight precision (see `NNWeightStorage`).
+ * @return The population, or `NULL` on failure.
+ */
+NeuralNetwork** evo_create_initial_population_with_storage(int population_size, int num_layers, const int* architecture,
+                                                           ActivationType activation_hidden, ActivationType activation_output,
+                                                           NNWeightStorage storage);
+
 /**
  * @brief Creates a new generation of networks through selection and crossover.
  * @details This function generates a new population of "child" networks from a
@@ -15,6 +15,7 @@
 #include "crossover.h"
 #include "mutation.h"
 #include "gann_errors.h" // Include the new error handling header
+#include "gann_simd.h"
 #include <stdbool.h>
 
 
@@ -55,6 +56,7 @@ typedef struct {
     bool logging;                   /**< If true, prints progress information (generation number, fitness scores) to the console during training. */
     int early_stopping_patience;    /**< Number of generations with no improvement in validation accuracy to wait before stopping training. Set to 0 to disable. */
     double early_stopping_threshold;/**< The minimum improvement in validation accuracy required to reset the patience counter for early stopping. */
+    NNWeightStorage weight_storage; /**< The precision the population keeps its weights in. `NN_STORAGE_BF16` or `NN_STORAGE_FP16` cut the memory of a double population to a quarter; the returned network keeps that storage. Defaults to `NN_STORAGE_NATIVE`. */
 } GannTrainParams;
 
 /**
@@ -138,7 +140,42 @@ NeuralNetwork* gann_train_with_backprop(const GannBackpropParams* params, const
  * @return The index of the predicted class (e.g., the digit 0-9).
  * @return -1 on failure. If -1 is returned, call `gann_get_last_error()` to get the specific error code.
  */
-int gann_predict(const NeuralNetwork* net, const double* input);
+int gann_predict(const NeuralNetwork* net, const gann_real* input);
+
+/**
+ * @brief Like `gann_predict()`, but runs through a preallocated inference context.
+ * @details Makes no heap allocation, so repeated predictions from an
+ * interactive or latency-sensitive path cost only the forward pass itself.
+ * Reentrant: threads sharing one network may predict concurrently, each
+ * through its own context (see `GannInferenceContext`).
+ * @param ctx A context from `gann_inference_context_create()`.
+ * @param input A flat array of input data, as for `gann_predict()`.
+ * @return The index of the predicted class, or -1 on failure.
+ */
+int gann_predict_ctx(GannInferenceContext* ctx, const gann_real* input);
+
+/**
+ * @brief Predicts the k most likely classes of many inputs at once.
+ * @details The inputs run through the batched forward pass
+ * (`nn_forward_pass_batch()`) in batches of `nn_get_forward_batch_size()` rows,
+ * and the k largest outputs of each row are selected with vector comparisons.
+ * The results go straight into the caller's buffers; apart from the scratch
+ * arena the first call grows, nothing is allocated, however many inputs there are.
+ * With a `SOFTMAX` output layer the scores are class probabilities.
+ * @param net The trained neural network.
+ * @param inputs `n` inputs stored one after another, each as for `gann_predict()`.
+ * @param n The number of inputs.
+ * @param k The number of classes to report per input, from 1 to the size of the output layer.
+ * @param out_classes Receives `n * k` class indices: for each input in turn, its
+ *        k best classes, best first. With `k = 1` these are what `gann_predict()`
+ *        returns; equal scores keep the lower class first.
+ * @param out_scores Receives the output of each class in `out_classes`, at the
+ *        same position, or `NULL` if only the classes are wanted.
+ * @return 1 on success, 0 on failure (`GANN_ERROR_INVALID_PARAM` if `n` or `k`
+ *         is out of range).
+ */
+int gann_predict_batch(const NeuralNetwork* net, const gann_real* inputs, int n, int k, int* out_classes,
+                       gann_real* out_scores);
 
 /**
  * @brief Evaluates the network's accuracy on a given dataset.
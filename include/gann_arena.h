@@ -0,0 +1,132 @@
+#ifndef GANN_ARENA_H
+#define GANN_ARENA_H
+
+/**
+ * @file gann_arena.h
+ * @brief A bump-pointer arena for short-lived scratch memory.
+ * @details An arena hands out memory by advancing a pointer through a large
+ * block and releases it all at once by moving the pointer back, so temporaries
+ * that live for one sample or one batch cost no `malloc`/`free` at all.
+ *
+ * Typical use is a mark/reset bracket around a unit of work:
+ * @code
+ * size_t mark = gann_arena_mark(arena);
+ * Matrix* tmp = gann_arena_create_matrix(arena, 1, 128);
+ * // ... use tmp ...
+ * gann_arena_reset_to(arena, mark); // tmp is gone
+ * @endcode
+ *
+ * When a request does not fit, the arena chains an extra chunk from the system
+ * allocator instead of failing. The next full reset (to position 0) replaces
+ * all chunks with a single block as large as the high-water mark, so after one
+ * warm-up iteration the same workload runs without touching the allocator.
+ * `gann_arena_get_stats()` reports the high-water mark and how often the arena
+ * has allocated, which is enough to size an arena once with
+ * `gann_arena_reserve()`.
+ *
+ * An arena is not thread-safe. Every thread has its own scratch arena
+ * (`gann_scratch_arena()`), which the library's training and inference
+ * functions draw their temporaries from.
+ */
+
+#include <stddef.h>
+#include "matrix.h"
+
+/** @brief An opaque bump-pointer arena. */
+typedef struct GannArena GannArena;
+
+/**
+ * @brief Usage statistics of an arena.
+ */
+typedef struct {
+    size_t capacity;          /**< Bytes currently reserved from the system, across all chunks. */
+    size_t used;              /**< Bytes handed out since the last reset, including alignment padding. */
+    size_t high_water;        /**< The largest value `used` has ever reached. */
+    size_t chunk_allocations; /**< Number of times the arena has called the system allocator. */
+} GannArenaStats;
+
+/**
+ * @brief Creates an arena with an initial block of at least `capacity` bytes.
+ * @param capacity The initial capacity in bytes; 0 selects a small default.
+ * @return The new arena, or `NULL` on failure. Free it with `gann_arena_free()`.
+ */
+GannArena* gann_arena_create(size_t capacity);
+
+/**
+ * @brief Frees an arena and all memory handed out from it.
+ * @details It is safe to pass `NULL`.
+ * @param arena The arena to free.
+ */
+void gann_arena_free(GannArena* arena);
+
+/**
+ * @brief Allocates `size` bytes aligned to `MATRIX_ALIGNMENT`.
+ * @details The memory is not initialized and stays valid until the arena is
+ * reset below the current position or freed.
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the memory, or `NULL` on failure (sets `GANN_ERROR_ALLOC_FAILED`).
+ */
+void* gann_arena_alloc(GannArena* arena, size_t size);
+
+/**
+ * @brief Creates a zero-initialized matrix inside the arena.
+ * @details The matrix has the same layout as one from `create_matrix()` but
+ * must not be passed to `free_matrix()`; it is released by resetting the arena.
+ * @param arena The arena to allocate from.
+ * @param rows The number of rows.
+ * @param cols The number of columns.
+ * @return The new matrix, or `NULL` on failure (sets the error code).
+ */
+Matrix* gann_arena_create_matrix(GannArena* arena, int rows, int cols);
+
+/**
+ * @brief Returns the current position of the arena, for a later `gann_arena_reset_to()`.
+ * @param arena The arena.
+ * @return The current position in bytes.
+ */
+size_t gann_arena_mark(const GannArena* arena);
+
+/**
+ * @brief Releases everything allocated after `mark` was taken.
+ * @param arena The arena.
+ * @param mark A position previously returned by `gann_arena_mark()`.
+ */
+void gann_arena_reset_to(GannArena* arena, size_t mark);
+
+/**
+ * @brief Releases everything allocated from the arena.
+ * @details Equivalent to `gann_arena_reset_to(arena, 0)`. If the arena had to
+ * chain extra chunks, they are merged into one block of the high-water size.
+ * @param arena The arena.
+ */
+void gann_arena_reset(GannArena* arena);
+
+/**
+ * @brief Grows an empty arena so that `capacity` bytes fit without further allocation.
+ * @param arena The arena; it must be fully reset.
+ * @param capacity The capacity in bytes to reserve.
+ * @return 1 on success, 0 on failure (sets `GANN_ERROR_INVALID_PARAM` if the arena is in use,
+ *         `GANN_ERROR_ALLOC_FAILED` if the memory could not be obtained).
+ */
+int gann_arena_reserve(GannArena* arena, size_t capacity);
+
+/**
+ * @brief Reads the usage statistics of an arena.
+ * @param arena The arena.
+ * @param stats Receives the statistics.
+ */
+void gann_arena_get_stats(const GannArena* arena, GannArenaStats* stats);
+
+/**
+ * @brief Returns the calling thread's scratch arena, creating it on first use.
+ * @details The library's training and inference functions (`backpropagate()`,
+ * `gann_predict()`, `gann_evaluate()`, `calculate_mse()`, `nn_forward_pass()`
+ * and the genetic algorithm's fitness evaluation) take their temporaries from
+ * this arena and release them before returning. Callers may use it the same
+ * way, and may inspect or pre-size it. It is freed when the thread exits.
+ * @return The scratch arena, or `NULL` if it could not be created.
+ */
+GannArena* gann_scratch_arena(void);
+
+#endif // GANN_ARENA_H
@@ -0,0 +1,56 @@
+#ifndef GANN_BACKEND_H
+#define GANN_BACKEND_H
+
+/**
+ * @file gann_backend.h
+ * @brief Runtime selection of the engine that computes matrix products.
+ * @details Every matrix product in the library (`dot_product()` and its
+ * transposed, accumulating and destination-passing variants, and therefore the
+ * forward and backward passes) goes through one GEMM entry point. By default
+ * it runs the library's own cache-blocked SIMD kernels.
+ *
+ * When the library is built with an external BLAS (`make BLAS=1`, which defines
+ * `GANN_USE_CBLAS` and links `-lopenblas` unless `BLAS_LIBS` says otherwise),
+ * products can instead be routed to `cblas_dgemm` (or `cblas_sgemm` in a
+ * `GANN_FLOAT32` build). Such a build starts on the BLAS backend. The
+ * `GANN_GEMM_BACKEND` environment variable (`builtin` or `cblas`) and
+ * `gann_gemm_set_backend()` switch between the two in the same binary, which
+ * makes A/B comparisons straightforward.
+ *
+ * The bit-for-bit reproducibility across thread counts described in
+ * `gann_threads.h` is a property of the built-in backend; an external BLAS
+ * makes its own guarantees.
+ */
+
+/**
+ * @brief Enumeration of the matrix-product backends.
+ */
+typedef enum {
+    GANN_GEMM_BUILTIN = 0, /**< The library's own packed, SIMD-dispatched kernels. Always available. */
+    GANN_GEMM_CBLAS        /**< The system BLAS through the CBLAS interface. Only in builds with `GANN_USE_CBLAS`. */
+} GannGemmBackend;
+
+/**
+ * @brief Returns the backend currently computing matrix products.
+ * @return The active `GannGemmBackend`.
+ */
+GannGemmBackend gann_gemm_get_backend(void);
+
+/**
+ * @brief Switches matrix products to the given backend.
+ * @details It may be called from any thread, also while other threads are
+ * running products: each product reads the backend once when it starts, so one
+ * already under way finishes on the old backend and later products use the new one.
+ * @param backend The backend to activate.
+ * @return 1 on success, 0 if the backend is not compiled into this build (the active backend is unchanged).
+ */
+int gann_gemm_set_backend(GannGemmBackend backend);
+
+/**
+ * @brief Converts a `GannGemmBackend` into its lowercase name (e.g., `"cblas"`).
+ * @param backend The backend to convert.
+ * @return A constant string naming the backend, the same spelling accepted by `GANN_GEMM_BACKEND`.
+ */
+const char* gann_gemm_backend_name(GannGemmBackend backend);
+
+#endif // GANN_BACKEND_H
@@ -0,0 +1,103 @@
+#ifndef GANN_PLAN_H
+#define GANN_PLAN_H
+
+/**
+ * @file gann_plan.h
+ * @brief Compiled, read-only inference plans.
+ * @details A `GannPlan` is an inference-only copy of a `NeuralNetwork` prepared
+ * once for a fixed maximum batch size, for serving code that loads a model and
+ * then runs it millions of times:
+ *
+ * - Every layer's kernel is chosen at compile time from its shape and the batch
+ *   size. Layers whose batches fill whole register tiles keep their weights
+ *   pre-packed in the panel layout of the GEMM micro-kernels, so a run never
+ *   packs them again; the others run the row kernel on row-major weights. A
+ *   packed layer keeps a row-major copy too, for passes with fewer rows than a
+ *   tile, which the row kernel computes faster.
+ * - The bias and the activation are fused into the write-back of each layer's
+ *   product.
+ * - The scratch memory a run needs is computed at compile time
+ *   (`gann_plan_workspace_size()`).
+ *
+ * A plan is immutable after `nn_compile()`: any number of threads may run the
+ * same plan at once, each with its own workspace. A run makes no allocation and
+ * touches no shared state; it computes on the calling thread only and always
+ * uses the built-in kernels, whatever `gann_gemm_set_backend()` selects. The
+ * kernels and the sigmoid mode are the ones selected when the plan was
+ * compiled, whatever `gann_simd_set_level()` or `gann_simd_set_sigmoid_mode()`
+ * chooses later.
+ *
+ * Typical use:
+ * @code
+ * GannPlanOptions options = { .max_batch_size = 64 };
+ * GannPlan* plan = nn_compile(net, &options);
+ * void* workspace = malloc(gann_plan_workspace_size(plan));
+ * gann_plan_run(plan, matrix_view(inputs), outputs, workspace);
+ * @endcode
+ */
+
+#include "neural_network.h"
+
+/** @brief An opaque compiled inference plan. */
+typedef struct GannPlan GannPlan;
+
+/**
+ * @brief How `nn_compile()` prepares a plan.
+ */
+typedef struct {
+    int max_batch_size; /**< The most rows one pass computes; larger inputs run in passes of this many rows. 0 selects `NN_DEFAULT_FORWARD_BATCH_SIZE`. */
+} GannPlanOptions;
+
+/**
+ * @brief Compiles a network into an inference plan.
+ * @details The plan copies everything it needs, so `net` may be changed or
+ * freed afterwards. Weights in 16-bit storage are widened once, here. The
+ * outputs match `nn_forward_pass()` up to rounding, which may differ because
+ * the products are blocked differently.
+ * @param net The network to compile.
+ * @param options The compile options, or `NULL` for the defaults.
+ * @return The plan, or `NULL` on failure (`GANN_ERROR_INVALID_PARAM` for a
+ *         negative batch size). Free it with `gann_plan_free()`.
+ */
+GannPlan* nn_compile(const NeuralNetwork* net, const GannPlanOptions* options);
+
+/**
+ * @brief Frees a plan. It is safe to pass `NULL`.
+ * @param plan The plan to free.
+ */
+void gann_plan_free(GannPlan* plan);
+
+/**
+ * @brief The number of bytes of workspace one `gann_plan_run()` needs.
+ * @param plan The plan.
+ * @return The size in bytes, or 0 if `plan` is `NULL`.
+ */
+size_t gann_plan_workspace_size(const GannPlan* plan);
+
+/**
+ * @brief Names the kernel a plan runs one of its layers with.
+ * @param plan The plan.
+ * @param layer The weight layer, from 0 to `num_layers - 2`.
+ * @return "packed" (micro-kernels on pre-packed weights, for passes that fill
+ *         a register tile), "rows" (the row kernel on row-major weights), or
+ *         `NULL` for an invalid argument.
+ */
+const char* gann_plan_layer_kernel(const GannPlan* plan, int layer);
+
+/**
+ * @brief Runs inputs through a plan.
+ * @details Any number of rows may be given; they run in passes of up to the
+ * plan's maximum batch size.
+ * @param plan The plan.
+ * @param inputs The inputs, one per row, `architecture[0]` columns.
+ * @param outputs Receives one row of `architecture[num_layers - 1]` outputs
+ *        per input. It must not overlap `inputs`.
+ * @param workspace At least `gann_plan_workspace_size(plan)` bytes that no other
+ *        run uses at the same time, with any alignment; or `NULL` to take them
+ *        from the calling thread's scratch arena, which then grows on first use.
+ * @return 1 on success, 0 on failure (`GANN_ERROR_INVALID_DIMENSIONS` for
+ *         mismatched inputs or outputs, `GANN_ERROR_INVALID_PARAM` if they overlap).
+ */
+int gann_plan_run(const GannPlan* plan, MatrixView inputs, Matrix* outputs, void* workspace);
+
+#endif // GANN_PLAN_H
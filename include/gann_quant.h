@@ -0,0 +1,117 @@
+#ifndef GANN_QUANT_H
+#define GANN_QUANT_H
+
+/**
+ * @file gann_quant.h
+ * @brief Int8 quantized inference.
+ * @details A `QuantizedNetwork` is an inference-only copy of a trained
+ * `NeuralNetwork` whose products run on 8-bit integers:
+ *
+ * - Weights are `int8` with one scale per output neuron (per-channel
+ *   symmetric quantization: `w ≈ scale_j * q`, `q` in [-127, 127]).
+ * - Every layer input is `uint8` with a per-layer scale and zero point
+ *   (`x ≈ scale * (q - zero_point)`), chosen by calibration so the range the
+ *   layer actually sees maps onto 0..255. MNIST pixels in [0, 1] map exactly.
+ * - Products accumulate in `int32`; the bias, the activation and the output
+ *   layer stay in `gann_real`.
+ *
+ * The integer dot products use AVX-512 VNNI (`vpdpbusd`) where the CPU has it,
+ * otherwise AVX-512BW or AVX2 widening multiply-adds, otherwise plain C. All of
+ * them compute the same exact integer sums, so results do not depend on the
+ * kernel. `GANN_SIMD` and `gann_simd_set_level()` cap the choice as they do for
+ * the floating-point kernels.
+ *
+ * Typical use:
+ * @code
+ * QuantizedNetwork* qnet = qnn_quantize(net, train_dataset, 1000);
+ * int digit = qnn_predict(qnet, image);
+ * qnn_save(qnet, "network.q8");
+ * @endcode
+ *
+ * A quantized network is read-only after creation, so several threads may run
+ * inference on the same one; temporaries come from each thread's scratch arena.
+ */
+
+#include "neural_network.h"
+#include "data_loader.h"
+
+/** @brief An opaque int8 quantized network. */
+typedef struct QuantizedNetwork QuantizedNetwork;
+
+/**
+ * @brief Quantizes a trained network, calibrating activation ranges on a dataset.
+ * @details Runs `net` in floating point over the first `max_samples` items of
+ * `calibration` and records the range of every layer's input. The images should
+ * be representative of what the network will see in use (a slice of the
+ * training set works well).
+ * @param net The trained network. It is not modified and not referenced afterwards.
+ * @param calibration The calibration images; its labels are not used.
+ * @param max_samples The number of samples to run, or 0 for the whole dataset.
+ * @return The quantized network, or `NULL` on failure. Free it with `qnn_free()`.
+ */
+QuantizedNetwork* qnn_quantize(const NeuralNetwork* net, const Dataset* calibration, int max_samples);
+
+/**
+ * @brief Frees a quantized network. It is safe to pass `NULL`.
+ * @param qnet The network to free.
+ */
+void qnn_free(QuantizedNetwork* qnet);
+
+/**
+ * @brief Returns the layer sizes of a quantized network.
+ * @param qnet The network.
+ * @param num_layers If not `NULL`, receives the number of layers.
+ * @return The architecture array (owned by `qnet`), or `NULL` if `qnet` is `NULL`.
+ */
+const int* qnn_get_architecture(const QuantizedNetwork* qnet, int* num_layers);
+
+/**
+ * @brief Runs one input through the quantized network.
+ * @param qnet The network.
+ * @param input `architecture[0]` input values.
+ * @param output Receives the `architecture[num_layers - 1]` output activations.
+ * @return 1 on success, 0 on failure.
+ */
+int qnn_forward(const QuantizedNetwork* qnet, const gann_real* input, gann_real* output);
+
+/**
+ * @brief Predicts the class of one input, like `gann_predict()`.
+ * @param qnet The network.
+ * @param input `architecture[0]` input values.
+ * @return The index of the largest output, or -1 on failure.
+ */
+int qnn_predict(const QuantizedNetwork* qnet, const gann_real* input);
+
+/**
+ * @brief Computes the classification accuracy on a dataset, like `gann_evaluate()`.
+ * @param qnet The network.
+ * @param dataset The dataset to evaluate on.
+ * @return The fraction of correctly classified items, or 0.0 on failure.
+ */
+double qnn_evaluate(const QuantizedNetwork* qnet, const Dataset* dataset);
+
+/**
+ * @brief Saves a quantized network to a binary file.
+ * @details The file holds the int8 weights, so it is about an eighth of the
+ * size of an `nn_save()` float64 file. It is a separate format: `nn_load()`
+ * does not read it.
+ * @param qnet The network to save.
+ * @param filepath The path of the file to write.
+ * @return 1 on success, 0 on failure.
+ */
+int qnn_save(const QuantizedNetwork* qnet, const char* filepath);
+
+/**
+ * @brief Loads a network saved with `qnn_save()`.
+ * @param filepath The path of the file to read.
+ * @return The network, or `NULL` on failure (e.g. `GANN_ERROR_INVALID_FILE_FORMAT`).
+ */
+QuantizedNetwork* qnn_load(const char* filepath);
+
+/**
+ * @brief Names the integer dot-product kernel that inference currently uses.
+ * @return "avx512vnni", "avx512bw", "avx2" or "scalar".
+ */
+const char* qnn_kernel_name(void);
+
+#endif // GANN_QUANT_H
@@ -0,0 +1,44 @@
+#ifndef GANN_REAL_H
+#define GANN_REAL_H
+
+/**
+ * @file gann_real.h
+ * @brief The floating-point type used for every matrix element, weight, bias and activation.
+ * @details The library stores and computes its numeric data in `gann_real`,
+ * which is `double` by default. Building the library with `GANN_FLOAT32`
+ * defined (`make FLOAT32=1`) switches it to `float`: matrices take half the
+ * memory and the SIMD kernels process twice as many elements per instruction.
+ *
+ * The choice is made at build time and is part of the ABI: programs must be
+ * compiled with the same setting as the library they link against, which can
+ * be checked at run time with `gann_real_size()`. Scalar parameters such as
+ * learning rates, fitness values and accuracies remain `double` in both modes.
+ */
+
+#include <stddef.h>
+#include <float.h>
+
+#ifdef GANN_FLOAT32
+typedef float gann_real;
+/** @brief `sizeof(gann_real)`, usable in preprocessor conditionals. */
+#define GANN_REAL_SIZE 4
+/** @brief The difference between 1 and the next representable `gann_real`. */
+#define GANN_REAL_EPSILON FLT_EPSILON
+/** @brief A printable name for the element type. */
+#define GANN_REAL_NAME "float32"
+#else
+typedef double gann_real;
+#define GANN_REAL_SIZE 8
+#define GANN_REAL_EPSILON DBL_EPSILON
+#define GANN_REAL_NAME "float64"
+#endif
+
+/**
+ * @brief Returns `sizeof(gann_real)` as the library was compiled.
+ * @details Compare against `sizeof(gann_real)` in the calling program to detect
+ * a library built with a different `GANN_FLOAT32` setting.
+ * @return 4 for a float32 build, 8 for the default double build.
+ */
+size_t gann_real_size(void);
+
+#endif // GANN_REAL_H
@@ -0,0 +1,91 @@
+#ifndef GANN_SIMD_H
+#define GANN_SIMD_H
+
+/**
+ * @file gann_simd.h
+ * @brief Runtime selection of the instruction set used by the numeric kernels.
+ * @details The hot kernels of the library (matrix products, bias addition,
+ * element-wise products, activations and optimizer updates) are compiled in
+ * several versions, one per supported instruction set. The best version the
+ * CPU supports is selected once when the library is loaded, so a single binary
+ * runs well on every CPU generation.
+ *
+ * The choice can be overridden with the `GANN_SIMD` environment variable
+ * (`scalar`, `sse2`, `avx2` or `avx512`). A request for a level the CPU does
+ * not support falls back to the best supported level below it.
+ *
+ * All levels vectorize the activation functions and their derivatives. The
+ * sigmoid can additionally be switched to a cheaper approximation with
+ * `gann_simd_set_sigmoid_mode()` or the `GANN_SIGMOID` environment variable
+ * (`exact` or `fast`).
+ */
+
+/**
+ * @brief Enumeration of the kernel instruction-set levels, from least to most capable.
+ */
+typedef enum {
+    GANN_SIMD_SCALAR = 0, /**< Portable C kernels with no explicit vector code. */
+    GANN_SIMD_SSE2,       /**< 128-bit SSE2 kernels (x86). */
+    GANN_SIMD_AVX2,       /**< 256-bit AVX2 + FMA kernels (x86). */
+    GANN_SIMD_AVX512      /**< 512-bit AVX-512F kernels (x86). */
+} GannSimdLevel;
+
+/**
+ * @brief Returns the instruction-set level of the kernels currently in use.
+ * @return The active `GannSimdLevel`.
+ */
+GannSimdLevel gann_simd_get_level(void);
+
+/**
+ * @brief Returns the most capable level supported by the CPU the program runs on.
+ * @return The best `GannSimdLevel` this CPU and build can execute.
+ */
+GannSimdLevel gann_simd_get_best_level(void);
+
+/**
+ * @brief Switches the kernels to the given instruction-set level.
+ * @details Intended for testing and benchmarking. It must not be called while
+ * other threads are running library code.
+ * @param level The level to activate.
+ * @return 1 on success, 0 if the CPU does not support `level` (the active level is unchanged).
+ */
+int gann_simd_set_level(GannSimdLevel level);
+
+/**
+ * @brief Converts a `GannSimdLevel` into its lowercase name (e.g., `"avx2"`).
+ * @param level The level to convert.
+ * @return A constant string naming the level, the same spelling accepted by `GANN_SIMD`.
+ */
+const char* gann_simd_level_name(GannSimdLevel level);
+
+/**
+ * @brief Enumeration of the ways the activation kernels compute the sigmoid.
+ */
+typedef enum {
+    GANN_SIGMOID_EXACT = 0, /**< A vectorized `1 / (1 + exp(-x))`, within a few ulp of the C library's result. */
+    GANN_SIGMOID_FAST       /**< A degree-3 polynomial for the exponential; the sigmoid is off by at most 2e-5 (absolute). */
+} GannSigmoidMode;
+
+/**
+ * @brief Selects how the sigmoid and its derivative are computed.
+ * @details Applies to every SIGMOID layer, in inference and in training. It must
+ * not be called while other threads are running library code.
+ * @param mode The mode to activate.
+ * @return 1 on success, 0 if `mode` is not a valid `GannSigmoidMode`.
+ */
+int gann_simd_set_sigmoid_mode(GannSigmoidMode mode);
+
+/**
+ * @brief Returns the sigmoid mode currently in use.
+ * @return The active `GannSigmoidMode`.
+ */
+GannSigmoidMode gann_simd_get_sigmoid_mode(void);
+
+/**
+ * @brief Converts a `GannSigmoidMode` into its lowercase name (e.g., `"fast"`).
+ * @param mode The mode to convert.
+ * @return A constant string naming the mode, the same spelling accepted by `GANN_SIGMOID`.
+ */
+const char* gann_simd_sigmoid_mode_name(GannSigmoidMode mode);
+
+#endif // GANN_SIMD_H
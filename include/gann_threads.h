@@ -0,0 +1,41 @@
+#ifndef GANN_THREADS_H
+#define GANN_THREADS_H
+
+/**
+ * @file gann_threads.h
+ * @brief Control over the worker threads used by the matrix engine.
+ * @details Large matrix products (for example a 256-sample minibatch through a
+ * 784x128 layer) are split into tiles of the output matrix and computed on an
+ * internal thread pool. Products too small to amortize the hand-off to other
+ * threads always run on the calling thread.
+ *
+ * Every element of a product is computed by the same sequence of floating-point
+ * operations whichever thread computes it, so results are bit-for-bit identical
+ * for any thread count.
+ *
+ * The default thread count is the number of online processors, or the value of
+ * the `GANN_NUM_THREADS` environment variable when it is set to a positive number.
+ */
+
+/** @brief The largest thread count accepted by `gann_set_num_threads()`. */
+#define GANN_MAX_THREADS 64
+
+/**
+ * @brief Sets the number of threads that large matrix products may use.
+ * @details The count includes the calling thread, so 1 disables threading. The
+ * pool is resized lazily on the next large product. It may be called from any
+ * thread, also while other threads are running products: a product already
+ * under way finishes with the count it started with, and later products use
+ * the new one.
+ * @param num_threads The thread count, between 1 and `GANN_MAX_THREADS`.
+ * @return 1 on success, 0 if `num_threads` is out of range.
+ */
+int gann_set_num_threads(int num_threads);
+
+/**
+ * @brief Returns the number of threads that large matrix products may use.
+ * @return The current thread count (at least 1).
+ */
+int gann_get_num_threads(void);
+
+#endif // GANN_THREADS_H
@@ -5,23 +5,60 @@
  * @file matrix.h
  * @brief A basic 2D matrix library for neural network computations.
  * @details Provides functions for creating, manipulating, and performing
- * mathematical operations on 2D matrices of doubles.
+ * mathematical operations on 2D matrices of `gann_real` (see `gann_real.h`).
  */
 
+#include <stddef.h>
+#include "gann_real.h"
+
+/**
+ * @brief Alignment, in bytes, of the element buffer of every matrix `create_matrix()` allocates.
+ * @details Matrices that point into memory they do not own, such as a network's
+ * weights and biases inside its parameter block, are only aligned to `gann_real`.
+ */
+#define MATRIX_ALIGNMENT 64
+
 /**
  * @brief Represents a 2D matrix.
+ * @details The elements live in a single contiguous, row-major buffer (`values`),
+ * aligned to `MATRIX_ALIGNMENT` bytes when `create_matrix()` allocated it. Row `i`
+ * starts at `values + i * stride`.
+ * The `data` array holds one pointer per row into that same buffer, so the
+ * classic `m->data[i][j]` indexing keeps working; new code should prefer
+ * `values` and `stride`, which allow whole-matrix loops and single `memcpy` calls.
  */
 typedef struct {
-    int rows;      /**< The number of rows in the matrix. */
-    int cols;      /**< The number of columns in the matrix. */
-    double** data; /**< A 2D array holding the matrix elements. */
+    int rows;          /**< The number of rows in the matrix. */
+    int cols;          /**< The number of columns in the matrix. */
+    gann_real** data;  /**< Row pointers into `values`. `data[i]` points to the first element of row `i`. */
+    gann_real* values; /**< The contiguous, row-major element buffer. */
+    int stride;        /**< The distance, in elements, between the starts of two consecutive rows (`>= cols`). */
 } Matrix;
 
+/**
+ * @brief A non-owning, read-only window onto the elements of a matrix.
+ * @details A view is a pointer plus a shape and a row stride, so it can describe
+ * a whole matrix, a single row, a range of rows (e.g., a minibatch of dataset
+ * samples) or a rectangular sub-block (e.g., a slice of a layer's weights)
+ * without copying anything. Views are small values meant to be passed by value;
+ * they stay valid only as long as the matrix they were taken from. Element
+ * `(i, j)` is `values[i * stride + j]`.
+ *
+ * A view with `values == NULL` is empty; the constructors return one on failure.
+ */
+typedef struct {
+    const gann_real* values; /**< Pointer to element (0, 0) of the view. */
+    int rows;                /**< The number of rows in the view. */
+    int cols;                /**< The number of columns in the view. */
+    int stride;              /**< The distance, in elements, between the starts of two consecutive rows. */
+} MatrixView;
+
 // --- Matrix Operations ---
 
 /**
  * @brief Creates a new matrix with all elements initialized to zero.
- * @details Allocates memory for a new `Matrix` struct and its underlying data array.
+ * @details The struct, the row pointer array and the element buffer are obtained
+ * from a single aligned allocation. The element buffer is dense (`stride == cols`).
  * The caller is responsible for freeing the matrix using `free_matrix()`.
  * @param rows The number of rows in the new matrix.
  * @param cols The number of columns in the new matrix.
@@ -29,6 +66,20 @@ typedef struct {
  */
 Matrix* create_matrix(int rows, int cols);
 
+/**
+ * @brief Creates a matrix over an existing, dense element buffer.
+ * @details Only the struct and the row pointer array are allocated; the elements
+ * stay where they are, so writes through the matrix land in `values`. This is
+ * how a network's weight and bias matrices share its single parameter buffer.
+ * `free_matrix()` releases the header and leaves `values` alone, so the buffer
+ * must outlive the matrix.
+ * @param values The `rows * cols` elements, row-major.
+ * @param rows The number of rows.
+ * @param cols The number of columns.
+ * @return The new matrix, or `NULL` on failure.
+ */
+Matrix* matrix_wrap(gann_real* values, int rows, int cols);
+
 /**
  * @brief Frees the memory allocated for a matrix.
  * @details Deallocates the matrix's data array and the struct itself.
@@ -53,6 +104,38 @@ void print_matrix(const Matrix* m);
  */
 Matrix* dot_product(const Matrix* m1, const Matrix* m2);
 
+/**
+ * @brief Computes the product of the transpose of `m1` with `m2` (m1ᵀ · m2).
+ * @details `m1` is read in place; no transposed copy is made. The number of rows
+ * in `m1` must equal the number of rows in `m2`.
+ * @param m1 The matrix whose transpose is the left operand.
+ * @param m2 The right operand.
+ * @return A new `m1->cols x m2->cols` matrix. The caller is responsible for
+ *         freeing this matrix. Returns `NULL` on failure.
+ */
+Matrix* dot_product_tn(const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes the product of `m1` with the transpose of `m2` (m1 · m2ᵀ).
+ * @details `m2` is read in place; no transposed copy is made. The number of
+ * columns in `m1` must equal the number of columns in `m2`.
+ * @param m1 The left operand.
+ * @param m2 The matrix whose transpose is the right operand.
+ * @return A new `m1->rows x m2->rows` matrix. The caller is responsible for
+ *         freeing this matrix. Returns `NULL` on failure.
+ */
+Matrix* dot_product_nt(const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Accumulates the product m1ᵀ · m2 into an existing matrix (`c += m1ᵀ · m2`).
+ * @details Nothing is allocated. `m1` and `m2` must have the same number of rows,
+ * and `c` must be `m1->cols x m2->cols`.
+ * @param c The matrix to accumulate into.
+ * @param m1 The matrix whose transpose is the left operand.
+ * @param m2 The right operand.
+ */
+void dot_product_tn_accumulate(Matrix* c, const Matrix* m1, const Matrix* m2);
+
 /**
  * @brief Adds a bias vector (a row matrix) to each row of a matrix, in place.
  * @details The number of columns in `m` must equal the number of columns in `bias`.
@@ -117,7 +200,7 @@ Matrix* matrix_scale(const Matrix* m, double scalar);
  * @return A new matrix containing the data from the array. The caller is
  *         responsible for freeing this matrix. Returns `NULL` on failure.
  */
-Matrix* matrix_from_array(const double* array, int rows, int cols);
+Matrix* matrix_from_array(const gann_real* array, int rows, int cols);
 
 /**
  * @brief Creates a deep copy of a matrix.
@@ -136,6 +219,44 @@ Matrix* matrix_copy(const Matrix* m);
  */
 Matrix* matrix_get_row(const Matrix* m, int row);
 
+/**
+ * @brief Checks whether a matrix stores its rows back to back with no padding.
+ * @param m The matrix to check.
+ * @return 1 if `m->stride == m->cols` (the whole matrix is one linear block of
+ *         `rows * cols` elements), 0 otherwise or if `m` is `NULL`.
+ */
+int matrix_is_contiguous(const Matrix* m);
+
+// --- Matrix Views ---
+
+/**
+ * @brief Returns a view of a whole matrix.
+ * @param m The matrix to view.
+ * @return A view covering all of `m`, or an empty view if `m` is `NULL`.
+ */
+MatrixView matrix_view(const Matrix* m);
+
+/**
+ * @brief Returns a `1 x cols` view of one row of a matrix, without copying it.
+ * @param m The matrix to view.
+ * @param row The index of the row (0-based).
+ * @return The row view, or an empty view if `m` is `NULL` or `row` is out of range.
+ */
+MatrixView matrix_view_row(const Matrix* m, int row);
+
+/**
+ * @brief Returns a view of `num_rows` consecutive rows of a matrix, starting at `first_row`.
+ * @details Useful for feeding a minibatch of dataset rows straight into a product.
+ * @return The view, or an empty view if `m` is `NULL` or the range is out of bounds.
+ */
+MatrixView matrix_view_rows(const Matrix* m, int first_row, int num_rows);
+
+/**
+ * @brief Returns a view of the `num_rows x num_cols` block whose top-left element is `(first_row, first_col)`.
+ * @return The view, or an empty view if `m` is `NULL` or the block is out of bounds.
+ */
+MatrixView matrix_view_block(const Matrix* m, int first_row, int first_col, int num_rows, int num_cols);
+
 /**
  * @brief Copies the data from a source matrix to a destination matrix.
  * @details This function only copies the `data` field. It assumes that the
@@ -146,5 +267,261 @@ Matrix* matrix_get_row(const Matrix* m, int row);
  */
 void matrix_copy_data(Matrix* dest, const Matrix* src);
 
+// --- Destination-Passing Operations ---
+// Each `_into` function writes its result into a matrix supplied by the caller
+// instead of allocating one, so loops that reuse their buffers never touch the
+// heap. The destination must already have the shape of the result. All of them
+// return 1 on success and 0 on failure (see `gann_get_last_error()`); on failure
+// the destination is left unchanged.
+
+/**
+ * @brief Computes `dest = m1 · m2` without allocating.
+ * @param dest The `m1->rows x m2->cols` result matrix. Must not be `m1` or `m2`.
+ * @param m1 The left operand.
+ * @param m2 The right operand.
+ * @return 1 on success, 0 on failure.
+ */
+int dot_product_into(Matrix* dest, const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes `dest = m1ᵀ · m2` without allocating or transposing.
+ * @param dest The `m1->cols x m2->cols` result matrix. Must not be `m1` or `m2`.
+ * @param m1 The matrix whose transpose is the left operand.
+ * @param m2 The right operand.
+ * @return 1 on success, 0 on failure.
+ */
+int dot_product_tn_into(Matrix* dest, const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes `dest = m1 · m2ᵀ` without allocating or transposing.
+ * @param dest The `m1->rows x m2->rows` result matrix. Must not be `m1` or `m2`.
+ * @param m1 The left operand.
+ * @param m2 The matrix whose transpose is the right operand.
+ * @return 1 on success, 0 on failure.
+ */
+int dot_product_nt_into(Matrix* dest, const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes `dest = m1 + m2` element by element. `dest` may be `m1` or `m2`.
+ * @return 1 on success, 0 on failure.
+ */
+int matrix_add_into(Matrix* dest, const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes `dest = m1 - m2` element by element. `dest` may be `m1` or `m2`.
+ * @return 1 on success, 0 on failure.
+ */
+int matrix_subtract_into(Matrix* dest, const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes the Hadamard product `dest = m1 ⊙ m2`. `dest` may be `m1` or `m2`.
+ * @return 1 on success, 0 on failure.
+ */
+int matrix_elementwise_multiply_into(Matrix* dest, const Matrix* m1, const Matrix* m2);
+
+/**
+ * @brief Computes `dest = m * scalar`. `dest` may be `m`.
+ * @return 1 on success, 0 on failure.
+ */
+int matrix_scale_into(Matrix* dest, const Matrix* m, double scalar);
+
+/**
+ * @brief Copies `src` into `dest`, which must have the same dimensions.
+ * @details Unlike `matrix_copy_data()`, a shape mismatch is reported as an error.
+ * @return 1 on success, 0 on failure.
+ */
+int matrix_copy_into(Matrix* dest, const Matrix* src);
+
+/**
+ * @brief Copies row `row` of `m` into the `1 x m->cols` matrix `dest`.
+ * @return 1 on success, 0 on failure (including an out-of-range `row`).
+ */
+int matrix_get_row_into(Matrix* dest, const Matrix* m, int row);
+
+// The `_view` variants below take their read-only operands as views, so rows,
+// row ranges and sub-blocks of larger matrices can be used without copying.
+// They follow the same rules as the `Matrix` versions above; an empty view is
+// reported as `GANN_ERROR_NULL_ARGUMENT`.
+
+/** @brief `dest = a · b` on views. `dest` must not overlap `a` or `b`. @return 1 on success, 0 on failure. */
+int dot_product_view_into(Matrix* dest, MatrixView a, MatrixView b);
+
+/** @brief `dest = aᵀ · b` on views. `dest` must not overlap `a` or `b`. @return 1 on success, 0 on failure. */
+int dot_product_tn_view_into(Matrix* dest, MatrixView a, MatrixView b);
+
+/** @brief `c += aᵀ · b` on views. `c` must not overlap `a` or `b`. @return 1 on success, 0 on failure. */
+int dot_product_tn_view_accumulate(Matrix* c, MatrixView a, MatrixView b);
+
+/** @brief `dest = a · bᵀ` on views. `dest` must not overlap `a` or `b`. @return 1 on success, 0 on failure. */
+int dot_product_nt_view_into(Matrix* dest, MatrixView a, MatrixView b);
+
+/** @brief `dest = a + b` on views. @return 1 on success, 0 on failure. */
+int matrix_add_view_into(Matrix* dest, MatrixView a, MatrixView b);
+
+/** @brief `dest = a - b` on views. @return 1 on success, 0 on failure. */
+int matrix_subtract_view_into(Matrix* dest, MatrixView a, MatrixView b);
+
+/** @brief `dest = a ⊙ b` on views. @return 1 on success, 0 on failure. */
+int matrix_elementwise_multiply_view_into(Matrix* dest, MatrixView a, MatrixView b);
+
+/** @brief `dest = m * scalar` on a view. @return 1 on success, 0 on failure. */
+int matrix_scale_view_into(Matrix* dest, MatrixView m, double scalar);
+
+/** @brief Copies the elements of a view into `dest`, which must have its shape. @return 1 on success, 0 on failure. */
+int matrix_copy_view_into(Matrix* dest, MatrixView src);
+
+/**
+ * @brief Adds a `1 x N` bias view to each row of `m`, in place.
+ * @details The view counterpart of `add_bias()`, reporting errors the same way.
+ */
+void add_bias_view(Matrix* m, MatrixView bias);
+
+/** @brief In-place addition: `m += other`. @return 1 on success, 0 on failure. */
+int matrix_add_inplace(Matrix* m, const Matrix* other);
+
+/** @brief In-place subtraction: `m -= other`. @return 1 on success, 0 on failure. */
+int matrix_subtract_inplace(Matrix* m, const Matrix* other);
+
+/** @brief In-place Hadamard product: `m ⊙= other`. @return 1 on success, 0 on failure. */
+int matrix_elementwise_multiply_inplace(Matrix* m, const Matrix* other);
+
+/** @brief In-place scaling: `m *= scalar`. @return 1 on success, 0 on failure. */
+int matrix_scale_inplace(Matrix* m, double scalar);
+
+// --- Batched Products ---
+// Many products of the same shape in one call, such as one layer of every
+// network of a population on the same inputs. Each product on its own may be
+// too small to keep the cores busy or to amortize packing its inputs; a batch
+// is scheduled across the threads as a whole, and products that share their
+// left operand pack it once for all of them. Each result is exactly what
+// `dot_product_view_into()` computes for that product.
+
+/**
+ * @brief Computes `dest[t] = a[t] · b[t]` for `count` products of the same shape.
+ * @details Consecutive products whose left operands are the same view (same
+ * `values` and `stride`) share its packing, so pass the same view `count`
+ * times to multiply one input by many weight matrices.
+ * @param count The number of products.
+ * @param dest `count` result matrices, each `a[t].rows x b[t].cols`. None may overlap an operand.
+ * @param a `count` left operands, all with the shape of `a[0]`.
+ * @param b `count` right operands, all with the shape of `b[0]`.
+ * @return 1 on success, 0 on failure.
+ */
+int dot_product_batch_into(int count, Matrix* const* dest, const MatrixView* a, const MatrixView* b);
+
+/**
+ * @brief Computes `count` products whose operands lie at fixed distances in memory.
+ * @details Product `t` multiplies the view `a` moved `t * stride_a` elements
+ * forward by the view `b` moved `t * stride_b` elements forward, and writes
+ * rows `t * a.rows` to `(t + 1) * a.rows - 1` of `dest`. A `stride_a` of 0
+ * shares one left operand across the batch.
+ * @param count The number of products.
+ * @param dest The `count * a.rows x b.cols` results, stacked. Must not overlap an operand.
+ * @param a The left operand of product 0.
+ * @param stride_a The distance, in elements, between consecutive left operands.
+ * @param b The right operand of product 0.
+ * @param stride_b The distance, in elements, between consecutive right operands.
+ * @return 1 on success, 0 on failure.
+ */
+int dot_product_batch_strided_into(int count, Matrix* dest, MatrixView a, size_t stride_a, MatrixView b, size_t stride_b);
+
+// --- Sparse Matrices ---
+
+/**
+ * @brief A matrix in compressed sparse row (CSR) form.
+ * @details Only the nonzero elements are stored. The nonzeros of row `i` are
+ * `values[p]` at column `col_index[p]` for `p` in `[row_start[i], row_start[i + 1])`,
+ * in increasing column order. Products with a sparse operand cost time
+ * proportional to its nonzeros instead of its size.
+ *
+ * Sparse products do less arithmetic but cannot use the blocked dense kernels,
+ * so they only pay off below a crossover density. Measured with
+ * `bench/bench_spmm` on this library's layer shapes (a 32-row minibatch
+ * through 784x128, 128x64 and 64x10 layers, float and double), the sparse
+ * operand wins up to about:
+ * - 70% density for sparse inputs times dense weights (`sparse_dot_product_into()`);
+ * - 30% for the weight gradient of sparse inputs (`sparse_dot_product_tn_accumulate()`);
+ * - 20% for activations times pruned weights (`dot_product_sparse_into()`).
+ */
+typedef struct {
+    int rows;          /**< The number of rows of the matrix. */
+    int cols;          /**< The number of columns of the matrix. */
+    int nnz;           /**< The number of stored elements. */
+    int* row_start;    /**< `rows + 1` offsets into `col_index` and `values`; `row_start[rows] == nnz`. */
+    int* col_index;    /**< The column of each stored element. */
+    gann_real* values; /**< The stored elements. */
+} SparseMatrix;
+
+/**
+ * @brief Converts a dense matrix (or view) to CSR, dropping small elements.
+ * @details Elements with `|x| <= threshold` are not stored, so a threshold of 0
+ * keeps exactly the nonzeros and a positive threshold prunes weights by magnitude.
+ * @param m The matrix to convert.
+ * @param threshold The largest magnitude that is treated as zero (`>= 0`).
+ * @return The new sparse matrix, or `NULL` on failure. Free it with `free_sparse_matrix()`.
+ */
+SparseMatrix* sparse_matrix_from_view(MatrixView m, double threshold);
+
+/** @brief `sparse_matrix_from_view()` on a whole matrix. @return The new sparse matrix, or `NULL` on failure. */
+SparseMatrix* sparse_matrix_from_dense(const Matrix* m, double threshold);
+
+/**
+ * @brief Expands a sparse matrix into a new dense one.
+ * @param s The sparse matrix.
+ * @return The dense matrix, or `NULL` on failure. Free it with `free_matrix()`.
+ */
+Matrix* sparse_matrix_to_dense(const SparseMatrix* s);
+
+/**
+ * @brief Returns the fraction of elements that are stored, `nnz / (rows * cols)`.
+ * @param s The sparse matrix.
+ * @return The density in `[0, 1]`, or 0 for `NULL` or an empty matrix.
+ */
+double sparse_matrix_density(const SparseMatrix* s);
+
+/**
+ * @brief Frees a sparse matrix. It is safe to pass `NULL`.
+ * @param s The sparse matrix to free.
+ */
+void free_sparse_matrix(SparseMatrix* s);
+
+/**
+ * @brief Computes `dest = a · b` for a sparse `a`, e.g. a batch of sparse inputs times a weight matrix.
+ * @param dest The `a->rows x b.cols` result matrix. Must not overlap `b`.
+ * @param a The sparse left operand.
+ * @param b The dense right operand (`a->cols` rows).
+ * @return 1 on success, 0 on failure.
+ */
+int sparse_dot_product_into(Matrix* dest, const SparseMatrix* a, MatrixView b);
+
+/**
+ * @brief Computes `dest = a · b` for a sparse `b`, e.g. activations times pruned weights.
+ * @details Zero elements of `a` are skipped as well.
+ * @param dest The `a.rows x b->cols` result matrix. Must not overlap `a`.
+ * @param a The dense left operand (`b->rows` columns).
+ * @param b The sparse right operand.
+ * @return 1 on success, 0 on failure.
+ */
+int dot_product_sparse_into(Matrix* dest, MatrixView a, const SparseMatrix* b);
+
+/**
+ * @brief Accumulates `c += aᵀ · b` for a sparse `a`: the weight gradient of a layer with sparse inputs.
+ * @details Only the rows of `c` that match a stored column of `a` are touched.
+ * @param c The `a->cols x b.cols` matrix to accumulate into. Must not overlap `b`.
+ * @param a The sparse matrix whose transpose is the left operand (e.g. a minibatch of inputs).
+ * @param b The dense right operand (`a->rows` rows, e.g. the layer's deltas).
+ * @return 1 on success, 0 on failure.
+ */
+int sparse_dot_product_tn_accumulate(Matrix* c, const SparseMatrix* a, MatrixView b);
+
+/**
+ * @brief Returns how many matrices the calling thread has created so far.
+ * @details Every successful `create_matrix()` or `matrix_wrap()` call (including those made inside
+ * other library functions) increments the count. Comparing it before and after a
+ * loop shows whether the loop allocates matrices.
+ * @return The number of matrices created by the calling thread.
+ */
+size_t matrix_get_allocation_count(void);
+
 
 #endif // MATRIX_H
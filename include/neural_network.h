@@ -2,7 +2,9 @@
 #define NEURAL_NETWORK_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include "matrix.h"
+#include "gann_arena.h"
 
 // --- Struct Definitions ---
 
@@ -13,9 +15,35 @@ typedef enum {
     SIGMOID,    /**< Sigmoid activation function. Maps input to a range between 0 and 1. */
     RELU,       /**< Rectified Linear Unit (ReLU) activation function. Returns `max(0, x)`. */
     LEAKY_RELU,  /**< Leaky ReLU activation function. A variant of ReLU that allows a small, non-zero gradient when the unit is not active. */
-    LINEAR      /**< Linear activation function. Returns the input value unchanged. Useful for output layers in regression tasks. */
+    LINEAR,     /**< Linear activation function. Returns the input value unchanged. Useful for output layers in regression tasks. */
+    SOFTMAX     /**< Softmax, for the output layer only: maps each row of outputs to probabilities that sum to 1. Backpropagation then minimizes the cross-entropy (see `calculate_cross_entropy()`). */
 } ActivationType;
 
+/**
+ * @brief Enumeration of the element precisions a network file can be stored in.
+ * @details See `nn_save_as()`. `nn_load()` accepts every format and converts the
+ * parameters to `gann_real` as it reads them.
+ */
+typedef enum {
+    NN_FILE_FLOAT64, /**< 8-byte doubles in the original, untagged layout that every library version reads. */
+    NN_FILE_FLOAT32, /**< 4-byte floats behind a tagged header; half the size of a float64 file. */
+    NN_FILE_FLOAT16, /**< IEEE half-precision (fp16) weights and native-precision biases; about a quarter of the size of a float64 file. */
+    NN_FILE_BFLOAT16 /**< bfloat16 weights and native-precision biases; about a quarter of the size of a float64 file. */
+} NNFileFormat;
+
+/**
+ * @brief Enumeration of the precisions a network can keep its weights in.
+ * @details See `nn_set_weight_storage()`. The 16-bit formats halve (float
+ * build) or quarter (double build) the memory of the weights. They are widened
+ * to `gann_real` as the matrix-product kernels read them, so all arithmetic
+ * still runs and accumulates in `gann_real`. Biases always stay in `gann_real`.
+ */
+typedef enum {
+    NN_STORAGE_NATIVE, /**< `gann_real` weight matrices in `weights`; the default, and the only storage that can be trained. */
+    NN_STORAGE_FP16,   /**< IEEE half precision: 11 significant bits, magnitudes up to 65504. */
+    NN_STORAGE_BF16    /**< bfloat16: 8 significant bits, the full float range. */
+} NNWeightStorage;
+
 /**
  * @brief Represents the state for optimizers like Adam and RMSprop.
  * @details This struct holds the moving averages of the gradients required by
@@ -43,10 +71,15 @@ typedef struct {
     ActivationType activation_hidden; /**< The activation function used for all hidden layers. */
     ActivationType activation_output; /**< The activation function used for the output layer. */
     OptimizerState* optimizer_state;  /**< A pointer to the optimizer state, used only for backpropagation training. `NULL` otherwise. */
+    NNWeightStorage weight_storage;   /**< The precision of the weights. Anything but `NN_STORAGE_NATIVE` keeps them in `weights_16` and leaves `weights` `NULL`. */
+    uint16_t** weights_16;            /**< With 16-bit storage, `weights_16[i]` holds the `architecture[i] x architecture[i+1]` weights row-major. `NULL` otherwise. */
+    gann_real* parameters;            /**< The single aligned block all weights and biases live in; the matrices above are views into it. See `nn_get_parameters()`. */
+    size_t num_parameters;            /**< The number of `gann_real` values in `parameters`: every weight and bias, or with 16-bit storage the biases only (the 16-bit weights follow them in the same block). */
 } NeuralNetwork;
 
 /**
  * @brief Applies an activation function element-wise to a matrix, modifying it in place.
+ * @details `SOFTMAX` is not element-wise: it normalizes each row of `m`.
  * @param m The matrix to modify.
  * @param activation_type The type of activation function to apply (e.g., `SIGMOID`, `RELU`).
  */
@@ -72,12 +105,78 @@ void nn_apply_activation_derivative(Matrix* m, ActivationType activation_type);
  * The caller is responsible for freeing the network using `nn_free()`.
  * @param num_layers The total number of layers (input, hidden, and output).
  * @param architecture An array of integers specifying the number of neurons in each layer. A deep copy of this array is made.
- * @param activation_hidden The activation function to be used for the hidden layers.
+ * @param activation_hidden The activation function to be used for the hidden layers. `SOFTMAX` is only valid for the output layer.
  * @param activation_output The activation function to be used for the output layer.
- * @return A pointer to the newly created `NeuralNetwork`, or `NULL` if allocation fails.
+ * @return A pointer to the newly created `NeuralNetwork`, or `NULL` on failure
+ *         (`GANN_ERROR_INVALID_PARAM` for a `SOFTMAX` hidden activation).
  */
 NeuralNetwork* nn_create(int num_layers, const int* architecture, ActivationType activation_hidden, ActivationType activation_output);
 
+/**
+ * @brief Like `nn_create()`, but keeps the weights in the given precision.
+ * @details With a 16-bit `storage` no `gann_real` weight matrices are ever
+ * allocated, which is what keeps a large population small.
+ * @param storage The weight precision (see `NNWeightStorage`).
+ * @return The new network, or `NULL` on failure (`GANN_ERROR_INVALID_PARAM` for an unknown storage).
+ */
+NeuralNetwork* nn_create_with_storage(int num_layers, const int* architecture, ActivationType activation_hidden,
+                                      ActivationType activation_output, NNWeightStorage storage);
+
+/**
+ * @brief Converts a network's weights to another precision, in place.
+ * @details Narrowing rounds every weight to the nearest representable value;
+ * widening back to `NN_STORAGE_NATIVE` is exact. The network computes the same
+ * outputs, up to that rounding, in every storage. Only `NN_STORAGE_NATIVE`
+ * networks can be trained with backpropagation, so a network with an optimizer
+ * state cannot be narrowed.
+ * @param net The network to convert.
+ * @param storage The new weight precision.
+ * @return 1 on success, 0 on failure (`GANN_ERROR_INVALID_PARAM` for an unknown
+ *         storage or a network that has an optimizer state).
+ */
+int nn_set_weight_storage(NeuralNetwork* net, NNWeightStorage storage);
+
+/**
+ * @brief Reads one weight, whatever the network's storage.
+ * @details For genetic operators and other code that must work on every
+ * storage. Like indexing a matrix, the arguments are not checked.
+ * @param net The network.
+ * @param layer The weight matrix, from 0 to `net->num_layers - 2`.
+ * @param row The input neuron, from 0 to `architecture[layer] - 1`.
+ * @param col The output neuron, from 0 to `architecture[layer + 1] - 1`.
+ * @return The weight, widened to `gann_real`.
+ */
+gann_real nn_get_weight(const NeuralNetwork* net, int layer, int row, int col);
+
+/**
+ * @brief Writes one weight, rounding it to the network's storage.
+ * @details The counterpart of `nn_get_weight()`; the arguments are not checked.
+ * Copying a weight between two networks of the same storage is exact.
+ * @param net The network.
+ * @param layer The weight matrix.
+ * @param row The input neuron.
+ * @param col The output neuron.
+ * @param value The new weight.
+ */
+void nn_set_weight(NeuralNetwork* net, int layer, int row, int col, gann_real value);
+
+/**
+ * @brief Returns the network's weights and biases as one flat array.
+ * @details Every network keeps its parameters in a single aligned buffer that
+ * the `weights` and `biases` matrices are views into: layer 0's weights
+ * (row-major), then its biases, then layer 1's weights and biases, and so on,
+ * with no padding in between, which is also the order `nn_save()` writes them
+ * in. Only the start of the buffer is aligned to `MATRIX_ALIGNMENT`. Writes through the
+ * returned pointer change the network, and two networks of the same
+ * architecture can be copied or recombined element by element. The buffer
+ * lives as long as the network or until `nn_set_weight_storage()` converts it.
+ * @param net The network. Its weights must be in `NN_STORAGE_NATIVE`.
+ * @param count Receives the number of parameters. May be `NULL`.
+ * @return The parameters, or `NULL` on failure (`GANN_ERROR_INVALID_PARAM` for
+ *         a network with 16-bit weight storage).
+ */
+gann_real* nn_get_parameters(const NeuralNetwork* net, size_t* count);
+
 /**
  * @brief Initializes the optimizer state for a neural network.
  * @details This function allocates memory for the `OptimizerState` struct and its
@@ -107,18 +206,227 @@ void nn_init(NeuralNetwork* net);
 
 /**
  * @brief Performs a forward pass through the network to compute an output.
+ * @details Runs through `nn_forward_pass_batch()`, so any number of input rows
+ * may be passed at once.
  * @param net The neural network.
- * @param input The input matrix, with dimensions `1 x num_input_neurons`.
- * @return A new matrix containing the output of the network, with dimensions `1 x num_output_neurons`.
+ * @param input The input matrix, with dimensions `rows x num_input_neurons`.
+ * @return A new matrix containing the output of the network, with dimensions `rows x num_output_neurons`.
  * The caller is responsible for freeing this matrix using `free_matrix()`.
  * @return `NULL` on failure (e.g., invalid input dimensions).
  */
 Matrix* nn_forward_pass(const NeuralNetwork* net, const Matrix* input);
 
+/** @brief The number of rows `nn_forward_pass_batch()` runs through the layers at a time, unless changed. */
+#define NN_DEFAULT_FORWARD_BATCH_SIZE 64
+
+/**
+ * @brief Runs many input rows through the network, one matrix product per layer and batch.
+ * @details One sample at a time, every layer is a matrix-vector product that
+ * reads each weight once per sample. Here the rows are taken in batches of
+ * `nn_get_forward_batch_size()`, so each weight loaded into cache serves the
+ * whole batch. The hidden layers of a batch live in the scratch arena; the
+ * output layer is written straight into `outputs`.
+ *
+ * `gann_predict()`, `gann_evaluate()`, `calculate_mse()` and the fitness
+ * evaluation of `gann_evolve()` all run on this function.
+ * @param net The neural network.
+ * @param inputs The input rows, `B x num_input_neurons`; a dataset's images can
+ * be passed whole or through `matrix_view_rows()`.
+ * @param outputs Receives the network outputs, `B x num_output_neurons`. Must not
+ * overlap `inputs`.
+ * @return 1 on success, 0 on failure (e.g., invalid dimensions).
+ */
+int nn_forward_pass_batch(const NeuralNetwork* net, MatrixView inputs, Matrix* outputs);
+
+/**
+ * @brief Sets how many rows `nn_forward_pass_batch()` runs through the layers at a time.
+ * @details Larger batches reuse each weight more often but need larger hidden
+ * layer buffers; the default, `NN_DEFAULT_FORWARD_BATCH_SIZE`, keeps the hidden
+ * layers of a typical MNIST network within L2. The batch size can change the
+ * rounding of the outputs, as any change of the product shapes can. It may be
+ * called from any thread, also while other threads are running batched passes:
+ * a call already under way finishes with the size it started with, and later
+ * calls use the new one.
+ * @param batch_size The number of rows, at least 1.
+ * @return 1 on success, 0 if `batch_size` is out of range.
+ */
+int nn_set_forward_batch_size(int batch_size);
+
+/**
+ * @brief Returns the number of rows `nn_forward_pass_batch()` runs at a time.
+ */
+int nn_get_forward_batch_size(void);
+
+/**
+ * @brief Two single-row activation buffers for running one network one sample at a time.
+ * @details Created once per network and thread with
+ * `gann_inference_context_create()`. The layers alternate between the two
+ * buffers, each as wide as the widest layer, so `nn_forward_ctx()` and
+ * `gann_predict_ctx()` never touch the heap or the scratch arena. The context
+ * also lists the nonzero entries of each input, so mostly blank inputs such as
+ * drawn digits take the sparse first layer (see `nn_layer_forward_sparse_into()`). A context
+ * holds a pointer to its network, which must outlive it; the network's
+ * weights may change between calls.
+ *
+ * Calls through a context are reentrant. They only read the network, write
+ * only the context and the calling thread's error code, and never touch the
+ * thread pool, a BLAS, the scratch arena or any global setting: the kernels
+ * and the sigmoid mode are the ones selected when the context was created,
+ * whatever `gann_simd_set_level()` or `gann_simd_set_sigmoid_mode()` chooses
+ * later. So any number of threads can serve
+ * predictions from one shared network, each through its own context, as long
+ * as no thread modifies the network meanwhile (training, mutation,
+ * `nn_set_weight_storage()`). A context itself must not be used by two
+ * threads at once.
+ */
+typedef struct GannInferenceContext GannInferenceContext;
+
+/**
+ * @brief Creates an inference context for `net`.
+ * @param net The network the context will run.
+ * @return The context, or `NULL` on failure. Free it with `gann_inference_context_free()`.
+ */
+GannInferenceContext* gann_inference_context_create(const NeuralNetwork* net);
+
+/**
+ * @brief Frees an inference context. It's safe to pass `NULL`.
+ */
+void gann_inference_context_free(GannInferenceContext* ctx);
+
+/**
+ * @brief Runs one input row through the context's network without allocating.
+ * @param ctx The inference context.
+ * @param input `num_input_neurons` values, read in place.
+ * @return The `num_output_neurons` outputs, held in the context until the next
+ * call on it, or `NULL` if an argument is `NULL`.
+ */
+const gann_real* nn_forward_ctx(GannInferenceContext* ctx, const gann_real* input);
+
+/**
+ * @brief Allocates the per-layer output buffers used by `nn_forward_pass_into()`.
+ * @param net The neural network the buffers are for.
+ * @param rows The number of samples (rows) the buffers hold; 1 for a single sample.
+ * @return An array of `net->num_layers - 1` matrices, where element `l` is a
+ * `rows x architecture[l + 1]` matrix. Free it with `nn_free_layer_buffers()`.
+ * Returns `NULL` on failure.
+ */
+Matrix** nn_create_layer_buffers(const NeuralNetwork* net, int rows);
+
+/**
+ * @brief Like `nn_create_layer_buffers()`, but takes the buffers from an arena.
+ * @details The buffers are released by resetting the arena to a mark taken
+ * before this call; they must not be passed to `nn_free_layer_buffers()`.
+ * @param net The neural network the buffers are for.
+ * @param rows The number of samples (rows) the buffers hold.
+ * @param arena The arena to allocate from.
+ * @return The buffer array, or `NULL` on failure.
+ */
+Matrix** nn_create_layer_buffers_arena(const NeuralNetwork* net, int rows, GannArena* arena);
+
+/**
+ * @brief Frees buffers created by `nn_create_layer_buffers()`.
+ * @param buffers The buffer array to free. It's safe to pass `NULL`.
+ * @param num_layers The `num_layers` of the network the buffers were created for.
+ */
+void nn_free_layer_buffers(Matrix** buffers, int num_layers);
+
+/**
+ * @brief Performs a forward pass into caller-provided buffers, without allocating.
+ * @details Layer `l`'s activations are written to `layer_outputs[l]`; the network
+ * output is `layer_outputs[net->num_layers - 2]`. Reusing the same buffers across
+ * calls makes repeated inference allocation-free.
+ * @param net The neural network.
+ * @param input The input matrix, `rows x num_input_neurons`.
+ * @param layer_outputs Buffers from `nn_create_layer_buffers(net, rows)`.
+ * @return 1 on success, 0 on failure (e.g., invalid input dimensions).
+ */
+int nn_forward_pass_into(const NeuralNetwork* net, const Matrix* input, Matrix** layer_outputs);
+
+/**
+ * @brief Like `nn_forward_pass_into()`, but reads the input through a view.
+ * @details Lets a dataset row or a range of rows (`matrix_view_rows()`) be fed
+ * to the network without copying it first. The buffers must have `input.rows` rows.
+ * @return 1 on success, 0 on failure.
+ */
+int nn_forward_pass_view_into(const NeuralNetwork* net, MatrixView input, Matrix** layer_outputs);
+
+/**
+ * @brief Runs one layer of the network: `output = f(input * W + b)`.
+ * @details The bias and the activation are applied by the matrix-product
+ * kernel as it writes each tile of `output`, so the layer is a single pass over
+ * its output. This is the building block of `nn_forward_pass_view_into()`.
+ * @param net The neural network.
+ * @param layer The layer index, from 0 to `net->num_layers - 2`.
+ * @param input The layer input, `rows x net->architecture[layer]`.
+ * @param output Receives the activations, `rows x net->architecture[layer + 1]`.
+ * @param z If not `NULL`, also receives the pre-activation values `input * W + b`
+ *          (same shape as `output`), as the backward pass needs them.
+ * @return 1 on success, 0 on failure (invalid layer, mismatched dimensions, or an
+ *         output that overlaps the input or `z`).
+ */
+int nn_layer_forward_into(const NeuralNetwork* net, int layer, MatrixView input, Matrix* output, Matrix* z);
+
+/**
+ * @brief The largest fraction of nonzero inputs for which the sparse first-layer
+ * kernel is used; denser inputs fall back to the dense kernel.
+ * @details Measured with `bench/bench_sparse`: on a 784 x 128 first layer the
+ * sparse kernel stays ahead of the dense one up to about 80% (float) to 85%
+ * (double) nonzeros; MNIST images are about 19% nonzero.
+ */
+#define NN_SPARSE_MAX_DENSITY 0.8
+
+/**
+ * @brief Runs the first layer on one input row, skipping its zero entries.
+ * @details Like `nn_layer_forward_into()` for layer 0, but only the weight rows
+ * of the listed input columns are read, so an input that is 80% zeros costs a
+ * fifth of the dense product. If more than `NN_SPARSE_MAX_DENSITY` of the inputs
+ * are listed, the dense kernel runs instead. The values themselves are read
+ * from `input`; columns that are not listed must be zero there. Networks with
+ * 16-bit weight storage always run the dense kernel.
+ * @param net The neural network.
+ * @param input One input row, `1 x net->architecture[0]`.
+ * @param nonzero_columns The columns of `input` that may be nonzero, each in `[0, net->architecture[0])`.
+ * @param num_nonzero The number of entries in `nonzero_columns`.
+ * @param output Receives the activations, `1 x net->architecture[1]`.
+ * @param z If not `NULL`, also receives the pre-activation values.
+ * @return 1 on success, 0 on failure (sets the error code).
+ */
+int nn_layer_forward_sparse_into(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                                 Matrix* output, Matrix* z);
+
+/**
+ * @brief Like `nn_forward_pass_view_into()` for one input row, with the sparse first layer.
+ * @details See `nn_layer_forward_sparse_into()`. Evaluation, fitness and
+ * training list the nonzero pixels of every image themselves.
+ * @return 1 on success, 0 on failure.
+ */
+int nn_forward_pass_sparse_into(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                                Matrix** layer_outputs);
+
+/**
+ * @brief Runs one layer with pruned weights: `output = f(input * W + b)` for a sparse `W`.
+ * @details Like `nn_layer_forward_into()`, but the product reads `weights`, a
+ * sparse copy of the layer's weight matrix (typically
+ * `sparse_matrix_from_dense(net->weights[layer], threshold)`), instead of
+ * `net->weights[layer]`. The bias and activation still come from the network.
+ * This pays off for layers pruned to about 20% of their weights or fewer (see
+ * `SparseMatrix` for the measured crossovers).
+ * @param net The neural network.
+ * @param layer The layer index, from 0 to `net->num_layers - 2`.
+ * @param weights The pruned weights, with the shape of `net->weights[layer]`.
+ * @param input The layer input, `rows x net->architecture[layer]`.
+ * @param output Receives the activations, `rows x net->architecture[layer + 1]`.
+ * @param z If not `NULL`, also receives the pre-activation values.
+ * @return 1 on success, 0 on failure.
+ */
+int nn_layer_forward_pruned_into(const NeuralNetwork* net, int layer, const SparseMatrix* weights, MatrixView input,
+                                 Matrix* output, Matrix* z);
+
 /**
  * @brief Creates a deep copy of a neural network.
  * @details This function creates a new, independent copy of the source network,
- * including its architecture, weights, biases, and optimizer state.
+ * including its architecture, weights, biases, and optimizer state. The copy
+ * keeps the source's weight storage.
  * @param src_net The source network to clone.
  * @return A pointer to the newly cloned `NeuralNetwork`. The caller is responsible for
  * freeing this network using `nn_free()`. Returns `NULL` on failure.
@@ -127,16 +435,35 @@ NeuralNetwork* nn_clone(const NeuralNetwork* src_net);
 
 /**
  * @brief Saves a neural network's structure and parameters to a binary file.
+ * @details The parameters are written in the library's native precision:
+ * `NN_FILE_FLOAT32` in a `GANN_FLOAT32` build, `NN_FILE_FLOAT64` otherwise. A
+ * network with 16-bit weight storage is written in that format instead
+ * (`NN_FILE_FLOAT16` or `NN_FILE_BFLOAT16`) with native-precision biases, so
+ * it is saved exactly.
  * @param net The neural network to save.
  * @param filepath The path to the file where the network will be saved.
  * @return 1 on success, 0 on failure (e.g., file could not be opened).
  */
 int nn_save(const NeuralNetwork* net, const char* filepath);
 
+/**
+ * @brief Saves a neural network, storing its parameters in the given precision.
+ * @details Saving a double network as `NN_FILE_FLOAT32` rounds every parameter
+ * to the nearest float. The 16-bit formats round the weights only; the biases
+ * are written in the library's native precision.
+ * @param net The neural network to save.
+ * @param filepath The path to the file where the network will be saved.
+ * @param format The element precision to write.
+ * @return 1 on success, 0 on failure. Sets `GANN_ERROR_INVALID_PARAM` for an unknown format.
+ */
+int nn_save_as(const NeuralNetwork* net, const char* filepath, NNFileFormat format);
+
 /**
  * @brief Loads a neural network from a binary file.
  * @details This function reconstructs a neural network that was previously saved
- * using `nn_save()`.
+ * using `nn_save()` or `nn_save_as()`, in any `NNFileFormat`. A network read
+ * from an `NN_FILE_FLOAT16` or `NN_FILE_BFLOAT16` file keeps its weights in that
+ * storage; call `nn_set_weight_storage()` to widen them, e.g. for training.
  * @param filepath The path to the file to load.
  * @return A pointer to the loaded `NeuralNetwork`. The caller is responsible for freeing
  * this network using `nn_free()`. Returns `NULL` on failure (e.g., file not found, format error).
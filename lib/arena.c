@@ -0,0 +1,212 @@
+#include "gann_arena.h"
+#include "gann_errors.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// --- Arena Layout ---
+// The arena is a stack of chunks. Positions are byte offsets into the logical
+// concatenation of all chunks, so a mark stays meaningful across chunk
+// boundaries: chunk `c` covers positions [c->base, c->base + c->size).
+
+#define ARENA_DEFAULT_CAPACITY ((size_t)64 * 1024)
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* prev; // The chunk below this one, or NULL
+    size_t base;             // Position of the first byte of `data`
+    size_t size;             // Usable bytes in `data`
+    unsigned char* data;     // MATRIX_ALIGNMENT-aligned, inside the same block as the header
+} ArenaChunk;
+
+struct GannArena {
+    ArenaChunk* top;         // The chunk allocations are served from
+    size_t offset;           // Bytes used in `top`
+    size_t high_water;
+    size_t chunk_allocations;
+};
+
+static size_t align_up(size_t size) {
+    return (size + MATRIX_ALIGNMENT - 1) & ~(size_t)(MATRIX_ALIGNMENT - 1);
+}
+
+static ArenaChunk* chunk_alloc(size_t size, size_t base) {
+    size_t header = align_up(sizeof(ArenaChunk));
+    if (size > SIZE_MAX - header) return NULL;
+#if defined(_WIN32)
+    unsigned char* block = (unsigned char*)_aligned_malloc(header + size, MATRIX_ALIGNMENT);
+    if (!block) return NULL;
+#else
+    void* raw = NULL;
+    if (posix_memalign(&raw, MATRIX_ALIGNMENT, header + size) != 0) return NULL;
+    unsigned char* block = (unsigned char*)raw;
+#endif
+    ArenaChunk* chunk = (ArenaChunk*)block;
+    chunk->prev = NULL;
+    chunk->base = base;
+    chunk->size = size;
+    chunk->data = block + header;
+    return chunk;
+}
+
+static void chunk_free(ArenaChunk* chunk) {
+#if defined(_WIN32)
+    _aligned_free(chunk);
+#else
+    free(chunk);
+#endif
+}
+
+static size_t arena_position(const GannArena* arena) {
+    return arena->top->base + arena->offset;
+}
+
+// Replaces every chunk with a single one of `capacity` bytes. Called only when
+// nothing is allocated; on failure the arena keeps its current chunks.
+static int arena_rebuild(GannArena* arena, size_t capacity) {
+    ArenaChunk* chunk = chunk_alloc(align_up(capacity), 0);
+    if (!chunk) return 0;
+    arena->chunk_allocations++;
+    while (arena->top) {
+        ArenaChunk* prev = arena->top->prev;
+        chunk_free(arena->top);
+        arena->top = prev;
+    }
+    arena->top = chunk;
+    arena->offset = 0;
+    return 1;
+}
+
+// --- Public API Functions ---
+
+GannArena* gann_arena_create(size_t capacity) {
+    GannArena* arena = (GannArena*)calloc(1, sizeof(GannArena));
+    if (!arena) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    arena->top = chunk_alloc(align_up(capacity > 0 ? capacity : ARENA_DEFAULT_CAPACITY), 0);
+    if (!arena->top) {
+        free(arena);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    arena->chunk_allocations = 1;
+    gann_set_error(GANN_SUCCESS);
+    return arena;
+}
+
+void gann_arena_free(GannArena* arena) {
+    if (arena == NULL) return;
+    while (arena->top) {
+        ArenaChunk* prev = arena->top->prev;
+        chunk_free(arena->top);
+        arena->top = prev;
+    }
+    free(arena);
+}
+
+void* gann_arena_alloc(GannArena* arena, size_t size) {
+    if (arena == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    size_t start = align_up(arena->offset);
+    if (start > arena->top->size || size > arena->top->size - start) {
+        // Chain a chunk at least twice as large as the current one; the unused
+        // tail of the current chunk counts towards the position.
+        size_t chunk_size = arena->top->size * 2;
+        if (chunk_size < size) chunk_size = size;
+        ArenaChunk* chunk = chunk_alloc(align_up(chunk_size), arena->top->base + arena->top->size);
+        if (!chunk) {
+            gann_set_error(GANN_ERROR_ALLOC_FAILED);
+            return NULL;
+        }
+        arena->chunk_allocations++;
+        chunk->prev = arena->top;
+        arena->top = chunk;
+        start = 0;
+    }
+    arena->offset = start + size;
+    size_t position = arena_position(arena);
+    if (position > arena->high_water) arena->high_water = position;
+    return arena->top->data + start;
+}
+
+size_t gann_arena_mark(const GannArena* arena) {
+    return arena ? arena_position(arena) : 0;
+}
+
+void gann_arena_reset_to(GannArena* arena, size_t mark) {
+    if (arena == NULL || mark > arena_position(arena)) return;
+    while (arena->top->prev && mark < arena->top->base) {
+        ArenaChunk* prev = arena->top->prev;
+        chunk_free(arena->top);
+        arena->top = prev;
+    }
+    arena->offset = mark - arena->top->base;
+    // Once empty, merge an overflowed arena into one block that fits the whole workload.
+    if (mark == 0 && arena->high_water > arena->top->size) {
+        arena_rebuild(arena, arena->high_water);
+    }
+}
+
+void gann_arena_reset(GannArena* arena) {
+    gann_arena_reset_to(arena, 0);
+}
+
+int gann_arena_reserve(GannArena* arena, size_t capacity) {
+    if (arena == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (arena_position(arena) != 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (capacity > arena->top->size && !arena_rebuild(arena, capacity)) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return 0;
+    }
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+void gann_arena_get_stats(const GannArena* arena, GannArenaStats* stats) {
+    if (arena == NULL || stats == NULL) return;
+    stats->capacity = 0;
+    for (const ArenaChunk* chunk = arena->top; chunk; chunk = chunk->prev) {
+        stats->capacity += chunk->size;
+    }
+    stats->used = arena_position(arena);
+    stats->high_water = arena->high_water;
+    stats->chunk_allocations = arena->chunk_allocations;
+}
+
+// --- Per-Thread Scratch Arena ---
+// The thread-local pointer gives fast access; the pthread key only exists so the
+// arena is freed when its thread exits.
+
+static GANN_THREAD_LOCAL GannArena* g_scratch_arena = NULL;
+static pthread_key_t g_scratch_key;
+static pthread_once_t g_scratch_key_once = PTHREAD_ONCE_INIT;
+
+static void scratch_arena_destroy(void* arena) {
+    gann_arena_free((GannArena*)arena);
+}
+
+static void scratch_key_create(void) {
+    pthread_key_create(&g_scratch_key, scratch_arena_destroy);
+}
+
+GannArena* gann_scratch_arena(void) {
+    if (g_scratch_arena == NULL) {
+        g_scratch_arena = gann_arena_create(0);
+        if (g_scratch_arena == NULL) return NULL; // gann_arena_create sets the error
+        pthread_once(&g_scratch_key_once, scratch_key_create);
+        pthread_setspecific(g_scratch_key, g_scratch_arena);
+    }
+    return g_scratch_arena;
+}
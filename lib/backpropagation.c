@@ -7,27 +7,31 @@
 
 
 #include "gann.h"
+#include "simd_kernels.h"
+#include "gemm.h"
+#include "nn_kernels.h"
 #include <math.h>
 
 // --- Optimizer-specific Weight Update Functions ---
 
+// Number of parameters in a weight or bias matrix. Gradients and optimizer
+// moments come from create_matrix, and the weights and biases are matrix_wrap
+// views into the network's parameter block; both have stride == cols, so each
+// matrix is one dense block.
+static size_t param_count(const Matrix* m) {
+    return (size_t)m->rows * m->cols;
+}
+
 void update_weights_sgd(NeuralNetwork* net, Matrix** weight_gradients, Matrix** bias_gradients, const GannBackpropParams* params, int batch_size) {
     if (net == NULL || weight_gradients == NULL || bias_gradients == NULL || params == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
+    const SimdKernels* kern = simd_kernels();
     double lr_batch = params->learning_rate / batch_size;
     for (int l = 0; l < net->num_layers - 1; l++) {
-        // Update weights
-        for(int r=0; r < net->weights[l]->rows; r++) {
-            for (int c=0; c < net->weights[l]->cols; c++) {
-                net->weights[l]->data[r][c] -= lr_batch * weight_gradients[l]->data[r][c];
-            }
-        }
-        // Update biases
-         for (int c=0; c < net->biases[l]->cols; c++) {
-            net->biases[l]->data[0][c] -= lr_batch * bias_gradients[l]->data[0][c];
-        }
+        kern->sgd_update(param_count(net->weights[l]), net->weights[l]->values, weight_gradients[l]->values, lr_batch);
+        kern->sgd_update(param_count(net->biases[l]), net->biases[l]->values, bias_gradients[l]->values, lr_batch);
     }
 }
 
@@ -36,26 +40,18 @@ void update_weights_rmsprop(NeuralNetwork* net, Matrix** weight_gradients, Matri
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
+    const SimdKernels* kern = simd_kernels();
     double lr = params->learning_rate;
     double beta2 = params->beta2;
     double epsilon = params->epsilon;
+    double grad_scale = 1.0 / batch_size;
     OptimizerState* opt_state = net->optimizer_state;
 
     for (int l = 0; l < net->num_layers - 1; l++) {
-        // Update weights
-        for (int r = 0; r < net->weights[l]->rows; r++) {
-            for (int c = 0; c < net->weights[l]->cols; c++) {
-                double grad = weight_gradients[l]->data[r][c] / batch_size;
-                opt_state->v_weights[l]->data[r][c] = beta2 * opt_state->v_weights[l]->data[r][c] + (1 - beta2) * (grad * grad);
-                net->weights[l]->data[r][c] -= (lr / (sqrt(opt_state->v_weights[l]->data[r][c]) + epsilon)) * grad;
-            }
-        }
-        // Update biases
-        for (int c = 0; c < net->biases[l]->cols; c++) {
-            double grad = bias_gradients[l]->data[0][c] / batch_size;
-            opt_state->v_biases[l]->data[0][c] = beta2 * opt_state->v_biases[l]->data[0][c] + (1 - beta2) * (grad * grad);
-            net->biases[l]->data[0][c] -= (lr / (sqrt(opt_state->v_biases[l]->data[0][c]) + epsilon)) * grad;
-        }
+        kern->rmsprop_update(param_count(net->weights[l]), net->weights[l]->values, opt_state->v_weights[l]->values,
+                             weight_gradients[l]->values, lr, beta2, epsilon, grad_scale);
+        kern->rmsprop_update(param_count(net->biases[l]), net->biases[l]->values, opt_state->v_biases[l]->values,
+                             bias_gradients[l]->values, lr, beta2, epsilon, grad_scale);
     }
 }
 
@@ -64,235 +60,238 @@ void update_weights_adam(NeuralNetwork* net, Matrix** weight_gradients, Matrix**
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
+    const SimdKernels* kern = simd_kernels();
     double lr = params->learning_rate;
     double beta1 = params->beta1;
     double beta2 = params->beta2;
     double epsilon = params->epsilon;
+    double grad_scale = 1.0 / batch_size;
+    // Bias correction factors depend only on the step, so compute them once per update.
+    double correction1 = 1.0 / (1 - pow(beta1, t));
+    double correction2 = 1.0 / (1 - pow(beta2, t));
     OptimizerState* opt_state = net->optimizer_state;
 
     for (int l = 0; l < net->num_layers - 1; l++) {
-        // Update weights
-        for (int r = 0; r < net->weights[l]->rows; r++) {
-            for (int c = 0; c < net->weights[l]->cols; c++) {
-                double grad = weight_gradients[l]->data[r][c] / batch_size;
-                // Update moments
-                opt_state->m_weights[l]->data[r][c] = beta1 * opt_state->m_weights[l]->data[r][c] + (1 - beta1) * grad;
-                opt_state->v_weights[l]->data[r][c] = beta2 * opt_state->v_weights[l]->data[r][c] + (1 - beta2) * (grad * grad);
-                // Bias correction
-                double m_hat = opt_state->m_weights[l]->data[r][c] / (1 - pow(beta1, t));
-                double v_hat = opt_state->v_weights[l]->data[r][c] / (1 - pow(beta2, t));
-                // Update weights
-                net->weights[l]->data[r][c] -= (lr * m_hat) / (sqrt(v_hat) + epsilon);
-            }
-        }
-        // Update biases
-        for (int c = 0; c < net->biases[l]->cols; c++) {
-            double grad = bias_gradients[l]->data[0][c] / batch_size;
-            // Update moments
-            opt_state->m_biases[l]->data[0][c] = beta1 * opt_state->m_biases[l]->data[0][c] + (1 - beta1) * grad;
-            opt_state->v_biases[l]->data[0][c] = beta2 * opt_state->v_biases[l]->data[0][c] + (1 - beta2) * (grad * grad);
-            // Bias correction
-            double m_hat = opt_state->m_biases[l]->data[0][c] / (1 - pow(beta1, t));
-            double v_hat = opt_state->v_biases[l]->data[0][c] / (1 - pow(beta2, t));
-            // Update biases
-            net->biases[l]->data[0][c] -= (lr * m_hat) / (sqrt(v_hat) + epsilon);
-        }
+        kern->adam_update(param_count(net->weights[l]), net->weights[l]->values,
+                          opt_state->m_weights[l]->values, opt_state->v_weights[l]->values, weight_gradients[l]->values,
+                          lr, beta1, beta2, epsilon, grad_scale, correction1, correction2);
+        kern->adam_update(param_count(net->biases[l]), net->biases[l]->values,
+                          opt_state->m_biases[l]->values, opt_state->v_biases[l]->values, bias_gradients[l]->values,
+                          lr, beta1, beta2, epsilon, grad_scale, correction1, correction2);
     }
 }
 
 
-// --- Utility function to calculate Mean Squared Error ---
-double calculate_mse(const NeuralNetwork* net, const Dataset* dataset) {
+// --- Loss Functions ---
+// The loss of one sample, from the network's outputs and the sample's label.
+// `output` may be overwritten.
+typedef double (*SampleLoss)(const SimdKernels* kern, int n, gann_real* output, const gann_real* target);
+
+static double squared_error(const SimdKernels* kern, int n, gann_real* output, const gann_real* target) {
+    kern->sub((size_t)n, output, target, output);
+    double mse = 0.0;
+    for (int j = 0; j < n; j++) {
+        mse += output[j] * output[j];
+    }
+    return mse / n;
+}
+
+// Probabilities are clamped to this before their logarithm, so that an output
+// that underflowed to 0 costs a large but finite loss.
+#define CROSS_ENTROPY_MIN_PROBABILITY 1e-12
+
+static double cross_entropy(const SimdKernels* kern, int n, gann_real* output, const gann_real* target) {
+    (void)kern;
+    double loss = 0.0;
+    for (int j = 0; j < n; j++) {
+        if (target[j] == 0) continue;
+        double p = output[j] > CROSS_ENTROPY_MIN_PROBABILITY ? output[j] : CROSS_ENTROPY_MIN_PROBABILITY;
+        loss -= target[j] * log(p);
+    }
+    return loss;
+}
+
+// The mean of `loss` over the dataset.
+static double mean_loss(const NeuralNetwork* net, const Dataset* dataset, SampleLoss loss) {
     if (net == NULL || dataset == NULL || dataset->num_items == 0) {
         return -1.0; // Indicate error
     }
+    if (!nn_check_dataset(net, dataset)) return -1.0;
+
+    // The rows run through the batched forward pass a batch at a time, read in
+    // place from the dataset, with the first layer skipping zero pixels; the
+    // outputs of one batch live in the scratch arena. The dataset has been checked against the network, so the batches
+    // run unchecked.
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return -1.0;
+    int num_outputs = net->architecture[net->num_layers - 1];
+    int batch_size = nn_get_forward_batch_size();
+    if (dataset->num_items < batch_size) batch_size = dataset->num_items;
+    size_t mark = gann_arena_mark(arena);
+    Matrix* outputs = gann_arena_create_matrix(arena, batch_size, num_outputs);
+    if (!outputs) {
+        gann_arena_reset_to(arena, mark);
+        return -1.0;
+    }
+    const SimdKernels* kern = simd_kernels();
 
-    double total_mse = 0.0;
-    for (int i = 0; i < dataset->num_items; i++) {
-        Matrix* input = matrix_get_row(dataset->images, i);
-        Matrix* target = matrix_get_row(dataset->labels, i);
-        Matrix* output = nn_forward_pass(net, input);
-
-        if (output == NULL || target == NULL) {
-            if(input) free_matrix(input);
-            if(target) free_matrix(target);
-            if(output) free_matrix(output);
+    double total_loss = 0.0;
+    for (int i = 0; i < dataset->num_items; i += batch_size) {
+        int rows = dataset->num_items - i < batch_size ? dataset->num_items - i : batch_size;
+        Matrix batch_outputs = matrix_window_unchecked(outputs, 0, rows);
+        if (!nn_forward_batch_unchecked(net, matrix_rows_unchecked(dataset->images, i, rows), 1, &batch_outputs)) {
             continue; // Skip if there was an error
         }
 
-        Matrix* error = matrix_subtract(output, target);
-        if (error == NULL) {
-            free_matrix(input);
-            free_matrix(target);
-            free_matrix(output);
-            if(error) free_matrix(error);
-            continue;
+        for (int r = 0; r < rows; r++) {
+            // The output buffer is overwritten by the next batch, so the loss may work in place.
+            total_loss += loss(kern, num_outputs, outputs->data[r], matrix_row_unchecked(dataset->labels, i + r).values);
         }
+    }
 
-        double mse = 0.0;
-        for (int j = 0; j < error->cols; j++) {
-            mse += error->data[0][j] * error->data[0][j];
-        }
-        total_mse += mse / error->cols;
+    gann_arena_reset_to(arena, mark);
+    return total_loss / dataset->num_items;
+}
 
-        free_matrix(input);
-        free_matrix(target);
-        free_matrix(output);
-        free_matrix(error);
-    }
+double calculate_mse(const NeuralNetwork* net, const Dataset* dataset) {
+    return mean_loss(net, dataset, squared_error);
+}
 
-    return total_mse / dataset->num_items;
+double calculate_cross_entropy(const NeuralNetwork* net, const Dataset* dataset) {
+    return mean_loss(net, dataset, cross_entropy);
 }
 
 // --- Private Helper Functions for `backpropagate` ---
 
 /**
- * @brief Allocates matrices to store accumulated gradients for a batch.
+ * @brief Every buffer one training run needs, taken from the scratch arena once
+ * by `backpropagate` so that the per-sample forward and backward passes never
+ * touch the heap.
  */
-static int create_gradient_accumulators(NeuralNetwork* net, Matrix*** out_wg, Matrix*** out_bg) {
-    int num_layers = net->num_layers;
-    Matrix** wg = calloc(num_layers - 1, sizeof(Matrix*));
-    Matrix** bg = calloc(num_layers - 1, sizeof(Matrix*));
-
-    if (!wg || !bg) {
-        free(wg);
-        free(bg);
-        gann_set_error(GANN_ERROR_ALLOC_FAILED);
-        return 0;
-    }
+typedef struct {
+    Matrix** weight_gradients; /**< Per-layer weight gradient accumulators. */
+    Matrix** bias_gradients;   /**< Per-layer bias gradient accumulators. */
+    MatrixView input;          /**< The current sample's input row, viewed in place in the dataset. */
+    MatrixView target;         /**< The current sample's one-hot label row, viewed in place in the dataset. */
+    int* input_nonzeros;       /**< The nonzero columns of `input`, listed for every sample. */
+    int num_input_nonzeros;    /**< The number of entries in `input_nonzeros`. */
+    Matrix** z_values;         /**< Per-layer weighted sums before activation. */
+    Matrix** activations;      /**< Per-layer outputs after activation. */
+    Matrix** deltas;           /**< Per-layer error terms of the backward pass. */
+} BackpropWorkspace;
 
-    for (int l = 0; l < num_layers - 1; l++) {
-        wg[l] = create_matrix(net->weights[l]->rows, net->weights[l]->cols);
-        bg[l] = create_matrix(net->biases[l]->rows, net->biases[l]->cols);
-        if (!wg[l] || !bg[l]) {
-            for (int i = 0; i < l; i++) { // Clean up previously allocated matrices
-                free_matrix(wg[i]);
-                free_matrix(bg[i]);
-            }
-            free(wg);
-            free(bg);
-            // create_matrix sets the error
-            return 0;
-        }
+/**
+ * @brief Takes from the arena one zeroed matrix shaped like each of `shapes[0..count)`.
+ */
+static Matrix** arena_matrices_like(GannArena* arena, Matrix* const* shapes, int count) {
+    Matrix** matrices = (Matrix**)gann_arena_alloc(arena, (size_t)count * sizeof(Matrix*));
+    if (!matrices) return NULL;
+    for (int l = 0; l < count; l++) {
+        matrices[l] = gann_arena_create_matrix(arena, shapes[l]->rows, shapes[l]->cols);
+        if (!matrices[l]) return NULL;
     }
-    *out_wg = wg;
-    *out_bg = bg;
-    return 1;
+    return matrices;
 }
 
 /**
- * @brief Frees the gradient accumulator matrices.
+ * @brief Resets the gradient accumulators to zero at the start of a batch.
  */
-static void free_gradient_accumulators(Matrix** wg, Matrix** bg, int num_layers) {
-    if (wg) {
-        for (int l = 0; l < num_layers - 1; l++) free_matrix(wg[l]);
-        free(wg);
-    }
-    if (bg) {
-        for (int l = 0; l < num_layers - 1; l++) free_matrix(bg[l]);
-        free(bg);
+static void zero_gradient_accumulators(Matrix** wg, Matrix** bg, int num_layers) {
+    for (int l = 0; l < num_layers - 1; l++) {
+        memset(wg[l]->values, 0, (size_t)wg[l]->rows * wg[l]->cols * sizeof(gann_real));
+        memset(bg[l]->values, 0, (size_t)bg[l]->rows * bg[l]->cols * sizeof(gann_real));
     }
 }
 
 /**
- * @brief Performs a forward pass, storing all intermediate activations and z-values.
+ * @brief Takes the gradient accumulators and the single-sample pass buffers from
+ * the arena. They are released by resetting the arena; on failure the caller
+ * resets it too.
  */
-static int forward_pass_and_store(const NeuralNetwork* net, const Matrix* input, Matrix*** out_activations, Matrix*** out_z_values) {
-    Matrix** activations = calloc(net->num_layers, sizeof(Matrix*));
-    Matrix** z_values = calloc(net->num_layers - 1, sizeof(Matrix*));
-    if (!activations || !z_values) {
-        free(activations);
-        free(z_values);
-        gann_set_error(GANN_ERROR_ALLOC_FAILED);
-        return 0;
-    }
+static int create_backprop_workspace(NeuralNetwork* net, BackpropWorkspace* ws, GannArena* arena) {
+    memset(ws, 0, sizeof(*ws));
+    ws->weight_gradients = arena_matrices_like(arena, net->weights, net->num_layers - 1);
+    ws->bias_gradients = ws->weight_gradients ? arena_matrices_like(arena, net->biases, net->num_layers - 1) : NULL;
+    ws->z_values = ws->bias_gradients ? nn_create_layer_buffers_arena(net, 1, arena) : NULL;
+    ws->activations = ws->z_values ? nn_create_layer_buffers_arena(net, 1, arena) : NULL;
+    ws->deltas = ws->activations ? nn_create_layer_buffers_arena(net, 1, arena) : NULL;
+    ws->input_nonzeros = ws->deltas ? (int*)gann_arena_alloc(arena, (size_t)net->architecture[0] * sizeof(int)) : NULL;
+    return ws->input_nonzeros != NULL; // the arena functions set the error
+}
 
-    activations[0] = matrix_copy(input);
-    if (!activations[0]) goto error;
+/**
+ * @brief Returns the input of layer `l`: the sample itself for the first layer,
+ * otherwise the activations of the previous layer.
+ */
+static MatrixView layer_input(const BackpropWorkspace* ws, int l) {
+    return (l == 0) ? ws->input : matrix_view(ws->activations[l - 1]);
+}
 
-    for (int l = 0; l < net->num_layers - 1; l++) {
-        Matrix* z = dot_product(activations[l], net->weights[l]);
-        if (!z) goto error;
-        add_bias(z, net->biases[l]);
-        z_values[l] = matrix_copy(z);
-        if (!z_values[l]) { free_matrix(z); goto error; }
-
-        ActivationType activation_type = (l == net->num_layers - 2) ? net->activation_output : net->activation_hidden;
-        nn_apply_activation(z, activation_type);
-        activations[l + 1] = z;
+/**
+ * @brief Performs a forward pass on `ws->input`, storing all intermediate activations and z-values.
+ * @details The workspace is shaped for the network and `backpropagate` has
+ * checked the dataset, so the layers run unchecked.
+ */
+static void forward_pass_and_store(const NeuralNetwork* net, BackpropWorkspace* ws) {
+    nn_layer_forward_sparse_unchecked(net, ws->input, ws->input_nonzeros, ws->num_input_nonzeros,
+                                      ws->activations[0], ws->z_values[0]);
+    for (int l = 1; l < net->num_layers - 1; l++) {
+        nn_layer_forward_unchecked(net, l, layer_input(ws, l), ws->activations[l], ws->z_values[l]);
     }
-
-    *out_activations = activations;
-    *out_z_values = z_values;
-    return 1;
-
-error:
-    for (int i = 0; i < net->num_layers; i++) free_matrix(activations[i]);
-    for (int i = 0; i < net->num_layers - 1; i++) free_matrix(z_values[i]);
-    free(activations);
-    free(z_values);
-    return 0;
 }
 
 /**
  * @brief Performs the backward pass to calculate and accumulate gradients for one sample.
+ * @details Weight gradients are accumulated directly into the workspace
+ * accumulators (`grad += a^T * delta`) and deltas are propagated with
+ * `delta * W^T`; neither operand is ever transposed into a temporary. The
+ * z-values are consumed: each is overwritten with its activation derivative.
+ * Every buffer is a single dense row shaped for its layer, so the kernels are
+ * called directly.
  */
-static int backward_pass_and_accumulate(const NeuralNetwork* net, const Matrix* target, Matrix** activations, Matrix** z_values, Matrix** weight_gradients, Matrix** bias_gradients) {
-    Matrix *delta = NULL, *activations_T = NULL, *dw = NULL;
-    int success = 0;
-
-    // Calculate delta for the output layer: (y_pred - y_true)
-    delta = matrix_subtract(activations[net->num_layers - 1], target);
-    if (!delta) goto cleanup;
-
-    // --- Calculate gradients for the last layer ---
-    activations_T = matrix_transpose(activations[net->num_layers - 2]);
-    if (!activations_T) goto cleanup;
-
-    dw = dot_product(activations_T, delta);
-    if (!dw) goto cleanup;
-
-    // Accumulate gradients
-    for (int r = 0; r < dw->rows; r++) for (int c = 0; c < dw->cols; c++) weight_gradients[net->num_layers - 2]->data[r][c] += dw->data[r][c];
-    for (int c = 0; c < delta->cols; c++) bias_gradients[net->num_layers - 2]->data[0][c] += delta->data[0][c];
-    free_matrix(dw); dw = NULL;
-    free_matrix(activations_T); activations_T = NULL;
-
-    // --- Propagate error backward ---
-    for (int l = net->num_layers - 3; l >= 0; l--) {
-        Matrix* weights_T = matrix_transpose(net->weights[l + 1]);
-        Matrix* next_delta = dot_product(delta, weights_T);
-        free_matrix(delta); delta = NULL;
-        free_matrix(weights_T);
-        if (!next_delta) goto cleanup;
-
-        Matrix* z_derivative = matrix_copy(z_values[l]);
-        if (!z_derivative) { free_matrix(next_delta); goto cleanup; }
-        nn_apply_activation_derivative(z_derivative, net->activation_hidden);
-
-        delta = matrix_elementwise_multiply(next_delta, z_derivative);
-        free_matrix(next_delta);
-        free_matrix(z_derivative);
-        if (!delta) goto cleanup;
-
-        // Calculate and accumulate gradients for the current layer
-        activations_T = matrix_transpose(activations[l]);
-        if (!activations_T) goto cleanup;
-        dw = dot_product(activations_T, delta);
-        if (!dw) goto cleanup;
-
-        for (int r = 0; r < dw->rows; r++) for (int c = 0; c < dw->cols; c++) weight_gradients[l]->data[r][c] += dw->data[r][c];
-        for (int c = 0; c < delta->cols; c++) bias_gradients[l]->data[0][c] += delta->data[0][c];
-        free_matrix(dw); dw = NULL;
-        free_matrix(activations_T); activations_T = NULL;
-    }
-    success = 1;
+static void backward_pass_and_accumulate(const NeuralNetwork* net, BackpropWorkspace* ws) {
+    const SimdKernels* kern = simd_kernels();
+    int last = net->num_layers - 2;
+
+    // Delta for the output layer: y_pred - y_true. This is the exact gradient of
+    // each output activation's matching loss with respect to the layer's sums:
+    // cross-entropy for SOFTMAX, binary cross-entropy for SIGMOID, squared error
+    // for LINEAR. The activation's Jacobian cancels against the loss's gradient,
+    // so softmax and cross-entropy are never differentiated separately.
+    Matrix* output_delta = ws->deltas[last];
+    GANN_DEBUG_ASSERT(ws->target.cols == output_delta->cols);
+    kern->sub((size_t)output_delta->cols, ws->activations[last]->values, ws->target.values, output_delta->values);
+
+    for (int l = last; l >= 0; l--) {
+        Matrix* delta = ws->deltas[l];
+        if (l < last) {
+            // --- Propagate error backward: delta = (next_delta * W^T) ⊙ f'(z) ---
+            const Matrix* next_delta = ws->deltas[l + 1];
+            const Matrix* weights = net->weights[l + 1];
+            GANN_DEBUG_ASSERT(weights->rows == delta->cols && weights->cols == next_delta->cols);
+            gemm_nt(1, weights->rows, weights->cols, next_delta->values, next_delta->stride,
+                    weights->values, weights->stride, 0.0, delta->values, delta->stride);
+            kern->activation_derivative((size_t)delta->cols, ws->z_values[l]->values, net->activation_hidden);
+            kern->mul((size_t)delta->cols, delta->values, ws->z_values[l]->values, delta->values);
+        }
 
-cleanup:
-    free_matrix(delta);
-    free_matrix(activations_T);
-    free_matrix(dw);
-    return success;
+        // Accumulate gradients for the current layer. Zero inputs contribute
+        // nothing, so the first layer only updates the rows of its nonzero inputs.
+        if (l == 0) {
+            Matrix* grad = ws->weight_gradients[0];
+            for (int p = 0; p < ws->num_input_nonzeros; p++) {
+                int row = ws->input_nonzeros[p];
+                kern->axpy((size_t)delta->cols, ws->input.values[row], delta->values, grad->values + (size_t)row * grad->stride);
+            }
+        } else {
+            MatrixView input = layer_input(ws, l);
+            Matrix* grad = ws->weight_gradients[l];
+            GANN_DEBUG_ASSERT(grad->rows == input.cols && grad->cols == delta->cols);
+            gemm_tn(input.cols, delta->cols, 1, input.values, input.stride,
+                    delta->values, delta->stride, 1.0, grad->values, grad->stride);
+        }
+        kern->add_inplace((size_t)delta->cols, ws->bias_gradients[l]->values, delta->values);
+    }
 }
 
 // Main function to train the network using backpropagation
@@ -301,52 +300,53 @@ void backpropagate(NeuralNetwork* net, const Dataset* train_dataset, const GannB
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
+    if (net->weight_storage != NN_STORAGE_NATIVE) {
+        // Gradient steps are far below the resolution of 16-bit weights
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return;
+    }
+    if (params->batch_size <= 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return;
+    }
+    // Every sample runs through the unchecked kernels, so the dataset is checked once here.
+    if (!nn_check_dataset(net, train_dataset)) return;
 
     double best_validation_accuracy = -1.0;
     int epochs_without_improvement = 0;
     NeuralNetwork* best_network_state = NULL;
     int t = 0; // Timestep for Adam
 
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return; // gann_scratch_arena sets the error
+    size_t arena_mark = gann_arena_mark(arena);
+    BackpropWorkspace ws;
+    if (!create_backprop_workspace(net, &ws, arena)) {
+        gann_arena_reset_to(arena, arena_mark);
+        return; // Critical error; the arena functions set the error
+    }
+
     for (int epoch = 0; epoch < params->epochs; epoch++) {
         for (int i = 0; i < train_dataset->num_items; i += params->batch_size) {
             t++;
             int current_batch_size = (i + params->batch_size > train_dataset->num_items) ? (train_dataset->num_items - i) : params->batch_size;
-            Matrix **weight_gradients = NULL, **bias_gradients = NULL;
-
-            if (!create_gradient_accumulators(net, &weight_gradients, &bias_gradients)) {
-                goto end_training; // Critical error
-            }
+            zero_gradient_accumulators(ws.weight_gradients, ws.bias_gradients, net->num_layers);
 
             for (int j = 0; j < current_batch_size; j++) {
-                Matrix *input = NULL, *target = NULL;
-                Matrix **activations = NULL, **z_values = NULL;
-
-                input = matrix_get_row(train_dataset->images, i + j);
-                target = matrix_get_row(train_dataset->labels, i + j);
-                if (!input || !target) { free_matrix(input); free_matrix(target); continue; }
-
-                if (!forward_pass_and_store(net, input, &activations, &z_values)) {
-                    free_matrix(input); free_matrix(target); continue;
-                }
-
-                backward_pass_and_accumulate(net, target, activations, z_values, weight_gradients, bias_gradients);
-
-                // Free memory for this sample
-                free_matrix(input);
-                free_matrix(target);
-                for(int l=0; l<net->num_layers; l++) free_matrix(activations[l]);
-                for(int l=0; l<net->num_layers-1; l++) free_matrix(z_values[l]);
-                free(activations);
-                free(z_values);
+                ws.input = matrix_row_unchecked(train_dataset->images, i + j);
+                ws.target = matrix_row_unchecked(train_dataset->labels, i + j);
+                // One compare per pixel, against a multiply-add per pixel and unit of the first layer
+                ws.num_input_nonzeros = nn_list_nonzeros(ws.input, ws.input_nonzeros);
+                forward_pass_and_store(net, &ws);
+                backward_pass_and_accumulate(net, &ws);
             }
 
             // Update weights
             switch (params->optimizer_type) {
-                case ADAM: update_weights_adam(net, weight_gradients, bias_gradients, params, current_batch_size, t); break;
-                case RMSPROP: update_weights_rmsprop(net, weight_gradients, bias_gradients, params, current_batch_size); break;
-                default: update_weights_sgd(net, weight_gradients, bias_gradients, params, current_batch_size); break;
+                case ADAM: update_weights_adam(net, ws.weight_gradients, ws.bias_gradients, params, current_batch_size, t); break;
+                case RMSPROP: update_weights_rmsprop(net, ws.weight_gradients, ws.bias_gradients, params, current_batch_size); break;
+                default: update_weights_sgd(net, ws.weight_gradients, ws.bias_gradients, params, current_batch_size); break;
             }
-            free_gradient_accumulators(weight_gradients, bias_gradients, net->num_layers);
         }
 
         if (params->logging) {
@@ -373,6 +373,7 @@ void backpropagate(NeuralNetwork* net, const Dataset* train_dataset, const GannB
     }
 
 end_training:
+    gann_arena_reset_to(arena, arena_mark);
     if (best_network_state) {
         for (int l = 0; l < net->num_layers - 1; l++) {
             matrix_copy_data(net->weights[l], best_network_state->weights[l]);
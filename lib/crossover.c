@@ -1,38 +1,51 @@
 #include "crossover.h"
+#include "half.h"
+#include "nn_kernels.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-// Performs uniform crossover between two parent networks.
-// For each weight and bias, the child's value is randomly taken from one of the two parents.
-static NeuralNetwork* uniform_crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
-    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers) {
+// Every operator works on the parents' genomes (see nn_genome), which are flat
+// arrays of the same layout when the parents share an architecture and a
+// weight storage.
+
+// Creates a zeroed child for two compatible parents, or returns NULL.
+static NeuralNetwork* create_child(const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
+    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers ||
+        parent1->weight_storage != parent2->weight_storage ||
+        memcmp(parent1->architecture, parent2->architecture, parent1->num_layers * sizeof(int)) != 0) {
         return NULL;
     }
+    return nn_create_with_storage(parent1->num_layers, parent1->architecture, parent1->activation_hidden,
+                                  parent1->activation_output, parent1->weight_storage);
+}
 
-    // Create a new network with the same architecture
-    NeuralNetwork* child = nn_create(parent1->num_layers, parent1->architecture, parent1->activation_hidden, parent1->activation_output);
+// Copies genes [first, last) of src into dest, counting the real genes first.
+static void copy_genes(NeuralNetwork* dest, const NeuralNetwork* src, size_t first, size_t last) {
+    NNGenome to = nn_genome(dest), from = nn_genome(src);
+    if (first < to.num_real) {
+        size_t end = last < to.num_real ? last : to.num_real;
+        memcpy(to.real + first, from.real + first, (end - first) * sizeof(gann_real));
+    }
+    if (last > to.num_real) {
+        size_t begin = first > to.num_real ? first - to.num_real : 0;
+        memcpy(to.half + begin, from.half + begin, (last - to.num_real - begin) * sizeof(uint16_t));
+    }
+}
+
+// Performs uniform crossover between two parent networks.
+// For each weight and bias, the child's value is randomly taken from one of the two parents.
+static NeuralNetwork* uniform_crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
+    NeuralNetwork* child = create_child(parent1, parent2);
     if (!child) return NULL;
 
-    // Perform uniform crossover for weights and biases
-    for (int i = 0; i < parent1->num_layers - 1; i++) {
-        // Weights
-        for (int r = 0; r < parent1->weights[i]->rows; r++) {
-            for (int c = 0; c < parent1->weights[i]->cols; c++) {
-                if ((double)rand() / RAND_MAX > 0.5) {
-                    child->weights[i]->data[r][c] = parent1->weights[i]->data[r][c];
-                } else {
-                    child->weights[i]->data[r][c] = parent2->weights[i]->data[r][c];
-                }
-            }
-        }
-        // Biases
-        for (int c = 0; c < parent1->biases[i]->cols; c++) {
-            if ((double)rand() / RAND_MAX > 0.5) {
-                child->biases[i]->data[0][c] = parent1->biases[i]->data[0][c];
-            } else {
-                child->biases[i]->data[0][c] = parent2->biases[i]->data[0][c];
-            }
-        }
+    NNGenome c = nn_genome(child), a = nn_genome(parent1), b = nn_genome(parent2);
+    for (size_t k = 0; k < c.num_real; k++) {
+        c.real[k] = (double)rand() / RAND_MAX > 0.5 ? a.real[k] : b.real[k];
+    }
+    // 16-bit weights are copied bit for bit
+    for (size_t k = 0; k < c.num_half; k++) {
+        c.half[k] = (double)rand() / RAND_MAX > 0.5 ? a.half[k] : b.half[k];
     }
 
     return child;
@@ -40,127 +53,60 @@ static NeuralNetwork* uniform_crossover(const NeuralNetwork* parent1, const Neur
 
 // Performs single-point crossover between two parent networks.
 static NeuralNetwork* single_point_crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
-    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers) {
-        return NULL;
-    }
-
-    NeuralNetwork* child = nn_create(parent1->num_layers, parent1->architecture, parent1->activation_hidden, parent1->activation_output);
+    NeuralNetwork* child = create_child(parent1, parent2);
     if (!child) return NULL;
 
-    int total_weights = 0;
-    for (int i = 0; i < parent1->num_layers - 1; i++) {
-        total_weights += parent1->weights[i]->rows * parent1->weights[i]->cols;
-        total_weights += parent1->biases[i]->cols;
-    }
+    NNGenome genome = nn_genome(child);
+    size_t total_genes = genome.num_real + genome.num_half;
+    size_t crossover_point = (size_t)rand() % total_genes;
 
-    int crossover_point = rand() % total_weights;
-    int current_weight = 0;
-
-    for (int i = 0; i < parent1->num_layers - 1; i++) {
-        // Weights
-        for (int r = 0; r < parent1->weights[i]->rows; r++) {
-            for (int c = 0; c < parent1->weights[i]->cols; c++) {
-                if (current_weight < crossover_point) {
-                    child->weights[i]->data[r][c] = parent1->weights[i]->data[r][c];
-                } else {
-                    child->weights[i]->data[r][c] = parent2->weights[i]->data[r][c];
-                }
-                current_weight++;
-            }
-        }
-        // Biases
-        for (int c = 0; c < parent1->biases[i]->cols; c++) {
-            if (current_weight < crossover_point) {
-                child->biases[i]->data[0][c] = parent1->biases[i]->data[0][c];
-            } else {
-                child->biases[i]->data[0][c] = parent2->biases[i]->data[0][c];
-            }
-            current_weight++;
-        }
-    }
+    copy_genes(child, parent1, 0, crossover_point);
+    copy_genes(child, parent2, crossover_point, total_genes);
 
     return child;
 }
 
 // Performs two-point crossover between two parent networks.
 static NeuralNetwork* two_point_crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
-    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers) {
-        return NULL;
-    }
-
-    NeuralNetwork* child = nn_create(parent1->num_layers, parent1->architecture, parent1->activation_hidden, parent1->activation_output);
+    NeuralNetwork* child = create_child(parent1, parent2);
     if (!child) return NULL;
 
-    int total_weights = 0;
-    for (int i = 0; i < parent1->num_layers - 1; i++) {
-        total_weights += parent1->weights[i]->rows * parent1->weights[i]->cols;
-        total_weights += parent1->biases[i]->cols;
-    }
-
-    int crossover_point1 = rand() % total_weights;
-    int crossover_point2 = rand() % total_weights;
+    NNGenome genome = nn_genome(child);
+    size_t total_genes = genome.num_real + genome.num_half;
+    size_t crossover_point1 = (size_t)rand() % total_genes;
+    size_t crossover_point2 = (size_t)rand() % total_genes;
     if (crossover_point1 > crossover_point2) {
-        int temp = crossover_point1;
+        size_t temp = crossover_point1;
         crossover_point1 = crossover_point2;
         crossover_point2 = temp;
     }
 
-    int current_weight = 0;
-
-    for (int i = 0; i < parent1->num_layers - 1; i++) {
-        // Weights
-        for (int r = 0; r < parent1->weights[i]->rows; r++) {
-            for (int c = 0; c < parent1->weights[i]->cols; c++) {
-                if (current_weight >= crossover_point1 && current_weight < crossover_point2) {
-                    child->weights[i]->data[r][c] = parent2->weights[i]->data[r][c];
-                } else {
-                    child->weights[i]->data[r][c] = parent1->weights[i]->data[r][c];
-                }
-                current_weight++;
-            }
-        }
-        // Biases
-        for (int c = 0; c < parent1->biases[i]->cols; c++) {
-            if (current_weight >= crossover_point1 && current_weight < crossover_point2) {
-                child->biases[i]->data[0][c] = parent2->biases[i]->data[0][c];
-            } else {
-                child->biases[i]->data[0][c] = parent1->biases[i]->data[0][c];
-            }
-            current_weight++;
-        }
-    }
+    copy_genes(child, parent1, 0, crossover_point1);
+    copy_genes(child, parent2, crossover_point1, crossover_point2);
+    copy_genes(child, parent1, crossover_point2, total_genes);
 
     return child;
 }
 
 // Performs arithmetic crossover between two parent networks.
 static NeuralNetwork* arithmetic_crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2) {
-    if (!parent1 || !parent2 || parent1->num_layers != parent2->num_layers) {
-        return NULL;
-    }
-
-    NeuralNetwork* child = nn_create(parent1->num_layers, parent1->architecture, parent1->activation_hidden, parent1->activation_output);
+    NeuralNetwork* child = create_child(parent1, parent2);
     if (!child) return NULL;
 
     double alpha = (double)rand() / RAND_MAX;
 
-    for (int i = 0; i < parent1->num_layers - 1; i++) {
-        // Weights
-        for (int r = 0; r < parent1->weights[i]->rows; r++) {
-            for (int c = 0; c < parent1->weights[i]->cols; c++) {
-                child->weights[i]->data[r][c] = alpha * parent1->weights[i]->data[r][c] + (1 - alpha) * parent2->weights[i]->data[r][c];
-            }
-        }
-        // Biases
-        for (int c = 0; c < parent1->biases[i]->cols; c++) {
-            child->biases[i]->data[0][c] = alpha * parent1->biases[i]->data[0][c] + (1 - alpha) * parent2->biases[i]->data[0][c];
-        }
+    NNGenome c = nn_genome(child), a = nn_genome(parent1), b = nn_genome(parent2);
+    for (size_t k = 0; k < c.num_real; k++) {
+        c.real[k] = alpha * a.real[k] + (1 - alpha) * b.real[k];
+    }
+    NNWeightStorage format = child->weight_storage;
+    for (size_t k = 0; k < c.num_half; k++) {
+        c.half[k] = half_from_real(alpha * half_to_real(a.half[k], format) + (1 - alpha) * half_to_real(b.half[k], format), format);
     }
 
     return child;
 }
 
-
 NeuralNetwork* crossover(const NeuralNetwork* parent1, const NeuralNetwork* parent2, CrossoverType crossover_type) {
     if (parent1 == NULL || parent2 == NULL) {
         fprintf(stderr, "Error: Cannot perform crossover. Provided parent network(s) is NULL.\n");
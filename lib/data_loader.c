@@ -2,7 +2,6 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <time.h>
 
 // Helper function to swap endianness (from big-endian to little-endian)
 static int swap_endian(int val) {
@@ -86,41 +85,63 @@ Dataset* load_mnist_dataset(const char* image_path, const char* label_path) {
     }
 
     // --- Read Data ---
-    int image_size = rows * cols;
-    unsigned char* image_buffer = (unsigned char*)malloc(image_size * sizeof(unsigned char));
-    unsigned char label_buffer;
+    // Both payloads are read with a single fread each and expanded linearly into
+    // the contiguous matrix buffers.
+    size_t image_size = (size_t)rows * cols;
+    size_t total_pixels = (size_t)num_images * image_size;
+    unsigned char* image_buffer = (unsigned char*)malloc(total_pixels * sizeof(unsigned char));
+    unsigned char* label_buffer = (unsigned char*)malloc((size_t)num_images * sizeof(unsigned char));
+    if (!image_buffer || !label_buffer) {
+        fprintf(stderr, "Error allocating read buffers for the dataset.\n");
+        free(image_buffer);
+        free(label_buffer);
+        free_dataset(dataset);
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
 
-    for (int i = 0; i < num_images; i++) {
-        // Read image
-        if (fread(image_buffer, sizeof(unsigned char), image_size, image_file) != image_size) {
-            fprintf(stderr, "Error reading image data for item %d.\n", i);
-            free(image_buffer);
-            free_dataset(dataset);
-            fclose(image_file);
-            fclose(label_file);
-            return NULL;
-        }
-        for (int j = 0; j < image_size; j++) {
-            dataset->images->data[i][j] = (double)image_buffer[j] / 255.0;
-        }
+    if (fread(image_buffer, sizeof(unsigned char), total_pixels, image_file) != total_pixels) {
+        fprintf(stderr, "Error reading image data.\n");
+        free(image_buffer);
+        free(label_buffer);
+        free_dataset(dataset);
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
+    if (fread(label_buffer, sizeof(unsigned char), num_images, label_file) != (size_t)num_images) {
+        fprintf(stderr, "Error reading label data.\n");
+        free(image_buffer);
+        free(label_buffer);
+        free_dataset(dataset);
+        fclose(image_file);
+        fclose(label_file);
+        return NULL;
+    }
+
+    gann_real* pixels = dataset->images->values;
+    for (size_t j = 0; j < total_pixels; j++) {
+        pixels[j] = (double)image_buffer[j] / 255.0;
+    }
 
-        // Read label and one-hot encode
-        if (fread(&label_buffer, sizeof(unsigned char), 1, label_file) != 1) {
-            fprintf(stderr, "Error reading label data for item %d.\n", i);
+    // Labels are one-hot encoded; create_matrix already zeroed the buffer.
+    for (int i = 0; i < num_images; i++) {
+        if (label_buffer[i] >= MNIST_NUM_CLASSES) {
+            fprintf(stderr, "Invalid label %d for item %d.\n", label_buffer[i], i);
             free(image_buffer);
+            free(label_buffer);
             free_dataset(dataset);
             fclose(image_file);
             fclose(label_file);
             return NULL;
         }
-        for(int k=0; k < MNIST_NUM_CLASSES; k++) {
-            dataset->labels->data[i][k] = 0.0;
-        }
-        dataset->labels->data[i][label_buffer] = 1.0;
+        dataset->labels->values[(size_t)i * dataset->labels->stride + label_buffer[i]] = 1.0;
     }
 
     // --- Cleanup ---
     free(image_buffer);
+    free(label_buffer);
     fclose(image_file);
     fclose(label_file);
 
@@ -145,12 +166,8 @@ Dataset* create_dummy_dataset_with_label(int num_items, int label) {
         return NULL;
     }
 
-    static int seeded = 0;
-    if (!seeded) {
-        srand(time(NULL));
-        seeded = 1;
-    }
-
+    // The values come from the library-wide rand() stream, so gann_seed_rng()
+    // makes dummy datasets reproducible.
     for (int i = 0; i < num_items; i++) {
         for (int j = 0; j < MNIST_IMAGE_SIZE; j++) {
             dataset->images->data[i][j] = (double)rand() / RAND_MAX;
@@ -177,12 +194,7 @@ Dataset* create_dummy_dataset(int num_items) {
         return NULL;
     }
 
-    // Seed random number generator if not already seeded
-    static int seeded = 0;
-    if (!seeded) {
-        srand(time(NULL));
-        seeded = 1;
-    }
+    // Drawn from the library-wide rand() stream; see gann_seed_rng()
 
     // Fill images with random pixel values (0.0 to 1.0)
     for (int i = 0; i < num_items; i++) {
@@ -223,17 +235,19 @@ void split_dataset(const Dataset* original, int split_size, Dataset* out_dataset
     out_dataset_1->num_items = first_size;
     out_dataset_1->images = create_matrix(first_size, original->images->cols);
     out_dataset_1->labels = create_matrix(first_size, original->labels->cols);
-    for (int i = 0; i < first_size; i++) {
-        memcpy(out_dataset_1->images->data[i], original->images->data[i], original->images->cols * sizeof(double));
-        memcpy(out_dataset_1->labels->data[i], original->labels->data[i], original->labels->cols * sizeof(double));
-    }
 
     // Second dataset (the smaller part, used for validation)
     out_dataset_2->num_items = split_size;
     out_dataset_2->images = create_matrix(split_size, original->images->cols);
     out_dataset_2->labels = create_matrix(split_size, original->labels->cols);
-    for (int i = 0; i < split_size; i++) {
-        memcpy(out_dataset_2->images->data[i], original->images->data[first_size + i], original->images->cols * sizeof(double));
-        memcpy(out_dataset_2->labels->data[i], original->labels->data[first_size + i], original->labels->cols * sizeof(double));
+
+    if (!out_dataset_1->images || !out_dataset_1->labels || !out_dataset_2->images || !out_dataset_2->labels) {
+        return; // create_matrix sets the error
     }
+
+    // Rows are stored back to back, so each part is a single block copy.
+    memcpy(out_dataset_1->images->values, original->images->values, (size_t)first_size * original->images->cols * sizeof(gann_real));
+    memcpy(out_dataset_1->labels->values, original->labels->values, (size_t)first_size * original->labels->cols * sizeof(gann_real));
+    memcpy(out_dataset_2->images->values, original->images->data[first_size], (size_t)split_size * original->images->cols * sizeof(gann_real));
+    memcpy(out_dataset_2->labels->values, original->labels->data[first_size], (size_t)split_size * original->labels->cols * sizeof(gann_real));
 }
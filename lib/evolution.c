@@ -8,6 +8,12 @@
 
 // Creates an initial population of neural networks
 NeuralNetwork** evo_create_initial_population(int population_size, int num_layers, const int* architecture, ActivationType activation_hidden, ActivationType activation_output) {
+    return evo_create_initial_population_with_storage(population_size, num_layers, architecture, activation_hidden, activation_output, NN_STORAGE_NATIVE);
+}
+
+NeuralNetwork** evo_create_initial_population_with_storage(int population_size, int num_layers, const int* architecture,
+                                                           ActivationType activation_hidden, ActivationType activation_output,
+                                                           NNWeightStorage storage) {
     if (architecture == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
@@ -19,9 +25,9 @@ NeuralNetwork** evo_create_initial_population(int population_size, int num_layer
     }
 
     for (int i = 0; i < population_size; i++) {
-        population[i] = nn_create(num_layers, architecture, activation_hidden, activation_output);
+        population[i] = nn_create_with_storage(num_layers, architecture, activation_hidden, activation_output, storage);
         if (population[i] == NULL) {
-            // nn_create sets the error, but we need to clean up
+            // nn_create_with_storage sets the error, but we need to clean up
             for (int j = 0; j < i; j++) {
                 nn_free(population[j]);
             }
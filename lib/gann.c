@@ -3,6 +3,7 @@
 #include "crossover.h"
 #include "mutation.h"
 #include "gann_errors.h"
+#include "nn_kernels.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,15 +21,11 @@ static int compare_fitness_desc(const void* a, const void* b) {
     return 0;
 }
 
-// Helper to get the index of the max value in a matrix row (the prediction)
-static int get_predicted_class(const Matrix* output) {
-    if (!output || !output->data || output->cols == 0) {
-        gann_set_error(GANN_ERROR_INVALID_PARAM);
-        return -1;
-    }
+// Helper to get the index of the max value in an output row (the prediction)
+static int get_predicted_class(const gann_real* output_row, int num_classes) {
     int max_index = 0;
-    for (int i = 1; i < output->cols; i++) {
-        if (output->data[0][i] > output->data[0][max_index]) {
+    for (int i = 1; i < num_classes; i++) {
+        if (output_row[i] > output_row[max_index]) {
             max_index = i;
         }
     }
@@ -36,7 +33,7 @@ static int get_predicted_class(const Matrix* output) {
 }
 
 // Helper to get the true class from a one-hot encoded label vector
-static int get_true_class(const double* label_row, int num_classes) {
+static int get_true_class(const gann_real* label_row, int num_classes) {
     if (!label_row) return -1;
     for (int i = 0; i < num_classes; i++) {
         if (label_row[i] == 1.0) {
@@ -46,45 +43,52 @@ static int get_true_class(const double* label_row, int num_classes) {
     return -1; // Should not happen with valid data
 }
 
-
-// Fitness function used by the training loop
-static double calculate_fitness(NeuralNetwork* network, const Dataset* dataset, int num_samples) {
-    int correct_predictions = 0;
-    if (num_samples <= 0 || num_samples > dataset->num_items) {
-        num_samples = dataset->num_items;
-    }
-
-    // Create a single input matrix to be reused to avoid repeated malloc/free calls.
-    Matrix* input = create_matrix(1, dataset->images->cols);
-    if (!input) {
-        // create_matrix sets the error, but this is a private helper.
-        // We don't propagate the error code here, just return 0 fitness.
-        return 0.0;
+// Counts how many of the first `num_samples` samples the network classifies
+// correctly. The samples run through the batched forward pass a batch at a
+// time, read straight from the dataset, with the first layer skipping zero
+// pixels; the outputs of one batch live in the scratch arena. The dataset must
+// have passed nn_check_dataset(), so the batches run unchecked. Returns -1 if a forward pass fails (the error code is set).
+static int count_correct_predictions(const NeuralNetwork* net, const Dataset* dataset, int num_samples) {
+    if (num_samples <= 0) return 0;
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return -1; // gann_scratch_arena sets the error
+    int num_classes = net->architecture[net->num_layers - 1];
+    int batch_size = nn_get_forward_batch_size();
+    if (num_samples < batch_size) batch_size = num_samples;
+    size_t mark = gann_arena_mark(arena);
+    Matrix* outputs = gann_arena_create_matrix(arena, batch_size, num_classes);
+    if (!outputs) {
+        gann_arena_reset_to(arena, mark);
+        return -1; // gann_arena_create_matrix sets the error
     }
 
-    for (int i = 0; i < num_samples; i++) {
-        // Copy the current sample's data into the reusable input matrix.
-        memcpy(input->data[0], dataset->images->data[i], dataset->images->cols * sizeof(double));
-
-        Matrix* output = nn_forward_pass(network, input);
-        if (!output) {
-            // nn_forward_pass sets the error, so we can just skip.
-            continue;
+    int correct_predictions = 0;
+    for (int i = 0; i < num_samples; i += batch_size) {
+        int rows = num_samples - i < batch_size ? num_samples - i : batch_size;
+        Matrix batch_outputs = matrix_window_unchecked(outputs, 0, rows);
+        if (!nn_forward_batch_unchecked(net, matrix_rows_unchecked(dataset->images, i, rows), 1, &batch_outputs)) {
+            correct_predictions = -1; // the forward pass sets the error
+            break;
         }
-
-        int predicted_class = get_predicted_class(output);
-        int num_classes = network->architecture[network->num_layers - 1];
-        int true_class = get_true_class(dataset->labels->data[i], num_classes);
-
-        if (predicted_class == true_class) {
-            correct_predictions++;
+        for (int r = 0; r < rows; r++) {
+            if (get_predicted_class(outputs->data[r], num_classes) == get_true_class(dataset->labels->data[i + r], num_classes)) {
+                correct_predictions++;
+            }
         }
-
-        free_matrix(output); // Output matrix is newly created in each pass, so it must be freed.
     }
 
-    free_matrix(input); // Free the reusable input matrix.
-    return (double)correct_predictions / num_samples;
+    gann_arena_reset_to(arena, mark);
+    return correct_predictions;
+}
+
+// Fitness function used by the training loop
+static double calculate_fitness(NeuralNetwork* network, const Dataset* dataset, int num_samples) {
+    if (num_samples <= 0 || num_samples > dataset->num_items) {
+        num_samples = dataset->num_items;
+    }
+    // This is a private helper: a failed evaluation simply scores 0 fitness.
+    int correct_predictions = count_correct_predictions(network, dataset, num_samples);
+    return correct_predictions < 0 ? 0.0 : (double)correct_predictions / num_samples;
 }
 
 
@@ -114,7 +118,8 @@ GannTrainParams gann_create_default_params(void) {
         .mutation_std_dev = 0.1,
         .logging = true,
         .early_stopping_patience = 0,
-        .early_stopping_threshold = 0.001
+        .early_stopping_threshold = 0.001,
+        .weight_storage = NN_STORAGE_NATIVE
     };
     gann_set_error(GANN_SUCCESS);
     return params;
@@ -136,9 +141,18 @@ NeuralNetwork* gann_evolve(const GannEvolveParams* params, const Dataset* train_
         gann_set_error(GANN_ERROR_INVALID_PARAM);
         return NULL;
     }
+    // Fitness evaluation runs every sample through the unchecked forward pass,
+    // so the dataset is checked against the architecture once, here.
+    if (train_dataset->images->cols != base_params->architecture[0] ||
+        train_dataset->labels->cols != base_params->architecture[base_params->num_layers - 1] ||
+        train_dataset->images->rows < train_dataset->num_items || train_dataset->labels->rows < train_dataset->num_items) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return NULL;
+    }
 
     // --- 1. Create Initial Population ---
-    NeuralNetwork** population = evo_create_initial_population(base_params->population_size, base_params->num_layers, base_params->architecture, base_params->activation_hidden, base_params->activation_output);
+    NeuralNetwork** population = evo_create_initial_population_with_storage(base_params->population_size, base_params->num_layers, base_params->architecture,
+                                                                            base_params->activation_hidden, base_params->activation_output, base_params->weight_storage);
     if (!population) {
         // evo_create_initial_population should set the error.
         return NULL;
@@ -333,60 +347,98 @@ NeuralNetwork* gann_train(const GannTrainParams* params, const Dataset* train_da
     return gann_evolve(&evolve_params, train_dataset, validation_dataset);
 }
 
-int gann_predict(const NeuralNetwork* net, const double* input_data) {
+int gann_predict(const NeuralNetwork* net, const gann_real* input_data) {
     if (!net || !input_data) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return -1; // Invalid input
     }
-
-    // Create a matrix for the input data
-    Matrix* input_matrix = create_matrix(1, net->architecture[0]);
-    if (!input_matrix) {
-        // create_matrix sets the error
-        return -1;
-    }
-    memcpy(input_matrix->data[0], input_data, net->architecture[0] * sizeof(double));
-
-    // Perform the forward pass
-    Matrix* output_matrix = nn_forward_pass(net, input_matrix);
-    if (!output_matrix) {
-        free_matrix(input_matrix);
-        // nn_forward_pass sets the error
-        return -1;
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return -1; // gann_scratch_arena sets the error
+
+    // The input is read in place as a batch of one row; the output lives in
+    // the scratch arena only for the duration of the call. Both are shaped for
+    // the network, so the pass runs unchecked.
+    int input_size = net->architecture[0];
+    int num_classes = net->architecture[net->num_layers - 1];
+    MatrixView input = { input_data, 1, input_size, input_size };
+    size_t mark = gann_arena_mark(arena);
+    Matrix* output = gann_arena_create_matrix(arena, 1, num_classes);
+    int prediction = -1;
+    if (output && nn_forward_batch_unchecked(net, input, 0, output)) {
+        prediction = get_predicted_class(output->values, num_classes);
     }
-
-    // Get the result
-    int prediction = get_predicted_class(output_matrix);
-
-    // Cleanup
-    free_matrix(input_matrix);
-    free_matrix(output_matrix);
+    gann_arena_reset_to(arena, mark);
+    if (prediction < 0) return -1; // the failing call set the error
 
     gann_set_error(GANN_SUCCESS);
     return prediction;
 }
 
-double gann_evaluate(const NeuralNetwork* net, const Dataset* dataset) {
-    if (!net || !dataset) {
+int gann_predict_ctx(GannInferenceContext* ctx, const gann_real* input_data) {
+    const gann_real* output = nn_forward_ctx(ctx, input_data);
+    if (!output) return -1; // nn_forward_ctx sets the error
+    return get_predicted_class(output, ctx->net->architecture[ctx->net->num_layers - 1]);
+}
+
+int gann_predict_batch(const NeuralNetwork* net, const gann_real* inputs, int n, int k, int* out_classes,
+                       gann_real* out_scores) {
+    if (!net || !inputs || !out_classes) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
-        return 0.0;
+        return 0;
+    }
+    int input_size = net->architecture[0];
+    int num_classes = net->architecture[net->num_layers - 1];
+    if (n <= 0 || k < 1 || k > num_classes) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return 0; // gann_scratch_arena sets the error
+
+    // The inputs are read in place a batch at a time; the outputs of one batch,
+    // and the scores when the caller does not want them, live in the scratch
+    // arena for the duration of the call.
+    int batch_size = nn_get_forward_batch_size();
+    if (n < batch_size) batch_size = n;
+    size_t mark = gann_arena_mark(arena);
+    Matrix* outputs = gann_arena_create_matrix(arena, batch_size, num_classes);
+    gann_real* discarded_scores = out_scores ? NULL : (gann_real*)gann_arena_alloc(arena, k * sizeof(gann_real));
+    if (!outputs || (!out_scores && !discarded_scores)) {
+        gann_arena_reset_to(arena, mark);
+        return 0; // the arena sets the error
     }
 
-    int correct_predictions = 0;
-    for (int i = 0; i < dataset->num_items; i++) {
-        int prediction = gann_predict(net, dataset->images->data[i]);
-        if (prediction == -1) {
-            // An error occurred in gann_predict, and it has set the error code.
-            // We can't continue evaluating, so we return 0.0 accuracy.
-            return 0.0;
+    const SimdKernels* kern = simd_kernels();
+    int ok = 1;
+    for (int i = 0; i < n; i += batch_size) {
+        int rows = n - i < batch_size ? n - i : batch_size;
+        MatrixView batch = { inputs + (size_t)i * input_size, rows, input_size, input_size };
+        Matrix batch_outputs = matrix_window_unchecked(outputs, 0, rows);
+        if (!nn_forward_batch_unchecked(net, batch, 0, &batch_outputs)) {
+            ok = 0; // the forward pass sets the error
+            break;
         }
-        int num_classes = net->architecture[net->num_layers - 1];
-        int true_class = get_true_class(dataset->labels->data[i], num_classes);
-
-        if (prediction == true_class) {
-            correct_predictions++;
+        for (int r = 0; r < rows; r++) {
+            size_t first = (size_t)(i + r) * k;
+            kern->top_k(num_classes, outputs->data[r], k, out_classes + first,
+                        out_scores ? out_scores + first : discarded_scores);
         }
     }
+    gann_arena_reset_to(arena, mark);
+    if (!ok) return 0;
+
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+double gann_evaluate(const NeuralNetwork* net, const Dataset* dataset) {
+    if (!nn_check_dataset(net, dataset)) return 0.0; // nn_check_dataset sets the error
+
+    int correct_predictions = count_correct_predictions(net, dataset, dataset->num_items);
+    if (correct_predictions < 0) {
+        // The forward pass failed and set the error code; no accuracy can be reported.
+        return 0.0;
+    }
 
     gann_set_error(GANN_SUCCESS);
     return (double)correct_predictions / dataset->num_items;
@@ -0,0 +1,831 @@
+#include "gemm.h"
+#include "matrix.h"
+#include "gann_errors.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include "gann_threads.h"
+#include "gann_backend.h"
+#include "gann_arena.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(GANN_USE_CBLAS)
+#include <cblas.h>
+#endif
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// --- Blocking Parameters ---
+// The MR x NR register tile comes from the active micro-kernel (see simd_kernels.h).
+// KC is chosen so that one packed NR-wide panel of B (KC * NR elements) stays in L1,
+// MC so that the packed MC x KC block of A stays in L2, and NC bounds the packed B block.
+#define GEMM_KC 256
+#define GEMM_MC 128
+#define GEMM_NC 2048
+
+_Static_assert(GEMM_MC % SIMD_MAX_MR == 0, "GEMM_MC must be a multiple of every micro-kernel MR");
+_Static_assert(GEMM_NC % SIMD_MAX_NR == 0, "GEMM_NC must be a multiple of every micro-kernel NR");
+// --- Packing Workspace ---
+// Each thread keeps its own packing buffers, allocated on first use and reused
+// across calls, so a steady-state GEMM never touches the allocator. Both live in
+// one block; the thread-local pointers give fast access, and the pthread key
+// only exists so the block is freed when its thread exits (pool workers exit
+// whenever gann_set_num_threads() restarts them).
+#define GEMM_PACK_A_ELEMENTS ((size_t)GEMM_MC * GEMM_KC)
+#define GEMM_PACK_B_ELEMENTS ((size_t)GEMM_KC * GEMM_NC)
+
+static GANN_THREAD_LOCAL gann_real* g_pack_a = NULL; // The start of the block
+static GANN_THREAD_LOCAL gann_real* g_pack_b = NULL;
+static pthread_key_t g_workspace_key;
+static pthread_once_t g_workspace_key_once = PTHREAD_ONCE_INIT;
+
+static gann_real* workspace_alloc(size_t count) {
+    size_t size = count * sizeof(gann_real);
+#if defined(_WIN32)
+    return (gann_real*)_aligned_malloc(size, MATRIX_ALIGNMENT);
+#else
+    void* block = NULL;
+    if (posix_memalign(&block, MATRIX_ALIGNMENT, size) != 0) return NULL;
+    return (gann_real*)block;
+#endif
+}
+
+static void workspace_destroy(void* block) {
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+static void workspace_key_create(void) {
+    pthread_key_create(&g_workspace_key, workspace_destroy);
+}
+
+static int ensure_workspace(void) {
+    if (g_pack_a) return 1;
+    gann_real* block = workspace_alloc(GEMM_PACK_A_ELEMENTS + GEMM_PACK_B_ELEMENTS);
+    if (!block) return 0;
+    pthread_once(&g_workspace_key_once, workspace_key_create);
+    pthread_setspecific(g_workspace_key, block);
+    g_pack_a = block;
+    g_pack_b = block + GEMM_PACK_A_ELEMENTS;
+    return 1;
+}
+
+// --- Packing ---
+// Operands are addressed through a row stride and a column stride, so the same
+// routines pack both row-major and transposed views.
+
+// Packs an mc x kc block of A into row micro-panels of MR rows.
+// Within a panel, element (i, p) lands at p * MR + i; rows past mc are zero.
+static void pack_a(int mc, int kc, const gann_real* a, int rsa, int csa, int MR, gann_real* out) {
+    for (int ir = 0; ir < mc; ir += MR) {
+        int mr = (mc - ir < MR) ? mc - ir : MR;
+        const gann_real* panel = a + (size_t)ir * rsa;
+        for (int p = 0; p < kc; p++) {
+            int i = 0;
+            for (; i < mr; i++) out[i] = panel[(size_t)i * rsa + (size_t)p * csa];
+            for (; i < MR; i++) out[i] = 0.0;
+            out += MR;
+        }
+    }
+}
+
+// Packs a kc x nc block of B into column micro-panels of NR columns.
+// Within a panel, element (p, j) lands at p * NR + j; columns past nc are zero.
+static void pack_b(int kc, int nc, const gann_real* b, int rsb, int csb, int NR, gann_real* out) {
+    for (int jr = 0; jr < nc; jr += NR) {
+        int nr = (nc - jr < NR) ? nc - jr : NR;
+        const gann_real* panel = b + (size_t)jr * csb;
+        for (int p = 0; p < kc; p++) {
+            const gann_real* src = panel + (size_t)p * rsb;
+            int j = 0;
+            if (csb == 1) {
+                memcpy(out, src, nr * sizeof(gann_real));
+                j = nr;
+            } else {
+                for (; j < nr; j++) out[j] = src[(size_t)j * csb];
+            }
+            for (; j < NR; j++) out[j] = 0.0;
+            out += NR;
+        }
+    }
+}
+
+// Packs a kc x nc block of 16-bit B (row-major, row stride ldb) like pack_b,
+// widening each row of the block once and then splitting it into the panels.
+static void pack_b_16(const SimdKernels* kern, int kc, int nc, const uint16_t* b, int ldb, NNWeightStorage format,
+                      int NR, gann_real* out) {
+    gann_real row[GEMM_NC];
+    for (int p = 0; p < kc; p++) {
+        kern->widen_16((size_t)nc, b + (size_t)p * ldb, row, format);
+        for (int jr = 0; jr < nc; jr += NR) {
+            int nr = (nc - jr < NR) ? nc - jr : NR;
+            gann_real* dst = out + (size_t)jr * kc + (size_t)p * NR;
+            memcpy(dst, row + jr, nr * sizeof(gann_real));
+            for (int j = nr; j < NR; j++) dst[j] = 0.0;
+        }
+    }
+}
+
+// --- Epilogue ---
+
+// Points `out` at the part of the epilogue that belongs to the block of C
+// starting at (row, col). Returns NULL when there is no epilogue.
+static const GemmEpilogue* epilogue_at(const GemmEpilogue* ep, int row, int col, GemmEpilogue* out) {
+    if (ep == NULL) return NULL;
+    *out = *ep;
+    if (out->bias) out->bias += col;
+    if (out->z) out->z += (size_t)row * ep->ldz + col;
+    return out;
+}
+
+void gemm_softmax_rows(const SimdKernels* kern, int m, int n, gann_real* c, int ldc, const GemmEpilogue* ep) {
+    if (ep == NULL || ep->activation != SOFTMAX) return;
+    for (int i = 0; i < m; i++) kern->softmax((size_t)n, c + (size_t)i * ldc);
+}
+
+// --- Blocked Driver ---
+
+// The two innermost loops: every MR x NR tile of the mc x nc block of C whose
+// top-left element is (ic, jc), from a packed block of A and a packed block of B.
+// The epilogue, if any, is applied to each tile.
+static void gemm_macro(const SimdKernels* kern, int mc, int nc, int kc, const gann_real* packed_a,
+                       const gann_real* packed_b, gann_real beta, gann_real* c, int ldc, int ic, int jc,
+                       const GemmEpilogue* ep) {
+    const int MR = kern->gemm_mr;
+    const int NR = kern->gemm_nr;
+    for (int jr = 0; jr < nc; jr += NR) {
+        int nr = (nc - jr < NR) ? nc - jr : NR;
+        const gann_real* b_panel = packed_b + (size_t)jr * kc;
+
+        for (int ir = 0; ir < mc; ir += MR) {
+            int mr = (mc - ir < MR) ? mc - ir : MR;
+            const gann_real* a_panel = packed_a + (size_t)ir * kc;
+            gann_real* c_tile = c + (size_t)(ic + ir) * ldc + jc + jr;
+            GemmEpilogue tile_ep;
+            kern->gemm_micro(kc, a_panel, b_panel, beta, c_tile, ldc, mr, nr, epilogue_at(ep, ic + ir, jc + jr, &tile_ep));
+        }
+    }
+}
+
+// The five loops around the micro-kernel (Goto/BLIS ordering): NC columns of B,
+// KC-deep rank updates, MC rows of A, then NR and MR register tiles. The
+// epilogue, if any, is handed to the micro-kernel on the last rank update only,
+// when each tile of C holds its final sums. When `b16` is not NULL, B is read
+// from it instead of `b`: 16-bit values in `b16_format`, row stride `rsb`.
+static void gemm_blocked(const SimdKernels* kern, int m, int n, int k, const gann_real* a, int rsa, int csa,
+                         const gann_real* b, int rsb, int csb, const uint16_t* b16, NNWeightStorage b16_format,
+                         gann_real beta, gann_real* c, int ldc, const GemmEpilogue* ep) {
+    const int MR = kern->gemm_mr;
+    const int NR = kern->gemm_nr;
+
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            // Only the first rank update applies the caller's beta; later ones accumulate.
+            gann_real beta_block = (pc == 0) ? beta : 1.0;
+            int last_update = (pc + kc >= k);
+
+            if (b16) pack_b_16(kern, kc, nc, b16 + (size_t)pc * rsb + jc, rsb, b16_format, NR, g_pack_b);
+            else pack_b(kc, nc, b + (size_t)pc * rsb + (size_t)jc * csb, rsb, csb, NR, g_pack_b);
+
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = (m - ic < GEMM_MC) ? m - ic : GEMM_MC;
+
+                pack_a(mc, kc, a + (size_t)ic * rsa + (size_t)pc * csa, rsa, csa, MR, g_pack_a);
+                gemm_macro(kern, mc, nc, kc, g_pack_a, g_pack_b, beta_block, c, ldc, ic, jc,
+                           last_update ? ep : NULL);
+            }
+        }
+    }
+}
+
+// --- Parallel Driver ---
+// A large product is split into strips of C along M (in whole MR tiles) or N (in
+// whole NR tiles), and each strip runs the blocked driver with its own packing
+// buffers. Every element of C still sees the same KC blocking and the same
+// micro-kernel arithmetic, so the result does not depend on the thread count.
+
+// Multiply-adds a thread must get before splitting a product pays for the hand-off.
+#define GEMM_PARALLEL_MIN_WORK (1 << 20)
+
+typedef struct {
+    const SimdKernels* kern;
+    int m, n, k;
+    const gann_real* a;
+    int rsa, csa;
+    const gann_real* b;
+    int rsb, csb;
+    const uint16_t* b16;
+    NNWeightStorage b16_format;
+    gann_real beta;
+    gann_real* c;
+    int ldc;
+    const GemmEpilogue* ep;
+    int split_m;                          // Strips run along M (1) or N (0)
+    int num_tasks;
+    unsigned char failed[GANN_MAX_THREADS]; // Tasks whose thread could not allocate its packing buffers
+} GemmJob;
+
+static void gemm_task(void* arg, int task) {
+    GemmJob* job = (GemmJob*)arg;
+    int unit = job->split_m ? job->kern->gemm_mr : job->kern->gemm_nr;
+    int extent = job->split_m ? job->m : job->n;
+    int tiles = (extent + unit - 1) / unit;
+    int begin = (int)((long)tiles * task / job->num_tasks) * unit;
+    int end = (int)((long)tiles * (task + 1) / job->num_tasks) * unit;
+    if (end > extent) end = extent;
+    if (begin >= end) return;
+    if (!ensure_workspace()) {
+        job->failed[task] = 1;
+        return;
+    }
+    GemmEpilogue strip_ep;
+    if (job->split_m) {
+        gemm_blocked(job->kern, end - begin, job->n, job->k, job->a + (size_t)begin * job->rsa, job->rsa, job->csa,
+                     job->b, job->rsb, job->csb, job->b16, job->b16_format,
+                     job->beta, job->c + (size_t)begin * job->ldc, job->ldc, epilogue_at(job->ep, begin, 0, &strip_ep));
+    } else {
+        gemm_blocked(job->kern, job->m, end - begin, job->k, job->a, job->rsa, job->csa,
+                     job->b16 ? NULL : job->b + (size_t)begin * job->csb, job->rsb, job->csb,
+                     job->b16 ? job->b16 + begin : NULL, job->b16_format,
+                     job->beta, job->c + begin, job->ldc, epilogue_at(job->ep, 0, begin, &strip_ep));
+    }
+}
+
+// Runs the blocked driver, on several threads when the product is large enough.
+// The caller has already set up its own packing buffers.
+static void gemm_parallel(const SimdKernels* kern, int m, int n, int k, const gann_real* a, int rsa, int csa,
+                          const gann_real* b, int rsb, int csb, const uint16_t* b16, NNWeightStorage b16_format,
+                          gann_real beta, gann_real* c, int ldc, const GemmEpilogue* ep) {
+    double work = (double)m * n * k;
+    int num_tasks = thread_pool_size();
+    if (work / num_tasks < GEMM_PARALLEL_MIN_WORK) {
+        num_tasks = (int)(work / GEMM_PARALLEL_MIN_WORK);
+    }
+    // Split the longer side of C so that each strip still spans many tiles.
+    int split_m = m >= n;
+    int unit = split_m ? kern->gemm_mr : kern->gemm_nr;
+    int tiles = ((split_m ? m : n) + unit - 1) / unit;
+    if (num_tasks > tiles) num_tasks = tiles;
+    if (num_tasks <= 1) {
+        gemm_blocked(kern, m, n, k, a, rsa, csa, b, rsb, csb, b16, b16_format, beta, c, ldc, ep);
+        return;
+    }
+
+    GemmJob job = {
+        .kern = kern, .m = m, .n = n, .k = k, .a = a, .rsa = rsa, .csa = csa,
+        .b = b, .rsb = rsb, .csb = csb, .b16 = b16, .b16_format = b16_format,
+        .beta = beta, .c = c, .ldc = ldc, .ep = ep,
+        .split_m = split_m, .num_tasks = num_tasks,
+    };
+    memset(job.failed, 0, sizeof(job.failed));
+    thread_pool_run(num_tasks, gemm_task, &job);
+    // A worker that could not allocate left its strip untouched; finish it here,
+    // where the buffers are known to exist.
+    for (int t = 0; t < num_tasks; t++) {
+        if (job.failed[t]) {
+            job.failed[t] = 0;
+            gemm_task(&job, t);
+        }
+    }
+}
+
+// --- Row-Dot Path ---
+
+// Computes C = A * B^T + beta * C for products with few rows: both A and the
+// stored B are walked along their contiguous rows, so every element of C is one
+// dot product.
+static void gemm_rows_nt(const SimdKernels* kern, int m, int n, int k, const gann_real* a, int lda,
+                         const gann_real* b, int ldb, gann_real beta, gann_real* c, int ldc) {
+    for (int i = 0; i < m; i++) {
+        const gann_real* a_row = a + (size_t)i * lda;
+        gann_real* c_row = c + (size_t)i * ldc;
+        for (int j = 0; j < n; j++) {
+            gann_real sum = kern->dot((size_t)k, a_row, b + (size_t)j * ldb);
+            if (beta == 0.0) c_row[j] = sum;
+            else if (beta == 1.0) c_row[j] += sum;
+            else c_row[j] = beta * c_row[j] + sum;
+        }
+    }
+}
+
+// --- Backend Selection ---
+
+#if defined(GANN_USE_CBLAS)
+#if defined(GANN_FLOAT32)
+#define CBLAS_GEMM cblas_sgemm
+#else
+#define CBLAS_GEMM cblas_dgemm
+#endif
+#endif
+
+// -1 until first use; then a GannGemmBackend. Atomic because any thread may
+// set the backend while others run products.
+static atomic_int g_backend = -1;
+
+// Parses GANN_GEMM_BACKEND. Returns -1 when it is unset or not recognized.
+static int backend_from_environment(void) {
+    const char* value = getenv("GANN_GEMM_BACKEND");
+    if (value == NULL) return -1;
+    for (int backend = GANN_GEMM_BUILTIN; backend <= GANN_GEMM_CBLAS; backend++) {
+        if (strcmp(value, gann_gemm_backend_name((GannGemmBackend)backend)) == 0) return backend;
+    }
+    return -1;
+}
+
+static int backend_available(int backend) {
+#if defined(GANN_USE_CBLAS)
+    return backend == GANN_GEMM_BUILTIN || backend == GANN_GEMM_CBLAS;
+#else
+    return backend == GANN_GEMM_BUILTIN;
+#endif
+}
+
+// A build linked against a BLAS uses it unless the environment asks otherwise.
+static GannGemmBackend active_backend(void) {
+    int backend = atomic_load(&g_backend);
+    if (backend < 0) {
+        int requested = backend_from_environment();
+#if defined(GANN_USE_CBLAS)
+        int chosen = backend_available(requested) ? requested : GANN_GEMM_CBLAS;
+#else
+        int chosen = backend_available(requested) ? requested : GANN_GEMM_BUILTIN;
+#endif
+        // A backend set by another thread in the meantime wins.
+        atomic_compare_exchange_strong(&g_backend, &backend, chosen);
+        backend = atomic_load(&g_backend);
+    }
+    return (GannGemmBackend)backend;
+}
+
+// --- Entry Points ---
+
+// Products with fewer rows than one register tile, or fewer rank-1 updates than
+// that, do not amortize the packing and are computed directly.
+static int use_unpacked(const SimdKernels* kern, int m, int k) {
+    return m < kern->gemm_mr || k < kern->gemm_mr || !ensure_workspace();
+}
+
+void gemm_nn(int m, int n, int k,
+             const gann_real* a, int lda,
+             const gann_real* b, int ldb,
+             gann_real beta, gann_real* c, int ldc) {
+    gemm_nn_epilogue(m, n, k, a, lda, b, ldb, beta, c, ldc, NULL);
+}
+
+void gemm_nn_epilogue(int m, int n, int k,
+                      const gann_real* a, int lda,
+                      const gann_real* b, int ldb,
+                      gann_real beta, gann_real* c, int ldc,
+                      const GemmEpilogue* ep) {
+    if (m <= 0 || n <= 0) return;
+    const SimdKernels* kern = simd_kernels();
+#if defined(GANN_USE_CBLAS)
+    if (k > 0 && active_backend() == GANN_GEMM_CBLAS) {
+        CBLAS_GEMM(CblasRowMajor, CblasNoTrans, CblasNoTrans, m, n, k, 1, a, lda, b, ldb, beta, c, ldc);
+        // The BLAS cannot run our epilogue, so it follows as one pass over C.
+        for (int i = 0; ep && i < m; i++) {
+            GemmEpilogue row_ep;
+            kern->epilogue_row(n, c + (size_t)i * ldc, epilogue_at(ep, i, 0, &row_ep));
+        }
+        gemm_softmax_rows(kern, m, n, c, ldc, ep);
+        return;
+    }
+#endif
+    if (k <= 0 || use_unpacked(kern, m, k)) {
+        kern->gemm_rows(m, n, k > 0 ? k : 0, a, lda, 1, b, ldb, beta, c, ldc, ep);
+    } else {
+        gemm_parallel(kern, m, n, k, a, lda, 1, b, ldb, 1, NULL, NN_STORAGE_NATIVE, beta, c, ldc, ep);
+    }
+    gemm_softmax_rows(kern, m, n, c, ldc, ep);
+}
+
+void gemm_tn(int m, int n, int k,
+             const gann_real* a, int lda,
+             const gann_real* b, int ldb,
+             gann_real beta, gann_real* c, int ldc) {
+    if (m <= 0 || n <= 0) return;
+#if defined(GANN_USE_CBLAS)
+    if (k > 0 && active_backend() == GANN_GEMM_CBLAS) {
+        CBLAS_GEMM(CblasRowMajor, CblasTrans, CblasNoTrans, m, n, k, 1, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+#endif
+    const SimdKernels* kern = simd_kernels();
+    // Element (i, p) of A^T is a[p * lda + i]: row stride 1, column stride lda.
+    if (k <= 0 || use_unpacked(kern, m, k)) {
+        kern->gemm_rows(m, n, k > 0 ? k : 0, a, 1, lda, b, ldb, beta, c, ldc, NULL);
+        return;
+    }
+    gemm_parallel(kern, m, n, k, a, 1, lda, b, ldb, 1, NULL, NN_STORAGE_NATIVE, beta, c, ldc, NULL);
+}
+
+void gemm_nt(int m, int n, int k,
+             const gann_real* a, int lda,
+             const gann_real* b, int ldb,
+             gann_real beta, gann_real* c, int ldc) {
+    if (m <= 0 || n <= 0) return;
+#if defined(GANN_USE_CBLAS)
+    if (k > 0 && active_backend() == GANN_GEMM_CBLAS) {
+        CBLAS_GEMM(CblasRowMajor, CblasNoTrans, CblasTrans, m, n, k, 1, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+#endif
+    const SimdKernels* kern = simd_kernels();
+    // Element (p, j) of B^T is b[j * ldb + p]: row stride 1, column stride ldb.
+    if (k <= 0 || use_unpacked(kern, m, k)) {
+        gemm_rows_nt(kern, m, n, k > 0 ? k : 0, a, lda, b, ldb, beta, c, ldc);
+        return;
+    }
+    gemm_parallel(kern, m, n, k, a, lda, 1, b, 1, ldb, NULL, NN_STORAGE_NATIVE, beta, c, ldc, NULL);
+}
+
+// --- 16-bit B ---
+
+int gemm_nn_16(int m, int n, int k,
+               const gann_real* a, int lda,
+               const uint16_t* b, int ldb, NNWeightStorage format,
+               gann_real* c, int ldc, const GemmEpilogue* ep) {
+    if (m <= 0 || n <= 0) return 1;
+    const SimdKernels* kern = simd_kernels();
+    if (!ensure_workspace()) return 0;
+    if (k > 0 && m >= kern->gemm_mr && k >= kern->gemm_mr) {
+        gemm_parallel(kern, m, n, k, a, lda, 1, NULL, ldb, 1, b, format, 0.0, c, ldc, ep);
+    } else {
+        // Few rows: each row of C reads B at its 16-bit size, widening it in registers.
+        for (int i = 0; i < m; i++) {
+            GemmEpilogue row_ep;
+            kern->gemm_row_16(n, k, a + (size_t)i * lda, b, ldb, format, c + (size_t)i * ldc, epilogue_at(ep, i, 0, &row_ep));
+        }
+    }
+    gemm_softmax_rows(kern, m, n, c, ldc, ep);
+    return 1;
+}
+
+// --- Prepacked B ---
+// A B that is multiplied many times, such as a layer of a compiled plan, is
+// packed once into exactly the panels gemm_blocked would build for it: for each
+// NC block of columns, its KC blocks of rows in turn. Every NC block but the
+// last is NC wide, so the block at (jc, pc) starts at jc * k + ncr * pc, where
+// ncr is that block's width rounded up to NR.
+
+size_t gemm_packed_b_size(const SimdKernels* kern, int n, int k) {
+    size_t NR = (size_t)kern->gemm_nr;
+    return ((size_t)n + NR - 1) / NR * NR * (size_t)k;
+}
+
+size_t gemm_packed_a_size(const SimdKernels* kern, int m, int k) {
+    int MR = kern->gemm_mr;
+    int mc = (m + MR - 1) / MR * MR;
+    if (mc > GEMM_MC) mc = GEMM_MC;
+    return (size_t)mc * (k < GEMM_KC ? k : GEMM_KC);
+}
+
+void gemm_pack_b(const SimdKernels* kern, int n, int k, const gann_real* b, int ldb, gann_real* packed_b) {
+    const int NR = kern->gemm_nr;
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+        int ncr = (nc + NR - 1) / NR * NR;
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            pack_b(kc, nc, b + (size_t)pc * ldb + jc, ldb, 1, NR, packed_b + (size_t)jc * k + (size_t)ncr * pc);
+        }
+    }
+}
+
+void gemm_nn_prepacked(const SimdKernels* kern, int m, int n, int k,
+                       const gann_real* a, int lda, const gann_real* packed_b,
+                       gann_real* c, int ldc, const GemmEpilogue* ep, gann_real* packed_a) {
+    const int MR = kern->gemm_mr;
+    const int NR = kern->gemm_nr;
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = (n - jc < GEMM_NC) ? n - jc : GEMM_NC;
+        int ncr = (nc + NR - 1) / NR * NR;
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            const gann_real* block_b = packed_b + (size_t)jc * k + (size_t)ncr * pc;
+            int last_update = (pc + kc >= k);
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = (m - ic < GEMM_MC) ? m - ic : GEMM_MC;
+                pack_a(mc, kc, a + (size_t)ic * lda + pc, lda, 1, MR, packed_a);
+                gemm_macro(kern, mc, nc, kc, packed_a, block_b, pc == 0 ? 0.0 : 1.0, c, ldc, ic, jc,
+                           last_update ? ep : NULL);
+            }
+        }
+    }
+    gemm_softmax_rows(kern, m, n, c, ldc, ep);
+}
+
+// --- Batched Products ---
+// A batch runs many products of one shape, such as one layer of every network
+// of a population, as a single job. Consecutive products that read the same A
+// are blocked together: their blocks of B are packed side by side, up to NC
+// columns, and each MC x KC block of A is packed once for all of them. Every
+// product still goes through the blocking and micro-kernels of gemm_blocked, so
+// its result is exactly what gemm_nn_epilogue computes for it alone. Threads
+// take contiguous ranges of the batch.
+
+// Products of one shape sharing an A, as many as fit side by side in the B buffer.
+#define GEMM_BATCH_GROUP 64
+
+// Where the operands of each product are: listed per product, or at fixed
+// distances from those of the first.
+typedef struct {
+    const GemmBatchItem* items; // NULL for a strided batch
+    GemmBatchItem first;
+    size_t stride_a, stride_b, stride_c;
+    const GemmEpilogue* ep;     // Strided batch: one epilogue per product, or NULL
+} GemmBatch;
+
+static GemmBatchItem batch_item(const GemmBatch* batch, int t) {
+    if (batch->items) return batch->items[t];
+    GemmBatchItem item = batch->first;
+    item.a += (size_t)t * batch->stride_a;
+    item.b += (size_t)t * batch->stride_b;
+    item.c += (size_t)t * batch->stride_c;
+    item.ep = batch->ep ? batch->ep + t : NULL;
+    return item;
+}
+
+// Runs products [first, last) of a batch on this thread's packing buffers.
+static void gemm_blocked_batch(const SimdKernels* kern, int m, int n, int k, const GemmBatch* batch,
+                               int first, int last, gann_real beta) {
+    const int MR = kern->gemm_mr;
+    const int NR = kern->gemm_nr;
+    // Columns one packed B takes in the buffer, and how many fit.
+    int width = (n + NR - 1) / NR * NR;
+    int max_group = GEMM_NC / width;
+    if (max_group > GEMM_BATCH_GROUP) max_group = GEMM_BATCH_GROUP;
+
+    GemmBatchItem group[GEMM_BATCH_GROUP];
+    for (int t = first; t < last;) {
+        group[0] = batch_item(batch, t);
+        const GemmBatchItem* lead = &group[0];
+        if (max_group < 1) {
+            // A single B wider than the buffer: the plain driver splits it.
+            gemm_blocked(kern, m, n, k, lead->a, lead->lda, 1, lead->b, lead->ldb, 1, NULL, NN_STORAGE_NATIVE,
+                         beta, lead->c, lead->ldc, lead->ep);
+            t++;
+            continue;
+        }
+        int size = 1;
+        while (size < max_group && t + size < last) {
+            group[size] = batch_item(batch, t + size);
+            if (group[size].a != lead->a || group[size].lda != lead->lda) break;
+            size++;
+        }
+
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = (k - pc < GEMM_KC) ? k - pc : GEMM_KC;
+            gann_real beta_block = (pc == 0) ? beta : 1.0;
+            int last_update = (pc + kc >= k);
+
+            for (int g = 0; g < size; g++) {
+                pack_b(kc, n, group[g].b + (size_t)pc * group[g].ldb, group[g].ldb, 1, NR, g_pack_b + (size_t)g * width * kc);
+            }
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = (m - ic < GEMM_MC) ? m - ic : GEMM_MC;
+
+                pack_a(mc, kc, lead->a + (size_t)ic * lead->lda + pc, lead->lda, 1, MR, g_pack_a);
+                for (int g = 0; g < size; g++) {
+                    gemm_macro(kern, mc, n, kc, g_pack_a, g_pack_b + (size_t)g * width * kc, beta_block,
+                               group[g].c, group[g].ldc, ic, 0, last_update ? group[g].ep : NULL);
+                }
+            }
+        }
+        t += size;
+    }
+}
+
+typedef struct {
+    const SimdKernels* kern;
+    int m, n, k;
+    const GemmBatch* batch;
+    int count;
+    gann_real beta;
+    int packed;                           // Blocked driver (1) or row kernel (0)
+    int num_tasks;
+    unsigned char failed[GANN_MAX_THREADS]; // Tasks whose thread could not allocate its packing buffers
+} GemmBatchJob;
+
+static void gemm_batch_task(void* arg, int task) {
+    GemmBatchJob* job = (GemmBatchJob*)arg;
+    int begin = (int)((long)job->count * task / job->num_tasks);
+    int end = (int)((long)job->count * (task + 1) / job->num_tasks);
+    if (begin >= end) return;
+    if (!job->packed) {
+        for (int t = begin; t < end; t++) {
+            GemmBatchItem item = batch_item(job->batch, t);
+            job->kern->gemm_rows(job->m, job->n, job->k, item.a, item.lda, 1, item.b, item.ldb, job->beta,
+                                 item.c, item.ldc, item.ep);
+        }
+        return;
+    }
+    if (!ensure_workspace()) {
+        job->failed[task] = 1;
+        return;
+    }
+    gemm_blocked_batch(job->kern, job->m, job->n, job->k, job->batch, begin, end, job->beta);
+}
+
+static void gemm_batch_products(const SimdKernels* kern, int count, int m, int n, int k, const GemmBatch* batch,
+                                gann_real beta) {
+    int packed = k > 0 && !use_unpacked(kern, m, k);
+    double work = (double)count * m * n * (k > 0 ? k : 1);
+    int num_tasks = thread_pool_size();
+    if (work / num_tasks < GEMM_PARALLEL_MIN_WORK) {
+        num_tasks = (int)(work / GEMM_PARALLEL_MIN_WORK);
+    }
+    if (packed && count < num_tasks) {
+        // Fewer products than threads: split each product instead.
+        for (int t = 0; t < count; t++) {
+            GemmBatchItem item = batch_item(batch, t);
+            gemm_parallel(kern, m, n, k, item.a, item.lda, 1, item.b, item.ldb, 1, NULL, NN_STORAGE_NATIVE,
+                          beta, item.c, item.ldc, item.ep);
+        }
+        return;
+    }
+    if (num_tasks < 1) num_tasks = 1;
+
+    GemmBatchJob job = {
+        .kern = kern, .m = m, .n = n, .k = k, .batch = batch, .count = count, .beta = beta,
+        .packed = packed, .num_tasks = num_tasks,
+    };
+    memset(job.failed, 0, sizeof(job.failed));
+    if (num_tasks == 1) {
+        gemm_batch_task(&job, 0); // this thread's buffers were set up by use_unpacked
+        return;
+    }
+    thread_pool_run(num_tasks, gemm_batch_task, &job);
+    for (int t = 0; t < num_tasks; t++) {
+        if (job.failed[t]) {
+            job.failed[t] = 0;
+            gemm_batch_task(&job, t);
+        }
+    }
+}
+
+static void gemm_batch_run(int count, int m, int n, int k, const GemmBatch* batch, gann_real beta) {
+    if (count <= 0 || m <= 0 || n <= 0) return;
+    if (k < 0) k = 0;
+    const SimdKernels* kern = simd_kernels();
+#if defined(GANN_USE_CBLAS)
+    if (k > 0 && active_backend() == GANN_GEMM_CBLAS) {
+        for (int t = 0; t < count; t++) {
+            GemmBatchItem item = batch_item(batch, t);
+            gemm_nn_epilogue(m, n, k, item.a, item.lda, item.b, item.ldb, beta, item.c, item.ldc, item.ep);
+        }
+        return;
+    }
+#endif
+    gemm_batch_products(kern, count, m, n, k, batch, beta);
+    for (int t = 0; t < count; t++) {
+        GemmBatchItem item = batch_item(batch, t);
+        gemm_softmax_rows(kern, m, n, item.c, item.ldc, item.ep);
+    }
+}
+
+void gemm_nn_batch(int count, int m, int n, int k, const GemmBatchItem* items, gann_real beta) {
+    GemmBatch batch = { .items = items };
+    gemm_batch_run(count, m, n, k, &batch, beta);
+}
+
+void gemm_nn_batch_strided(int count, int m, int n, int k,
+                           const gann_real* a, int lda, size_t stride_a,
+                           const gann_real* b, int ldb, size_t stride_b,
+                           gann_real beta, gann_real* c, int ldc, size_t stride_c,
+                           const GemmEpilogue* ep) {
+    GemmBatch batch = {
+        .first = { .a = a, .lda = lda, .b = b, .ldb = ldb, .c = c, .ldc = ldc },
+        .stride_a = stride_a, .stride_b = stride_b, .stride_c = stride_c, .ep = ep,
+    };
+    gemm_batch_run(count, m, n, k, &batch, beta);
+}
+
+// --- Sparse Products ---
+// A CSR operand is given by its row_start (rows + 1 offsets), col_index and
+// values arrays. None of these use the BLAS or the thread pool: their cost is
+// proportional to the nonzeros, which is the point of storing them sparsely.
+
+void gemm_csr_nn(int m, int n,
+                 const int* row_start, const int* col_index, const gann_real* values,
+                 const gann_real* b, int ldb,
+                 gann_real* c, int ldc, const GemmEpilogue* ep) {
+    if (m <= 0 || n <= 0) return;
+    const SimdKernels* kern = simd_kernels();
+    for (int i = 0; i < m; i++) {
+        GemmEpilogue row_ep;
+        int first = row_start[i];
+        kern->gemm_csr_row(n, row_start[i + 1] - first, col_index + first, values + first, b, ldb,
+                           c + (size_t)i * ldc, ep ? epilogue_at(ep, i, 0, &row_ep) : NULL);
+    }
+    gemm_softmax_rows(kern, m, n, c, ldc, ep);
+}
+
+// Batches of at least this many rows run the dense x CSR product transposed.
+#define CSR_TRANSPOSE_MIN_ROWS 8
+
+// C^T = B^T * A^T: every nonzero B[p][j] becomes one axpy of A's column p into
+// row j of C^T, each as long as the batch, instead of one scalar update per row
+// of A. Returns 0 if the scratch buffers cannot be allocated.
+static int gemm_nn_csr_transposed(const SimdKernels* kern, int m, int n, int k,
+                                  const gann_real* a, int lda,
+                                  const int* row_start, const int* col_index, const gann_real* values,
+                                  gann_real* c, int ldc) {
+    GannArena* arena = gann_scratch_arena();
+    size_t mark = gann_arena_mark(arena);
+    gann_real* at = (gann_real*)gann_arena_alloc(arena, (size_t)k * m * sizeof(gann_real));
+    gann_real* ct = (gann_real*)gann_arena_alloc(arena, (size_t)n * m * sizeof(gann_real));
+    if (!at || !ct) {
+        gann_arena_reset_to(arena, mark);
+        return 0;
+    }
+    for (int i = 0; i < m; i++) {
+        for (int p = 0; p < k; p++) at[(size_t)p * m + i] = a[(size_t)i * lda + p];
+    }
+    memset(ct, 0, (size_t)n * m * sizeof(gann_real));
+    for (int p = 0; p < k; p++) {
+        for (int q = row_start[p]; q < row_start[p + 1]; q++) {
+            kern->axpy((size_t)m, values[q], at + (size_t)p * m, ct + (size_t)col_index[q] * m);
+        }
+    }
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) c[(size_t)i * ldc + j] = ct[(size_t)j * m + i];
+    }
+    gann_arena_reset_to(arena, mark);
+    return 1;
+}
+
+void gemm_nn_csr(int m, int n, int k,
+                 const gann_real* a, int lda,
+                 const int* row_start, const int* col_index, const gann_real* values,
+                 gann_real* c, int ldc, const GemmEpilogue* ep) {
+    if (m <= 0 || n <= 0) return;
+    const SimdKernels* kern = simd_kernels();
+    if (m < CSR_TRANSPOSE_MIN_ROWS ||
+        !gemm_nn_csr_transposed(kern, m, n, k, a, lda, row_start, col_index, values, c, ldc)) {
+        for (int i = 0; i < m; i++) {
+            const gann_real* restrict a_row = a + (size_t)i * lda;
+            gann_real* restrict c_row = c + (size_t)i * ldc;
+            memset(c_row, 0, (size_t)n * sizeof(gann_real));
+            // Scatter each nonzero of B, scaled by the matching entry of A; zeros in
+            // A (ReLU outputs, for instance) skip their whole row of B.
+            for (int p = 0; p < k; p++) {
+                const gann_real ap = a_row[p];
+                if (ap == 0) continue;
+                for (int q = row_start[p]; q < row_start[p + 1]; q++) {
+                    c_row[col_index[q]] += ap * values[q];
+                }
+            }
+        }
+    }
+    for (int i = 0; ep && i < m; i++) {
+        GemmEpilogue row_ep;
+        kern->epilogue_row(n, c + (size_t)i * ldc, epilogue_at(ep, i, 0, &row_ep));
+    }
+    gemm_softmax_rows(kern, m, n, c, ldc, ep);
+}
+
+void gemm_csr_tn_accumulate(int k, int n,
+                            const int* row_start, const int* col_index, const gann_real* values,
+                            const gann_real* b, int ldb,
+                            gann_real* c, int ldc) {
+    if (n <= 0) return;
+    const SimdKernels* kern = simd_kernels();
+    // Row i of A contributes a[i][j] * B[i, :] to row j of C.
+    for (int i = 0; i < k; i++) {
+        const gann_real* b_row = b + (size_t)i * ldb;
+        for (int q = row_start[i]; q < row_start[i + 1]; q++) {
+            kern->axpy((size_t)n, values[q], b_row, c + (size_t)col_index[q] * ldc);
+        }
+    }
+}
+
+// --- Public API Functions ---
+
+GannGemmBackend gann_gemm_get_backend(void) {
+    return active_backend();
+}
+
+int gann_gemm_set_backend(GannGemmBackend backend) {
+    if (!backend_available((int)backend)) {
+        return 0;
+    }
+    atomic_store(&g_backend, (int)backend);
+    return 1;
+}
+
+const char* gann_gemm_backend_name(GannGemmBackend backend) {
+    switch (backend) {
+        case GANN_GEMM_BUILTIN: return "builtin";
+        case GANN_GEMM_CBLAS: return "cblas";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,282 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+/**
+ * @file gemm.h
+ * @internal
+ * @brief The general matrix-multiply engine behind `dot_product()`.
+ * @details Private to the library. All operands are row-major with an explicit
+ * leading dimension (the row stride, in elements). The engine splits the
+ * problem into cache-sized blocks (KC for L1, MC for L2, NC for L3), packs each
+ * block of A and B into contiguous micro-panels, and computes every MR x NR tile
+ * of C in registers with a micro-kernel. Products with very few rows, such as
+ * the 1xN per-sample products of the forward pass, skip packing and stream B
+ * directly.
+ *
+ * Transposed operands are read in place through their strides (`gemm_tn`,
+ * `gemm_nt`); no transposed copy is ever materialized.
+ *
+ * `gemm_nn_epilogue` additionally folds a bias and an activation into the
+ * write-back of C (see `GemmEpilogue`), so a network layer costs one pass over
+ * its output instead of three.
+ *
+ * `gemm_nn_batch` and `gemm_nn_batch_strided` run many products of one shape
+ * as a single job, sharing the packing of a common A.
+ *
+ * `gemm_pack_b` packs a B once for any number of `gemm_nn_prepacked` products.
+ *
+ * In a `GANN_USE_CBLAS` build the entry points forward to `cblas_?gemm` while
+ * that backend is selected (see `gann_backend.h`).
+ *
+ * The `gemm_*csr*` routines take one operand in compressed sparse row form
+ * (see `SparseMatrix`), and `gemm_nn_16` a B of 16-bit weights (see
+ * `NNWeightStorage`); both always run on the built-in kernels.
+ */
+
+#include "gann_real.h"
+#include "simd_kernels.h"
+
+/**
+ * @internal
+ * @brief Computes `C = A * B + beta * C`.
+ * @param m Rows of A and C.
+ * @param n Columns of B and C.
+ * @param k Columns of A and rows of B.
+ * @param a Pointer to A (`m x k`), row stride `lda`.
+ * @param lda Row stride of A.
+ * @param b Pointer to B (`k x n`), row stride `ldb`.
+ * @param ldb Row stride of B.
+ * @param beta Scale applied to the existing contents of C. With `beta == 0`
+ *        C is overwritten and never read.
+ * @param c Pointer to C (`m x n`), row stride `ldc`.
+ * @param ldc Row stride of C.
+ */
+void gemm_nn(int m, int n, int k,
+             const gann_real* a, int lda,
+             const gann_real* b, int ldb,
+             gann_real beta, gann_real* c, int ldc);
+
+/**
+ * @internal
+ * @brief Computes `C = f(A * B + beta * C + bias)` in one pass over C.
+ * @details Same as `gemm_nn()` followed by the epilogue `ep`, which each
+ * micro-kernel applies to its tile before storing it. With `ep == NULL` this is
+ * exactly `gemm_nn()`. The results match the unfused sequence of product, bias
+ * addition and activation.
+ * @param ep The bias, activation and optional pre-activation output, or NULL.
+ */
+void gemm_nn_epilogue(int m, int n, int k,
+                      const gann_real* a, int lda,
+                      const gann_real* b, int ldb,
+                      gann_real beta, gann_real* c, int ldc,
+                      const GemmEpilogue* ep);
+
+/**
+ * @internal
+ * @brief Normalizes every row of C if `ep` asks for `SOFTMAX`, and does nothing otherwise.
+ * @details The entry points here call it once their product is complete (see
+ * `GemmEpilogue`); code that calls a row kernel directly calls it afterwards.
+ */
+void gemm_softmax_rows(const SimdKernels* kern, int m, int n, gann_real* c, int ldc, const GemmEpilogue* ep);
+
+/**
+ * @internal
+ * @brief Computes `C = f(A * B + bias)` for a B stored as 16-bit values.
+ * @details B is widened to `gann_real` block by block as it is packed, so the
+ * micro-kernels, and the accumulation in `gann_real`, are those of
+ * `gemm_nn_epilogue()`; only half as many (float) or a quarter as many (double)
+ * bytes of B are read from memory. With fewer rows than a register tile, each
+ * row of C is instead swept over B, widening it in registers and skipping rows
+ * of B that the row of A multiplies by zero. Always runs on the built-in kernels.
+ * @param b Pointer to B (`k x n`), row stride `ldb`.
+ * @param format `NN_STORAGE_FP16` or `NN_STORAGE_BF16`.
+ * @param c Pointer to C (`m x n`), row stride `ldc`. Overwritten, never read.
+ * @param ep The bias, activation and optional pre-activation output, or NULL.
+ * @return 1 on success, 0 if this thread's packing buffers cannot be allocated.
+ */
+int gemm_nn_16(int m, int n, int k,
+               const gann_real* a, int lda,
+               const uint16_t* b, int ldb, NNWeightStorage format,
+               gann_real* c, int ldc, const GemmEpilogue* ep);
+
+/**
+ * @internal
+ * @brief The number of elements `gemm_pack_b()` writes for a `k x n` B.
+ * @param kern The kernels the packed B will be used with; the layout depends on their tile.
+ */
+size_t gemm_packed_b_size(const SimdKernels* kern, int n, int k);
+
+/**
+ * @internal
+ * @brief Packs a whole `k x n` B into the panel layout of the blocked driver.
+ * @details The result can be multiplied any number of times by
+ * `gemm_nn_prepacked()` with the same `kern`, without packing B again.
+ * @param b Pointer to B (`k x n`), row stride `ldb`.
+ * @param packed_b Receives `gemm_packed_b_size(kern, n, k)` elements.
+ */
+void gemm_pack_b(const SimdKernels* kern, int n, int k, const gann_real* b, int ldb, gann_real* packed_b);
+
+/**
+ * @internal
+ * @brief The number of elements `gemm_nn_prepacked()` needs to pack up to `m` rows of A.
+ */
+size_t gemm_packed_a_size(const SimdKernels* kern, int m, int k);
+
+/**
+ * @internal
+ * @brief Computes `C = f(A * B + bias)` for a B packed by `gemm_pack_b()`.
+ * @details Runs the blocked driver on the calling thread only, packing A into
+ * the caller's `packed_a` rather than this thread's buffers, so it touches no
+ * shared or thread-local state and never allocates. Rows past the last whole
+ * register tile are computed as a partial tile. Always runs on `kern`, whatever
+ * the selected backend.
+ * @param kern The kernels B was packed for.
+ * @param packed_b B as packed by `gemm_pack_b(kern, n, k, ...)`.
+ * @param c Pointer to C (`m x n`), row stride `ldc`. Overwritten, never read.
+ * @param ep The bias, activation and optional pre-activation output, or NULL.
+ * @param packed_a Room for `gemm_packed_a_size(kern, m, k)` elements, aligned to `MATRIX_ALIGNMENT`.
+ */
+void gemm_nn_prepacked(const SimdKernels* kern, int m, int n, int k,
+                       const gann_real* a, int lda, const gann_real* packed_b,
+                       gann_real* c, int ldc, const GemmEpilogue* ep, gann_real* packed_a);
+
+/**
+ * @internal
+ * @brief Computes `C = A^T * B + beta * C` without transposing A.
+ * @details With `beta == 1` this accumulates the product into C, as the
+ * backward pass does for weight gradients.
+ * @param m Columns of A; rows of C.
+ * @param n Columns of B and C.
+ * @param k Rows of A and B.
+ * @param a Pointer to A as stored (`k x m`), row stride `lda`.
+ * @param lda Row stride of A.
+ * @param b Pointer to B (`k x n`), row stride `ldb`.
+ * @param ldb Row stride of B.
+ * @param beta Scale applied to the existing contents of C.
+ * @param c Pointer to C (`m x n`), row stride `ldc`.
+ * @param ldc Row stride of C.
+ */
+void gemm_tn(int m, int n, int k,
+             const gann_real* a, int lda,
+             const gann_real* b, int ldb,
+             gann_real beta, gann_real* c, int ldc);
+
+/**
+ * @internal
+ * @brief Computes `C = A * B^T + beta * C` without transposing B.
+ * @param m Rows of A and C.
+ * @param n Rows of B; columns of C.
+ * @param k Columns of A and B.
+ * @param a Pointer to A (`m x k`), row stride `lda`.
+ * @param lda Row stride of A.
+ * @param b Pointer to B as stored (`n x k`), row stride `ldb`.
+ * @param ldb Row stride of B.
+ * @param beta Scale applied to the existing contents of C.
+ * @param c Pointer to C (`m x n`), row stride `ldc`.
+ * @param ldc Row stride of C.
+ */
+void gemm_nt(int m, int n, int k,
+             const gann_real* a, int lda,
+             const gann_real* b, int ldb,
+             gann_real beta, gann_real* c, int ldc);
+
+/**
+ * @internal
+ * @brief The operands of one product of a batch (see `gemm_nn_batch`).
+ */
+typedef struct {
+    const gann_real* a;     /**< A (`m x k`). */
+    int lda;                /**< Row stride of A. */
+    const gann_real* b;     /**< B (`k x n`). */
+    int ldb;                /**< Row stride of B. */
+    gann_real* c;           /**< C (`m x n`). */
+    int ldc;                /**< Row stride of C. */
+    const GemmEpilogue* ep; /**< The bias and activation applied to this C, or NULL. */
+} GemmBatchItem;
+
+/**
+ * @internal
+ * @brief Computes `C = f(A * B + beta * C + bias)` for `count` products of the same shape.
+ * @details One call schedules the whole batch: threads take ranges of
+ * products, and consecutive products with the same A (pointer and stride)
+ * pack each block of it once for all of them, so evaluating one input batch
+ * on many networks packs the input once per group rather than once per
+ * network. Each C is exactly what `gemm_nn_epilogue()` computes for its product.
+ * @param count The number of products.
+ * @param m Rows of every A and C.
+ * @param n Columns of every B and C.
+ * @param k Columns of every A; rows of every B.
+ * @param items The `count` products. No C may overlap any A or B.
+ * @param beta Scale applied to the existing contents of every C.
+ */
+void gemm_nn_batch(int count, int m, int n, int k, const GemmBatchItem* items, gann_real beta);
+
+/**
+ * @internal
+ * @brief Like `gemm_nn_batch()`, for operands laid out at fixed distances.
+ * @details Product `t` reads A at `a + t * stride_a` and B at `b + t * stride_b`,
+ * and writes C at `c + t * stride_c`. A `stride_a` of 0 shares one A across
+ * the batch.
+ * @param ep `count` epilogues, one per product, or NULL.
+ */
+void gemm_nn_batch_strided(int count, int m, int n, int k,
+                           const gann_real* a, int lda, size_t stride_a,
+                           const gann_real* b, int ldb, size_t stride_b,
+                           gann_real beta, gann_real* c, int ldc, size_t stride_c,
+                           const GemmEpilogue* ep);
+
+/**
+ * @internal
+ * @brief Computes `C = f(A * B + bias)` for a CSR matrix A and a dense B.
+ * @param m Rows of A and C.
+ * @param n Columns of B and C.
+ * @param row_start, col_index, values A in CSR form (`m` rows).
+ * @param b Pointer to B, whose rows are indexed by the columns of A; row stride `ldb`.
+ * @param ldb Row stride of B.
+ * @param c Pointer to C (`m x n`), row stride `ldc`. Overwritten, never read.
+ * @param ldc Row stride of C.
+ * @param ep The bias, activation and optional pre-activation output, or NULL.
+ */
+void gemm_csr_nn(int m, int n,
+                 const int* row_start, const int* col_index, const gann_real* values,
+                 const gann_real* b, int ldb,
+                 gann_real* c, int ldc, const GemmEpilogue* ep);
+
+/**
+ * @internal
+ * @brief Computes `C = f(A * B + bias)` for a dense A and a CSR matrix B.
+ * @details A few rows are computed by scattering the nonzeros of B into each
+ * row of C. Larger batches compute `C^T = B^T * A^T` in scratch-arena buffers,
+ * where every nonzero of B is one vectorized update across the whole batch.
+ * @param m Rows of A and C.
+ * @param n Columns of B and C.
+ * @param k Columns of A; rows of B.
+ * @param a Pointer to A (`m x k`), row stride `lda`.
+ * @param lda Row stride of A.
+ * @param row_start, col_index, values B in CSR form (`k` rows).
+ * @param c Pointer to C (`m x n`), row stride `ldc`. Overwritten, never read.
+ * @param ldc Row stride of C.
+ * @param ep The bias, activation and optional pre-activation output, or NULL.
+ */
+void gemm_nn_csr(int m, int n, int k,
+                 const gann_real* a, int lda,
+                 const int* row_start, const int* col_index, const gann_real* values,
+                 gann_real* c, int ldc, const GemmEpilogue* ep);
+
+/**
+ * @internal
+ * @brief Computes `C += A^T * B` for a CSR matrix A, as for weight gradients of sparse inputs.
+ * @param k Rows of A and B.
+ * @param n Columns of B and C.
+ * @param row_start, col_index, values A in CSR form (`k` rows).
+ * @param b Pointer to B (`k x n`), row stride `ldb`.
+ * @param ldb Row stride of B.
+ * @param c Pointer to C, whose rows are indexed by the columns of A; row stride `ldc`.
+ * @param ldc Row stride of C.
+ */
+void gemm_csr_tn_accumulate(int k, int n,
+                            const int* row_start, const int* col_index, const gann_real* values,
+                            const gann_real* b, int ldb,
+                            gann_real* c, int ldc);
+
+#endif // GEMM_H
@@ -0,0 +1,98 @@
+#ifndef HALF_H
+#define HALF_H
+
+/**
+ * @file half.h
+ * @internal
+ * @brief Conversions between `gann_real` and the 16-bit weight formats.
+ * @details Private to the library. `NN_STORAGE_FP16` is IEEE 754 binary16 (5
+ * exponent bits, 10 mantissa bits, largest finite value 65504);
+ * `NN_STORAGE_BF16` is bfloat16, the upper half of a float32 (8 exponent bits,
+ * 7 mantissa bits). Narrowing rounds to nearest, ties to even; widening is exact.
+ * Everything here is branch-light plain C so that loops over these functions
+ * vectorize.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "gann_real.h"
+#include "neural_network.h"
+
+static inline uint32_t half_float_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static inline float half_bits_float(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+/** @internal Widens a binary16 value. Subnormals, infinities and NaNs are preserved. */
+static inline float fp16_to_float(uint16_t h) {
+    // Shift the exponent and mantissa into float position, then rebias the
+    // exponent by a multiplication, which also normalizes subnormals.
+    float magnitude = half_bits_float((uint32_t)(h & 0x7fff) << 13) * 0x1p112f;
+    uint32_t bits = half_float_bits(magnitude);
+    if ((h & 0x7c00) == 0x7c00) bits |= 0x7f800000; // infinity or NaN
+    return half_bits_float(bits | (uint32_t)(h & 0x8000) << 16);
+}
+
+/** @internal Narrows a float to binary16; values beyond 65504 become infinities. */
+static inline uint16_t float_to_fp16(float f) {
+    // The first multiplication turns values beyond the binary16 range into
+    // infinity. Adding a power of two picked from the exponent then makes the
+    // float unit round away every mantissa bit binary16 cannot keep (more of
+    // them for subnormals), and the result is read back out of the sum's bits.
+    float base = (fabsf(f) * 0x1p112f) * 0x1p-110f;
+    uint32_t w = half_float_bits(f);
+    uint32_t shl1_w = w + w;
+    uint32_t sign = w & 0x80000000u;
+    uint32_t bias = shl1_w & 0xff000000u;
+    if (bias < 0x71000000u) bias = 0x71000000u;
+    base = half_bits_float((bias >> 1) + 0x07800000u) + base;
+    uint32_t bits = half_float_bits(base);
+    uint32_t nonsign = ((bits >> 13) & 0x7c00u) + (bits & 0x0fffu);
+    return (uint16_t)((sign >> 16) | (shl1_w > 0xff000000u ? 0x7e00u : nonsign));
+}
+
+/** @internal Widens a bfloat16 value. */
+static inline float bf16_to_float(uint16_t h) {
+    return half_bits_float((uint32_t)h << 16);
+}
+
+/** @internal Narrows a float to bfloat16. */
+static inline uint16_t float_to_bf16(float f) {
+    uint32_t bits = half_float_bits(f);
+    if ((bits & 0x7fffffffu) > 0x7f800000u) return (uint16_t)((bits >> 16) | 0x40); // keep NaNs quiet
+    bits += 0x7fffu + ((bits >> 16) & 1);
+    return (uint16_t)(bits >> 16);
+}
+
+/**
+ * @internal
+ * @brief Widens one stored weight to `gann_real`.
+ * @param h The stored value.
+ * @param format `NN_STORAGE_FP16` or `NN_STORAGE_BF16`.
+ */
+static inline gann_real half_to_real(uint16_t h, NNWeightStorage format) {
+    return (gann_real)(format == NN_STORAGE_BF16 ? bf16_to_float(h) : fp16_to_float(h));
+}
+
+/**
+ * @internal
+ * @brief Rounds a `gann_real` to a stored weight.
+ * @details A double is first rounded to float; both 16-bit formats are exactly
+ * representable in float, so this differs from a single rounding only for
+ * values within a float ulp of a tie.
+ * @param x The value.
+ * @param format `NN_STORAGE_FP16` or `NN_STORAGE_BF16`.
+ */
+static inline uint16_t half_from_real(gann_real x, NNWeightStorage format) {
+    return format == NN_STORAGE_BF16 ? float_to_bf16((float)x) : float_to_fp16((float)x);
+}
+
+#endif // HALF_H
@@ -1,43 +1,152 @@
 #include "matrix.h"
+#include "gann_arena.h"
 #include "gann_errors.h"
+#include "gemm.h"
+#include "simd_kernels.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// --- Storage Helpers ---
+
+// Rounds `size` up to the next multiple of MATRIX_ALIGNMENT
+static size_t align_up(size_t size) {
+    return (size + MATRIX_ALIGNMENT - 1) & ~(size_t)(MATRIX_ALIGNMENT - 1);
+}
+
+static void* aligned_block_alloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, MATRIX_ALIGNMENT);
+#else
+    void* block = NULL;
+    if (posix_memalign(&block, MATRIX_ALIGNMENT, size) != 0) return NULL;
+    return block;
+#endif
+}
+
+static void aligned_block_free(void* block) {
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+// --- Allocation Accounting ---
+
+// Number of matrices created by the calling thread; lets tests check that hot
+// loops built on the `_into` API stay allocation-free.
+static GANN_THREAD_LOCAL size_t g_matrix_allocations = 0;
+
+size_t matrix_get_allocation_count(void) {
+    return g_matrix_allocations;
+}
+
+size_t gann_real_size(void) {
+    return sizeof(gann_real);
+}
 
 // --- Matrix Operations Implementation ---
 
-// Creates and allocates memory for a new matrix
+// Layout of a matrix block: [Matrix][row pointers][padding][values, 64-byte aligned].
+// Returns the size of the block for a rows x cols matrix and stores the offset of
+// the values in *values_offset, or returns 0 if the size does not fit in size_t.
+static size_t matrix_block_size(int rows, int cols, size_t* values_offset) {
+    size_t num_values = (size_t)rows * (size_t)cols;
+    *values_offset = align_up(sizeof(Matrix) + (size_t)rows * sizeof(gann_real*));
+    if (num_values > (SIZE_MAX - *values_offset) / sizeof(gann_real)) return 0;
+    return *values_offset + num_values * sizeof(gann_real);
+}
+
+// Builds a zeroed, dense matrix inside `block` (which must be MATRIX_ALIGNMENT-aligned).
+static Matrix* matrix_init_block(unsigned char* block, int rows, int cols, size_t values_offset) {
+    Matrix* m = (Matrix*)block;
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = (gann_real**)(block + sizeof(Matrix));
+    m->values = (gann_real*)(block + values_offset);
+    memset(m->values, 0, (size_t)rows * cols * sizeof(gann_real));
+    for (int i = 0; i < rows; i++) {
+        m->data[i] = m->values + (size_t)i * cols;
+    }
+    return m;
+}
+
+// Creates and allocates memory for a new matrix.
 Matrix* create_matrix(int rows, int cols) {
     if (rows <= 0 || cols <= 0) {
         gann_set_error(GANN_ERROR_INVALID_PARAM);
         return NULL;
     }
 
-    Matrix* m = (Matrix*)malloc(sizeof(Matrix));
-    if (!m) {
+    size_t values_offset;
+    size_t block_size = matrix_block_size(rows, cols, &values_offset);
+    unsigned char* block = block_size ? (unsigned char*)aligned_block_alloc(block_size) : NULL;
+    if (!block) {
         gann_set_error(GANN_ERROR_ALLOC_FAILED);
         return NULL;
     }
 
-    m->rows = rows;
-    m->cols = cols;
-    m->data = (double**)malloc(rows * sizeof(double*));
-    if (!m->data) {
-        free(m);
+    g_matrix_allocations++;
+    Matrix* m = matrix_init_block(block, rows, cols, values_offset);
+    gann_set_error(GANN_SUCCESS);
+    return m;
+}
+
+Matrix* gann_arena_create_matrix(GannArena* arena, int rows, int cols) {
+    if (arena == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (rows <= 0 || cols <= 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+
+    size_t values_offset;
+    size_t block_size = matrix_block_size(rows, cols, &values_offset);
+    if (block_size == 0) {
         gann_set_error(GANN_ERROR_ALLOC_FAILED);
         return NULL;
     }
+    unsigned char* block = (unsigned char*)gann_arena_alloc(arena, block_size);
+    if (!block) return NULL; // gann_arena_alloc sets the error
+
+    Matrix* m = matrix_init_block(block, rows, cols, values_offset);
+    gann_set_error(GANN_SUCCESS);
+    return m;
+}
+
+Matrix* matrix_wrap(gann_real* values, int rows, int cols) {
+    if (values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (rows <= 0 || cols <= 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
 
+    // Same header layout as create_matrix(), minus the elements, so free_matrix() applies
+    Matrix* m = (Matrix*)aligned_block_alloc(sizeof(Matrix) + (size_t)rows * sizeof(gann_real*));
+    if (!m) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    g_matrix_allocations++;
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = (gann_real**)(m + 1);
+    m->values = values;
     for (int i = 0; i < rows; i++) {
-        m->data[i] = (double*)calloc(cols, sizeof(double));
-        if (!m->data[i]) {
-            // Rollback allocation on failure
-            for (int j = 0; j < i; j++) free(m->data[j]);
-            free(m->data);
-            free(m);
-            gann_set_error(GANN_ERROR_ALLOC_FAILED);
-            return NULL;
-        }
+        m->data[i] = values + (size_t)i * cols;
     }
     gann_set_error(GANN_SUCCESS);
     return m;
@@ -48,13 +157,57 @@ void free_matrix(Matrix* m) {
     if (m == NULL) {
         return;
     }
-    if (m->data) {
-        for (int i = 0; i < m->rows; i++) {
-            free(m->data[i]);
-        }
-        free(m->data);
+    aligned_block_free(m);
+}
+
+int matrix_is_contiguous(const Matrix* m) {
+    return m != NULL && m->stride == m->cols;
+}
+
+// --- Matrix Views ---
+
+// The view returned for invalid arguments: no data and no extent.
+static MatrixView empty_view(void) {
+    MatrixView v = { NULL, 0, 0, 0 };
+    return v;
+}
+
+MatrixView matrix_view(const Matrix* m) {
+    if (m == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return empty_view();
+    }
+    MatrixView v = { m->values, m->rows, m->cols, m->stride };
+    return v;
+}
+
+MatrixView matrix_view_row(const Matrix* m, int row) {
+    return matrix_view_block(m, row, 0, 1, m ? m->cols : 0);
+}
+
+MatrixView matrix_view_rows(const Matrix* m, int first_row, int num_rows) {
+    return matrix_view_block(m, first_row, 0, num_rows, m ? m->cols : 0);
+}
+
+MatrixView matrix_view_block(const Matrix* m, int first_row, int first_col, int num_rows, int num_cols) {
+    if (m == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return empty_view();
     }
-    free(m);
+    if (first_row < 0 || first_col < 0 || num_rows <= 0 || num_cols <= 0 ||
+        num_rows > m->rows - first_row || num_cols > m->cols - first_col) {
+        gann_set_error(GANN_ERROR_INDEX_OUT_OF_BOUNDS);
+        return empty_view();
+    }
+    MatrixView v = { m->values + (size_t)first_row * m->stride + first_col, num_rows, num_cols, m->stride };
+    return v;
+}
+
+// Returns 1 if the elements spanned by `v` and by `m` share any memory.
+static int view_overlaps(MatrixView v, const Matrix* m) {
+    const gann_real* v_end = v.values + (size_t)(v.rows - 1) * v.stride + v.cols;
+    const gann_real* m_end = m->values + (size_t)(m->rows - 1) * m->stride + m->cols;
+    return (uintptr_t)v.values < (uintptr_t)m_end && (uintptr_t)m->values < (uintptr_t)v_end;
 }
 
 // Prints the matrix data (for debugging)
@@ -64,8 +217,9 @@ void print_matrix(const Matrix* m) {
         return;
     }
     for (int i = 0; i < m->rows; i++) {
+        const gann_real* row = m->values + (size_t)i * m->stride;
         for (int j = 0; j < m->cols; j++) {
-            printf("%f ", m->data[i][j]);
+            printf("%f ", row[j]);
         }
         printf("\n");
     }
@@ -77,30 +231,163 @@ Matrix* dot_product(const Matrix* m1, const Matrix* m2) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
     }
-    if (m1->cols != m2->rows) {
+    Matrix* result = create_matrix(m1->rows, m2->cols);
+    if (!result) return NULL; // create_matrix sets the error
+
+    if (!dot_product_into(result, m1, m2)) {
+        free_matrix(result);
+        return NULL; // dot_product_into sets the error
+    }
+    return result;
+}
+
+int dot_product_into(Matrix* dest, const Matrix* m1, const Matrix* m2) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    return dot_product_view_into(dest, matrix_view(m1), matrix_view(m2));
+}
+
+int dot_product_view_into(Matrix* dest, MatrixView a, MatrixView b) {
+    if (dest == NULL || a.values == NULL || b.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (a.cols != b.rows || dest->rows != a.rows || dest->cols != b.cols) {
         gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (view_overlaps(a, dest) || view_overlaps(b, dest)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_nn(a.rows, b.cols, a.cols,
+            a.values, a.stride,
+            b.values, b.stride,
+            0.0, dest->values, dest->stride);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+// Computes m1^T * m2 by reading m1 through its strides
+Matrix* dot_product_tn(const Matrix* m1, const Matrix* m2) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
     }
+    Matrix* result = create_matrix(m1->cols, m2->cols);
+    if (!result) return NULL; // create_matrix sets the error
 
-    Matrix* result = create_matrix(m1->rows, m2->cols);
+    if (!dot_product_tn_into(result, m1, m2)) {
+        free_matrix(result);
+        return NULL; // dot_product_tn_into sets the error
+    }
+    return result;
+}
+
+// Shared by the A^T * B entry points: beta = 0 overwrites dest, beta = 1 accumulates into it
+static int dot_product_tn_beta(Matrix* dest, MatrixView a, MatrixView b, double beta) {
+    if (dest == NULL || a.values == NULL || b.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (a.rows != b.rows || dest->rows != a.cols || dest->cols != b.cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (view_overlaps(a, dest) || view_overlaps(b, dest)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_tn(a.cols, b.cols, a.rows,
+            a.values, a.stride,
+            b.values, b.stride,
+            beta, dest->values, dest->stride);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int dot_product_tn_into(Matrix* dest, const Matrix* m1, const Matrix* m2) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    return dot_product_tn_beta(dest, matrix_view(m1), matrix_view(m2), 0.0);
+}
+
+int dot_product_tn_view_into(Matrix* dest, MatrixView a, MatrixView b) {
+    return dot_product_tn_beta(dest, a, b, 0.0);
+}
+
+// Accumulates m1^T * m2 into c
+void dot_product_tn_accumulate(Matrix* c, const Matrix* m1, const Matrix* m2) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return;
+    }
+    dot_product_tn_beta(c, matrix_view(m1), matrix_view(m2), 1.0);
+}
+
+int dot_product_tn_view_accumulate(Matrix* c, MatrixView a, MatrixView b) {
+    return dot_product_tn_beta(c, a, b, 1.0);
+}
+
+// Computes m1 * m2^T by reading m2 through its strides
+Matrix* dot_product_nt(const Matrix* m1, const Matrix* m2) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    Matrix* result = create_matrix(m1->rows, m2->rows);
     if (!result) return NULL; // create_matrix sets the error
 
-    for (int i = 0; i < m1->rows; i++) {
-        for (int k = 0; k < m1->cols; k++) {
-            for (int j = 0; j < m2->cols; j++) {
-                result->data[i][j] += m1->data[i][k] * m2->data[k][j];
-            }
-        }
+    if (!dot_product_nt_into(result, m1, m2)) {
+        free_matrix(result);
+        return NULL; // dot_product_nt_into sets the error
     }
     return result;
 }
 
+int dot_product_nt_into(Matrix* dest, const Matrix* m1, const Matrix* m2) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    return dot_product_nt_view_into(dest, matrix_view(m1), matrix_view(m2));
+}
+
+int dot_product_nt_view_into(Matrix* dest, MatrixView a, MatrixView b) {
+    if (dest == NULL || a.values == NULL || b.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (a.cols != b.cols || dest->rows != a.rows || dest->cols != b.rows) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (view_overlaps(a, dest) || view_overlaps(b, dest)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_nt(a.rows, b.rows, a.cols,
+            a.values, a.stride,
+            b.values, b.stride,
+            0.0, dest->values, dest->stride);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
 void matrix_copy_data(Matrix* dest, const Matrix* src) {
     if (dest == NULL || src == NULL || dest->rows != src->rows || dest->cols != src->cols) {
         return;
     }
+    if (matrix_is_contiguous(dest) && matrix_is_contiguous(src)) {
+        memcpy(dest->values, src->values, (size_t)src->rows * src->cols * sizeof(gann_real));
+        return;
+    }
     for (int i = 0; i < src->rows; i++) {
-        memcpy(dest->data[i], src->data[i], src->cols * sizeof(double));
+        memcpy(dest->values + (size_t)i * dest->stride, src->values + (size_t)i * src->stride, src->cols * sizeof(gann_real));
     }
 }
 
@@ -110,14 +397,21 @@ void add_bias(Matrix* m, const Matrix* bias) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
-    if (m->cols != bias->cols || bias->rows != 1) {
+    add_bias_view(m, matrix_view(bias));
+}
+
+void add_bias_view(Matrix* m, MatrixView bias) {
+    if (m == NULL || bias.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return;
+    }
+    if (m->cols != bias.cols || bias.rows != 1) {
         gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
         return;
     }
+    const SimdKernels* kern = simd_kernels();
     for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            m->data[i][j] += bias->data[0][j];
-        }
+        kern->add_inplace((size_t)m->cols, m->values + (size_t)i * m->stride, bias.values);
     }
     gann_set_error(GANN_SUCCESS);
 }
@@ -132,77 +426,114 @@ Matrix* matrix_transpose(const Matrix* m) {
     if (!result) return NULL; // create_matrix sets the error
 
     for (int i = 0; i < m->rows; i++) {
+        const gann_real* row = m->values + (size_t)i * m->stride;
         for (int j = 0; j < m->cols; j++) {
-            result->data[j][i] = m->data[i][j];
+            result->values[(size_t)j * result->stride + i] = row[j];
         }
     }
     return result;
 }
 
-// Performs element-wise multiplication (Hadamard product) of two matrices
-Matrix* matrix_elementwise_multiply(const Matrix* m1, const Matrix* m2) {
-    if (m1 == NULL || m2 == NULL) {
+// Element-wise binary operations share the same traversal; `op` is one of the
+// dispatched SIMD kernels (add, sub or mul). `dest` may be one of the operands.
+typedef void (*ElementwiseOp)(size_t n, const gann_real* a, const gann_real* b, gann_real* r);
+
+static int elementwise_binary_into(Matrix* dest, MatrixView a, MatrixView b, ElementwiseOp op) {
+    if (dest == NULL || a.values == NULL || b.values == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
-        return NULL;
+        return 0;
     }
-    if (m1->rows != m2->rows || m1->cols != m2->cols) {
+    if (a.rows != b.rows || a.cols != b.cols || dest->rows != a.rows || dest->cols != a.cols) {
         gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
-        return NULL;
+        return 0;
     }
 
-    Matrix* result = create_matrix(m1->rows, m1->cols);
-    if (!result) return NULL; // create_matrix sets the error
+    // When every operand is dense the whole matrix is walked as a single row.
+    int dense = a.stride == a.cols && b.stride == b.cols && matrix_is_contiguous(dest);
+    int rows = dense ? 1 : a.rows;
+    size_t cols = dense ? (size_t)a.rows * a.cols : (size_t)a.cols;
 
-    for (int i = 0; i < m1->rows; i++) {
-        for (int j = 0; j < m1->cols; j++) {
-            result->data[i][j] = m1->data[i][j] * m2->data[i][j];
-        }
+    for (int i = 0; i < rows; i++) {
+        op(cols, a.values + (size_t)i * a.stride, b.values + (size_t)i * b.stride,
+           dest->values + (size_t)i * dest->stride);
     }
-    return result;
+    gann_set_error(GANN_SUCCESS);
+    return 1;
 }
 
-// Subtracts the second matrix from the first matrix
-Matrix* matrix_subtract(const Matrix* m1, const Matrix* m2) {
+// Adapts the Matrix-based entry points, keeping their NULL check ahead of matrix_view()
+static int elementwise_matrix_into(Matrix* dest, const Matrix* m1, const Matrix* m2, ElementwiseOp op) {
     if (m1 == NULL || m2 == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
-        return NULL;
+        return 0;
     }
-    if (m1->rows != m2->rows || m1->cols != m2->cols) {
-        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+    return elementwise_binary_into(dest, matrix_view(m1), matrix_view(m2), op);
+}
+
+static Matrix* elementwise_binary(const Matrix* m1, const Matrix* m2, ElementwiseOp op) {
+    if (m1 == NULL || m2 == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
     }
-
     Matrix* result = create_matrix(m1->rows, m1->cols);
     if (!result) return NULL; // create_matrix sets the error
 
-    for (int i = 0; i < m1->rows; i++) {
-        for (int j = 0; j < m1->cols; j++) {
-            result->data[i][j] = m1->data[i][j] - m2->data[i][j];
-        }
+    if (!elementwise_matrix_into(result, m1, m2, op)) {
+        free_matrix(result);
+        return NULL; // elementwise_binary_into sets the error
     }
     return result;
 }
 
+// Performs element-wise multiplication (Hadamard product) of two matrices
+Matrix* matrix_elementwise_multiply(const Matrix* m1, const Matrix* m2) {
+    return elementwise_binary(m1, m2, simd_kernels()->mul);
+}
+
+int matrix_elementwise_multiply_into(Matrix* dest, const Matrix* m1, const Matrix* m2) {
+    return elementwise_matrix_into(dest, m1, m2, simd_kernels()->mul);
+}
+
+int matrix_elementwise_multiply_view_into(Matrix* dest, MatrixView a, MatrixView b) {
+    return elementwise_binary_into(dest, a, b, simd_kernels()->mul);
+}
+
+int matrix_elementwise_multiply_inplace(Matrix* m, const Matrix* other) {
+    return elementwise_matrix_into(m, m, other, simd_kernels()->mul);
+}
+
+// Subtracts the second matrix from the first matrix
+Matrix* matrix_subtract(const Matrix* m1, const Matrix* m2) {
+    return elementwise_binary(m1, m2, simd_kernels()->sub);
+}
+
+int matrix_subtract_into(Matrix* dest, const Matrix* m1, const Matrix* m2) {
+    return elementwise_matrix_into(dest, m1, m2, simd_kernels()->sub);
+}
+
+int matrix_subtract_view_into(Matrix* dest, MatrixView a, MatrixView b) {
+    return elementwise_binary_into(dest, a, b, simd_kernels()->sub);
+}
+
+int matrix_subtract_inplace(Matrix* m, const Matrix* other) {
+    return elementwise_matrix_into(m, m, other, simd_kernels()->sub);
+}
+
 // Adds two matrices
 Matrix* matrix_add(const Matrix* m1, const Matrix* m2) {
-    if (m1 == NULL || m2 == NULL) {
-        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
-        return NULL;
-    }
-    if (m1->rows != m2->rows || m1->cols != m2->cols) {
-        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
-        return NULL;
-    }
+    return elementwise_binary(m1, m2, simd_kernels()->add);
+}
 
-    Matrix* result = create_matrix(m1->rows, m1->cols);
-    if (!result) return NULL; // create_matrix sets the error
+int matrix_add_into(Matrix* dest, const Matrix* m1, const Matrix* m2) {
+    return elementwise_matrix_into(dest, m1, m2, simd_kernels()->add);
+}
 
-    for (int i = 0; i < m1->rows; i++) {
-        for (int j = 0; j < m1->cols; j++) {
-            result->data[i][j] = m1->data[i][j] + m2->data[i][j];
-        }
-    }
-    return result;
+int matrix_add_view_into(Matrix* dest, MatrixView a, MatrixView b) {
+    return elementwise_binary_into(dest, a, b, simd_kernels()->add);
+}
+
+int matrix_add_inplace(Matrix* m, const Matrix* other) {
+    return elementwise_matrix_into(m, m, other, simd_kernels()->add);
 }
 
 // Scales a matrix by a scalar value
@@ -214,16 +545,42 @@ Matrix* matrix_scale(const Matrix* m, double scalar) {
     Matrix* result = create_matrix(m->rows, m->cols);
     if (!result) return NULL; // create_matrix sets the error
 
-    for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            result->data[i][j] = m->data[i][j] * scalar;
-        }
-    }
+    matrix_scale_into(result, m, scalar);
     return result;
 }
 
+int matrix_scale_into(Matrix* dest, const Matrix* m, double scalar) {
+    if (m == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    return matrix_scale_view_into(dest, matrix_view(m), scalar);
+}
+
+int matrix_scale_view_into(Matrix* dest, MatrixView m, double scalar) {
+    if (dest == NULL || m.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (dest->rows != m.rows || dest->cols != m.cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    const SimdKernels* kern = simd_kernels();
+    for (int i = 0; i < m.rows; i++) {
+        kern->scale((size_t)m.cols, m.values + (size_t)i * m.stride, scalar,
+                    dest->values + (size_t)i * dest->stride);
+    }
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int matrix_scale_inplace(Matrix* m, double scalar) {
+    return matrix_scale_into(m, m, scalar);
+}
+
 // Creates a matrix from a 1D array
-Matrix* matrix_from_array(const double* array, int rows, int cols) {
+Matrix* matrix_from_array(const gann_real* array, int rows, int cols) {
     if (array == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
@@ -231,11 +588,7 @@ Matrix* matrix_from_array(const double* array, int rows, int cols) {
     Matrix* m = create_matrix(rows, cols);
     if (!m) return NULL; // create_matrix sets the error
 
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            m->data[i][j] = array[i * cols + j];
-        }
-    }
+    memcpy(m->values, array, (size_t)rows * cols * sizeof(gann_real));
     return m;
 }
 
@@ -248,12 +601,36 @@ Matrix* matrix_copy(const Matrix* m) {
     Matrix* copy = create_matrix(m->rows, m->cols);
     if (!copy) return NULL; // create_matrix sets the error
 
-    for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            copy->data[i][j] = m->data[i][j];
+    matrix_copy_data(copy, m);
+    return copy;
+}
+
+int matrix_copy_into(Matrix* dest, const Matrix* src) {
+    if (src == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    return matrix_copy_view_into(dest, matrix_view(src));
+}
+
+int matrix_copy_view_into(Matrix* dest, MatrixView src) {
+    if (dest == NULL || src.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (dest->rows != src.rows || dest->cols != src.cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (matrix_is_contiguous(dest) && src.stride == src.cols) {
+        memcpy(dest->values, src.values, (size_t)src.rows * src.cols * sizeof(gann_real));
+    } else {
+        for (int i = 0; i < src.rows; i++) {
+            memcpy(dest->values + (size_t)i * dest->stride, src.values + (size_t)i * src.stride, src.cols * sizeof(gann_real));
         }
     }
-    return copy;
+    gann_set_error(GANN_SUCCESS);
+    return 1;
 }
 
 // Extracts a single row from a matrix
@@ -269,8 +646,266 @@ Matrix* matrix_get_row(const Matrix* m, int row) {
     Matrix* result = create_matrix(1, m->cols);
     if (!result) return NULL; // create_matrix sets the error
 
-    for (int j = 0; j < m->cols; j++) {
-        result->data[0][j] = m->data[row][j];
-    }
+    memcpy(result->values, m->values + (size_t)row * m->stride, m->cols * sizeof(gann_real));
     return result;
 }
+
+int matrix_get_row_into(Matrix* dest, const Matrix* m, int row) {
+    if (dest == NULL || m == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (row < 0 || row >= m->rows) {
+        gann_set_error(GANN_ERROR_INDEX_OUT_OF_BOUNDS);
+        return 0;
+    }
+    if (dest->rows != 1 || dest->cols != m->cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    memcpy(dest->values, m->values + (size_t)row * m->stride, m->cols * sizeof(gann_real));
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+// --- Batched Products ---
+
+// Whether `count` copies of the view, `stride` elements apart, overlap `m`.
+static int strided_views_overlap(MatrixView v, int count, size_t stride, const Matrix* m) {
+    if (stride == 0) return view_overlaps(v, m);
+    const gann_real* first = v.values;
+    const gann_real* end = v.values + (size_t)(count - 1) * stride + (size_t)(v.rows - 1) * v.stride + v.cols;
+    const gann_real* m_end = m->values + (size_t)(m->rows - 1) * m->stride + m->cols;
+    return (uintptr_t)first < (uintptr_t)m_end && (uintptr_t)m->values < (uintptr_t)end;
+}
+
+int dot_product_batch_into(int count, Matrix* const* dest, const MatrixView* a, const MatrixView* b) {
+    if (count < 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (count > 0 && (dest == NULL || a == NULL || b == NULL)) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    for (int t = 0; t < count; t++) {
+        if (dest[t] == NULL || a[t].values == NULL || b[t].values == NULL) {
+            gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+            return 0;
+        }
+        if (a[t].rows != a[0].rows || a[t].cols != a[0].cols || b[t].rows != b[0].rows || b[t].cols != b[0].cols ||
+            a[t].cols != b[t].rows || dest[t]->rows != a[t].rows || dest[t]->cols != b[t].cols) {
+            gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+            return 0;
+        }
+    }
+    // Every result against every operand: a result may not be another product's input.
+    for (int t = 0; t < count; t++) {
+        for (int u = 0; u < count; u++) {
+            if (view_overlaps(a[u], dest[t]) || view_overlaps(b[u], dest[t])) {
+                gann_set_error(GANN_ERROR_INVALID_PARAM);
+                return 0;
+            }
+        }
+    }
+    if (count == 0) {
+        gann_set_error(GANN_SUCCESS);
+        return 1;
+    }
+
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return 0; // gann_scratch_arena sets the error
+    size_t mark = gann_arena_mark(arena);
+    GemmBatchItem* items = (GemmBatchItem*)gann_arena_alloc(arena, (size_t)count * sizeof(GemmBatchItem));
+    if (!items) return 0; // gann_arena_alloc sets the error
+    for (int t = 0; t < count; t++) {
+        items[t] = (GemmBatchItem){
+            .a = a[t].values, .lda = a[t].stride,
+            .b = b[t].values, .ldb = b[t].stride,
+            .c = dest[t]->values, .ldc = dest[t]->stride,
+        };
+    }
+    gemm_nn_batch(count, a[0].rows, b[0].cols, a[0].cols, items, 0.0);
+    gann_arena_reset_to(arena, mark);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int dot_product_batch_strided_into(int count, Matrix* dest, MatrixView a, size_t stride_a, MatrixView b, size_t stride_b) {
+    if (dest == NULL || a.values == NULL || b.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (count < 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (a.cols != b.rows || (long)dest->rows != (long)count * a.rows || dest->cols != b.cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (count > 0 && (strided_views_overlap(a, count, stride_a, dest) || strided_views_overlap(b, count, stride_b, dest))) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_nn_batch_strided(count, a.rows, b.cols, a.cols,
+                          a.values, a.stride, stride_a,
+                          b.values, b.stride, stride_b,
+                          0.0, dest->values, dest->stride, (size_t)a.rows * dest->stride, NULL);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+// --- Sparse Matrices ---
+
+static SparseMatrix* sparse_matrix_alloc(int rows, int cols, int nnz) {
+    SparseMatrix* s = (SparseMatrix*)calloc(1, sizeof(SparseMatrix));
+    if (!s) return NULL;
+    s->rows = rows;
+    s->cols = cols;
+    s->nnz = nnz;
+    s->row_start = (int*)malloc(((size_t)rows + 1) * sizeof(int));
+    // One spare element keeps malloc(0) out of the picture for an all-zero matrix.
+    s->col_index = (int*)malloc(((size_t)nnz + 1) * sizeof(int));
+    s->values = (gann_real*)malloc(((size_t)nnz + 1) * sizeof(gann_real));
+    if (!s->row_start || !s->col_index || !s->values) {
+        free_sparse_matrix(s);
+        return NULL;
+    }
+    return s;
+}
+
+void free_sparse_matrix(SparseMatrix* s) {
+    if (s == NULL) return;
+    free(s->row_start);
+    free(s->col_index);
+    free(s->values);
+    free(s);
+}
+
+SparseMatrix* sparse_matrix_from_view(MatrixView m, double threshold) {
+    if (m.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (!(threshold >= 0)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    const gann_real t = (gann_real)threshold;
+    // First pass counts, second pass fills, so the arrays are allocated exactly once.
+    size_t nnz = 0;
+    for (int i = 0; i < m.rows; i++) {
+        const gann_real* row = m.values + (size_t)i * m.stride;
+        for (int j = 0; j < m.cols; j++) nnz += (row[j] > t || row[j] < -t);
+    }
+    if (nnz > INT_MAX) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return NULL;
+    }
+    SparseMatrix* s = sparse_matrix_alloc(m.rows, m.cols, (int)nnz);
+    if (!s) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    int p = 0;
+    for (int i = 0; i < m.rows; i++) {
+        const gann_real* row = m.values + (size_t)i * m.stride;
+        s->row_start[i] = p;
+        for (int j = 0; j < m.cols; j++) {
+            if (row[j] > t || row[j] < -t) {
+                s->col_index[p] = j;
+                s->values[p] = row[j];
+                p++;
+            }
+        }
+    }
+    s->row_start[m.rows] = p;
+    gann_set_error(GANN_SUCCESS);
+    return s;
+}
+
+SparseMatrix* sparse_matrix_from_dense(const Matrix* m, double threshold) {
+    if (m == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    return sparse_matrix_from_view(matrix_view(m), threshold);
+}
+
+Matrix* sparse_matrix_to_dense(const SparseMatrix* s) {
+    if (s == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    Matrix* m = create_matrix(s->rows, s->cols);
+    if (!m) return NULL; // create_matrix sets the error
+    for (int i = 0; i < s->rows; i++) {
+        gann_real* row = m->values + (size_t)i * m->stride;
+        for (int p = s->row_start[i]; p < s->row_start[i + 1]; p++) row[s->col_index[p]] = s->values[p];
+    }
+    gann_set_error(GANN_SUCCESS);
+    return m;
+}
+
+double sparse_matrix_density(const SparseMatrix* s) {
+    if (s == NULL || s->rows == 0 || s->cols == 0) return 0.0;
+    return (double)s->nnz / ((double)s->rows * (double)s->cols);
+}
+
+int sparse_dot_product_into(Matrix* dest, const SparseMatrix* a, MatrixView b) {
+    if (dest == NULL || a == NULL || b.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (a->cols != b.rows || dest->rows != a->rows || dest->cols != b.cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (view_overlaps(b, dest)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_csr_nn(a->rows, b.cols, a->row_start, a->col_index, a->values, b.values, b.stride,
+                dest->values, dest->stride, NULL);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int dot_product_sparse_into(Matrix* dest, MatrixView a, const SparseMatrix* b) {
+    if (dest == NULL || a.values == NULL || b == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (a.cols != b->rows || dest->rows != a.rows || dest->cols != b->cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (view_overlaps(a, dest)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_nn_csr(a.rows, b->cols, a.cols, a.values, a.stride, b->row_start, b->col_index, b->values,
+                dest->values, dest->stride, NULL);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int sparse_dot_product_tn_accumulate(Matrix* c, const SparseMatrix* a, MatrixView b) {
+    if (c == NULL || a == NULL || b.values == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (a->rows != b.rows || c->rows != a->cols || c->cols != b.cols) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (view_overlaps(b, c)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    gemm_csr_tn_accumulate(a->rows, b.cols, a->row_start, a->col_index, a->values, b.values, b.stride,
+                           c->values, c->stride);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
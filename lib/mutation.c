@@ -1,4 +1,6 @@
 #include "mutation.h"
+#include "half.h"
+#include "nn_kernels.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
@@ -11,70 +13,54 @@ static double randn(double mu, double sigma) {
     return mu + sigma * z;
 }
 
-// Simple uniform mutation
-static void uniform_mutation(NeuralNetwork* network, float mutation_rate, float mutation_chance) {
-    for (int i = 0; i < network->num_layers - 1; i++) {
-        // Mutate weights
-        for (int r = 0; r < network->weights[i]->rows; r++) {
-            for (int c = 0; c < network->weights[i]->cols; c++) {
-                if ((double)rand() / RAND_MAX < mutation_chance) {
-                    double mutation = ((double)rand() / RAND_MAX - 0.5) * 2.0 * mutation_rate;
-                    network->weights[i]->data[r][c] += mutation;
-                }
-            }
+// How a mutated gene is perturbed: uniformly within [-rate, rate], or, when
+// `gaussian` is set, by a Gaussian with standard deviation `std_dev`.
+typedef struct {
+    int gaussian;
+    double rate;
+    double std_dev;
+} Perturbation;
+
+static double draw_perturbation(const Perturbation* perturbation) {
+    if (perturbation->gaussian) return randn(0, perturbation->std_dev);
+    return ((double)rand() / RAND_MAX - 0.5) * 2.0 * perturbation->rate;
+}
+
+// Perturbs each gene (weight or bias) with probability mutation_chance, in one
+// pass over the network's genome (see nn_genome).
+static void mutate_genes(NeuralNetwork* network, float mutation_chance, Perturbation perturbation) {
+    NNGenome genome = nn_genome(network);
+    for (size_t k = 0; k < genome.num_real; k++) {
+        if ((double)rand() / RAND_MAX < mutation_chance) {
+            genome.real[k] += draw_perturbation(&perturbation);
         }
-        // Mutate biases
-        for (int c = 0; c < network->biases[i]->cols; c++) {
-            if ((double)rand() / RAND_MAX < mutation_chance) {
-                double mutation = ((double)rand() / RAND_MAX - 0.5) * 2.0 * mutation_rate;
-                network->biases[i]->data[0][c] += mutation;
-            }
+    }
+    NNWeightStorage format = network->weight_storage;
+    for (size_t k = 0; k < genome.num_half; k++) {
+        if ((double)rand() / RAND_MAX < mutation_chance) {
+            genome.half[k] = half_from_real(half_to_real(genome.half[k], format) + draw_perturbation(&perturbation), format);
         }
     }
 }
 
+// Simple uniform mutation
+static void uniform_mutation(NeuralNetwork* network, float mutation_rate, float mutation_chance) {
+    Perturbation perturbation = { 0, mutation_rate, 0.0 };
+    mutate_genes(network, mutation_chance, perturbation);
+}
+
 // Gaussian mutation
 static void gaussian_mutation(NeuralNetwork* network, float mutation_chance, double std_dev) {
-    for (int i = 0; i < network->num_layers - 1; i++) {
-        // Mutate weights
-        for (int r = 0; r < network->weights[i]->rows; r++) {
-            for (int c = 0; c < network->weights[i]->cols; c++) {
-                if ((double)rand() / RAND_MAX < mutation_chance) {
-                    network->weights[i]->data[r][c] += randn(0, std_dev);
-                }
-            }
-        }
-        // Mutate biases
-        for (int c = 0; c < network->biases[i]->cols; c++) {
-            if ((double)rand() / RAND_MAX < mutation_chance) {
-                network->biases[i]->data[0][c] += randn(0, std_dev);
-            }
-        }
-    }
+    Perturbation perturbation = { 1, 0.0, std_dev };
+    mutate_genes(network, mutation_chance, perturbation);
 }
 
 
 // Non-uniform mutation
 static void non_uniform_mutation(NeuralNetwork* network, float mutation_rate, float mutation_chance, int current_gen, int max_gens) {
     float current_mutation_rate = mutation_rate * (1.0 - (double)current_gen / max_gens);
-    for (int i = 0; i < network->num_layers - 1; i++) {
-        // Mutate weights
-        for (int r = 0; r < network->weights[i]->rows; r++) {
-            for (int c = 0; c < network->weights[i]->cols; c++) {
-                if ((double)rand() / RAND_MAX < mutation_chance) {
-                    double mutation = ((double)rand() / RAND_MAX - 0.5) * 2.0 * current_mutation_rate;
-                    network->weights[i]->data[r][c] += mutation;
-                }
-            }
-        }
-        // Mutate biases
-        for (int c = 0; c < network->biases[i]->cols; c++) {
-            if ((double)rand() / RAND_MAX < mutation_chance) {
-                double mutation = ((double)rand() / RAND_MAX - 0.5) * 2.0 * current_mutation_rate;
-                network->biases[i]->data[0][c] += mutation;
-            }
-        }
-    }
+    Perturbation perturbation = { 0, current_mutation_rate, 0.0 };
+    mutate_genes(network, mutation_chance, perturbation);
 }
 
 
@@ -89,24 +75,8 @@ static void adaptive_mutation(NeuralNetwork* network, float initial_mutation_rat
         mutation_rate *= 0.75;
     }
 
-    for (int i = 0; i < network->num_layers - 1; i++) {
-        // Mutate weights
-        for (int r = 0; r < network->weights[i]->rows; r++) {
-            for (int c = 0; c < network->weights[i]->cols; c++) {
-                if ((double)rand() / RAND_MAX < mutation_chance) {
-                    double mutation = ((double)rand() / RAND_MAX - 0.5) * 2.0 * mutation_rate;
-                    network->weights[i]->data[r][c] += mutation;
-                }
-            }
-        }
-        // Mutate biases
-        for (int c = 0; c < network->biases[i]->cols; c++) {
-            if ((double)rand() / RAND_MAX < mutation_chance) {
-                double mutation = ((double)rand() / RAND_MAX - 0.5) * 2.0 * mutation_rate;
-                network->biases[i]->data[0][c] += mutation;
-            }
-        }
-    }
+    Perturbation perturbation = { 0, mutation_rate, 0.0 };
+    mutate_genes(network, mutation_chance, perturbation);
 }
 
 
@@ -1,21 +1,23 @@
 #include "neural_network.h"
 #include "matrix.h"
+#include "gann_arena.h"
 #include "gann_errors.h"
+#include "simd_kernels.h"
+#include "gemm.h"
+#include "half.h"
+#include "nn_kernels.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
-// --- Private Activation Functions ---
-static double sigmoid(double x) { return 1.0 / (1.0 + exp(-x)); }
-static double relu(double x) { return x > 0 ? x : 0; }
-static double leaky_relu(double x) { return x > 0 ? x : 0.01 * x; }
-static double linear(double x) { return x; } // Identity function
-static double sigmoid_derivative(double x) { double s = sigmoid(x); return s * (1 - s); }
-static double relu_derivative(double x) { return x > 0 ? 1 : 0; }
-static double leaky_relu_derivative(double x) { return x > 0 ? 1 : 0.01; }
-static double linear_derivative(double x) { (void)x; return 1; } // Derivative is constant 1
+// Activations and their derivatives are applied by the dispatched SIMD kernels (simd_impl.h).
 
 // --- Public API Functions ---
 
@@ -24,15 +26,12 @@ void nn_apply_activation(Matrix* m, ActivationType activation_type) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
-    for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            double* val = &m->data[i][j];
-            switch (activation_type) {
-                case SIGMOID: *val = sigmoid(*val); break;
-                case RELU: *val = relu(*val); break;
-                case LEAKY_RELU: *val = leaky_relu(*val); break;
-                case LINEAR: *val = linear(*val); break;
-            }
+    const SimdKernels* kern = simd_kernels();
+    if (matrix_is_contiguous(m) && activation_type != SOFTMAX) {
+        kern->activation((size_t)m->rows * m->cols, m->values, activation_type);
+    } else {
+        for (int i = 0; i < m->rows; i++) {
+            kern->activation((size_t)m->cols, m->values + (size_t)i * m->stride, activation_type);
         }
     }
     gann_set_error(GANN_SUCCESS);
@@ -43,21 +42,131 @@ void nn_apply_activation_derivative(Matrix* m, ActivationType activation_type) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return;
     }
-    for (int i = 0; i < m->rows; i++) {
-        for (int j = 0; j < m->cols; j++) {
-            double* val = &m->data[i][j];
-            switch (activation_type) {
-                case SIGMOID: *val = sigmoid_derivative(*val); break;
-                case RELU: *val = relu_derivative(*val); break;
-                case LEAKY_RELU: *val = leaky_relu_derivative(*val); break;
-                case LINEAR: *val = linear_derivative(*val); break;
-            }
+    const SimdKernels* kern = simd_kernels();
+    if (matrix_is_contiguous(m)) {
+        kern->activation_derivative((size_t)m->rows * m->cols, m->values, activation_type);
+    } else {
+        for (int i = 0; i < m->rows; i++) {
+            kern->activation_derivative((size_t)m->cols, m->values + (size_t)i * m->stride, activation_type);
         }
     }
     gann_set_error(GANN_SUCCESS);
 }
 
 NeuralNetwork* nn_create(int num_layers, const int* architecture, ActivationType activation_hidden, ActivationType activation_output) {
+    return nn_create_with_storage(num_layers, architecture, activation_hidden, activation_output, NN_STORAGE_NATIVE);
+}
+
+static int valid_storage(NNWeightStorage storage) {
+    return storage == NN_STORAGE_NATIVE || storage == NN_STORAGE_FP16 || storage == NN_STORAGE_BF16;
+}
+
+// --- Parameter Storage ---
+// A network's weights and biases live in one aligned block, so that a clone is
+// a single memcpy and the genetic operators are linear loops. With native
+// storage the block holds each layer's weights (row-major) followed by its
+// biases, layer after layer, which is also the file order of nn_save. With
+// 16-bit storage it holds the biases of every layer, followed by the 16-bit
+// weights of every layer. The Matrix headers are views made by matrix_wrap.
+
+typedef struct {
+    gann_real* block;      // The parameter block; owns everything below
+    size_t num_parameters; // gann_real values at the start of the block
+    Matrix** weights;      // Native storage only
+    uint16_t** weights_16; // 16-bit storage only
+    Matrix** biases;
+} ParameterStorage;
+
+static gann_real* parameter_block_alloc(size_t size) {
+#if defined(_WIN32)
+    return (gann_real*)_aligned_malloc(size, MATRIX_ALIGNMENT);
+#else
+    void* block = NULL;
+    if (posix_memalign(&block, MATRIX_ALIGNMENT, size) != 0) return NULL;
+    return (gann_real*)block;
+#endif
+}
+
+static void parameter_block_free(gann_real* block) {
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+// The size in bytes of the parameter block for an architecture and storage.
+// Stores the number of gann_real values at its start in *num_parameters.
+static size_t parameter_block_size(int num_layers, const int* architecture, NNWeightStorage storage, size_t* num_parameters) {
+    size_t num_weights = 0, num_biases = 0;
+    for (int i = 0; i < num_layers - 1; i++) {
+        num_weights += (size_t)architecture[i] * architecture[i + 1];
+        num_biases += (size_t)architecture[i + 1];
+    }
+    if (storage == NN_STORAGE_NATIVE) {
+        *num_parameters = num_weights + num_biases;
+        return *num_parameters * sizeof(gann_real);
+    }
+    *num_parameters = num_biases;
+    return num_biases * sizeof(gann_real) + num_weights * sizeof(uint16_t);
+}
+
+static void parameter_storage_free(ParameterStorage* params, int num_weight_sets) {
+    for (int i = 0; i < num_weight_sets; i++) {
+        if (params->weights) free_matrix(params->weights[i]);
+        if (params->biases) free_matrix(params->biases[i]);
+    }
+    free(params->weights);
+    free(params->weights_16);
+    free(params->biases);
+    parameter_block_free(params->block);
+}
+
+// Allocates a zeroed parameter block and the views into it. A zero bit pattern
+// is +0.0 in every storage. Returns 1 on success; on failure frees whatever it
+// allocated, sets the error and returns 0.
+static int parameter_storage_create(ParameterStorage* params, int num_layers, const int* architecture, NNWeightStorage storage) {
+    memset(params, 0, sizeof(*params));
+    int num_weight_sets = num_layers - 1;
+    size_t block_size = parameter_block_size(num_layers, architecture, storage, &params->num_parameters);
+
+    params->block = parameter_block_alloc(block_size);
+    if (storage == NN_STORAGE_NATIVE) {
+        params->weights = (Matrix**)calloc(num_weight_sets, sizeof(Matrix*));
+    } else {
+        params->weights_16 = (uint16_t**)calloc(num_weight_sets, sizeof(uint16_t*));
+    }
+    params->biases = (Matrix**)calloc(num_weight_sets, sizeof(Matrix*));
+    if (!params->block || (!params->weights && !params->weights_16) || !params->biases) {
+        parameter_storage_free(params, num_weight_sets);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return 0;
+    }
+    memset(params->block, 0, block_size);
+
+    gann_real* next = params->block;
+    uint16_t* next_16 = (uint16_t*)(params->block + params->num_parameters);
+    for (int i = 0; i < num_weight_sets; i++) {
+        int rows = architecture[i], cols = architecture[i + 1];
+        if (params->weights) {
+            params->weights[i] = matrix_wrap(next, rows, cols);
+            next += (size_t)rows * cols;
+        } else {
+            params->weights_16[i] = next_16;
+            next_16 += (size_t)rows * cols;
+        }
+        params->biases[i] = matrix_wrap(next, 1, cols);
+        next += cols;
+        if ((params->weights && !params->weights[i]) || !params->biases[i]) {
+            parameter_storage_free(params, num_weight_sets);
+            return 0; // matrix_wrap sets the error
+        }
+    }
+    return 1;
+}
+
+NeuralNetwork* nn_create_with_storage(int num_layers, const int* architecture, ActivationType activation_hidden,
+                                      ActivationType activation_output, NNWeightStorage storage) {
     if (num_layers < 2) {
         gann_set_error(GANN_ERROR_INVALID_ARCHITECTURE);
         return NULL;
@@ -66,6 +175,17 @@ NeuralNetwork* nn_create(int num_layers, const int* architecture, ActivationType
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
     }
+    // Softmax couples a layer's outputs, which the hidden layers' backward pass does not model
+    if (!valid_storage(storage) || activation_hidden == SOFTMAX) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    for (int i = 0; i < num_layers; i++) {
+        if (architecture[i] <= 0) {
+            gann_set_error(GANN_ERROR_INVALID_PARAM);
+            return NULL;
+        }
+    }
 
     NeuralNetwork* net = (NeuralNetwork*)calloc(1, sizeof(NeuralNetwork));
     if (!net) {
@@ -77,6 +197,7 @@ NeuralNetwork* nn_create(int num_layers, const int* architecture, ActivationType
     net->activation_hidden = activation_hidden;
     net->activation_output = activation_output;
     net->optimizer_state = NULL; // Initialize optimizer state to NULL
+    net->weight_storage = storage;
 
     net->architecture = (int*)malloc(num_layers * sizeof(int));
     if (!net->architecture) {
@@ -86,25 +207,17 @@ NeuralNetwork* nn_create(int num_layers, const int* architecture, ActivationType
     }
     memcpy(net->architecture, architecture, num_layers * sizeof(int));
 
-    int num_weight_sets = num_layers - 1;
-    net->weights = (Matrix**)calloc(num_weight_sets, sizeof(Matrix*));
-    net->biases = (Matrix**)calloc(num_weight_sets, sizeof(Matrix*));
-
-    if (!net->weights || !net->biases) {
-        nn_free(net);
-        gann_set_error(GANN_ERROR_ALLOC_FAILED);
-        return NULL;
-    }
-
-    for (int i = 0; i < num_weight_sets; i++) {
-        net->weights[i] = create_matrix(architecture[i], architecture[i+1]);
-        net->biases[i] = create_matrix(1, architecture[i+1]);
-        if (!net->weights[i] || !net->biases[i]) {
-            nn_free(net);
-            // create_matrix already sets the error code
-            return NULL;
-        }
+    ParameterStorage params;
+    if (!parameter_storage_create(&params, num_layers, architecture, storage)) {
+        free(net->architecture);
+        free(net);
+        return NULL; // parameter_storage_create sets the error
     }
+    net->parameters = params.block;
+    net->num_parameters = params.num_parameters;
+    net->weights = params.weights;
+    net->weights_16 = params.weights_16;
+    net->biases = params.biases;
     gann_set_error(GANN_SUCCESS);
     return net;
 }
@@ -116,9 +229,17 @@ void nn_init(NeuralNetwork* net) {
     }
     for (int i = 0; i < net->num_layers - 1; i++) {
         double limit = sqrt(6.0 / (net->architecture[i] + net->architecture[i+1]));
-        for (int r = 0; r < net->weights[i]->rows; r++) {
-            for (int c = 0; c < net->weights[i]->cols; c++) {
-                net->weights[i]->data[r][c] = ((double)rand() / RAND_MAX) * 2 * limit - limit;
+        size_t count = (size_t)net->architecture[i] * net->architecture[i+1];
+        if (net->weights) {
+            gann_real* w = net->weights[i]->values;
+            for (size_t k = 0; k < count; k++) {
+                w[k] = ((double)rand() / RAND_MAX) * 2 * limit - limit;
+            }
+        } else {
+            // The same random sequence as a native network, rounded to the storage
+            uint16_t* w = net->weights_16[i];
+            for (size_t k = 0; k < count; k++) {
+                w[k] = half_from_real(((double)rand() / RAND_MAX) * 2 * limit - limit, net->weight_storage);
             }
         }
     }
@@ -201,55 +322,609 @@ void nn_free(NeuralNetwork* net) {
     }
     if (net->architecture) free(net->architecture);
     int num_weight_sets = net->num_layers > 1 ? net->num_layers - 1 : 0;
-    if (net->weights) {
-        for (int i = 0; i < num_weight_sets; i++) free_matrix(net->weights[i]);
-        free(net->weights);
-    }
-    if (net->biases) {
-        for (int i = 0; i < num_weight_sets; i++) free_matrix(net->biases[i]);
-        free(net->biases);
-    }
+    ParameterStorage params = { net->parameters, net->num_parameters, net->weights, net->weights_16, net->biases };
+    parameter_storage_free(&params, num_weight_sets);
     if (net->optimizer_state) {
         free_optimizer_state(net->optimizer_state, num_weight_sets);
     }
     free(net);
 }
 
+int nn_set_weight_storage(NeuralNetwork* net, NNWeightStorage storage) {
+    if (net == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (!valid_storage(storage) || (storage != NN_STORAGE_NATIVE && net->optimizer_state)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (storage == net->weight_storage) {
+        gann_set_error(GANN_SUCCESS);
+        return 1;
+    }
+
+    // Build the new parameters completely before releasing the old ones, so
+    // that a failed allocation leaves the network as it was.
+    int num_weight_sets = net->num_layers - 1;
+    ParameterStorage params;
+    if (!parameter_storage_create(&params, net->num_layers, net->architecture, storage)) {
+        return 0; // parameter_storage_create sets the error
+    }
+    for (int i = 0; i < num_weight_sets; i++) {
+        size_t count = (size_t)net->architecture[i] * net->architecture[i + 1];
+        const gann_real* src = net->weights ? net->weights[i]->values : NULL;
+        for (size_t k = 0; k < count; k++) {
+            gann_real w = src ? src[k] : half_to_real(net->weights_16[i][k], net->weight_storage);
+            if (params.weights) params.weights[i]->values[k] = w;
+            else params.weights_16[i][k] = half_from_real(w, storage);
+        }
+        memcpy(params.biases[i]->values, net->biases[i]->values, (size_t)net->architecture[i + 1] * sizeof(gann_real));
+    }
+
+    ParameterStorage old = { net->parameters, net->num_parameters, net->weights, net->weights_16, net->biases };
+    parameter_storage_free(&old, num_weight_sets);
+    net->parameters = params.block;
+    net->num_parameters = params.num_parameters;
+    net->weights = params.weights;
+    net->weights_16 = params.weights_16;
+    net->biases = params.biases;
+    net->weight_storage = storage;
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+gann_real nn_get_weight(const NeuralNetwork* net, int layer, int row, int col) {
+    if (net->weights) return net->weights[layer]->data[row][col];
+    return half_to_real(net->weights_16[layer][(size_t)row * net->architecture[layer + 1] + col], net->weight_storage);
+}
+
+void nn_set_weight(NeuralNetwork* net, int layer, int row, int col, gann_real value) {
+    if (net->weights) {
+        net->weights[layer]->data[row][col] = value;
+    } else {
+        net->weights_16[layer][(size_t)row * net->architecture[layer + 1] + col] = half_from_real(value, net->weight_storage);
+    }
+}
+
+gann_real* nn_get_parameters(const NeuralNetwork* net, size_t* count) {
+    if (count) *count = 0;
+    if (net == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (net->weight_storage != NN_STORAGE_NATIVE) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    if (count) *count = net->num_parameters;
+    gann_set_error(GANN_SUCCESS);
+    return net->parameters;
+}
+
+// Takes the pointer array and the first `count` layer buffers from the arena;
+// the remaining slots are left NULL for the caller to fill.
+static Matrix** arena_layer_buffers(const NeuralNetwork* net, int rows, GannArena* arena, int count) {
+    Matrix** buffers = (Matrix**)gann_arena_alloc(arena, (size_t)(net->num_layers - 1) * sizeof(Matrix*));
+    if (!buffers) return NULL; // gann_arena_alloc sets the error
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        buffers[l] = NULL;
+        if (l < count && !(buffers[l] = gann_arena_create_matrix(arena, rows, net->architecture[l + 1]))) {
+            return NULL; // gann_arena_create_matrix sets the error
+        }
+    }
+    return buffers;
+}
+
 Matrix* nn_forward_pass(const NeuralNetwork* net, const Matrix* input) {
     if (net == NULL || input == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return NULL;
     }
-    if (input->cols != net->architecture[0]) {
+    Matrix* output = create_matrix(input->rows, net->architecture[net->num_layers - 1]);
+    if (!output) return NULL; // create_matrix sets the error
+    if (!nn_forward_pass_batch(net, matrix_view(input), output)) {
+        free_matrix(output);
+        return NULL; // nn_forward_pass_batch sets the error
+    }
+    return output;
+}
+
+Matrix** nn_create_layer_buffers(const NeuralNetwork* net, int rows) {
+    if (net == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    Matrix** buffers = (Matrix**)calloc(net->num_layers - 1, sizeof(Matrix*));
+    if (!buffers) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        buffers[l] = create_matrix(rows, net->architecture[l + 1]);
+        if (!buffers[l]) {
+            nn_free_layer_buffers(buffers, net->num_layers);
+            return NULL; // create_matrix sets the error
+        }
+    }
+    return buffers;
+}
+
+Matrix** nn_create_layer_buffers_arena(const NeuralNetwork* net, int rows, GannArena* arena) {
+    if (net == NULL || arena == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (rows <= 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    return arena_layer_buffers(net, rows, arena, net->num_layers - 1);
+}
+
+void nn_free_layer_buffers(Matrix** buffers, int num_layers) {
+    if (buffers == NULL) return;
+    for (int l = 0; l < num_layers - 1; l++) free_matrix(buffers[l]);
+    free(buffers);
+}
+
+int nn_forward_pass_into(const NeuralNetwork* net, const Matrix* input, Matrix** layer_outputs) {
+    if (input == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    return nn_forward_pass_view_into(net, matrix_view(input), layer_outputs);
+}
+
+// Returns 1 if the elements of `v` and `m` share any memory.
+static int storage_overlaps(MatrixView v, const Matrix* m) {
+    const gann_real* v_end = v.values + (size_t)(v.rows - 1) * v.stride + v.cols;
+    const gann_real* m_end = m->values + (size_t)(m->rows - 1) * m->stride + m->cols;
+    return v.values < m_end && m->values < v_end;
+}
+
+// The bias and activation of `layer`, and where to keep the pre-activations.
+static GemmEpilogue layer_epilogue(const NeuralNetwork* net, int layer, Matrix* z) {
+    GemmEpilogue epilogue = {
+        .bias = net->biases[layer]->values,
+        .z = z ? z->values : NULL,
+        .ldz = z ? z->stride : 0,
+        .activation = (layer < net->num_layers - 2) ? net->activation_hidden : net->activation_output,
+        .fast_sigmoid = g_simd_fast_sigmoid,
+    };
+    return epilogue;
+}
+
+// Adaptive switch: dense inputs run faster through the dense kernel, and
+// 16-bit weights are only read through the widening GEMM.
+static int sparse_kernel_applies(const NeuralNetwork* net, MatrixView input, int num_nonzero) {
+    return num_nonzero <= NN_SPARSE_MAX_DENSITY * input.cols && net->weight_storage == NN_STORAGE_NATIVE;
+}
+
+// Checks the buffers of a whole forward pass over `input` in one go, so that
+// the layers can then run unchecked: every layer needs an output of the right
+// shape that does not overlap its own input. Sets the error and returns 0 if not.
+static int check_forward_buffers(const NeuralNetwork* net, MatrixView input, Matrix** layer_outputs) {
+    MatrixView current = input;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        const Matrix* output = layer_outputs[l];
+        if (output == NULL) {
+            gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+            return 0;
+        }
+        if (output->rows != input.rows || output->cols != net->architecture[l + 1]) {
+            gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+            return 0;
+        }
+        if (storage_overlaps(current, output)) {
+            gann_set_error(GANN_ERROR_INVALID_PARAM);
+            return 0;
+        }
+        current = matrix_view(output);
+    }
+    return 1;
+}
+
+int nn_forward_pass_view_into(const NeuralNetwork* net, MatrixView input, Matrix** layer_outputs) {
+    if (net == NULL || input.values == NULL || layer_outputs == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (input.cols != net->architecture[0]) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (!check_forward_buffers(net, input, layer_outputs)) return 0;
+
+    if (!nn_forward_unchecked(net, input, NULL, 0, layer_outputs)) return 0; // the 16-bit path sets the error
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int nn_forward_unchecked(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                         Matrix** layer_outputs) {
+    GANN_DEBUG_ASSERT(nonzero_columns == NULL || input.rows == 1);
+    int first = 0;
+    if (nonzero_columns) {
+        if (!nn_layer_forward_sparse_unchecked(net, input, nonzero_columns, num_nonzero, layer_outputs[0], NULL)) return 0;
+        first = 1;
+    }
+    MatrixView current = first ? matrix_view(layer_outputs[0]) : input;
+    for (int l = first; l < net->num_layers - 1; l++) {
+        if (!nn_layer_forward_unchecked(net, l, current, layer_outputs[l], NULL)) return 0;
+        current = matrix_view(layer_outputs[l]);
+    }
+    return 1;
+}
+
+int nn_check_dataset(const NeuralNetwork* net, const Dataset* dataset) {
+    if (net == NULL || dataset == NULL || dataset->images == NULL || dataset->labels == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (dataset->num_items < 0 || dataset->images->rows < dataset->num_items || dataset->labels->rows < dataset->num_items ||
+        dataset->images->cols != net->architecture[0] || dataset->labels->cols != net->architecture[net->num_layers - 1]) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    return 1;
+}
+
+// --- Batched Forward Pass ---
+
+// Rows per batch of nn_forward_pass_batch(); see nn_set_forward_batch_size().
+// Set from any thread. Each call reads it once, so one call never mixes sizes.
+static _Atomic int g_forward_batch_size = NN_DEFAULT_FORWARD_BATCH_SIZE;
+
+int nn_set_forward_batch_size(int batch_size) {
+    if (batch_size < 1) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    atomic_store_explicit(&g_forward_batch_size, batch_size, memory_order_relaxed);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int nn_get_forward_batch_size(void) {
+    return atomic_load_explicit(&g_forward_batch_size, memory_order_relaxed);
+}
+
+int nn_forward_pass_batch(const NeuralNetwork* net, MatrixView inputs, Matrix* outputs) {
+    if (net == NULL || inputs.values == NULL || outputs == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (inputs.cols != net->architecture[0] || outputs->rows != inputs.rows ||
+        outputs->cols != net->architecture[net->num_layers - 1]) {
         gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (storage_overlaps(inputs, outputs)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+
+    if (!nn_forward_batch_unchecked(net, inputs, 0, outputs)) return 0; // the failing call sets the error
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+// --- Inference Contexts ---
+
+GannInferenceContext* gann_inference_context_create(const NeuralNetwork* net) {
+    if (net == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    int widest = 1;
+    for (int l = 1; l < net->num_layers; l++) {
+        if (net->architecture[l] > widest) widest = net->architecture[l];
+    }
+    GannInferenceContext* ctx = (GannInferenceContext*)calloc(1, sizeof(GannInferenceContext));
+    if (!ctx) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
         return NULL;
     }
+    ctx->net = net;
+    ctx->kern = simd_kernels();
+    ctx->fast_sigmoid = g_simd_fast_sigmoid;
+    ctx->buffers[0] = create_matrix(1, widest);
+    ctx->buffers[1] = ctx->buffers[0] ? create_matrix(1, widest) : NULL;
+    if (!ctx->buffers[1]) {
+        gann_inference_context_free(ctx);
+        return NULL; // create_matrix sets the error
+    }
+    ctx->nonzero_columns = (int*)malloc((size_t)net->architecture[0] * sizeof(int));
+    if (!ctx->nonzero_columns) {
+        gann_inference_context_free(ctx);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    gann_set_error(GANN_SUCCESS);
+    return ctx;
+}
 
-    Matrix* current_output = matrix_copy(input);
-    if (!current_output) return NULL; // matrix_copy sets the error
+void gann_inference_context_free(GannInferenceContext* ctx) {
+    if (ctx == NULL) return;
+    free_matrix(ctx->buffers[0]);
+    free_matrix(ctx->buffers[1]);
+    free(ctx->nonzero_columns);
+    free(ctx);
+}
 
-    for (int i = 0; i < net->num_layers - 1; i++) {
-        Matrix* weighted_sum = dot_product(current_output, net->weights[i]);
-        if (!weighted_sum) {
-            free_matrix(current_output);
-            return NULL; // dot_product sets the error
+const gann_real* nn_forward_ctx(GannInferenceContext* ctx, const gann_real* input) {
+    if (ctx == NULL || input == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    const NeuralNetwork* net = ctx->net;
+    MatrixView current = { input, 1, net->architecture[0], net->architecture[0] };
+    int num_nonzero = nn_list_nonzeros(current, ctx->nonzero_columns);
+
+    // One row needs none of the blocked GEMM's machinery, so the layers call the
+    // context's row kernels directly: no thread pool, BLAS, packing buffer or
+    // global setting is involved, which is what makes contexts reentrant. The
+    // epilogues take the context's sigmoid mode instead of the live one.
+    const SimdKernels* kern = ctx->kern;
+    gann_real* output = NULL;
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        int rows = net->architecture[l], cols = net->architecture[l + 1];
+        output = ctx->buffers[l % 2]->values;
+        GemmEpilogue epilogue = layer_epilogue(net, l, NULL);
+        epilogue.fast_sigmoid = ctx->fast_sigmoid;
+        if (l == 0 && sparse_kernel_applies(net, current, num_nonzero)) {
+            kern->gemm_sparse_row(cols, num_nonzero, ctx->nonzero_columns, current.values, net->weights[0]->values,
+                                  net->weights[0]->stride, output, &epilogue);
+        } else if (net->weight_storage != NN_STORAGE_NATIVE) {
+            kern->gemm_row_16(cols, rows, current.values, net->weights_16[l], cols, net->weight_storage, output, &epilogue);
+        } else {
+            kern->gemm_rows(1, cols, rows, current.values, current.stride, 1, net->weights[l]->values, net->weights[l]->stride,
+                            0.0, output, cols, &epilogue);
         }
-        free_matrix(current_output); // Free previous step's output
+        gemm_softmax_rows(kern, 1, cols, output, cols, &epilogue);
+        current = (MatrixView){ output, 1, cols, cols };
+    }
+    gann_set_error(GANN_SUCCESS);
+    return output;
+}
 
-        add_bias(weighted_sum, net->biases[i]);
-        // add_bias doesn't return a value, but can set an error.
-        if (gann_get_last_error() != GANN_SUCCESS) {
-            free_matrix(weighted_sum);
-            return NULL;
+int nn_list_nonzeros(MatrixView row, int* columns) {
+    int count = 0;
+    for (int j = 0; j < row.cols; j++) {
+        columns[count] = j;
+        count += (row.values[j] != 0); // branch-free: the slot is overwritten unless the entry is nonzero
+    }
+    return count;
+}
+
+// Lists the nonzero columns of every row of `inputs`: those of row r are
+// columns[row_start[r]] up to columns[row_start[r + 1]]. Returns the total.
+static int list_batch_nonzeros(MatrixView inputs, int* row_start, int* columns) {
+    int count = 0;
+    for (int r = 0; r < inputs.rows; r++) {
+        MatrixView row = { inputs.values + (size_t)r * inputs.stride, 1, inputs.cols, inputs.stride };
+        row_start[r] = count;
+        count += nn_list_nonzeros(row, columns + count);
+    }
+    row_start[inputs.rows] = count;
+    return count;
+}
+
+// Runs a batch of rows whose first layer only reads their nonzero entries,
+// listed as by list_batch_nonzeros. The sparse kernel takes one row at a time,
+// so the first layer is computed row by row into the batch's first buffer and
+// the remaining layers as one product each.
+static int forward_sparse_batch(const NeuralNetwork* net, MatrixView inputs, const int* row_start, const int* columns,
+                                Matrix** layer_outputs) {
+    for (int r = 0; r < inputs.rows; r++) {
+        MatrixView input = { inputs.values + (size_t)r * inputs.stride, 1, inputs.cols, inputs.stride };
+        Matrix output = matrix_window_unchecked(layer_outputs[0], r, 1);
+        if (!nn_layer_forward_sparse_unchecked(net, input, columns + row_start[r], row_start[r + 1] - row_start[r],
+                                               &output, NULL)) return 0;
+    }
+    for (int l = 1; l < net->num_layers - 1; l++) {
+        if (!nn_layer_forward_unchecked(net, l, matrix_view(layer_outputs[l - 1]), layer_outputs[l], NULL)) return 0;
+    }
+    return 1;
+}
+
+int nn_forward_batch_unchecked(const NeuralNetwork* net, MatrixView inputs, int skip_zeros, Matrix* outputs) {
+    GANN_DEBUG_ASSERT(inputs.cols == net->architecture[0] && outputs->rows == inputs.rows);
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return 0; // gann_scratch_arena sets the error
+
+    // The hidden layers are sized for one batch and reused for every batch; the
+    // last, shorter batch runs on windows onto their first rows. The output
+    // layer writes straight into the caller's rows.
+    int last = net->num_layers - 2;
+    int batch_size = nn_get_forward_batch_size();
+    if (inputs.rows < batch_size) batch_size = inputs.rows;
+    size_t mark = gann_arena_mark(arena);
+    Matrix** buffers = arena_layer_buffers(net, batch_size, arena, last);
+    Matrix* windows = buffers ? (Matrix*)gann_arena_alloc(arena, (size_t)(last + 1) * sizeof(Matrix)) : NULL;
+    Matrix** layer_outputs = windows ? (Matrix**)gann_arena_alloc(arena, (size_t)(last + 1) * sizeof(Matrix*)) : NULL;
+    int* row_start = NULL;
+    int* columns = NULL;
+    if (layer_outputs && skip_zeros) {
+        row_start = (int*)gann_arena_alloc(arena, ((size_t)batch_size + 1) * sizeof(int));
+        columns = row_start ? (int*)gann_arena_alloc(arena, (size_t)batch_size * inputs.cols * sizeof(int)) : NULL;
+    }
+    int ok = layer_outputs != NULL && (!skip_zeros || columns != NULL); // the arena functions set the error
+
+    for (int r = 0; ok && r < inputs.rows; r += batch_size) {
+        int rows = inputs.rows - r < batch_size ? inputs.rows - r : batch_size;
+        for (int l = 0; l <= last; l++) {
+            windows[l] = (l < last) ? matrix_window_unchecked(buffers[l], 0, rows) : matrix_window_unchecked(outputs, r, rows);
+            layer_outputs[l] = &windows[l];
+        }
+        MatrixView batch = { inputs.values + (size_t)r * inputs.stride, rows, inputs.cols, inputs.stride };
+        // Listing the nonzeros costs one compare per entry, against a multiply-add
+        // per entry and first-layer unit for the dense product.
+        int sparse = skip_zeros && net->weight_storage == NN_STORAGE_NATIVE &&
+                     list_batch_nonzeros(batch, row_start, columns) <= NN_SPARSE_MAX_DENSITY * rows * inputs.cols;
+        ok = sparse ? forward_sparse_batch(net, batch, row_start, columns, layer_outputs)
+                    : nn_forward_unchecked(net, batch, NULL, 0, layer_outputs);
+    }
+    gann_arena_reset_to(arena, mark);
+    return ok;
+}
+
+int nn_layer_forward_into(const NeuralNetwork* net, int layer, MatrixView input, Matrix* output, Matrix* z) {
+    if (net == NULL || input.values == NULL || output == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (layer < 0 || layer > net->num_layers - 2) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    const int rows = net->architecture[layer], cols = net->architecture[layer + 1];
+    if (input.cols != rows || output->rows != input.rows || output->cols != cols ||
+        (z && (z->rows != output->rows || z->cols != output->cols))) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (storage_overlaps(input, output) || (z && (storage_overlaps(input, z) || storage_overlaps(matrix_view(z), output)))) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+
+    if (!nn_layer_forward_unchecked(net, layer, input, output, z)) return 0; // the 16-bit path sets the error
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int nn_layer_forward_unchecked(const NeuralNetwork* net, int layer, MatrixView input, Matrix* output, Matrix* z) {
+    const int rows = net->architecture[layer], cols = net->architecture[layer + 1];
+    GANN_DEBUG_ASSERT(layer >= 0 && layer <= net->num_layers - 2);
+    GANN_DEBUG_ASSERT(input.cols == rows && output->rows == input.rows && output->cols == cols);
+    GANN_DEBUG_ASSERT(!z || (z->rows == output->rows && z->cols == output->cols));
+    GANN_DEBUG_ASSERT(!storage_overlaps(input, output));
+
+    GemmEpilogue epilogue = layer_epilogue(net, layer, z);
+    if (net->weight_storage != NN_STORAGE_NATIVE) {
+        if (!gemm_nn_16(input.rows, cols, rows, input.values, input.stride, net->weights_16[layer], cols,
+                        net->weight_storage, output->values, output->stride, &epilogue)) {
+            gann_set_error(GANN_ERROR_ALLOC_FAILED);
+            return 0;
         }
+    } else {
+        const Matrix* weights = net->weights[layer];
+        gemm_nn_epilogue(input.rows, cols, rows,
+                         input.values, input.stride,
+                         weights->values, weights->stride,
+                         0.0, output->values, output->stride, &epilogue);
+    }
+    return 1;
+}
+
+// Checks the column list of a sparse first layer. Sets the error and returns 0 if it is invalid.
+static int check_nonzero_columns(MatrixView input, const int* nonzero_columns, int num_nonzero) {
+    for (int p = 0; p < num_nonzero; p++) {
+        if (nonzero_columns[p] < 0 || nonzero_columns[p] >= input.cols) {
+            gann_set_error(GANN_ERROR_INVALID_PARAM);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int nn_layer_forward_sparse_into(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                                 Matrix* output, Matrix* z) {
+    if (net == NULL || input.values == NULL || output == NULL || (nonzero_columns == NULL && num_nonzero > 0)) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (input.rows != 1 || input.cols != net->architecture[0] || output->rows != 1 || output->cols != net->architecture[1] ||
+        (z && (z->rows != 1 || z->cols != output->cols))) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (num_nonzero < 0 || num_nonzero > input.cols) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (!sparse_kernel_applies(net, input, num_nonzero)) {
+        return nn_layer_forward_into(net, 0, input, output, z);
+    }
+    if (!check_nonzero_columns(input, nonzero_columns, num_nonzero)) return 0;
+    if (storage_overlaps(input, output) || (z && (storage_overlaps(input, z) || storage_overlaps(matrix_view(z), output)))) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+
+    nn_layer_forward_sparse_unchecked(net, input, nonzero_columns, num_nonzero, output, z);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int nn_layer_forward_sparse_unchecked(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                                      Matrix* output, Matrix* z) {
+    if (!sparse_kernel_applies(net, input, num_nonzero)) {
+        return nn_layer_forward_unchecked(net, 0, input, output, z);
+    }
+    GANN_DEBUG_ASSERT(input.rows == 1 && output->rows == 1 && output->cols == net->architecture[1]);
+    GANN_DEBUG_ASSERT(num_nonzero >= 0 && num_nonzero <= input.cols);
+
+    const Matrix* weights = net->weights[0];
+    GemmEpilogue epilogue = layer_epilogue(net, 0, z);
+    const SimdKernels* kern = simd_kernels();
+    kern->gemm_sparse_row(weights->cols, num_nonzero, nonzero_columns, input.values,
+                          weights->values, weights->stride, output->values, &epilogue);
+    gemm_softmax_rows(kern, 1, weights->cols, output->values, output->stride, &epilogue);
+    return 1;
+}
+
+int nn_layer_forward_pruned_into(const NeuralNetwork* net, int layer, const SparseMatrix* weights, MatrixView input,
+                                 Matrix* output, Matrix* z) {
+    if (net == NULL || weights == NULL || input.values == NULL || output == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (layer < 0 || layer > net->num_layers - 2) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (weights->rows != net->architecture[layer] || weights->cols != net->architecture[layer + 1] ||
+        input.cols != weights->rows || output->rows != input.rows || output->cols != weights->cols ||
+        (z && (z->rows != output->rows || z->cols != output->cols))) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (storage_overlaps(input, output) || (z && (storage_overlaps(input, z) || storage_overlaps(matrix_view(z), output)))) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
 
-        ActivationType activation = (i < net->num_layers - 2) ? net->activation_hidden : net->activation_output;
-        nn_apply_activation(weighted_sum, activation);
+    GemmEpilogue epilogue = layer_epilogue(net, layer, z);
+    gemm_nn_csr(input.rows, weights->cols, input.cols, input.values, input.stride,
+                weights->row_start, weights->col_index, weights->values,
+                output->values, output->stride, &epilogue);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
 
-        current_output = weighted_sum;
+int nn_forward_pass_sparse_into(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                                Matrix** layer_outputs) {
+    if (net == NULL || input.values == NULL || layer_outputs == NULL || (nonzero_columns == NULL && num_nonzero > 0)) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
     }
+    if (input.rows != 1 || input.cols != net->architecture[0]) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (num_nonzero < 0 || num_nonzero > input.cols) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+    if (!check_forward_buffers(net, input, layer_outputs)) return 0;
+    if (sparse_kernel_applies(net, input, num_nonzero) && !check_nonzero_columns(input, nonzero_columns, num_nonzero)) return 0;
+
+    if (!nn_forward_unchecked(net, input, nonzero_columns, num_nonzero, layer_outputs)) return 0; // the 16-bit path sets the error
     gann_set_error(GANN_SUCCESS);
-    return current_output;
+    return 1;
 }
 
 NeuralNetwork* nn_clone(const NeuralNetwork* src_net) {
@@ -258,20 +933,14 @@ NeuralNetwork* nn_clone(const NeuralNetwork* src_net) {
         return NULL;
     }
 
-    NeuralNetwork* new_net = nn_create(src_net->num_layers, src_net->architecture, src_net->activation_hidden, src_net->activation_output);
-    if (!new_net) return NULL; // nn_create sets the error
+    NeuralNetwork* new_net = nn_create_with_storage(src_net->num_layers, src_net->architecture, src_net->activation_hidden,
+                                                    src_net->activation_output, src_net->weight_storage);
+    if (!new_net) return NULL; // nn_create_with_storage sets the error
 
-    for (int i = 0; i < src_net->num_layers - 1; i++) {
-        // Copy weights and biases
-        free_matrix(new_net->weights[i]);
-        new_net->weights[i] = matrix_copy(src_net->weights[i]);
-        free_matrix(new_net->biases[i]);
-        new_net->biases[i] = matrix_copy(src_net->biases[i]);
-        if (!new_net->weights[i] || !new_net->biases[i]) {
-            nn_free(new_net);
-            return NULL;
-        }
-    }
+    // Same architecture and storage, so the same parameter block layout
+    size_t num_parameters;
+    memcpy(new_net->parameters, src_net->parameters,
+           parameter_block_size(src_net->num_layers, src_net->architecture, src_net->weight_storage, &num_parameters));
 
     // Clone optimizer state if it exists
     if (src_net->optimizer_state) {
@@ -289,11 +958,131 @@ NeuralNetwork* nn_clone(const NeuralNetwork* src_net) {
     return new_net;
 }
 
+// --- Persistence ---
+// A float64 file is the original layout: num_layers, the two activation types,
+// the architecture, then each layer's weights and biases as doubles. Any other
+// precision is announced by a tag in front of that same layout: the magic bytes
+// "GANN", a format version and the size in bytes of one stored element. The
+// two 16-bit formats have the same element size, so their tag adds the
+// NNFileFormat itself. Only the weights are narrowed to 16 bits: the tag
+// (version 3) ends with the size of a stored bias, 4 or 8 bytes, and the
+// biases are written at that precision, so a 16-bit network saves exactly.
+// The first field of an untagged file is a small layer count, so it never
+// reads as the magic.
+static const char NN_FILE_MAGIC[4] = { 'G', 'A', 'N', 'N' };
+#define NN_FILE_VERSION 1
+#define NN_FILE_VERSION_16_WIDE_BIASES 3
+#define NN_FILE_CHUNK 256
+
+static size_t file_element_size(NNFileFormat format) {
+    switch (format) {
+        case NN_FILE_FLOAT64: return sizeof(double);
+        case NN_FILE_FLOAT32: return sizeof(float);
+        case NN_FILE_FLOAT16:
+        case NN_FILE_BFLOAT16: return sizeof(uint16_t);
+        default: return 0;
+    }
+}
+
+// The weight storage that holds a file format's values exactly.
+static NNWeightStorage file_storage(NNFileFormat format) {
+    switch (format) {
+        case NN_FILE_FLOAT16: return NN_STORAGE_FP16;
+        case NN_FILE_BFLOAT16: return NN_STORAGE_BF16;
+        default: return NN_STORAGE_NATIVE;
+    }
+}
+
+typedef union {
+    float f[NN_FILE_CHUNK];
+    double d[NN_FILE_CHUNK];
+    uint16_t h[NN_FILE_CHUNK];
+} FileChunk;
+
+// Writes count elements converted to the file's format. Returns 1 on success.
+static int write_elements(FILE* file, const gann_real* src, size_t count, NNFileFormat format) {
+    size_t element_size = file_element_size(format);
+    if (element_size == sizeof(gann_real)) {
+        return fwrite(src, sizeof(gann_real), count, file) == count;
+    }
+    // Convert through a small stack buffer so that saving never allocates.
+    FileChunk chunk;
+    while (count > 0) {
+        size_t n = count < NN_FILE_CHUNK ? count : NN_FILE_CHUNK;
+        for (size_t i = 0; i < n; i++) {
+            if (format == NN_FILE_FLOAT32) chunk.f[i] = (float)src[i];
+            else if (format == NN_FILE_FLOAT64) chunk.d[i] = (double)src[i];
+            else chunk.h[i] = half_from_real(src[i], file_storage(format));
+        }
+        if (fwrite(&chunk, element_size, n, file) != n) return 0;
+        src += n;
+        count -= n;
+    }
+    return 1;
+}
+
+// Reads count elements of the file's format into dest. Returns 1 on success.
+static int read_elements(FILE* file, gann_real* dest, size_t count, NNFileFormat format) {
+    size_t element_size = file_element_size(format);
+    if (element_size == sizeof(gann_real)) {
+        return fread(dest, sizeof(gann_real), count, file) == count;
+    }
+    FileChunk chunk;
+    while (count > 0) {
+        size_t n = count < NN_FILE_CHUNK ? count : NN_FILE_CHUNK;
+        if (fread(&chunk, element_size, n, file) != n) return 0;
+        for (size_t i = 0; i < n; i++) {
+            if (format == NN_FILE_FLOAT32) dest[i] = (gann_real)chunk.f[i];
+            else if (format == NN_FILE_FLOAT64) dest[i] = (gann_real)chunk.d[i];
+            else dest[i] = half_to_real(chunk.h[i], file_storage(format));
+        }
+        dest += n;
+        count -= n;
+    }
+    return 1;
+}
+
+// Writes the 16-bit weights of one layer. Weights already in the file's format
+// are written as they are; any other format converts through gann_real.
+static int write_weights_16(FILE* file, const NeuralNetwork* net, int layer, NNFileFormat format) {
+    size_t count = (size_t)net->architecture[layer] * net->architecture[layer + 1];
+    const uint16_t* src = net->weights_16[layer];
+    if (file_storage(format) == net->weight_storage) {
+        return fwrite(src, sizeof(uint16_t), count, file) == count;
+    }
+    gann_real chunk[NN_FILE_CHUNK];
+    while (count > 0) {
+        size_t n = count < NN_FILE_CHUNK ? count : NN_FILE_CHUNK;
+        simd_kernels()->widen_16(n, src, chunk, net->weight_storage);
+        if (!write_elements(file, chunk, n, format)) return 0;
+        src += n;
+        count -= n;
+    }
+    return 1;
+}
+
+// The format that holds native parameters exactly.
+static NNFileFormat native_file_format(void) {
+    return sizeof(gann_real) == sizeof(float) ? NN_FILE_FLOAT32 : NN_FILE_FLOAT64;
+}
+
 int nn_save(const NeuralNetwork* net, const char* filepath) {
+    NNFileFormat format = native_file_format();
+    if (net && net->weight_storage == NN_STORAGE_FP16) format = NN_FILE_FLOAT16;
+    if (net && net->weight_storage == NN_STORAGE_BF16) format = NN_FILE_BFLOAT16;
+    return nn_save_as(net, filepath, format);
+}
+
+int nn_save_as(const NeuralNetwork* net, const char* filepath, NNFileFormat format) {
     if (net == NULL || filepath == NULL) {
         gann_set_error(GANN_ERROR_NULL_ARGUMENT);
         return 0;
     }
+    size_t element_size = file_element_size(format);
+    if (element_size == 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
     FILE* file = fopen(filepath, "wb");
     if (!file) {
         gann_set_error(GANN_ERROR_FILE_OPEN);
@@ -308,6 +1097,23 @@ int nn_save(const NeuralNetwork* net, const char* filepath) {
         return 0; \
     }
 
+    // Tag every format except the original float64 layout
+    int is_16 = file_storage(format) != NN_STORAGE_NATIVE;
+    NNFileFormat bias_format = is_16 ? native_file_format() : format;
+    if (format != NN_FILE_FLOAT64) {
+        int version = is_16 ? NN_FILE_VERSION_16_WIDE_BIASES : NN_FILE_VERSION;
+        int stored_size = (int)element_size;
+        int stored_format = (int)format;
+        int bias_size = (int)file_element_size(bias_format);
+        CHECK_WRITE(NN_FILE_MAGIC, 1, sizeof(NN_FILE_MAGIC), file);
+        CHECK_WRITE(&version, sizeof(int), 1, file);
+        CHECK_WRITE(&stored_size, sizeof(int), 1, file);
+        if (is_16) {
+            CHECK_WRITE(&stored_format, sizeof(int), 1, file);
+            CHECK_WRITE(&bias_size, sizeof(int), 1, file);
+        }
+    }
+
     // Write header: num_layers, activation_hidden, activation_output
     CHECK_WRITE(&net->num_layers, sizeof(int), 1, file);
     CHECK_WRITE(&net->activation_hidden, sizeof(ActivationType), 1, file);
@@ -316,12 +1122,22 @@ int nn_save(const NeuralNetwork* net, const char* filepath) {
     // Write architecture
     CHECK_WRITE(net->architecture, sizeof(int), net->num_layers, file);
 
-    // Write weights and biases
-    for (int i = 0; i < net->num_layers - 1; i++) {
-        for (int j = 0; j < net->weights[i]->rows; j++) {
-            CHECK_WRITE(net->weights[i]->data[j], sizeof(double), net->weights[i]->cols, file);
-        }
-        CHECK_WRITE(net->biases[i]->data[0], sizeof(double), net->biases[i]->cols, file);
+    // Write weights and biases. Native parameters are already in file order
+    // unless the weights are narrowed and the biases are not.
+    int written = 1;
+    if (net->weights && !is_16) {
+        written = write_elements(file, net->parameters, net->num_parameters, format);
+    }
+    for (int i = 0; (!net->weights || is_16) && written && i < net->num_layers - 1; i++) {
+        size_t weight_count = (size_t)net->architecture[i] * net->architecture[i + 1];
+        written = (net->weights ? write_elements(file, net->weights[i]->values, weight_count, format)
+                                : write_weights_16(file, net, i, format)) &&
+                  write_elements(file, net->biases[i]->values, (size_t)net->biases[i]->cols, bias_format);
+    }
+    if (!written) {
+        gann_set_error(GANN_ERROR_FILE_WRITE);
+        fclose(file);
+        return 0;
     }
 
 #undef CHECK_WRITE
@@ -349,6 +1165,41 @@ NeuralNetwork* nn_load(const char* filepath) {
         return NULL; \
     }
 
+    // A tagged file announces its element format; an untagged one holds doubles
+    NNFileFormat format = NN_FILE_FLOAT64;
+    NNFileFormat bias_format = NN_FILE_FLOAT64;
+    char magic[sizeof(NN_FILE_MAGIC)];
+    if (fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, NN_FILE_MAGIC, sizeof(magic)) == 0) {
+        int version, stored_size, stored_format = -1;
+        CHECK_READ(&version, sizeof(int), 1, file);
+        CHECK_READ(&stored_size, sizeof(int), 1, file);
+        if (version == NN_FILE_VERSION) {
+            if (stored_size == (int)sizeof(float)) stored_format = NN_FILE_FLOAT32;
+            else if (stored_size == (int)sizeof(double)) stored_format = NN_FILE_FLOAT64;
+            bias_format = (NNFileFormat)stored_format;
+        } else if (version == NN_FILE_VERSION_16_WIDE_BIASES) {
+            int bias_size;
+            CHECK_READ(&stored_format, sizeof(int), 1, file);
+            CHECK_READ(&bias_size, sizeof(int), 1, file);
+            if ((stored_format != NN_FILE_FLOAT16 && stored_format != NN_FILE_BFLOAT16) || stored_size != (int)sizeof(uint16_t)) {
+                stored_format = -1;
+            }
+            if (bias_size == (int)sizeof(float)) bias_format = NN_FILE_FLOAT32;
+            else if (bias_size == (int)sizeof(double)) bias_format = NN_FILE_FLOAT64;
+            else stored_format = -1;
+        }
+        if (stored_format < 0) {
+            gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+            fclose(file);
+            return NULL;
+        }
+        format = (NNFileFormat)stored_format;
+    } else {
+        rewind(file);
+    }
+    size_t element_size = file_element_size(format);
+    size_t bias_size = file_element_size(bias_format);
+
     int num_layers;
     ActivationType activation_hidden, activation_output;
 
@@ -356,7 +1207,13 @@ NeuralNetwork* nn_load(const char* filepath) {
     CHECK_READ(&activation_hidden, sizeof(ActivationType), 1, file);
     CHECK_READ(&activation_output, sizeof(ActivationType), 1, file);
 
-    if (num_layers < 2) {
+    // Bound num_layers by what the file could possibly hold before allocating for it
+    long header_end = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, header_end, SEEK_SET);
+    if (num_layers < 2 || header_end < 0 || file_size < header_end ||
+        (size_t)num_layers > (size_t)(file_size - header_end) / sizeof(int)) {
         gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
         fclose(file);
         return NULL;
@@ -368,32 +1225,59 @@ NeuralNetwork* nn_load(const char* filepath) {
         fclose(file);
         return NULL;
     }
-    CHECK_READ(architecture, sizeof(int), num_layers, file);
+    if (fread(architecture, sizeof(int), num_layers, file) != (size_t)num_layers) {
+        gann_set_error(GANN_ERROR_FILE_READ);
+        free(architecture);
+        fclose(file);
+        return NULL;
+    }
+
+    // The remaining bytes must hold exactly the weights and biases of this architecture
+    size_t expected_weights = 0, expected_biases = 0;
+    for (int i = 0; i < num_layers; i++) {
+        if (architecture[i] <= 0) {
+            expected_weights = SIZE_MAX;
+            break;
+        }
+        if (i > 0) {
+            expected_weights += (size_t)architecture[i - 1] * (size_t)architecture[i];
+            expected_biases += (size_t)architecture[i];
+        }
+    }
+    size_t payload_size = (size_t)(file_size - header_end) - (size_t)num_layers * sizeof(int);
+    if (expected_weights == SIZE_MAX || expected_weights > payload_size / element_size ||
+        payload_size - expected_weights * element_size != expected_biases * bias_size) {
+        gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+        free(architecture);
+        fclose(file);
+        return NULL;
+    }
 
-    NeuralNetwork* net = nn_create(num_layers, architecture, activation_hidden, activation_output);
+    // 16-bit weights stay 16-bit: they are read straight into the network
+    NeuralNetwork* net = nn_create_with_storage(num_layers, architecture, activation_hidden, activation_output, file_storage(format));
     free(architecture);
     if (!net) {
-        // nn_create sets the error
+        // nn_create_with_storage sets the error
         fclose(file);
         return NULL;
     }
 
-    // Read weights and biases
-    for (int i = 0; i < net->num_layers - 1; i++) {
-        for (int j = 0; j < net->weights[i]->rows; j++) {
-            if (fread(net->weights[i]->data[j], sizeof(double), net->weights[i]->cols, file) != net->weights[i]->cols) {
-                gann_set_error(GANN_ERROR_FILE_READ);
-                nn_free(net);
-                fclose(file);
-                return NULL;
-            }
-        }
-        if (fread(net->biases[i]->data[0], sizeof(double), net->biases[i]->cols, file) != net->biases[i]->cols) {
-            gann_set_error(GANN_ERROR_FILE_READ);
-            nn_free(net);
-            fclose(file);
-            return NULL;
-        }
+    // Read weights and biases. Native parameters are in file order, so they
+    // are read in one go; 16-bit weights and the biases alternate in the file.
+    int loaded = 1;
+    if (net->weights) {
+        loaded = read_elements(file, net->parameters, net->num_parameters, format);
+    }
+    for (int i = 0; !net->weights && loaded && i < net->num_layers - 1; i++) {
+        size_t weight_count = (size_t)net->architecture[i] * net->architecture[i + 1];
+        loaded = fread(net->weights_16[i], sizeof(uint16_t), weight_count, file) == weight_count &&
+               read_elements(file, net->biases[i]->values, (size_t)net->biases[i]->cols, bias_format);
+    }
+    if (!loaded) {
+        gann_set_error(GANN_ERROR_FILE_READ);
+        nn_free(net);
+        fclose(file);
+        return NULL;
     }
 
 #undef CHECK_READ
@@ -0,0 +1,160 @@
+#ifndef NN_KERNELS_H
+#define NN_KERNELS_H
+
+/**
+ * @file nn_kernels.h
+ * @internal
+ * @brief The unchecked network layer behind the public forward and training entry points.
+ * @details Private to the library. The public functions validate their
+ * arguments and report through the thread-local error code on every call,
+ * which costs little once but adds up over the millions of per-sample calls a
+ * training run or a fitness evaluation makes. The functions here do neither:
+ * they trust their caller to have checked the network, the buffers and the
+ * dataset once, up front (`nn_check_dataset()` covers a whole dataset), and
+ * they leave the error code alone unless an allocation fails.
+ *
+ * Building with `make DEBUG_CHECKS=1` defines `GANN_DEBUG_CHECKS`, which turns
+ * every `GANN_DEBUG_ASSERT` here and in the callers into an `assert`, so that a
+ * caller that skipped its validation is caught at the offending call.
+ */
+
+#include <assert.h>
+#include "neural_network.h"
+#include "data_loader.h"
+#include "simd_kernels.h"
+
+#ifdef GANN_DEBUG_CHECKS
+#define GANN_DEBUG_ASSERT(cond) assert(cond)
+#else
+#define GANN_DEBUG_ASSERT(cond) ((void)0)
+#endif
+
+/** @internal `matrix_view_rows()` without the bounds check. */
+static inline MatrixView matrix_rows_unchecked(const Matrix* m, int first_row, int num_rows) {
+    GANN_DEBUG_ASSERT(first_row >= 0 && num_rows > 0 && num_rows <= m->rows - first_row);
+    MatrixView v = { m->values + (size_t)first_row * m->stride, num_rows, m->cols, m->stride };
+    return v;
+}
+
+/** @internal `matrix_view_row()` without the bounds check. */
+static inline MatrixView matrix_row_unchecked(const Matrix* m, int row) {
+    return matrix_rows_unchecked(m, row, 1);
+}
+
+/**
+ * @internal
+ * @brief A matrix header for rows `[first_row, first_row + num_rows)` of `m`
+ * that shares its elements.
+ * @details Only `rows`, `cols`, `values` and `stride` are set, which is all the
+ * unchecked functions read; `data` is NULL, so the header must never reach the
+ * public API.
+ */
+static inline Matrix matrix_window_unchecked(Matrix* m, int first_row, int num_rows) {
+    GANN_DEBUG_ASSERT(first_row >= 0 && num_rows > 0 && num_rows <= m->rows - first_row);
+    Matrix w = { num_rows, m->cols, NULL, m->values + (size_t)first_row * m->stride, m->stride };
+    return w;
+}
+
+/**
+ * @internal
+ * @brief A network's parameters as the genetic operators walk them.
+ * @details With native storage `real` is every weight and bias, in the order of
+ * `nn_get_parameters()`, and `half` is empty. With 16-bit storage `real` holds
+ * the biases and `half` the weights of every layer, in the network's format.
+ * Two networks of the same architecture and storage have the same genome layout.
+ */
+typedef struct {
+    gann_real* real;
+    size_t num_real;
+    uint16_t* half;
+    size_t num_half;
+} NNGenome;
+
+/** @internal The genome of `net`; it aliases the network's parameter block. */
+static inline NNGenome nn_genome(const NeuralNetwork* net) {
+    NNGenome genome = { net->parameters, net->num_parameters, NULL, 0 };
+    if (net->weights_16) {
+        genome.half = net->weights_16[0];
+        for (int i = 0; i < net->num_layers - 1; i++) {
+            genome.num_half += (size_t)net->architecture[i] * net->architecture[i + 1];
+        }
+    }
+    return genome;
+}
+
+/**
+ * @internal
+ * @brief The state behind `GannInferenceContext`.
+ */
+struct GannInferenceContext {
+    const NeuralNetwork* net; /**< The network the context runs. */
+    const SimdKernels* kern;  /**< The kernels active at creation; calls never read the global selection. */
+    int fast_sigmoid;         /**< The sigmoid mode at creation (`g_simd_fast_sigmoid`), used by every call. */
+    Matrix* buffers[2];       /**< Single-row buffers as wide as the widest layer; layer `l` writes `buffers[l % 2]`. */
+    int* nonzero_columns;     /**< Room for the nonzero columns of one input row. */
+};
+
+/**
+ * @internal
+ * @brief Checks that every row of `dataset` fits `net`.
+ * @details The images must have as many columns as the network has inputs and
+ * the labels as many as it has outputs, and both must hold `num_items` rows.
+ * @return 1 if they do; otherwise 0 with `GANN_ERROR_NULL_ARGUMENT` or
+ * `GANN_ERROR_INVALID_DIMENSIONS` set.
+ */
+int nn_check_dataset(const NeuralNetwork* net, const Dataset* dataset);
+
+/**
+ * @internal
+ * @brief `nn_layer_forward_into()` without the argument checks.
+ * @details `input` must be `rows x architecture[layer]`, `output` (and `z`, if
+ * not NULL) `rows x architecture[layer + 1]`, and none of them may overlap.
+ * @return 1, or 0 with `GANN_ERROR_ALLOC_FAILED` set if the 16-bit weight path
+ * could not get its packing buffer.
+ */
+int nn_layer_forward_unchecked(const NeuralNetwork* net, int layer, MatrixView input, Matrix* output, Matrix* z);
+
+/**
+ * @internal
+ * @brief `nn_layer_forward_sparse_into()` without the argument checks.
+ * @details Same shapes as `nn_layer_forward_unchecked()` for layer 0 with one
+ * input row; every entry of `nonzero_columns` must be a valid input column.
+ * @return As `nn_layer_forward_unchecked()`.
+ */
+int nn_layer_forward_sparse_unchecked(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                                      Matrix* output, Matrix* z);
+
+/**
+ * @internal
+ * @brief Runs every layer on `input`, through the sparse first layer when
+ * `nonzero_columns` is not NULL.
+ * @details `layer_outputs` must be shaped as by `nn_create_layer_buffers()`
+ * for `input.rows` rows, and `nonzero_columns` may only be given for one row.
+ * @return As `nn_layer_forward_unchecked()`.
+ */
+int nn_forward_unchecked(const NeuralNetwork* net, MatrixView input, const int* nonzero_columns, int num_nonzero,
+                         Matrix** layer_outputs);
+
+/**
+ * @internal
+ * @brief `nn_forward_pass_batch()` without the argument checks.
+ * @details When `skip_zeros` is nonzero, the nonzero columns of each batch of
+ * rows are listed in the scratch arena first. A batch with at most
+ * `NN_SPARSE_MAX_DENSITY` nonzeros runs its first layer one row at a time
+ * through the sparse kernel and the other layers batched; denser batches run
+ * as if `skip_zeros` were 0.
+ * @return As `nn_layer_forward_unchecked()`, or 0 if the scratch arena could
+ * not supply the buffers (the error is set).
+ */
+int nn_forward_batch_unchecked(const NeuralNetwork* net, MatrixView inputs, int skip_zeros, Matrix* outputs);
+
+/**
+ * @internal
+ * @brief Lists the columns of the nonzero entries of `row`, in increasing order.
+ * @details One compare per entry and no branches; `columns` needs room for
+ * `row.cols` entries.
+ * @return The number of nonzero entries.
+ */
+int nn_list_nonzeros(MatrixView row, int* columns);
+
+#endif // NN_KERNELS_H
@@ -0,0 +1,261 @@
+#include "gann_plan.h"
+#include "gann_arena.h"
+#include "gann_errors.h"
+#include "simd_kernels.h"
+#include "gemm.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// --- Layout ---
+// All weights and biases of a plan live in one aligned block, each array
+// starting on a MATRIX_ALIGNMENT boundary. Every layer keeps its weights
+// row-major for the row kernel; a layer nn_compile chose the packed kernel for
+// also keeps them packed for gemm_nn_prepacked, which it uses for every pass
+// that fills a register tile. Partial tiles cost as much as whole ones, so a
+// shorter pass is faster on the row kernel. The workspace of a run holds two
+// activation buffers as large as the widest hidden layer times the batch size,
+// then the buffer gemm_nn_prepacked packs the rows of A into.
+
+typedef enum {
+    PLAN_KERNEL_PACKED, // Micro-kernels on weights packed by gemm_pack_b
+    PLAN_KERNEL_ROWS    // The row kernel on row-major weights
+} PlanKernel;
+
+static const char* const PLAN_KERNEL_NAMES[] = { "packed", "rows" };
+
+typedef struct {
+    int inputs;
+    int outputs;
+    PlanKernel kernel;
+    const gann_real* weights; // Row-major
+    const gann_real* packed;  // Packed by gemm_pack_b, or NULL for the row kernel
+    GemmEpilogue ep;          // The layer's biases, activation and sigmoid mode
+} PlanLayer;
+
+struct GannPlan {
+    int num_layers;
+    int* architecture;
+    int max_batch_size;
+    const SimdKernels* kern;  // The kernels the weights were packed for
+    PlanLayer* layers;        // num_layers - 1
+    gann_real* parameters;    // Every layer's weights and biases
+    size_t buffer_elements;   // Elements of each activation buffer, rounded to the alignment
+    size_t workspace_size;    // Bytes a run needs, including room to align the workspace
+};
+
+#define PLAN_ALIGN_ELEMENTS (MATRIX_ALIGNMENT / sizeof(gann_real))
+
+static size_t align_elements(size_t count) {
+    return (count + PLAN_ALIGN_ELEMENTS - 1) / PLAN_ALIGN_ELEMENTS * PLAN_ALIGN_ELEMENTS;
+}
+
+static gann_real* parameter_block_alloc(size_t size) {
+#if defined(_WIN32)
+    return (gann_real*)_aligned_malloc(size, MATRIX_ALIGNMENT);
+#else
+    void* block = NULL;
+    if (posix_memalign(&block, MATRIX_ALIGNMENT, size) != 0) return NULL;
+    return (gann_real*)block;
+#endif
+}
+
+static void parameter_block_free(gann_real* block) {
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+// The packed path pays for itself once a pass fills a register tile; below
+// that, and for layers with fewer inputs than a tile has rows, the row kernel
+// streams the weights directly.
+static PlanKernel choose_kernel(const SimdKernels* kern, int max_batch_size, int inputs) {
+    return max_batch_size >= kern->gemm_mr && inputs >= kern->gemm_mr ? PLAN_KERNEL_PACKED : PLAN_KERNEL_ROWS;
+}
+
+static size_t packed_elements(const GannPlan* plan, const PlanLayer* layer) {
+    if (layer->kernel != PLAN_KERNEL_PACKED) return 0;
+    return align_elements(gemm_packed_b_size(plan->kern, layer->outputs, layer->inputs));
+}
+
+GannPlan* nn_compile(const NeuralNetwork* net, const GannPlanOptions* options) {
+    if (net == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    int max_batch_size = options ? options->max_batch_size : 0;
+    if (max_batch_size < 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    if (max_batch_size == 0) max_batch_size = NN_DEFAULT_FORWARD_BATCH_SIZE;
+
+    GannPlan* plan = (GannPlan*)calloc(1, sizeof(GannPlan));
+    if (!plan) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    int num_weight_sets = net->num_layers - 1;
+    plan->num_layers = net->num_layers;
+    plan->max_batch_size = max_batch_size;
+    plan->kern = simd_kernels();
+    plan->architecture = (int*)malloc(net->num_layers * sizeof(int));
+    plan->layers = (PlanLayer*)calloc(num_weight_sets, sizeof(PlanLayer));
+    if (!plan->architecture || !plan->layers) {
+        gann_plan_free(plan);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    memcpy(plan->architecture, net->architecture, net->num_layers * sizeof(int));
+
+    // Choose each layer's kernel and size everything before filling anything in
+    size_t parameter_elements = 0, pack_elements = 0;
+    int widest_hidden = 0;
+    for (int l = 0; l < num_weight_sets; l++) {
+        PlanLayer* layer = &plan->layers[l];
+        layer->inputs = net->architecture[l];
+        layer->outputs = net->architecture[l + 1];
+        layer->kernel = choose_kernel(plan->kern, max_batch_size, layer->inputs);
+        size_t weight_count = (size_t)layer->inputs * layer->outputs;
+        parameter_elements += align_elements(weight_count) + packed_elements(plan, layer) + align_elements(layer->outputs);
+        if (layer->kernel == PLAN_KERNEL_PACKED) {
+            size_t pack = gemm_packed_a_size(plan->kern, max_batch_size, layer->inputs);
+            if (pack > pack_elements) pack_elements = pack;
+        }
+        if (l < num_weight_sets - 1 && layer->outputs > widest_hidden) widest_hidden = layer->outputs;
+    }
+    plan->buffer_elements = align_elements((size_t)max_batch_size * widest_hidden);
+    plan->workspace_size = (2 * plan->buffer_elements + pack_elements) * sizeof(gann_real) + MATRIX_ALIGNMENT;
+
+    plan->parameters = parameter_block_alloc(parameter_elements * sizeof(gann_real));
+    if (!plan->parameters) {
+        gann_plan_free(plan);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+
+    gann_real* next = plan->parameters;
+    for (int l = 0; l < num_weight_sets; l++) {
+        PlanLayer* layer = &plan->layers[l];
+        size_t weight_count = (size_t)layer->inputs * layer->outputs;
+        // 16-bit weights are widened once, here
+        gann_real* weights = next;
+        if (net->weights) memcpy(weights, net->weights[l]->values, weight_count * sizeof(gann_real));
+        else plan->kern->widen_16(weight_count, net->weights_16[l], weights, net->weight_storage);
+        layer->weights = weights;
+        next += align_elements(weight_count);
+
+        if (layer->kernel == PLAN_KERNEL_PACKED) {
+            gemm_pack_b(plan->kern, layer->outputs, layer->inputs, weights, layer->outputs, next);
+            layer->packed = next;
+            next += packed_elements(plan, layer);
+        }
+
+        memcpy(next, net->biases[l]->values, layer->outputs * sizeof(gann_real));
+        layer->ep.bias = next;
+        layer->ep.z = NULL;
+        layer->ep.ldz = 0;
+        layer->ep.activation = l == num_weight_sets - 1 ? net->activation_output : net->activation_hidden;
+        layer->ep.fast_sigmoid = g_simd_fast_sigmoid;
+        next += align_elements(layer->outputs);
+    }
+
+    gann_set_error(GANN_SUCCESS);
+    return plan;
+}
+
+void gann_plan_free(GannPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->architecture);
+    free(plan->layers);
+    parameter_block_free(plan->parameters);
+    free(plan);
+}
+
+size_t gann_plan_workspace_size(const GannPlan* plan) {
+    return plan ? plan->workspace_size : 0;
+}
+
+const char* gann_plan_layer_kernel(const GannPlan* plan, int layer) {
+    if (plan == NULL || layer < 0 || layer >= plan->num_layers - 1) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    return PLAN_KERNEL_NAMES[plan->layers[layer].kernel];
+}
+
+// Runs rows [first_row, first_row + rows) of `inputs` through every layer. The
+// hidden layers write to the two activation buffers in turn, the last one
+// straight into the caller's outputs.
+static void run_pass(const GannPlan* plan, MatrixView inputs, int first_row, int rows, Matrix* outputs,
+                     gann_real* buffers[2], gann_real* packed_a) {
+    const gann_real* a = inputs.values + (size_t)first_row * inputs.stride;
+    int lda = inputs.stride;
+    for (int l = 0; l < plan->num_layers - 1; l++) {
+        const PlanLayer* layer = &plan->layers[l];
+        int last = l == plan->num_layers - 2;
+        gann_real* c = last ? outputs->values + (size_t)first_row * outputs->stride : buffers[l % 2];
+        int ldc = last ? outputs->stride : layer->outputs;
+        if (layer->packed && rows >= plan->kern->gemm_mr) {
+            gemm_nn_prepacked(plan->kern, rows, layer->outputs, layer->inputs, a, lda, layer->packed, c, ldc, &layer->ep, packed_a);
+        } else {
+            plan->kern->gemm_rows(rows, layer->outputs, layer->inputs, a, lda, 1, layer->weights, layer->outputs, 0.0, c, ldc,
+                                  &layer->ep);
+            gemm_softmax_rows(plan->kern, rows, layer->outputs, c, ldc, &layer->ep);
+        }
+        a = c;
+        lda = ldc;
+    }
+}
+
+// Returns 1 if the elements of `v` and `m` share any memory.
+static int storage_overlaps(MatrixView v, const Matrix* m) {
+    const gann_real* v_end = v.values + (size_t)(v.rows - 1) * v.stride + v.cols;
+    const gann_real* m_end = m->values + (size_t)(m->rows - 1) * m->stride + m->cols;
+    return v.values < m_end && m->values < v_end;
+}
+
+int gann_plan_run(const GannPlan* plan, MatrixView inputs, Matrix* outputs, void* workspace) {
+    if (plan == NULL || inputs.values == NULL || outputs == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    if (inputs.rows <= 0 || inputs.cols != plan->architecture[0] || outputs->rows != inputs.rows ||
+        outputs->cols != plan->architecture[plan->num_layers - 1]) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0;
+    }
+    if (storage_overlaps(inputs, outputs)) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0;
+    }
+
+    GannArena* arena = NULL;
+    size_t mark = 0;
+    if (workspace == NULL) {
+        arena = gann_scratch_arena();
+        if (!arena) return 0; // gann_scratch_arena sets the error
+        mark = gann_arena_mark(arena);
+        workspace = gann_arena_alloc(arena, plan->workspace_size);
+        if (!workspace) return 0; // gann_arena_alloc sets the error
+    }
+    uintptr_t aligned = ((uintptr_t)workspace + MATRIX_ALIGNMENT - 1) & ~(uintptr_t)(MATRIX_ALIGNMENT - 1);
+    gann_real* buffers[2] = { (gann_real*)aligned, (gann_real*)aligned + plan->buffer_elements };
+    gann_real* packed_a = buffers[1] + plan->buffer_elements;
+
+    for (int first = 0; first < inputs.rows; first += plan->max_batch_size) {
+        int rows = inputs.rows - first < plan->max_batch_size ? inputs.rows - first : plan->max_batch_size;
+        run_pass(plan, inputs, first, rows, outputs, buffers, packed_a);
+    }
+
+    if (arena) gann_arena_reset_to(arena, mark);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
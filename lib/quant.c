@@ -0,0 +1,657 @@
+#include "gann_quant.h"
+#include "gann_arena.h"
+#include "gann_errors.h"
+#include "simd_kernels.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define QUANT_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Layout ---
+// Each layer stores its weights transposed, one row of `stride` int8 values per
+// output neuron, so an output is one contiguous dot product with the quantized
+// input. Rows are padded with zero weights to a multiple of QUANT_K_ALIGN inputs
+// (every kernel then runs whole vectors) and to a multiple of QUANT_CHANNELS
+// rows (the kernels compute that many outputs per pass over the input).
+
+#define QUANT_K_ALIGN 64
+#define QUANT_CHANNELS 4
+#define QUANT_WEIGHT_MAX 127
+#define QUANT_CALIBRATION_BATCH 32
+// Keeps 255 * 127 * inputs within int32.
+#define QUANT_MAX_INPUTS 65536
+
+typedef struct {
+    int inputs;
+    int outputs;
+    int stride;              // inputs rounded up to QUANT_K_ALIGN
+    float input_scale;       // x ≈ input_scale * (q - input_zero_point)
+    int input_zero_point;
+    gann_real input_inverse; // 1 / input_scale
+    int8_t* weights;         // round_up(outputs, QUANT_CHANNELS) x stride
+    float* weight_scales;    // w ≈ weight_scales[j] * q, per output neuron
+    int32_t* weight_sums;    // sum of row j of weights, for the zero-point correction
+    gann_real* scales;       // input_scale * weight_scales[j]
+    gann_real* biases;
+} QuantLayer;
+
+struct QuantizedNetwork {
+    int num_layers;
+    int* architecture;
+    ActivationType activation_hidden;
+    ActivationType activation_output;
+    QuantLayer* layers;      // num_layers - 1
+    int max_stride;          // largest layer stride, for the scratch buffers
+    int max_outputs;         // largest padded output count
+};
+
+static int round_up(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// --- Integer Dot Products ---
+// out[c] = sum over i < k of a[i] * w[c * stride + i] for c < QUANT_CHANNELS,
+// with `a` unsigned and `w` signed 8-bit; `k` is a multiple of QUANT_K_ALIGN.
+// Every kernel returns the exact integer sums.
+
+typedef void (*QuantDotFn)(int k, const uint8_t* a, const int8_t* w, int stride, int32_t* out);
+
+static void quant_dot_scalar(int k, const uint8_t* a, const int8_t* w, int stride, int32_t* out) {
+    for (int c = 0; c < QUANT_CHANNELS; c++) {
+        const int8_t* row = w + (size_t)c * stride;
+        int32_t sum = 0;
+        for (int i = 0; i < k; i++) sum += (int32_t)a[i] * row[i];
+        out[c] = sum;
+    }
+}
+
+#if defined(QUANT_HAVE_X86)
+
+__attribute__((target("avx2")))
+static int32_t hsum_avx2(__m256i v) {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+// Widens both operands to 16 bits; vpmaddwd then sums pairs of products into
+// 32-bit lanes. (vpmaddubsw would saturate: 2 * 255 * 127 exceeds int16.)
+__attribute__((target("avx2")))
+static void quant_dot_avx2(int k, const uint8_t* a, const int8_t* w, int stride, int32_t* out) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+    for (int i = 0; i < k; i += 16) {
+        __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(a + i)));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(x, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(w + i)))));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(x, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(w + stride + i)))));
+        acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(x, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(w + 2 * (size_t)stride + i)))));
+        acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(x, _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(w + 3 * (size_t)stride + i)))));
+    }
+    out[0] = hsum_avx2(acc0);
+    out[1] = hsum_avx2(acc1);
+    out[2] = hsum_avx2(acc2);
+    out[3] = hsum_avx2(acc3);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void quant_dot_avx512bw(int k, const uint8_t* a, const int8_t* w, int stride, int32_t* out) {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512(), acc3 = _mm512_setzero_si512();
+    for (int i = 0; i < k; i += 32) {
+        __m512i x = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*)(a + i)));
+        acc0 = _mm512_add_epi32(acc0, _mm512_madd_epi16(x, _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(w + i)))));
+        acc1 = _mm512_add_epi32(acc1, _mm512_madd_epi16(x, _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(w + stride + i)))));
+        acc2 = _mm512_add_epi32(acc2, _mm512_madd_epi16(x, _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(w + 2 * (size_t)stride + i)))));
+        acc3 = _mm512_add_epi32(acc3, _mm512_madd_epi16(x, _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(w + 3 * (size_t)stride + i)))));
+    }
+    out[0] = _mm512_reduce_add_epi32(acc0);
+    out[1] = _mm512_reduce_add_epi32(acc1);
+    out[2] = _mm512_reduce_add_epi32(acc2);
+    out[3] = _mm512_reduce_add_epi32(acc3);
+}
+
+// vpdpbusd multiplies 64 unsigned by 64 signed bytes and adds each group of
+// four products to a 32-bit lane in one instruction, without saturation.
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static void quant_dot_avx512vnni(int k, const uint8_t* a, const int8_t* w, int stride, int32_t* out) {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = _mm512_setzero_si512();
+    __m512i acc2 = _mm512_setzero_si512(), acc3 = _mm512_setzero_si512();
+    for (int i = 0; i < k; i += 64) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        acc0 = _mm512_dpbusd_epi32(acc0, x, _mm512_loadu_si512(w + i));
+        acc1 = _mm512_dpbusd_epi32(acc1, x, _mm512_loadu_si512(w + stride + i));
+        acc2 = _mm512_dpbusd_epi32(acc2, x, _mm512_loadu_si512(w + 2 * (size_t)stride + i));
+        acc3 = _mm512_dpbusd_epi32(acc3, x, _mm512_loadu_si512(w + 3 * (size_t)stride + i));
+    }
+    out[0] = _mm512_reduce_add_epi32(acc0);
+    out[1] = _mm512_reduce_add_epi32(acc1);
+    out[2] = _mm512_reduce_add_epi32(acc2);
+    out[3] = _mm512_reduce_add_epi32(acc3);
+}
+
+#endif // QUANT_HAVE_X86
+
+// Picks the best kernel the CPU supports, capped by the active SIMD level.
+static QuantDotFn select_dot(const char** name) {
+    const char* unused;
+    if (name == NULL) name = &unused;
+#if defined(QUANT_HAVE_X86)
+    GannSimdLevel level = simd_kernels()->level;
+    if (level >= GANN_SIMD_AVX512 && __builtin_cpu_supports("avx512bw")) {
+        if (__builtin_cpu_supports("avx512vnni")) {
+            *name = "avx512vnni";
+            return quant_dot_avx512vnni;
+        }
+        *name = "avx512bw";
+        return quant_dot_avx512bw;
+    }
+    if (level >= GANN_SIMD_AVX2) {
+        *name = "avx2";
+        return quant_dot_avx2;
+    }
+#endif
+    *name = "scalar";
+    return quant_dot_scalar;
+}
+
+// --- Construction ---
+
+static void quant_layer_release(QuantLayer* layer) {
+    free(layer->weights);
+    free(layer->weight_scales);
+    free(layer->weight_sums);
+    free(layer->scales);
+    free(layer->biases);
+}
+
+void qnn_free(QuantizedNetwork* qnet) {
+    if (qnet == NULL) return;
+    if (qnet->layers) {
+        for (int l = 0; l < qnet->num_layers - 1; l++) quant_layer_release(&qnet->layers[l]);
+        free(qnet->layers);
+    }
+    free(qnet->architecture);
+    free(qnet);
+}
+
+// Allocates a network with zeroed layers of the given shape. Sets the error on failure.
+static QuantizedNetwork* qnn_alloc(int num_layers, const int* architecture, ActivationType hidden, ActivationType output) {
+    QuantizedNetwork* qnet = (QuantizedNetwork*)calloc(1, sizeof(QuantizedNetwork));
+    if (!qnet) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    qnet->num_layers = num_layers;
+    qnet->activation_hidden = hidden;
+    qnet->activation_output = output;
+    qnet->architecture = (int*)malloc((size_t)num_layers * sizeof(int));
+    qnet->layers = (QuantLayer*)calloc((size_t)num_layers - 1, sizeof(QuantLayer));
+    if (!qnet->architecture || !qnet->layers) {
+        qnn_free(qnet);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    memcpy(qnet->architecture, architecture, (size_t)num_layers * sizeof(int));
+    for (int l = 0; l < num_layers - 1; l++) {
+        QuantLayer* layer = &qnet->layers[l];
+        layer->inputs = architecture[l];
+        layer->outputs = architecture[l + 1];
+        layer->stride = round_up(layer->inputs, QUANT_K_ALIGN);
+        int rows = round_up(layer->outputs, QUANT_CHANNELS);
+        layer->weights = (int8_t*)calloc((size_t)rows * layer->stride, sizeof(int8_t));
+        layer->weight_scales = (float*)calloc((size_t)layer->outputs, sizeof(float));
+        layer->weight_sums = (int32_t*)calloc((size_t)layer->outputs, sizeof(int32_t));
+        layer->scales = (gann_real*)calloc((size_t)layer->outputs, sizeof(gann_real));
+        layer->biases = (gann_real*)calloc((size_t)layer->outputs, sizeof(gann_real));
+        if (!layer->weights || !layer->weight_scales || !layer->weight_sums || !layer->scales || !layer->biases) {
+            qnn_free(qnet);
+            gann_set_error(GANN_ERROR_ALLOC_FAILED);
+            return NULL;
+        }
+        if (layer->stride > qnet->max_stride) qnet->max_stride = layer->stride;
+        if (rows > qnet->max_outputs) qnet->max_outputs = rows;
+    }
+    return qnet;
+}
+
+// Derives the per-neuron constants from the stored weights, scales and zero point.
+static void quant_layer_finish(QuantLayer* layer) {
+    layer->input_inverse = (gann_real)(1.0 / layer->input_scale);
+    for (int j = 0; j < layer->outputs; j++) {
+        const int8_t* row = layer->weights + (size_t)j * layer->stride;
+        int32_t sum = 0;
+        for (int i = 0; i < layer->inputs; i++) sum += row[i];
+        layer->weight_sums[j] = sum;
+        layer->scales[j] = (gann_real)layer->input_scale * (gann_real)layer->weight_scales[j];
+    }
+}
+
+// Maps the observed range [lo, hi] (which always contains 0) onto 0..255.
+static void choose_input_quantization(QuantLayer* layer, double lo, double hi) {
+    double scale = (hi - lo) / 255.0;
+    if (!(scale > 0)) scale = 1.0;
+    int zero_point = (int)lround(-lo / scale);
+    layer->input_scale = (float)scale;
+    layer->input_zero_point = zero_point < 0 ? 0 : (zero_point > 255 ? 255 : zero_point);
+}
+
+// Symmetric per-neuron quantization of column j of W. Biases are rounded to
+// float, as the file stores them, so a saved network reloads identically.
+static void quantize_weights(QuantLayer* layer, const NeuralNetwork* net, int l) {
+    const Matrix* biases = net->biases[l];
+    for (int j = 0; j < layer->outputs; j++) {
+        double max_abs = 0.0;
+        for (int i = 0; i < layer->inputs; i++) {
+            double v = fabs((double)nn_get_weight(net, l, i, j));
+            if (v > max_abs) max_abs = v;
+        }
+        float scale = (max_abs > 0) ? (float)(max_abs / QUANT_WEIGHT_MAX) : 1.0f;
+        int8_t* row = layer->weights + (size_t)j * layer->stride;
+        for (int i = 0; i < layer->inputs; i++) {
+            long q = lround((double)nn_get_weight(net, l, i, j) / scale);
+            row[i] = (int8_t)(q > QUANT_WEIGHT_MAX ? QUANT_WEIGHT_MAX : (q < -QUANT_WEIGHT_MAX ? -QUANT_WEIGHT_MAX : q));
+        }
+        layer->weight_scales[j] = scale;
+        layer->biases[j] = (gann_real)(float)biases->data[0][j];
+    }
+}
+
+static void update_range(MatrixView values, double* lo, double* hi) {
+    for (int i = 0; i < values.rows; i++) {
+        const gann_real* row = values.values + (size_t)i * values.stride;
+        for (int j = 0; j < values.cols; j++) {
+            if (row[j] < *lo) *lo = row[j];
+            if (row[j] > *hi) *hi = row[j];
+        }
+    }
+}
+
+QuantizedNetwork* qnn_quantize(const NeuralNetwork* net, const Dataset* calibration, int max_samples) {
+    if (net == NULL || calibration == NULL || calibration->images == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (max_samples < 0 || calibration->num_items <= 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return NULL;
+    }
+    if (calibration->images->cols != net->architecture[0] || calibration->images->rows < calibration->num_items) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return NULL;
+    }
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        if (net->architecture[l] > QUANT_MAX_INPUTS) {
+            gann_set_error(GANN_ERROR_INVALID_ARCHITECTURE);
+            return NULL;
+        }
+    }
+    int samples = (max_samples == 0 || max_samples > calibration->num_items) ? calibration->num_items : max_samples;
+
+    // Observed input range of every layer; 0 is always representable.
+    int num_weights = net->num_layers - 1;
+    double* lo = (double*)calloc((size_t)num_weights, sizeof(double));
+    double* hi = (double*)calloc((size_t)num_weights, sizeof(double));
+    GannArena* arena = gann_scratch_arena();
+    if (!lo || !hi || !arena) {
+        free(lo);
+        free(hi);
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        return NULL;
+    }
+    size_t mark = gann_arena_mark(arena);
+    int ok = 1;
+    for (int first = 0; ok && first < samples; first += QUANT_CALIBRATION_BATCH) {
+        int rows = (samples - first < QUANT_CALIBRATION_BATCH) ? samples - first : QUANT_CALIBRATION_BATCH;
+        size_t batch_mark = gann_arena_mark(arena);
+        Matrix** outputs = nn_create_layer_buffers_arena(net, rows, arena);
+        MatrixView input = matrix_view_rows(calibration->images, first, rows);
+        ok = outputs && nn_forward_pass_view_into(net, input, outputs);
+        if (ok) {
+            update_range(input, &lo[0], &hi[0]);
+            for (int l = 1; l < num_weights; l++) update_range(matrix_view(outputs[l - 1]), &lo[l], &hi[l]);
+        }
+        gann_arena_reset_to(arena, batch_mark);
+    }
+    gann_arena_reset_to(arena, mark);
+    if (!ok) {
+        free(lo);
+        free(hi);
+        return NULL; // the failing call set the error
+    }
+
+    QuantizedNetwork* qnet = qnn_alloc(net->num_layers, net->architecture, net->activation_hidden, net->activation_output);
+    if (qnet) {
+        for (int l = 0; l < num_weights; l++) {
+            choose_input_quantization(&qnet->layers[l], lo[l], hi[l]);
+            quantize_weights(&qnet->layers[l], net, l);
+            quant_layer_finish(&qnet->layers[l]);
+        }
+        gann_set_error(GANN_SUCCESS);
+    }
+    free(lo);
+    free(hi);
+    return qnet;
+}
+
+const int* qnn_get_architecture(const QuantizedNetwork* qnet, int* num_layers) {
+    if (qnet == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    if (num_layers) *num_layers = qnet->num_layers;
+    return qnet->architecture;
+}
+
+// --- Inference ---
+
+static void quantize_input(int n, const gann_real* x, const QuantLayer* layer, uint8_t* q) {
+    const gann_real inverse = layer->input_inverse;
+    const gann_real zero_point = (gann_real)layer->input_zero_point;
+    for (int i = 0; i < n; i++) {
+        gann_real v = x[i] * inverse + zero_point;
+        v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        q[i] = (uint8_t)(v + (gann_real)0.5);
+    }
+}
+
+// z[j] = scale_j * (sum_i q[i] * w[j][i] - zero_point * sum_i w[j][i]) + b[j]
+static void quant_layer_forward(const QuantLayer* layer, QuantDotFn dot, const uint8_t* q, gann_real* z) {
+    int32_t acc[QUANT_CHANNELS];
+    for (int j = 0; j < layer->outputs; j += QUANT_CHANNELS) {
+        dot(layer->stride, q, layer->weights + (size_t)j * layer->stride, layer->stride, acc);
+        int count = (layer->outputs - j < QUANT_CHANNELS) ? layer->outputs - j : QUANT_CHANNELS;
+        for (int c = 0; c < count; c++) {
+            int32_t sum = acc[c] - layer->input_zero_point * layer->weight_sums[j + c];
+            z[j + c] = (gann_real)sum * layer->scales[j + c] + layer->biases[j + c];
+        }
+    }
+}
+
+// Runs the network into `output`, with temporaries from `arena`. Sets the error on failure.
+static int quant_forward(const QuantizedNetwork* qnet, QuantDotFn dot, const gann_real* input, gann_real* output, GannArena* arena) {
+    size_t mark = gann_arena_mark(arena);
+    uint8_t* q = (uint8_t*)gann_arena_alloc(arena, (size_t)qnet->max_stride);
+    gann_real* z = (gann_real*)gann_arena_alloc(arena, (size_t)qnet->max_outputs * sizeof(gann_real));
+    if (!q || !z) {
+        gann_arena_reset_to(arena, mark);
+        return 0; // gann_arena_alloc sets the error
+    }
+    // The padding only ever meets zero weights, but is cleared so it is never read uninitialized.
+    memset(q, 0, (size_t)qnet->max_stride);
+    const SimdKernels* kern = simd_kernels();
+    int last = qnet->num_layers - 2;
+    quantize_input(qnet->layers[0].inputs, input, &qnet->layers[0], q);
+    for (int l = 0; l <= last; l++) {
+        const QuantLayer* layer = &qnet->layers[l];
+        quant_layer_forward(layer, dot, q, z);
+        kern->activation((size_t)layer->outputs, z, l < last ? qnet->activation_hidden : qnet->activation_output);
+        if (l < last) quantize_input(layer->outputs, z, &qnet->layers[l + 1], q);
+    }
+    memcpy(output, z, (size_t)qnet->layers[last].outputs * sizeof(gann_real));
+    gann_arena_reset_to(arena, mark);
+    return 1;
+}
+
+static int argmax(const gann_real* values, int n) {
+    int best = 0;
+    for (int i = 1; i < n; i++) {
+        if (values[i] > values[best]) best = i;
+    }
+    return best;
+}
+
+int qnn_forward(const QuantizedNetwork* qnet, const gann_real* input, gann_real* output) {
+    if (qnet == NULL || input == NULL || output == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return 0; // gann_scratch_arena sets the error
+    if (!quant_forward(qnet, select_dot(NULL), input, output, arena)) return 0;
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+int qnn_predict(const QuantizedNetwork* qnet, const gann_real* input) {
+    if (qnet == NULL || input == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return -1;
+    }
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return -1; // gann_scratch_arena sets the error
+    size_t mark = gann_arena_mark(arena);
+    int num_outputs = qnet->architecture[qnet->num_layers - 1];
+    gann_real* output = (gann_real*)gann_arena_alloc(arena, (size_t)num_outputs * sizeof(gann_real));
+    int prediction = -1;
+    if (output && quant_forward(qnet, select_dot(NULL), input, output, arena)) {
+        prediction = argmax(output, num_outputs);
+    }
+    gann_arena_reset_to(arena, mark);
+    if (prediction < 0) return -1; // the failing call set the error
+    gann_set_error(GANN_SUCCESS);
+    return prediction;
+}
+
+double qnn_evaluate(const QuantizedNetwork* qnet, const Dataset* dataset) {
+    if (qnet == NULL || dataset == NULL || dataset->images == NULL || dataset->labels == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0.0;
+    }
+    int num_outputs = qnet->architecture[qnet->num_layers - 1];
+    if (dataset->images->cols != qnet->architecture[0] || dataset->labels->cols != num_outputs ||
+        dataset->images->rows < dataset->num_items || dataset->labels->rows < dataset->num_items) {
+        gann_set_error(GANN_ERROR_INVALID_DIMENSIONS);
+        return 0.0;
+    }
+    if (dataset->num_items <= 0) {
+        gann_set_error(GANN_ERROR_INVALID_PARAM);
+        return 0.0;
+    }
+    GannArena* arena = gann_scratch_arena();
+    if (!arena) return 0.0; // gann_scratch_arena sets the error
+    size_t mark = gann_arena_mark(arena);
+    gann_real* output = (gann_real*)gann_arena_alloc(arena, (size_t)num_outputs * sizeof(gann_real));
+    if (!output) return 0.0; // gann_arena_alloc sets the error
+    QuantDotFn dot = select_dot(NULL);
+    int correct = 0;
+    for (int i = 0; i < dataset->num_items; i++) {
+        if (!quant_forward(qnet, dot, dataset->images->data[i], output, arena)) {
+            gann_arena_reset_to(arena, mark);
+            return 0.0; // quant_forward sets the error
+        }
+        correct += argmax(output, num_outputs) == argmax(dataset->labels->data[i], num_outputs);
+    }
+    gann_arena_reset_to(arena, mark);
+    gann_set_error(GANN_SUCCESS);
+    return (double)correct / dataset->num_items;
+}
+
+const char* qnn_kernel_name(void) {
+    const char* name;
+    select_dot(&name);
+    return name;
+}
+
+// --- Persistence ---
+// Layout: the magic "GNQ8", a format version, num_layers, the two activation
+// types and the architecture, then per layer: the input scale (float) and zero
+// point (int), the per-neuron weight scales and biases (float), and the int8
+// weights, one row of `inputs` values per output neuron.
+
+static const char QNN_FILE_MAGIC[4] = { 'G', 'N', 'Q', '8' };
+#define QNN_FILE_VERSION 1
+
+int qnn_save(const QuantizedNetwork* qnet, const char* filepath) {
+    if (qnet == NULL || filepath == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return 0;
+    }
+    FILE* file = fopen(filepath, "wb");
+    if (!file) {
+        gann_set_error(GANN_ERROR_FILE_OPEN);
+        return 0;
+    }
+
+#define CHECK_WRITE(data, size, count, file_ptr) \
+    if (fwrite(data, size, count, file_ptr) != (size_t)(count)) { \
+        gann_set_error(GANN_ERROR_FILE_WRITE); \
+        fclose(file_ptr); \
+        return 0; \
+    }
+
+    int version = QNN_FILE_VERSION;
+    CHECK_WRITE(QNN_FILE_MAGIC, 1, sizeof(QNN_FILE_MAGIC), file);
+    CHECK_WRITE(&version, sizeof(int), 1, file);
+    CHECK_WRITE(&qnet->num_layers, sizeof(int), 1, file);
+    CHECK_WRITE(&qnet->activation_hidden, sizeof(ActivationType), 1, file);
+    CHECK_WRITE(&qnet->activation_output, sizeof(ActivationType), 1, file);
+    CHECK_WRITE(qnet->architecture, sizeof(int), qnet->num_layers, file);
+    for (int l = 0; l < qnet->num_layers - 1; l++) {
+        const QuantLayer* layer = &qnet->layers[l];
+        CHECK_WRITE(&layer->input_scale, sizeof(float), 1, file);
+        CHECK_WRITE(&layer->input_zero_point, sizeof(int), 1, file);
+        CHECK_WRITE(layer->weight_scales, sizeof(float), layer->outputs, file);
+        for (int j = 0; j < layer->outputs; j++) {
+            float bias = (float)layer->biases[j];
+            CHECK_WRITE(&bias, sizeof(float), 1, file);
+        }
+        for (int j = 0; j < layer->outputs; j++) {
+            CHECK_WRITE(layer->weights + (size_t)j * layer->stride, sizeof(int8_t), layer->inputs, file);
+        }
+    }
+
+#undef CHECK_WRITE
+    fclose(file);
+    gann_set_error(GANN_SUCCESS);
+    return 1;
+}
+
+QuantizedNetwork* qnn_load(const char* filepath) {
+    if (filepath == NULL) {
+        gann_set_error(GANN_ERROR_NULL_ARGUMENT);
+        return NULL;
+    }
+    FILE* file = fopen(filepath, "rb");
+    if (!file) {
+        gann_set_error(GANN_ERROR_FILE_OPEN);
+        return NULL;
+    }
+
+#define CHECK_READ(data, size, count, file_ptr) \
+    if (fread(data, size, count, file_ptr) != (size_t)(count)) { \
+        gann_set_error(GANN_ERROR_FILE_READ); \
+        fclose(file_ptr); \
+        return NULL; \
+    }
+
+    char magic[sizeof(QNN_FILE_MAGIC)];
+    int version, num_layers;
+    ActivationType activation_hidden, activation_output;
+    CHECK_READ(magic, 1, sizeof(magic), file);
+    CHECK_READ(&version, sizeof(int), 1, file);
+    if (memcmp(magic, QNN_FILE_MAGIC, sizeof(magic)) != 0 || version != QNN_FILE_VERSION) {
+        gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+        fclose(file);
+        return NULL;
+    }
+    CHECK_READ(&num_layers, sizeof(int), 1, file);
+    CHECK_READ(&activation_hidden, sizeof(ActivationType), 1, file);
+    CHECK_READ(&activation_output, sizeof(ActivationType), 1, file);
+    // nn_create would reject a hidden softmax; the enums come straight from the file
+    if ((int)activation_hidden < SIGMOID || (int)activation_hidden > LINEAR ||
+        (int)activation_output < SIGMOID || (int)activation_output > SOFTMAX) {
+        gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+        fclose(file);
+        return NULL;
+    }
+
+    // Bound num_layers by what the file could hold, then check that the payload
+    // has exactly the size this architecture needs before allocating for it.
+    long header_end = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, header_end, SEEK_SET);
+    if (num_layers < 2 || header_end < 0 || file_size < header_end ||
+        (size_t)num_layers > (size_t)(file_size - header_end) / sizeof(int)) {
+        gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+        fclose(file);
+        return NULL;
+    }
+    int* architecture = (int*)malloc((size_t)num_layers * sizeof(int));
+    if (!architecture) {
+        gann_set_error(GANN_ERROR_ALLOC_FAILED);
+        fclose(file);
+        return NULL;
+    }
+    if (fread(architecture, sizeof(int), num_layers, file) != (size_t)num_layers) {
+        gann_set_error(GANN_ERROR_FILE_READ);
+        free(architecture);
+        fclose(file);
+        return NULL;
+    }
+    size_t expected = 0;
+    for (int l = 0; l < num_layers; l++) {
+        if (architecture[l] <= 0 || (l < num_layers - 1 && architecture[l] > QUANT_MAX_INPUTS)) {
+            expected = SIZE_MAX;
+            break;
+        }
+        if (l > 0) {
+            expected += sizeof(float) + sizeof(int) +
+                        (size_t)architecture[l] * (2 * sizeof(float) + (size_t)architecture[l - 1]);
+        }
+    }
+    if (expected == SIZE_MAX || expected != (size_t)(file_size - header_end) - (size_t)num_layers * sizeof(int)) {
+        gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+        free(architecture);
+        fclose(file);
+        return NULL;
+    }
+
+    QuantizedNetwork* qnet = qnn_alloc(num_layers, architecture, activation_hidden, activation_output);
+    free(architecture);
+    if (!qnet) {
+        fclose(file);
+        return NULL; // qnn_alloc sets the error
+    }
+#undef CHECK_READ
+#define CHECK_READ(data, size, count, file_ptr) \
+    if (fread(data, size, count, file_ptr) != (size_t)(count)) { \
+        gann_set_error(GANN_ERROR_FILE_READ); \
+        fclose(file_ptr); \
+        qnn_free(qnet); \
+        return NULL; \
+    }
+    for (int l = 0; l < num_layers - 1; l++) {
+        QuantLayer* layer = &qnet->layers[l];
+        CHECK_READ(&layer->input_scale, sizeof(float), 1, file);
+        CHECK_READ(&layer->input_zero_point, sizeof(int), 1, file);
+        CHECK_READ(layer->weight_scales, sizeof(float), layer->outputs, file);
+        for (int j = 0; j < layer->outputs; j++) {
+            float bias;
+            CHECK_READ(&bias, sizeof(float), 1, file);
+            layer->biases[j] = (gann_real)bias;
+        }
+        for (int j = 0; j < layer->outputs; j++) {
+            CHECK_READ(layer->weights + (size_t)j * layer->stride, sizeof(int8_t), layer->inputs, file);
+        }
+        if (!(layer->input_scale > 0) || layer->input_zero_point < 0 || layer->input_zero_point > 255) {
+            gann_set_error(GANN_ERROR_INVALID_FILE_FORMAT);
+            fclose(file);
+            qnn_free(qnet);
+            return NULL;
+        }
+        quant_layer_finish(layer);
+    }
+
+#undef CHECK_READ
+    fclose(file);
+    gann_set_error(GANN_SUCCESS);
+    return qnet;
+}
@@ -0,0 +1,279 @@
+#include "simd_kernels.h"
+#include "gann_simd.h"
+#include "half.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Kernel Instantiations ---
+// Each block below compiles the template in simd_impl.h for one instruction set.
+// Vector widths are given in bytes and converted to gann_real lanes, so a float32
+// build gets twice the lanes (and twice the GEMM tile width) of a double build.
+
+#define SIMD_LANES(bytes) ((bytes) / GANN_REAL_SIZE)
+#ifdef GANN_FLOAT32
+#define SIMD_X86(op) op##_ps
+#define REAL_SQRT(x) sqrtf(x)
+#define REAL_EXP(x) expf(x)
+#else
+#define SIMD_X86(op) op##_pd
+#define REAL_SQRT(x) sqrt(x)
+#define REAL_EXP(x) exp(x)
+#endif
+
+// --- Exponential ---
+// The vector kernels compute exp(x) = 2^n * e^r with n = round(x / ln 2) and
+// |r| <= ln(2) / 2. e^r is a polynomial; 2^n is built directly in the exponent
+// field. Inputs are clamped so that 2^n stays a normal number.
+#ifdef GANN_FLOAT32
+typedef int32_t real_int;
+#define REAL_MANTISSA_BITS 23
+#define REAL_EXPONENT_BIAS 127
+#define REAL_ROUND_MAGIC 12582912.0f /* 1.5 * 2^23: adding it rounds to an integer */
+#define EXP_INPUT_MIN -87.0f
+#define EXP_INPUT_MAX 88.0f
+#define LN2_HI 0.693359375f
+#define LN2_LO -2.12194440e-4f
+// Taylor series of degree 7, highest power first: within 2 ulp of expf.
+static const gann_real exp_coefficients[] = {
+    1.0f / 5040, 1.0f / 720, 1.0f / 120, 1.0f / 24, 1.0f / 6, 0.5f, 1.0f, 1.0f
+};
+#else
+typedef int64_t real_int;
+#define REAL_MANTISSA_BITS 52
+#define REAL_EXPONENT_BIAS 1023
+#define REAL_ROUND_MAGIC 6755399441055744.0 /* 1.5 * 2^52: adding it rounds to an integer */
+#define EXP_INPUT_MIN -708.0
+#define EXP_INPUT_MAX 709.0
+#define LN2_HI 6.93147180369123816490e-01
+#define LN2_LO 1.90821492927058770002e-10
+// Taylor series of degree 13, highest power first: within 2 ulp of exp.
+static const gann_real exp_coefficients[] = {
+    1.6059043836821613e-10, 2.08767569878681e-09, 2.505210838544172e-08, 2.7557319223985888e-07,
+    2.7557319223985893e-06, 2.4801587301587302e-05, 1.9841269841269841e-04, 1.3888888888888889e-03,
+    8.3333333333333332e-03, 4.1666666666666664e-02, 1.6666666666666666e-01, 0.5, 1.0, 1.0
+};
+#endif
+#define EXP_DEGREE ((int)(sizeof(exp_coefficients) / sizeof(exp_coefficients[0])) - 1)
+
+// The fast sigmoid (GANN_SIGMOID_FAST) uses a degree-3 minimax polynomial for
+// e^r instead, with a relative error below 7.5e-5. Since
+// |d sigmoid| = sigmoid * (1 - sigmoid) * |de / e| <= |de / e| / 4, the sigmoid
+// is off by at most 1.9e-5 (2e-5 with rounding) anywhere.
+static const gann_real fast_exp_coefficients[] = {
+    0.16566842347964333, 0.5049632641822398, 1.0001641857610948, 0.9999280735404956
+};
+#define FAST_EXP_DEGREE 3
+
+int g_simd_fast_sigmoid = 0;
+
+// Portable kernels: plain C, used on non-x86 targets or when forced.
+#define SIMD_NAME(x) x##_scalar
+#define SIMD_LEVEL GANN_SIMD_SCALAR
+#define SIMD_ATTR
+#define SIMD_WIDTH 1
+#define SIMD_MR 4
+#define SIMD_NR 4
+#define SIMD_SQRT(v) REAL_SQRT(v)
+#define SIMD_MAX(a, b) ((a) > (b) ? (a) : (b))
+#include "simd_impl.h"
+#undef SIMD_NAME
+#undef SIMD_LEVEL
+#undef SIMD_ATTR
+#undef SIMD_WIDTH
+#undef SIMD_MR
+#undef SIMD_NR
+#undef SIMD_SQRT
+#undef SIMD_MAX
+
+#if defined(SIMD_HAVE_X86)
+
+#define SIMD_NAME(x) x##_sse2
+#define SIMD_LEVEL GANN_SIMD_SSE2
+#define SIMD_ATTR __attribute__((target("sse2")))
+#define SIMD_WIDTH SIMD_LANES(16)
+#define SIMD_MR 4
+#define SIMD_NR (2 * SIMD_WIDTH)
+#define SIMD_SQRT(v) SIMD_X86(_mm_sqrt)(v)
+#define SIMD_MAX(a, b) SIMD_X86(_mm_max)(a, b)
+#include "simd_impl.h"
+#undef SIMD_NAME
+#undef SIMD_LEVEL
+#undef SIMD_ATTR
+#undef SIMD_WIDTH
+#undef SIMD_MR
+#undef SIMD_NR
+#undef SIMD_SQRT
+#undef SIMD_MAX
+
+#define SIMD_NAME(x) x##_avx2
+#define SIMD_LEVEL GANN_SIMD_AVX2
+#define SIMD_ATTR __attribute__((target("avx2,fma")))
+#define SIMD_WIDTH SIMD_LANES(32)
+#define SIMD_MR 4
+#define SIMD_NR (2 * SIMD_WIDTH)
+#define SIMD_SQRT(v) SIMD_X86(_mm256_sqrt)(v)
+#define SIMD_MAX(a, b) SIMD_X86(_mm256_max)(a, b)
+#include "simd_impl.h"
+#undef SIMD_NAME
+#undef SIMD_LEVEL
+#undef SIMD_ATTR
+#undef SIMD_WIDTH
+#undef SIMD_MR
+#undef SIMD_NR
+#undef SIMD_SQRT
+#undef SIMD_MAX
+
+#define SIMD_NAME(x) x##_avx512
+#define SIMD_LEVEL GANN_SIMD_AVX512
+#define SIMD_ATTR __attribute__((target("avx512f,avx2,fma")))
+#define SIMD_WIDTH SIMD_LANES(64)
+#define SIMD_MR 8
+#define SIMD_NR (2 * SIMD_WIDTH)
+#define SIMD_SQRT(v) SIMD_X86(_mm512_sqrt)(v)
+#define SIMD_MAX(a, b) SIMD_X86(_mm512_max)(a, b)
+// AVX-512F converts binary16 and float to double in one instruction each, where
+// the generic code spends several shuffles per vector.
+#ifdef GANN_FLOAT32
+#define SIMD_LOAD_FP16(p) _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(p)))
+#define SIMD_LOAD_BF16(p) _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)(p))), 16))
+#else
+#define SIMD_LOAD_FP16(p) \
+    _mm512_cvtps_pd(_mm512_castps512_ps256(_mm512_cvtph_ps(_mm256_zextsi128_si256(_mm_loadu_si128((const __m128i*)(p))))))
+#define SIMD_LOAD_BF16(p) \
+    _mm512_cvtps_pd(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(p))), 16)))
+#endif
+#include "simd_impl.h"
+#undef SIMD_NAME
+#undef SIMD_LEVEL
+#undef SIMD_ATTR
+#undef SIMD_WIDTH
+#undef SIMD_MR
+#undef SIMD_NR
+#undef SIMD_SQRT
+#undef SIMD_MAX
+#undef SIMD_LOAD_FP16
+#undef SIMD_LOAD_BF16
+
+#endif // SIMD_HAVE_X86
+
+// --- Dispatch ---
+
+const SimdKernels* g_simd_active = NULL;
+
+static const SimdKernels* table_for_level(GannSimdLevel level) {
+    switch (level) {
+#if defined(SIMD_HAVE_X86)
+        case GANN_SIMD_AVX512: return &kernels_avx512;
+        case GANN_SIMD_AVX2: return &kernels_avx2;
+        case GANN_SIMD_SSE2: return &kernels_sse2;
+#endif
+        default: return &kernels_scalar;
+    }
+}
+
+// Queries CPUID (through the compiler's CPU model, which also checks that the OS
+// saves the wider register state).
+static GannSimdLevel detect_best_level(void) {
+#if defined(SIMD_HAVE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return GANN_SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return GANN_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2")) return GANN_SIMD_SSE2;
+#endif
+    return GANN_SIMD_SCALAR;
+}
+
+// Parses GANN_SIMD. Returns -1 when it is unset or not recognized.
+static int level_from_environment(void) {
+    const char* value = getenv("GANN_SIMD");
+    if (value == NULL) return -1;
+    for (int level = GANN_SIMD_SCALAR; level <= GANN_SIMD_AVX512; level++) {
+        if (strcmp(value, gann_simd_level_name((GannSimdLevel)level)) == 0) return level;
+    }
+    return -1;
+}
+
+// Parses GANN_SIGMOID. Returns -1 when it is unset or not recognized.
+static int sigmoid_mode_from_environment(void) {
+    const char* value = getenv("GANN_SIGMOID");
+    if (value == NULL) return -1;
+    for (int mode = GANN_SIGMOID_EXACT; mode <= GANN_SIGMOID_FAST; mode++) {
+        if (strcmp(value, gann_simd_sigmoid_mode_name((GannSigmoidMode)mode)) == 0) return mode;
+    }
+    return -1;
+}
+
+const SimdKernels* simd_init(void) {
+    g_simd_fast_sigmoid = (sigmoid_mode_from_environment() == GANN_SIGMOID_FAST);
+    GannSimdLevel level = detect_best_level();
+    int requested = level_from_environment();
+    if (requested >= 0 && requested < (int)level) {
+        level = (GannSimdLevel)requested;
+    }
+    g_simd_active = table_for_level(level);
+    return g_simd_active;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+// Select the kernels when the library is loaded so that the hot paths never branch on it.
+__attribute__((constructor)) static void simd_init_at_load(void) {
+    simd_init();
+}
+#endif
+
+// --- Public API Functions ---
+
+GannSimdLevel gann_simd_get_level(void) {
+    return simd_kernels()->level;
+}
+
+GannSimdLevel gann_simd_get_best_level(void) {
+    return detect_best_level();
+}
+
+int gann_simd_set_level(GannSimdLevel level) {
+    if (level < GANN_SIMD_SCALAR || level > detect_best_level()) {
+        return 0;
+    }
+    g_simd_active = table_for_level(level);
+    return 1;
+}
+
+const char* gann_simd_level_name(GannSimdLevel level) {
+    switch (level) {
+        case GANN_SIMD_SCALAR: return "scalar";
+        case GANN_SIMD_SSE2: return "sse2";
+        case GANN_SIMD_AVX2: return "avx2";
+        case GANN_SIMD_AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+int gann_simd_set_sigmoid_mode(GannSigmoidMode mode) {
+    if (mode != GANN_SIGMOID_EXACT && mode != GANN_SIGMOID_FAST) {
+        return 0;
+    }
+    simd_kernels(); // Make sure load-time initialization cannot overwrite the choice later
+    g_simd_fast_sigmoid = (mode == GANN_SIGMOID_FAST);
+    return 1;
+}
+
+GannSigmoidMode gann_simd_get_sigmoid_mode(void) {
+    simd_kernels();
+    return g_simd_fast_sigmoid ? GANN_SIGMOID_FAST : GANN_SIGMOID_EXACT;
+}
+
+const char* gann_simd_sigmoid_mode_name(GannSigmoidMode mode) {
+    switch (mode) {
+        case GANN_SIGMOID_EXACT: return "exact";
+        case GANN_SIGMOID_FAST: return "fast";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,740 @@
+/**
+ * @file simd_impl.h
+ * @internal
+ * @brief Kernel template, included once per instruction set by `lib/simd.c`.
+ * @details Deliberately has no include guard. Before each inclusion the includer
+ * defines:
+ *  - `SIMD_NAME(x)`  : appends the level suffix to a kernel name (e.g. `x##_avx2`).
+ *  - `SIMD_LEVEL`    : the `GannSimdLevel` this instantiation implements.
+ *  - `SIMD_ATTR`     : function attributes enabling the instruction set.
+ *  - `SIMD_WIDTH`    : `gann_real` elements per vector register (1 for the portable kernels).
+ *  - `SIMD_MR`, `SIMD_NR` : the GEMM register tile (`SIMD_NR` a multiple of `SIMD_WIDTH`).
+ *  - `SIMD_SQRT(v)`, `SIMD_MAX(a, b)` : vector square root and maximum.
+ *  - optionally `SIMD_LOAD_FP16(p)`, `SIMD_LOAD_BF16(p)` : load `SIMD_WIDTH`
+ *    16-bit weights as a vector, for instruction sets that convert them natively.
+ * and, once for all levels, `REAL_SQRT(x)` and `REAL_EXP(x)`: the scalar square
+ * root and exponential of the `gann_real` precision, `real_int` (the integer of
+ * the same size) and the constants of the vector exponential (see `lib/simd.c`).
+ * The kernels use GCC vector extensions, so the same source becomes SSE2, AVX2 or
+ * AVX-512 code depending on `SIMD_WIDTH` and `SIMD_ATTR`.
+ */
+
+#if SIMD_WIDTH == 1
+typedef gann_real SIMD_NAME(vreal);
+typedef real_int SIMD_NAME(vint);
+#else
+typedef gann_real SIMD_NAME(vreal) __attribute__((vector_size(SIMD_WIDTH * sizeof(gann_real))));
+typedef real_int SIMD_NAME(vint) __attribute__((vector_size(SIMD_WIDTH * sizeof(gann_real))));
+#endif
+#define vreal SIMD_NAME(vreal)
+#define vint SIMD_NAME(vint)
+#define SIMD_NV (SIMD_NR / SIMD_WIDTH)
+
+static inline SIMD_ATTR vreal SIMD_NAME(load)(const gann_real* p) {
+    vreal v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline SIMD_ATTR void SIMD_NAME(store)(gann_real* p, vreal v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// Reinterpret the bits of a vector (a plain cast would convert the values when SIMD_WIDTH is 1).
+static inline SIMD_ATTR vint SIMD_NAME(as_int)(vreal v) {
+    vint i;
+    memcpy(&i, &v, sizeof(i));
+    return i;
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(as_real)(vint i) {
+    vreal v;
+    memcpy(&v, &i, sizeof(v));
+    return v;
+}
+
+// Per lane: x > 0 ? if_positive : otherwise.
+static inline SIMD_ATTR vreal SIMD_NAME(select_positive)(vreal x, vreal if_positive, vreal otherwise) {
+#if SIMD_WIDTH == 1
+    return x > 0 ? if_positive : otherwise;
+#else
+    const vreal zero = {0};
+    vint mask = (vint)(x > zero);
+    return SIMD_NAME(as_real)((mask & SIMD_NAME(as_int)(if_positive)) | (~mask & SIMD_NAME(as_int)(otherwise)));
+#endif
+}
+
+// --- Activation Functions ---
+// One function per activation, on a whole vector. The loops below pick the
+// function once and then run it over every vector of the array.
+
+// exp(x) with the range reduction described in simd.c and a polynomial of the
+// given degree (coefficients highest power first) for e^r.
+static inline SIMD_ATTR vreal SIMD_NAME(exp_poly)(vreal x, const gann_real* coefficients, int degree) {
+    const vreal zero = {0};
+    x = SIMD_MAX(x, zero + EXP_INPUT_MIN);
+    x = -SIMD_MAX(-x, zero - EXP_INPUT_MAX);
+    // t = round(x / ln 2) in the low mantissa bits of t; n = the same value as a real.
+    vreal t = x * (gann_real)1.4426950408889634 + REAL_ROUND_MAGIC;
+    vreal n = t - REAL_ROUND_MAGIC;
+    vreal r = (x - n * LN2_HI) - n * LN2_LO;
+    vreal p = zero + coefficients[0];
+    for (int k = 1; k <= degree; k++) p = p * r + coefficients[k];
+    vint exponent = SIMD_NAME(as_int)(t) - SIMD_NAME(as_int)(zero + REAL_ROUND_MAGIC);
+    vreal scale = SIMD_NAME(as_real)((exponent + REAL_EXPONENT_BIAS) << REAL_MANTISSA_BITS);
+    return p * scale;
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(sigmoid)(vreal x) {
+#if SIMD_WIDTH == 1
+    return 1 / (1 + REAL_EXP(-x)); // The portable kernels keep the C library's exp as the reference.
+#else
+    return 1 / (1 + SIMD_NAME(exp_poly)(-x, exp_coefficients, EXP_DEGREE));
+#endif
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(sigmoid_fast)(vreal x) {
+    return 1 / (1 + SIMD_NAME(exp_poly)(-x, fast_exp_coefficients, FAST_EXP_DEGREE));
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(relu)(vreal x) {
+    const vreal zero = {0};
+    return SIMD_MAX(x, zero);
+}
+
+// max(x, 0.01x) equals x for x > 0 and 0.01x otherwise.
+static inline SIMD_ATTR vreal SIMD_NAME(leaky_relu)(vreal x) {
+    return SIMD_MAX(x, (gann_real)0.01 * x);
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(sigmoid_derivative)(vreal x) {
+    vreal s = SIMD_NAME(sigmoid)(x);
+    return s * (1 - s);
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(sigmoid_fast_derivative)(vreal x) {
+    vreal s = SIMD_NAME(sigmoid_fast)(x);
+    return s * (1 - s);
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(relu_derivative)(vreal x) {
+    const vreal zero = {0};
+    return SIMD_NAME(select_positive)(x, zero + 1, zero);
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(leaky_relu_derivative)(vreal x) {
+    const vreal zero = {0};
+    return SIMD_NAME(select_positive)(x, zero + 1, zero + (gann_real)0.01);
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(linear_derivative)(vreal x) {
+    const vreal zero = {0};
+    (void)x;
+    return zero + 1;
+}
+
+static inline SIMD_ATTR vreal SIMD_NAME(exp)(vreal x) {
+#if SIMD_WIDTH == 1
+    return REAL_EXP(x);
+#else
+    return SIMD_NAME(exp_poly)(x, exp_coefficients, EXP_DEGREE);
+#endif
+}
+
+// Softmax of one row. The row's maximum is subtracted before exponentiating, so
+// no term can overflow and the largest is exactly 1, which keeps the sum at
+// least 1. A short last block is padded with the row's first value, which
+// cannot raise the maximum, and its padding lanes are left out of the sum.
+static SIMD_ATTR void SIMD_NAME(softmax)(size_t n, gann_real* x) {
+    if (n == 0) return;
+    const vreal zero = {0};
+    size_t full = n / SIMD_WIDTH * SIMD_WIDTH;
+    gann_real tail[SIMD_WIDTH];
+    for (int l = 0; l < SIMD_WIDTH; l++) tail[l] = x[0];
+    memcpy(tail, x + full, (n - full) * sizeof(gann_real));
+
+    vreal vmax = SIMD_NAME(load)(tail);
+    for (size_t i = 0; i < full; i += SIMD_WIDTH) vmax = SIMD_MAX(vmax, SIMD_NAME(load)(x + i));
+    gann_real lanes[SIMD_WIDTH];
+    SIMD_NAME(store)(lanes, vmax);
+    gann_real max = lanes[0];
+    for (int l = 1; l < SIMD_WIDTH; l++) max = lanes[l] > max ? lanes[l] : max;
+
+    vreal vsum = zero;
+    for (size_t i = 0; i < full; i += SIMD_WIDTH) {
+        vreal e = SIMD_NAME(exp)(SIMD_NAME(load)(x + i) - max);
+        SIMD_NAME(store)(x + i, e);
+        vsum += e;
+    }
+    SIMD_NAME(store)(lanes, vsum);
+    gann_real sum = 0.0;
+    for (int l = 0; l < SIMD_WIDTH; l++) sum += lanes[l];
+    SIMD_NAME(store)(tail, SIMD_NAME(exp)(SIMD_NAME(load)(tail) - max));
+    for (size_t l = 0; l < n - full; l++) sum += tail[l];
+    memcpy(x + full, tail, (n - full) * sizeof(gann_real));
+
+    const gann_real inverse = 1 / sum;
+    for (size_t i = 0; i < full; i += SIMD_WIDTH) SIMD_NAME(store)(x + i, SIMD_NAME(load)(x + i) * inverse);
+    for (size_t i = full; i < n; i++) x[i] *= inverse;
+}
+
+// --- Selection ---
+
+// Inserts x[i] into the first `count` entries of the descending lists
+// classes/scores, which hold at most k. Earlier classes stay ahead of equal
+// scores, as they do in an argmax that keeps the first maximum.
+static inline SIMD_ATTR void SIMD_NAME(top_k_insert)(int i, gann_real value, int k, int count, int* classes, gann_real* scores) {
+    int position = count < k ? count : k - 1;
+    while (position > 0 && value > scores[position - 1]) {
+        classes[position] = classes[position - 1];
+        scores[position] = scores[position - 1];
+        position--;
+    }
+    classes[position] = i;
+    scores[position] = value;
+}
+
+// The k largest of x[0..n), largest first. Once k scores are held, a whole
+// vector none of whose lanes beats the k-th is skipped with one comparison, so
+// for k much smaller than n nearly every vector costs only a load and a compare.
+static SIMD_ATTR void SIMD_NAME(top_k)(int n, const gann_real* x, int k, int* classes, gann_real* scores) {
+    int i = 0;
+    for (; i < k; i++) SIMD_NAME(top_k_insert)(i, x[i], k, i, classes, scores);
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        vreal v = SIMD_NAME(load)(x + i);
+#if SIMD_WIDTH == 1
+        int beats_kth = v > scores[k - 1];
+#else
+        const vreal zero = {0};
+        vint mask = (vint)(v > zero + scores[k - 1]);
+        real_int lanes[SIMD_WIDTH];
+        memcpy(lanes, &mask, sizeof(lanes));
+        real_int any = 0;
+        for (int l = 0; l < SIMD_WIDTH; l++) any |= lanes[l];
+        int beats_kth = any != 0;
+#endif
+        if (!beats_kth) continue;
+        for (int l = 0; l < SIMD_WIDTH; l++) {
+            if (x[i + l] > scores[k - 1]) SIMD_NAME(top_k_insert)(i + l, x[i + l], k, k, classes, scores);
+        }
+    }
+    for (; i < n; i++) {
+        if (x[i] > scores[k - 1]) SIMD_NAME(top_k_insert)(i, x[i], k, k, classes, scores);
+    }
+}
+
+// --- GEMM Epilogue ---
+
+// Applies the epilogue's activation to `count` vectors in place; the switch runs
+// once per call rather than once per element.
+static inline SIMD_ATTR void SIMD_NAME(activate_vectors)(vreal* v, int count, const GemmEpilogue* ep) {
+    switch (ep->activation) {
+        case SIGMOID:
+            if (ep->fast_sigmoid) {
+                for (int j = 0; j < count; j++) v[j] = SIMD_NAME(sigmoid_fast)(v[j]);
+            } else {
+                for (int j = 0; j < count; j++) v[j] = SIMD_NAME(sigmoid)(v[j]);
+            }
+            break;
+        case RELU:
+            for (int j = 0; j < count; j++) v[j] = SIMD_NAME(relu)(v[j]);
+            break;
+        case LEAKY_RELU:
+            for (int j = 0; j < count; j++) v[j] = SIMD_NAME(leaky_relu)(v[j]);
+            break;
+        case LINEAR:
+        case SOFTMAX: // Normalized once the whole row is known (see GemmEpilogue)
+            break;
+    }
+}
+
+// Finishes one row of C, SIMD_NR columns at a time. A short last block is padded
+// to whole vectors so that it goes through exactly the same arithmetic.
+static SIMD_ATTR void SIMD_NAME(epilogue_row)(int n, gann_real* c, const GemmEpilogue* ep) {
+    vreal v[SIMD_NV];
+    for (int j0 = 0; j0 < n; j0 += SIMD_NR) {
+        int width = (n - j0 < SIMD_NR) ? n - j0 : SIMD_NR;
+        if (width == SIMD_NR) {
+            for (int j = 0; j < SIMD_NV; j++) {
+                v[j] = SIMD_NAME(load)(c + j0 + j * SIMD_WIDTH);
+                if (ep->bias) v[j] += SIMD_NAME(load)(ep->bias + j0 + j * SIMD_WIDTH);
+                if (ep->z) SIMD_NAME(store)(ep->z + j0 + j * SIMD_WIDTH, v[j]);
+            }
+            SIMD_NAME(activate_vectors)(v, SIMD_NV, ep);
+            for (int j = 0; j < SIMD_NV; j++) SIMD_NAME(store)(c + j0 + j * SIMD_WIDTH, v[j]);
+        } else {
+            gann_real lanes[SIMD_NR] = {0};
+            gann_real bias[SIMD_NR] = {0};
+            memcpy(lanes, c + j0, (size_t)width * sizeof(gann_real));
+            if (ep->bias) memcpy(bias, ep->bias + j0, (size_t)width * sizeof(gann_real));
+            for (int j = 0; j < SIMD_NV; j++) {
+                v[j] = SIMD_NAME(load)(lanes + j * SIMD_WIDTH) + SIMD_NAME(load)(bias + j * SIMD_WIDTH);
+                SIMD_NAME(store)(lanes + j * SIMD_WIDTH, v[j]);
+            }
+            if (ep->z) memcpy(ep->z + j0, lanes, (size_t)width * sizeof(gann_real));
+            SIMD_NAME(activate_vectors)(v, SIMD_NV, ep);
+            for (int j = 0; j < SIMD_NV; j++) SIMD_NAME(store)(lanes + j * SIMD_WIDTH, v[j]);
+            memcpy(c + j0, lanes, (size_t)width * sizeof(gann_real));
+        }
+    }
+}
+
+// --- GEMM ---
+
+static SIMD_ATTR void SIMD_NAME(gemm_micro)(int kc, const gann_real* restrict a, const gann_real* restrict b,
+                                            gann_real beta, gann_real* restrict c, int ldc, int mr, int nr,
+                                            const GemmEpilogue* ep) {
+    const vreal zero = {0};
+    vreal acc[SIMD_MR][SIMD_NV];
+    for (int i = 0; i < SIMD_MR; i++) {
+        for (int j = 0; j < SIMD_NV; j++) acc[i][j] = zero;
+    }
+
+    for (int p = 0; p < kc; p++) {
+        vreal bv[SIMD_NV];
+        for (int j = 0; j < SIMD_NV; j++) bv[j] = SIMD_NAME(load)(b + j * SIMD_WIDTH);
+        for (int i = 0; i < SIMD_MR; i++) {
+            const vreal ai = zero + a[i];
+            for (int j = 0; j < SIMD_NV; j++) acc[i][j] += ai * bv[j];
+        }
+        a += SIMD_MR;
+        b += SIMD_NR;
+    }
+
+    if (mr == SIMD_MR && nr == SIMD_NR) {
+        vreal bias[SIMD_NV];
+        for (int j = 0; j < SIMD_NV; j++) bias[j] = (ep && ep->bias) ? SIMD_NAME(load)(ep->bias + j * SIMD_WIDTH) : zero;
+        for (int i = 0; i < SIMD_MR; i++) {
+            gann_real* c_row = c + (size_t)i * ldc;
+            for (int j = 0; j < SIMD_NV; j++) {
+                vreal out = acc[i][j];
+                if (beta == 1.0) out += SIMD_NAME(load)(c_row + j * SIMD_WIDTH);
+                else if (beta != 0.0) out += beta * SIMD_NAME(load)(c_row + j * SIMD_WIDTH);
+                if (ep) {
+                    // Epilogue: the finished tile gets its bias and activation before it leaves the registers.
+                    if (ep->bias) out += bias[j];
+                    if (ep->z) SIMD_NAME(store)(ep->z + (size_t)i * ep->ldz + j * SIMD_WIDTH, out);
+                }
+                acc[i][j] = out;
+            }
+            if (ep) SIMD_NAME(activate_vectors)(acc[i], SIMD_NV, ep);
+            for (int j = 0; j < SIMD_NV; j++) SIMD_NAME(store)(c_row + j * SIMD_WIDTH, acc[i][j]);
+        }
+        return;
+    }
+
+    // Edge tile: spill the accumulator and write only the valid corner.
+    gann_real tile[SIMD_MR][SIMD_NR];
+    for (int i = 0; i < SIMD_MR; i++) {
+        for (int j = 0; j < SIMD_NV; j++) SIMD_NAME(store)(&tile[i][j * SIMD_WIDTH], acc[i][j]);
+    }
+    for (int i = 0; i < mr; i++) {
+        gann_real* c_row = c + (size_t)i * ldc;
+        for (int j = 0; j < nr; j++) {
+            if (beta == 0.0) c_row[j] = tile[i][j];
+            else if (beta == 1.0) c_row[j] += tile[i][j];
+            else c_row[j] = beta * c_row[j] + tile[i][j];
+        }
+        if (ep) {
+            GemmEpilogue row_ep = *ep;
+            if (row_ep.z) row_ep.z += (size_t)i * ep->ldz;
+            SIMD_NAME(epilogue_row)(nr, c_row, &row_ep);
+        }
+    }
+}
+
+// Row-at-a-time product: each row of C is a linear combination of the rows of B,
+// accumulated four rows of B per sweep to cut load/store traffic on C. The
+// epilogue runs on each row right after its last sweep, while it is still in L1.
+static SIMD_ATTR void SIMD_NAME(gemm_rows)(int m, int n, int k, const gann_real* a, int rsa, int csa,
+                                           const gann_real* b, int ldb, gann_real beta, gann_real* c, int ldc,
+                                           const GemmEpilogue* ep) {
+    for (int i = 0; i < m; i++) {
+        const gann_real* a_row = a + (size_t)i * rsa;
+        gann_real* restrict c_row = c + (size_t)i * ldc;
+
+        if (beta == 0.0) {
+            memset(c_row, 0, (size_t)n * sizeof(gann_real));
+        } else if (beta != 1.0) {
+            for (int j = 0; j < n; j++) c_row[j] *= beta;
+        }
+
+        int p = 0;
+        for (; p + 4 <= k; p += 4) {
+            const gann_real a0 = a_row[(size_t)(p + 0) * csa];
+            const gann_real a1 = a_row[(size_t)(p + 1) * csa];
+            const gann_real a2 = a_row[(size_t)(p + 2) * csa];
+            const gann_real a3 = a_row[(size_t)(p + 3) * csa];
+            const gann_real* restrict b0 = b + (size_t)(p + 0) * ldb;
+            const gann_real* restrict b1 = b + (size_t)(p + 1) * ldb;
+            const gann_real* restrict b2 = b + (size_t)(p + 2) * ldb;
+            const gann_real* restrict b3 = b + (size_t)(p + 3) * ldb;
+            int j = 0;
+            for (; j + SIMD_WIDTH <= n; j += SIMD_WIDTH) {
+                vreal acc = SIMD_NAME(load)(c_row + j);
+                acc += a0 * SIMD_NAME(load)(b0 + j) + a1 * SIMD_NAME(load)(b1 + j)
+                     + a2 * SIMD_NAME(load)(b2 + j) + a3 * SIMD_NAME(load)(b3 + j);
+                SIMD_NAME(store)(c_row + j, acc);
+            }
+            for (; j < n; j++) {
+                c_row[j] += a0 * b0[j] + a1 * b1[j] + a2 * b2[j] + a3 * b3[j];
+            }
+        }
+        for (; p < k; p++) {
+            const gann_real ap = a_row[(size_t)p * csa];
+            const gann_real* restrict bp = b + (size_t)p * ldb;
+            int j = 0;
+            for (; j + SIMD_WIDTH <= n; j += SIMD_WIDTH) {
+                SIMD_NAME(store)(c_row + j, SIMD_NAME(load)(c_row + j) + ap * SIMD_NAME(load)(bp + j));
+            }
+            for (; j < n; j++) c_row[j] += ap * bp[j];
+        }
+        if (ep) {
+            GemmEpilogue row_ep = *ep;
+            if (row_ep.z) row_ep.z += (size_t)i * ep->ldz;
+            SIMD_NAME(epilogue_row)(n, c_row, &row_ep);
+        }
+    }
+}
+
+// Sparse row sweep shared by gemm_sparse_row and gemm_csr_row: c = sum over p of
+// a_p * B[cols[p], :], where a_p is a[cols[p]] when `gather` is set (values read in
+// place from a dense row) and a[p] otherwise (CSR values). Same 4-way sweep as
+// gemm_rows, but only over the listed rows of B, so zeros cost nothing.
+static inline SIMD_ATTR void SIMD_NAME(sparse_sweep)(int n, int nnz, const int* cols, const gann_real* a, int gather,
+                                                     const gann_real* b, int ldb, gann_real* restrict c) {
+    memset(c, 0, (size_t)n * sizeof(gann_real));
+    int p = 0;
+    for (; p + 4 <= nnz; p += 4) {
+        const gann_real a0 = gather ? a[cols[p + 0]] : a[p + 0];
+        const gann_real a1 = gather ? a[cols[p + 1]] : a[p + 1];
+        const gann_real a2 = gather ? a[cols[p + 2]] : a[p + 2];
+        const gann_real a3 = gather ? a[cols[p + 3]] : a[p + 3];
+        const gann_real* restrict b0 = b + (size_t)cols[p + 0] * ldb;
+        const gann_real* restrict b1 = b + (size_t)cols[p + 1] * ldb;
+        const gann_real* restrict b2 = b + (size_t)cols[p + 2] * ldb;
+        const gann_real* restrict b3 = b + (size_t)cols[p + 3] * ldb;
+        int j = 0;
+        for (; j + SIMD_WIDTH <= n; j += SIMD_WIDTH) {
+            vreal acc = SIMD_NAME(load)(c + j);
+            acc += a0 * SIMD_NAME(load)(b0 + j) + a1 * SIMD_NAME(load)(b1 + j)
+                 + a2 * SIMD_NAME(load)(b2 + j) + a3 * SIMD_NAME(load)(b3 + j);
+            SIMD_NAME(store)(c + j, acc);
+        }
+        for (; j < n; j++) {
+            c[j] += a0 * b0[j] + a1 * b1[j] + a2 * b2[j] + a3 * b3[j];
+        }
+    }
+    for (; p < nnz; p++) {
+        const gann_real ap = gather ? a[cols[p]] : a[p];
+        const gann_real* restrict bp = b + (size_t)cols[p] * ldb;
+        int j = 0;
+        for (; j + SIMD_WIDTH <= n; j += SIMD_WIDTH) {
+            SIMD_NAME(store)(c + j, SIMD_NAME(load)(c + j) + ap * SIMD_NAME(load)(bp + j));
+        }
+        for (; j < n; j++) c[j] += ap * bp[j];
+    }
+}
+
+// Row product with a sparse left operand: c = f(sum over p of a_row[cols[p]] * B[cols[p], :] + bias).
+static SIMD_ATTR void SIMD_NAME(gemm_sparse_row)(int n, int nnz, const int* cols, const gann_real* a_row,
+                                                 const gann_real* b, int ldb, gann_real* restrict c, const GemmEpilogue* ep) {
+    SIMD_NAME(sparse_sweep)(n, nnz, cols, a_row, 1, b, ldb, c);
+    if (ep) SIMD_NAME(epilogue_row)(n, c, ep);
+}
+
+// Row product with a CSR left operand: c = f(sum over p of values[p] * B[cols[p], :] + bias).
+static SIMD_ATTR void SIMD_NAME(gemm_csr_row)(int n, int nnz, const int* cols, const gann_real* values,
+                                              const gann_real* b, int ldb, gann_real* restrict c, const GemmEpilogue* ep) {
+    SIMD_NAME(sparse_sweep)(n, nnz, cols, values, 0, b, ldb, c);
+    if (ep) SIMD_NAME(epilogue_row)(n, c, ep);
+}
+
+// --- Element-wise ---
+
+static SIMD_ATTR gann_real SIMD_NAME(dot)(size_t n, const gann_real* a, const gann_real* b) {
+    // Two independent accumulators hide the latency of the dependent adds.
+    vreal acc0 = {0}, acc1 = {0};
+    size_t i = 0;
+    for (; i + 2 * SIMD_WIDTH <= n; i += 2 * SIMD_WIDTH) {
+        acc0 += SIMD_NAME(load)(a + i) * SIMD_NAME(load)(b + i);
+        acc1 += SIMD_NAME(load)(a + i + SIMD_WIDTH) * SIMD_NAME(load)(b + i + SIMD_WIDTH);
+    }
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        acc0 += SIMD_NAME(load)(a + i) * SIMD_NAME(load)(b + i);
+    }
+    acc0 += acc1;
+    gann_real lanes[SIMD_WIDTH];
+    SIMD_NAME(store)(lanes, acc0);
+    gann_real sum = 0.0;
+    for (int l = 0; l < SIMD_WIDTH; l++) sum += lanes[l];
+    for (; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+static SIMD_ATTR void SIMD_NAME(add_inplace)(size_t n, gann_real* x, const gann_real* y) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(x + i, SIMD_NAME(load)(x + i) + SIMD_NAME(load)(y + i));
+    }
+    for (; i < n; i++) x[i] += y[i];
+}
+
+static SIMD_ATTR void SIMD_NAME(axpy)(size_t n, gann_real alpha, const gann_real* x, gann_real* y) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(y + i, SIMD_NAME(load)(y + i) + alpha * SIMD_NAME(load)(x + i));
+    }
+    for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+static SIMD_ATTR void SIMD_NAME(add)(size_t n, const gann_real* a, const gann_real* b, gann_real* r) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(r + i, SIMD_NAME(load)(a + i) + SIMD_NAME(load)(b + i));
+    }
+    for (; i < n; i++) r[i] = a[i] + b[i];
+}
+
+static SIMD_ATTR void SIMD_NAME(sub)(size_t n, const gann_real* a, const gann_real* b, gann_real* r) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(r + i, SIMD_NAME(load)(a + i) - SIMD_NAME(load)(b + i));
+    }
+    for (; i < n; i++) r[i] = a[i] - b[i];
+}
+
+static SIMD_ATTR void SIMD_NAME(mul)(size_t n, const gann_real* a, const gann_real* b, gann_real* r) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(r + i, SIMD_NAME(load)(a + i) * SIMD_NAME(load)(b + i));
+    }
+    for (; i < n; i++) r[i] = a[i] * b[i];
+}
+
+static SIMD_ATTR void SIMD_NAME(scale)(size_t n, const gann_real* a, gann_real s, gann_real* r) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(r + i, SIMD_NAME(load)(a + i) * s);
+    }
+    for (; i < n; i++) r[i] = a[i] * s;
+}
+
+// --- 16-bit Weights ---
+
+// Loads SIMD_WIDTH 16-bit weights as one vector, with the arithmetic of
+// bf16_to_float and fp16_to_float done lane-wise.
+static inline SIMD_ATTR vreal SIMD_NAME(load_16)(const uint16_t* p, NNWeightStorage format) {
+#if SIMD_WIDTH == 1
+    return half_to_real(*p, format);
+#elif defined(SIMD_LOAD_FP16)
+    return format == NN_STORAGE_BF16 ? (vreal)SIMD_LOAD_BF16(p) : (vreal)SIMD_LOAD_FP16(p);
+#else
+    typedef uint16_t v16 __attribute__((vector_size(SIMD_WIDTH * sizeof(uint16_t))));
+    typedef uint32_t v32 __attribute__((vector_size(SIMD_WIDTH * sizeof(uint32_t))));
+    typedef float vfloat __attribute__((vector_size(SIMD_WIDTH * sizeof(float))));
+    v16 h;
+    memcpy(&h, p, sizeof(h));
+    v32 w = __builtin_convertvector(h, v32);
+    vfloat f;
+    if (format == NN_STORAGE_BF16) {
+        w <<= 16;
+    } else {
+        v32 magnitude = (w & 0x7fff) << 13;
+        memcpy(&f, &magnitude, sizeof(f));
+        f *= 0x1p112f;
+        v32 special = (v32)((w & 0x7c00) == 0x7c00) & 0x7f800000; // infinity or NaN
+        v32 sign = (w & 0x8000) << 16;
+        memcpy(&w, &f, sizeof(w));
+        w |= special | sign;
+    }
+    memcpy(&f, &w, sizeof(f));
+    return __builtin_convertvector(f, vreal);
+#endif
+}
+
+static SIMD_ATTR void SIMD_NAME(widen_16)(size_t n, const uint16_t* restrict src, gann_real* restrict dst, NNWeightStorage format) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) SIMD_NAME(store)(dst + i, SIMD_NAME(load_16)(src + i, format));
+    for (; i < n; i++) dst[i] = half_to_real(src[i], format);
+}
+
+// Row product with a 16-bit B: c = f(a_row * B + bias). The 4-way sweep of
+// gemm_rows, widening each vector of B as it is loaded; groups of four rows of
+// B that a_row multiplies by zero are skipped.
+static inline SIMD_ATTR void SIMD_NAME(row_sweep_16)(int n, int k, const gann_real* a, const uint16_t* b, int ldb,
+                                                     NNWeightStorage format, gann_real* restrict c) {
+    memset(c, 0, (size_t)n * sizeof(gann_real));
+    int p = 0;
+    for (; p + 4 <= k; p += 4) {
+        const gann_real a0 = a[p + 0], a1 = a[p + 1], a2 = a[p + 2], a3 = a[p + 3];
+        if (a0 == 0 && a1 == 0 && a2 == 0 && a3 == 0) continue;
+        const uint16_t* b0 = b + (size_t)(p + 0) * ldb;
+        const uint16_t* b1 = b + (size_t)(p + 1) * ldb;
+        const uint16_t* b2 = b + (size_t)(p + 2) * ldb;
+        const uint16_t* b3 = b + (size_t)(p + 3) * ldb;
+        int j = 0;
+        for (; j + SIMD_WIDTH <= n; j += SIMD_WIDTH) {
+            vreal acc = SIMD_NAME(load)(c + j);
+            acc += a0 * SIMD_NAME(load_16)(b0 + j, format) + a1 * SIMD_NAME(load_16)(b1 + j, format)
+                 + a2 * SIMD_NAME(load_16)(b2 + j, format) + a3 * SIMD_NAME(load_16)(b3 + j, format);
+            SIMD_NAME(store)(c + j, acc);
+        }
+        for (; j < n; j++) {
+            c[j] += a0 * half_to_real(b0[j], format) + a1 * half_to_real(b1[j], format)
+                  + a2 * half_to_real(b2[j], format) + a3 * half_to_real(b3[j], format);
+        }
+    }
+    for (; p < k; p++) {
+        const gann_real ap = a[p];
+        const uint16_t* bp = b + (size_t)p * ldb;
+        int j = 0;
+        for (; j + SIMD_WIDTH <= n; j += SIMD_WIDTH) {
+            SIMD_NAME(store)(c + j, SIMD_NAME(load)(c + j) + ap * SIMD_NAME(load_16)(bp + j, format));
+        }
+        for (; j < n; j++) c[j] += ap * half_to_real(bp[j], format);
+    }
+}
+
+static SIMD_ATTR void SIMD_NAME(gemm_row_16)(int n, int k, const gann_real* a_row, const uint16_t* b, int ldb,
+                                             NNWeightStorage format, gann_real* restrict c, const GemmEpilogue* ep) {
+    // Each call below inlines the sweep for one constant format.
+    if (format == NN_STORAGE_BF16) {
+        SIMD_NAME(row_sweep_16)(n, k, a_row, b, ldb, NN_STORAGE_BF16, c);
+    } else {
+        SIMD_NAME(row_sweep_16)(n, k, a_row, b, ldb, NN_STORAGE_FP16, c);
+    }
+    if (ep) SIMD_NAME(epilogue_row)(n, c, ep);
+}
+
+// --- Activations ---
+
+// Applies f to every whole vector of x, then to the tail padded to a whole
+// vector, so that every element goes through the same arithmetic.
+#define SIMD_MAP(f, n, x)                                                        \
+    do {                                                                         \
+        size_t i_ = 0;                                                           \
+        for (; i_ + SIMD_WIDTH <= (n); i_ += SIMD_WIDTH) {                       \
+            SIMD_NAME(store)((x) + i_, f(SIMD_NAME(load)((x) + i_)));            \
+        }                                                                        \
+        if (i_ < (n)) {                                                          \
+            gann_real lanes_[SIMD_WIDTH] = {0};                                  \
+            memcpy(lanes_, (x) + i_, ((n) - i_) * sizeof(gann_real));            \
+            SIMD_NAME(store)(lanes_, f(SIMD_NAME(load)(lanes_)));                \
+            memcpy((x) + i_, lanes_, ((n) - i_) * sizeof(gann_real));            \
+        }                                                                        \
+    } while (0)
+
+static SIMD_ATTR void SIMD_NAME(activation)(size_t n, gann_real* x, ActivationType type) {
+    switch (type) {
+        case SIGMOID:
+            if (g_simd_fast_sigmoid) SIMD_MAP(SIMD_NAME(sigmoid_fast), n, x);
+            else SIMD_MAP(SIMD_NAME(sigmoid), n, x);
+            break;
+        case RELU: SIMD_MAP(SIMD_NAME(relu), n, x); break;
+        case LEAKY_RELU: SIMD_MAP(SIMD_NAME(leaky_relu), n, x); break;
+        case LINEAR: break;
+        case SOFTMAX: SIMD_NAME(softmax)(n, x); break;
+    }
+}
+
+static SIMD_ATTR void SIMD_NAME(activation_derivative)(size_t n, gann_real* x, ActivationType type) {
+    switch (type) {
+        case SIGMOID:
+            if (g_simd_fast_sigmoid) SIMD_MAP(SIMD_NAME(sigmoid_fast_derivative), n, x);
+            else SIMD_MAP(SIMD_NAME(sigmoid_derivative), n, x);
+            break;
+        case RELU: SIMD_MAP(SIMD_NAME(relu_derivative), n, x); break;
+        case LEAKY_RELU: SIMD_MAP(SIMD_NAME(leaky_relu_derivative), n, x); break;
+        case LINEAR:
+        case SOFTMAX: SIMD_MAP(SIMD_NAME(linear_derivative), n, x); break;
+    }
+}
+
+#undef SIMD_MAP
+
+// --- Optimizer Updates ---
+
+static SIMD_ATTR void SIMD_NAME(sgd_update)(size_t n, gann_real* w, const gann_real* g, gann_real step) {
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        SIMD_NAME(store)(w + i, SIMD_NAME(load)(w + i) - step * SIMD_NAME(load)(g + i));
+    }
+    for (; i < n; i++) w[i] -= step * g[i];
+}
+
+static SIMD_ATTR void SIMD_NAME(rmsprop_update)(size_t n, gann_real* w, gann_real* v, const gann_real* g,
+                                                gann_real lr, gann_real beta2, gann_real epsilon, gann_real grad_scale) {
+    const gann_real one_minus_beta2 = 1.0 - beta2;
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        vreal grad = SIMD_NAME(load)(g + i) * grad_scale;
+        vreal vv = beta2 * SIMD_NAME(load)(v + i) + one_minus_beta2 * (grad * grad);
+        SIMD_NAME(store)(v + i, vv);
+        SIMD_NAME(store)(w + i, SIMD_NAME(load)(w + i) - (lr / (SIMD_SQRT(vv) + epsilon)) * grad);
+    }
+    for (; i < n; i++) {
+        gann_real grad = g[i] * grad_scale;
+        v[i] = beta2 * v[i] + one_minus_beta2 * (grad * grad);
+        w[i] -= (lr / (REAL_SQRT(v[i]) + epsilon)) * grad;
+    }
+}
+
+static SIMD_ATTR void SIMD_NAME(adam_update)(size_t n, gann_real* w, gann_real* m, gann_real* v, const gann_real* g,
+                                             gann_real lr, gann_real beta1, gann_real beta2, gann_real epsilon, gann_real grad_scale,
+                                             gann_real correction1, gann_real correction2) {
+    const gann_real one_minus_beta1 = 1.0 - beta1;
+    const gann_real one_minus_beta2 = 1.0 - beta2;
+    size_t i = 0;
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        vreal grad = SIMD_NAME(load)(g + i) * grad_scale;
+        vreal mv = beta1 * SIMD_NAME(load)(m + i) + one_minus_beta1 * grad;
+        vreal vv = beta2 * SIMD_NAME(load)(v + i) + one_minus_beta2 * (grad * grad);
+        SIMD_NAME(store)(m + i, mv);
+        SIMD_NAME(store)(v + i, vv);
+        vreal m_hat = mv * correction1;
+        vreal v_hat = vv * correction2;
+        SIMD_NAME(store)(w + i, SIMD_NAME(load)(w + i) - (lr * m_hat) / (SIMD_SQRT(v_hat) + epsilon));
+    }
+    for (; i < n; i++) {
+        gann_real grad = g[i] * grad_scale;
+        m[i] = beta1 * m[i] + one_minus_beta1 * grad;
+        v[i] = beta2 * v[i] + one_minus_beta2 * (grad * grad);
+        gann_real m_hat = m[i] * correction1;
+        gann_real v_hat = v[i] * correction2;
+        w[i] -= (lr * m_hat) / (REAL_SQRT(v_hat) + epsilon);
+    }
+}
+
+// --- Table ---
+
+static const SimdKernels SIMD_NAME(kernels) = {
+    .level = SIMD_LEVEL,
+    .gemm_mr = SIMD_MR,
+    .gemm_nr = SIMD_NR,
+    .gemm_micro = SIMD_NAME(gemm_micro),
+    .gemm_rows = SIMD_NAME(gemm_rows),
+    .epilogue_row = SIMD_NAME(epilogue_row),
+    .gemm_sparse_row = SIMD_NAME(gemm_sparse_row),
+    .gemm_csr_row = SIMD_NAME(gemm_csr_row),
+    .widen_16 = SIMD_NAME(widen_16),
+    .gemm_row_16 = SIMD_NAME(gemm_row_16),
+    .dot = SIMD_NAME(dot),
+    .add_inplace = SIMD_NAME(add_inplace),
+    .axpy = SIMD_NAME(axpy),
+    .add = SIMD_NAME(add),
+    .sub = SIMD_NAME(sub),
+    .mul = SIMD_NAME(mul),
+    .scale = SIMD_NAME(scale),
+    .activation = SIMD_NAME(activation),
+    .activation_derivative = SIMD_NAME(activation_derivative),
+    .softmax = SIMD_NAME(softmax),
+    .top_k = SIMD_NAME(top_k),
+    .sgd_update = SIMD_NAME(sgd_update),
+    .rmsprop_update = SIMD_NAME(rmsprop_update),
+    .adam_update = SIMD_NAME(adam_update),
+};
+
+#undef SIMD_NV
+#undef vreal
+#undef vint
@@ -0,0 +1,129 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+/**
+ * @file simd_kernels.h
+ * @internal
+ * @brief The table of instruction-set specific kernels used by the library.
+ * @details Private to the library. `lib/simd.c` compiles every kernel once per
+ * instruction set from the template in `lib/simd_impl.h` and selects one table
+ * at load time (see `gann_simd.h`). The kernels perform no argument checking:
+ * callers validate shapes and pointers before dispatching.
+ */
+
+#include <stddef.h>
+#include "gann_simd.h"
+#include "neural_network.h"
+
+/** The largest register tile of any micro-kernel; GEMM block sizes are multiples of these. */
+#define SIMD_MAX_MR 8
+#define SIMD_MAX_NR (2 * 64 / GANN_REAL_SIZE)
+
+/**
+ * @internal
+ * @brief Work a GEMM folds into the write-back of C: `C = f(A * B + bias)`.
+ * @details Applied to each tile of C after its last rank update, while the tile
+ * is still in registers. `bias` and `z` point at the column (and row) of C the
+ * kernel is writing; the GEMM drivers offset them for every tile.
+ *
+ * `SOFTMAX` normalizes whole rows, which a tile never holds, so the kernels
+ * store the biased sums for it and leave the normalization to whoever knows the
+ * row is complete: the gemm.c entry points do it once their product is done
+ * (`gemm_softmax_rows()`), and code that calls a row kernel directly calls
+ * `softmax` after it.
+ */
+typedef struct {
+    const gann_real* bias;     /**< One value per column of C, or NULL for no bias. */
+    gann_real* z;              /**< Receives `A * B + bias` before the activation, or NULL. */
+    int ldz;                   /**< Row stride of `z`. */
+    ActivationType activation; /**< Applied last; `LINEAR` and `SOFTMAX` store the biased sums unchanged. */
+    int fast_sigmoid;          /**< Nonzero to apply `SIGMOID` with the fast approximation (`GANN_SIGMOID_FAST`). */
+} GemmEpilogue;
+
+/**
+ * @internal
+ * @brief One complete set of kernels for a single instruction-set level.
+ */
+typedef struct {
+    GannSimdLevel level; /**< The instruction set these kernels were compiled for. */
+    int gemm_mr;         /**< Rows of the register tile computed by `gemm_micro`. */
+    int gemm_nr;         /**< Columns of the register tile computed by `gemm_micro`. */
+
+    /** C[mr x nr] = A_panel * B_panel + beta * C on packed panels (see gemm.c), then the epilogue `ep` if not NULL. */
+    void (*gemm_micro)(int kc, const gann_real* a, const gann_real* b, gann_real beta, gann_real* c, int ldc, int mr, int nr,
+                       const GemmEpilogue* ep);
+    /** C = A * B + beta * C without packing, for products with very few rows. A is addressed as a[i * rsa + p * csa].
+     *  The epilogue `ep`, if not NULL, is applied to each row of C as soon as it is complete. */
+    void (*gemm_rows)(int m, int n, int k, const gann_real* a, int rsa, int csa, const gann_real* b, int ldb, gann_real beta, gann_real* c, int ldc,
+                      const GemmEpilogue* ep);
+    /** Applies the epilogue `ep` to one row of n finished sums in c. */
+    void (*epilogue_row)(int n, gann_real* c, const GemmEpilogue* ep);
+    /** c[0..n) = sum of a_row[cols[p]] * b[cols[p] * ldb + (0..n)] over p < nnz, then the epilogue `ep` if not NULL. */
+    void (*gemm_sparse_row)(int n, int nnz, const int* cols, const gann_real* a_row, const gann_real* b, int ldb, gann_real* c,
+                            const GemmEpilogue* ep);
+    /** c[0..n) = sum of values[p] * b[cols[p] * ldb + (0..n)] over p < nnz (one CSR row times B), then the epilogue `ep` if not NULL. */
+    void (*gemm_csr_row)(int n, int nnz, const int* cols, const gann_real* values, const gann_real* b, int ldb, gann_real* c,
+                         const GemmEpilogue* ep);
+
+    /** dst[i] = src[i] widened from the 16-bit weight `format` (`NN_STORAGE_FP16` or `NN_STORAGE_BF16`). */
+    void (*widen_16)(size_t n, const uint16_t* src, gann_real* dst, NNWeightStorage format);
+    /** Row product with a 16-bit B: c = f(a_row * B + bias), widening B as it is read (see `gemm_nn_16`). */
+    void (*gemm_row_16)(int n, int k, const gann_real* a_row, const uint16_t* b, int ldb, NNWeightStorage format, gann_real* c,
+                        const GemmEpilogue* ep);
+
+    /** Returns the sum of a[i] * b[i]. */
+    gann_real (*dot)(size_t n, const gann_real* a, const gann_real* b);
+    /** x[i] += y[i] */
+    void (*add_inplace)(size_t n, gann_real* x, const gann_real* y);
+    /** y[i] += alpha * x[i] */
+    void (*axpy)(size_t n, gann_real alpha, const gann_real* x, gann_real* y);
+    /** r[i] = a[i] + b[i] */
+    void (*add)(size_t n, const gann_real* a, const gann_real* b, gann_real* r);
+    /** r[i] = a[i] - b[i] */
+    void (*sub)(size_t n, const gann_real* a, const gann_real* b, gann_real* r);
+    /** r[i] = a[i] * b[i] */
+    void (*mul)(size_t n, const gann_real* a, const gann_real* b, gann_real* r);
+    /** r[i] = a[i] * s */
+    void (*scale)(size_t n, const gann_real* a, gann_real s, gann_real* r);
+
+    /** x[i] = f(x[i]) for the given activation function; `SOFTMAX` normalizes x as one row. */
+    void (*activation)(size_t n, gann_real* x, ActivationType type);
+    /** x[i] = f'(x[i]) for the given activation function; 1 for `SOFTMAX`, whose Jacobian the fused cross-entropy gradient cancels. */
+    void (*activation_derivative)(size_t n, gann_real* x, ActivationType type);
+    /** x = exp(x - max(x)) / sum(exp(x - max(x))): the softmax of one row, which cannot overflow. */
+    void (*softmax)(size_t n, gann_real* x);
+    /** The indices and values of the k (1 <= k <= n) largest of x[0..n), largest first; equal values keep index order. */
+    void (*top_k)(int n, const gann_real* x, int k, int* classes, gann_real* scores);
+
+    /** w[i] -= step * g[i] */
+    void (*sgd_update)(size_t n, gann_real* w, const gann_real* g, gann_real step);
+    /** RMSprop step on n parameters; each gradient is first multiplied by grad_scale. */
+    void (*rmsprop_update)(size_t n, gann_real* w, gann_real* v, const gann_real* g,
+                           gann_real lr, gann_real beta2, gann_real epsilon, gann_real grad_scale);
+    /** Adam step on n parameters; correction1/2 are 1 / (1 - beta^t). */
+    void (*adam_update)(size_t n, gann_real* w, gann_real* m, gann_real* v, const gann_real* g,
+                        gann_real lr, gann_real beta1, gann_real beta2, gann_real epsilon, gann_real grad_scale,
+                        gann_real correction1, gann_real correction2);
+} SimdKernels;
+
+/** @internal The active kernel table; set when the library is loaded. */
+extern const SimdKernels* g_simd_active;
+
+/**
+ * @internal
+ * @brief Nonzero while `GANN_SIGMOID_FAST` is selected.
+ * @details Read by the `activation` kernels on every call. Epilogues carry their
+ * own copy (`GemmEpilogue::fast_sigmoid`), so code that must not see later
+ * changes, such as inference contexts and plans, copies it once.
+ */
+extern int g_simd_fast_sigmoid;
+
+/** @internal Selects the kernel table (once) and returns it. */
+const SimdKernels* simd_init(void);
+
+/** @internal Returns the active kernel table. */
+static inline const SimdKernels* simd_kernels(void) {
+    return g_simd_active ? g_simd_active : simd_init();
+}
+
+#endif // SIMD_KERNELS_H
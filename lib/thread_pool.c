@@ -0,0 +1,158 @@
+#include "thread_pool.h"
+#include "gann_threads.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// --- Pool State ---
+// g_dispatch_lock admits one job at a time; g_state_lock and the two condition
+// variables hand the job to the workers and report their completion.
+
+static pthread_mutex_t g_dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_state_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_work_done = PTHREAD_COND_INITIALIZER;
+
+static atomic_int g_num_threads = 0; // Configured count including the caller; 0 until first queried. Set from any thread.
+static pthread_t g_workers[GANN_MAX_THREADS];
+static int g_num_workers = 0;      // Workers currently running
+static int g_started_for = 0;      // The configured count the running workers were started for
+static int g_shutdown = 0;
+static unsigned long g_generation = 0;
+static unsigned long g_spawn_generation = 0; // g_generation when the current workers were started
+static int g_active_workers = 0;   // Workers still inside the current job
+
+static ThreadPoolTask g_job_fn = NULL;
+static void* g_job_arg = NULL;
+static int g_job_tasks = 0;
+static atomic_int g_next_task;
+
+// Claims and runs tasks of the current job until none are left.
+static void run_tasks(void) {
+    int task;
+    while ((task = atomic_fetch_add(&g_next_task, 1)) < g_job_tasks) {
+        g_job_fn(g_job_arg, task);
+    }
+}
+
+static void* worker_main(void* unused) {
+    (void)unused;
+    pthread_mutex_lock(&g_state_lock);
+    // A worker may first get here after its first job was posted, so it must not
+    // take the current generation as already seen.
+    unsigned long seen = g_spawn_generation;
+    for (;;) {
+        while (!g_shutdown && g_generation == seen) {
+            pthread_cond_wait(&g_work_ready, &g_state_lock);
+        }
+        if (g_shutdown) break;
+        seen = g_generation;
+        pthread_mutex_unlock(&g_state_lock);
+
+        run_tasks();
+
+        pthread_mutex_lock(&g_state_lock);
+        if (--g_active_workers == 0) {
+            pthread_cond_signal(&g_work_done);
+        }
+    }
+    pthread_mutex_unlock(&g_state_lock);
+    return NULL;
+}
+
+// Reads GANN_NUM_THREADS, falling back to the number of online processors.
+static int default_num_threads(void) {
+    const char* value = getenv("GANN_NUM_THREADS");
+    int count = value ? atoi(value) : 0;
+    if (count <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        count = online > 0 ? (int)online : 1;
+    }
+    return count > GANN_MAX_THREADS ? GANN_MAX_THREADS : count;
+}
+
+// Joins every worker. Called with g_dispatch_lock held.
+static void stop_workers(void) {
+    pthread_mutex_lock(&g_state_lock);
+    g_shutdown = 1;
+    pthread_cond_broadcast(&g_work_ready);
+    pthread_mutex_unlock(&g_state_lock);
+    for (int i = 0; i < g_num_workers; i++) {
+        pthread_join(g_workers[i], NULL);
+    }
+    g_num_workers = 0;
+    g_shutdown = 0;
+}
+
+// Starts the workers the configured count asks for. If the system refuses a
+// thread, the pool simply runs with fewer. Called with g_dispatch_lock held.
+static void start_workers(void) {
+    int size = thread_pool_size();
+    g_spawn_generation = g_generation;
+    while (g_num_workers < size - 1) {
+        if (pthread_create(&g_workers[g_num_workers], NULL, worker_main, NULL) != 0) break;
+        g_num_workers++;
+    }
+    g_started_for = size;
+}
+
+// --- Internal API ---
+
+void thread_pool_run(int num_tasks, ThreadPoolTask fn, void* arg) {
+    if (num_tasks <= 0) return;
+    if (num_tasks == 1 || thread_pool_size() == 1 || pthread_mutex_trylock(&g_dispatch_lock) != 0) {
+        for (int t = 0; t < num_tasks; t++) fn(arg, t);
+        return;
+    }
+
+    if (g_started_for != thread_pool_size()) {
+        stop_workers();
+        start_workers();
+    }
+
+    pthread_mutex_lock(&g_state_lock);
+    g_job_fn = fn;
+    g_job_arg = arg;
+    g_job_tasks = num_tasks;
+    atomic_store(&g_next_task, 0);
+    g_active_workers = g_num_workers;
+    g_generation++;
+    pthread_cond_broadcast(&g_work_ready);
+    pthread_mutex_unlock(&g_state_lock);
+
+    run_tasks();
+
+    pthread_mutex_lock(&g_state_lock);
+    while (g_active_workers > 0) {
+        pthread_cond_wait(&g_work_done, &g_state_lock);
+    }
+    pthread_mutex_unlock(&g_state_lock);
+
+    pthread_mutex_unlock(&g_dispatch_lock);
+}
+
+int thread_pool_size(void) {
+    int size = atomic_load(&g_num_threads);
+    if (size == 0) {
+        // A count set by another thread in the meantime wins.
+        int expected = 0;
+        atomic_compare_exchange_strong(&g_num_threads, &expected, default_num_threads());
+        size = atomic_load(&g_num_threads);
+    }
+    return size;
+}
+
+// --- Public API Functions ---
+
+int gann_set_num_threads(int num_threads) {
+    if (num_threads < 1 || num_threads > GANN_MAX_THREADS) {
+        return 0;
+    }
+    atomic_store(&g_num_threads, num_threads);
+    return 1;
+}
+
+int gann_get_num_threads(void) {
+    return thread_pool_size();
+}
@@ -0,0 +1,28 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/**
+ * @file thread_pool.h
+ * @internal
+ * @brief A minimal fork-join pool of persistent worker threads.
+ * @details Private to the library. One job at a time is spread over the
+ * workers and the calling thread; the call returns once every task of the job
+ * has finished. The workers are started on first use and sleep between jobs.
+ */
+
+/** @internal A unit of work: runs task number `task` of a job. */
+typedef void (*ThreadPoolTask)(void* arg, int task);
+
+/**
+ * @internal
+ * @brief Runs `fn(arg, t)` for every `t` in `[0, num_tasks)` and waits for all of them.
+ * @details Tasks may run in any order and on any thread, including the caller.
+ * When the pool is busy with a job submitted from another thread, or has no
+ * workers, all tasks run on the calling thread instead.
+ */
+void thread_pool_run(int num_tasks, ThreadPoolTask fn, void* arg);
+
+/** @internal Returns the configured thread count, including the calling thread. */
+int thread_pool_size(void);
+
+#endif // THREAD_POOL_H
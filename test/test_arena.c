@@ -0,0 +1,147 @@
+#include "minunit.h"
+#include "gann.h"
+#include "gann_arena.h"
+#include "data_loader.h"
+#include "backpropagation.h"
+#include <stdint.h>
+#include <string.h>
+
+const char* test_arena_alloc_and_reset() {
+    GannArena* arena = gann_arena_create(1024);
+    mu_assert("Failed to create arena", arena != NULL);
+
+    // Every allocation is aligned, even after an odd-sized one.
+    unsigned char* a = (unsigned char*)gann_arena_alloc(arena, 3);
+    unsigned char* b = (unsigned char*)gann_arena_alloc(arena, 100);
+    mu_assert("Arena allocation failed", a != NULL && b != NULL);
+    mu_assert("Arena allocation is not aligned", ((uintptr_t)a % MATRIX_ALIGNMENT) == 0 && ((uintptr_t)b % MATRIX_ALIGNMENT) == 0);
+    mu_assert("Arena allocations overlap", b >= a + 3);
+
+    // Resetting to a mark hands the same memory out again.
+    size_t mark = gann_arena_mark(arena);
+    void* c = gann_arena_alloc(arena, 64);
+    gann_arena_reset_to(arena, mark);
+    mu_assert("reset_to did not rewind the arena", gann_arena_mark(arena) == mark);
+    mu_assert("reset_to did not reuse the memory", gann_arena_alloc(arena, 64) == c);
+
+    // Arena matrices are zeroed, aligned and usable like heap matrices.
+    size_t before = matrix_get_allocation_count();
+    Matrix* m = gann_arena_create_matrix(arena, 3, 5);
+    mu_assert("gann_arena_create_matrix failed", m != NULL && m->rows == 3 && m->cols == 5);
+    mu_assert("Arena matrix is not aligned", ((uintptr_t)m->values % MATRIX_ALIGNMENT) == 0);
+    mu_assert("Arena matrix rows are not contiguous", m->data[2] == m->values + 2 * m->stride);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 5; j++) {
+            mu_assert("Arena matrix is not zeroed", m->data[i][j] == 0.0);
+        }
+    }
+    mu_assert("Arena matrices count as heap allocations", matrix_get_allocation_count() == before);
+
+    GannArenaStats stats;
+    gann_arena_get_stats(arena, &stats);
+    mu_assert("used does not match the mark", stats.used == gann_arena_mark(arena));
+    mu_assert("high_water is below used", stats.high_water >= stats.used);
+    mu_assert("The arena allocated more than its first chunk", stats.chunk_allocations == 1);
+
+    gann_arena_reset(arena);
+    mu_assert("reset did not empty the arena", gann_arena_mark(arena) == 0);
+    gann_arena_free(arena);
+
+    mu_assert("alloc on NULL should fail", gann_arena_alloc(NULL, 8) == NULL);
+    mu_assert("Wrong error code for NULL arena", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    gann_arena_free(NULL);
+    return NULL;
+}
+
+const char* test_arena_growth() {
+    GannArena* arena = gann_arena_create(256);
+    mu_assert("Failed to create arena", arena != NULL);
+
+    // Overflowing the first chunk chains new ones instead of failing, and the
+    // earlier allocations stay intact.
+    unsigned char* first = (unsigned char*)gann_arena_alloc(arena, 200);
+    mu_assert("First allocation failed", first != NULL);
+    memset(first, 0xAB, 200);
+    for (int i = 0; i < 10; i++) {
+        mu_assert("Overflowing allocation failed", gann_arena_alloc(arena, 1000) != NULL);
+    }
+    mu_assert("Earlier allocation was clobbered", first[0] == 0xAB && first[199] == 0xAB);
+
+    GannArenaStats stats;
+    gann_arena_get_stats(arena, &stats);
+    mu_assert("Overflow did not chain chunks", stats.chunk_allocations > 1);
+    size_t high_water = stats.high_water;
+
+    // A full reset merges the chunks into one block that fits the whole
+    // workload, so running it again does not allocate.
+    gann_arena_reset(arena);
+    gann_arena_get_stats(arena, &stats);
+    mu_assert("Reset did not consolidate the chunks", stats.capacity >= high_water);
+    size_t allocations = stats.chunk_allocations;
+    gann_arena_alloc(arena, 200);
+    for (int i = 0; i < 10; i++) {
+        gann_arena_alloc(arena, 1000);
+    }
+    gann_arena_reset(arena);
+    gann_arena_get_stats(arena, &stats);
+    mu_assert("A repeated workload allocated again", stats.chunk_allocations == allocations);
+    mu_assert("High-water mark changed on the same workload", stats.high_water == high_water);
+
+    // Reserving sizes an empty arena up front; an arena in use cannot be reserved.
+    mu_assert("gann_arena_reserve failed", gann_arena_reserve(arena, 1 << 20));
+    gann_arena_get_stats(arena, &stats);
+    mu_assert("gann_arena_reserve did not grow the arena", stats.capacity >= (1 << 20));
+    gann_arena_alloc(arena, 8);
+    mu_assert("gann_arena_reserve accepted an arena in use", !gann_arena_reserve(arena, 1 << 21));
+    mu_assert("Wrong error code for reserving an arena in use", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+
+    gann_arena_free(arena);
+    return NULL;
+}
+
+const char* test_scratch_arena_steady_state() {
+    gann_seed_rng(777);
+    Dataset* dataset = create_dummy_dataset(32);
+    mu_assert("Failed to create dummy dataset", dataset != NULL);
+    const int ARCHITECTURE[] = {dataset->images->cols, 16, 8, dataset->labels->cols};
+    NeuralNetwork* net = nn_create(4, ARCHITECTURE, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+
+    GannArena* scratch = gann_scratch_arena();
+    mu_assert("No scratch arena", scratch != NULL);
+    mu_assert("Scratch arena is per thread, not per call", gann_scratch_arena() == scratch);
+
+    GannBackpropParams params = {
+        .learning_rate = 0.01,
+        .epochs = 1,
+        .batch_size = 4,
+        .optimizer_type = SGD,
+        .logging = false
+    };
+    // Warm-up: lets the scratch arena reach its high-water size.
+    backpropagate(net, dataset, &params, NULL);
+    gann_evaluate(net, dataset);
+    calculate_mse(net, dataset);
+
+    GannArenaStats stats;
+    gann_arena_get_stats(scratch, &stats);
+    mu_assert("Library calls left scratch memory allocated", stats.used == 0);
+    size_t chunk_allocations = stats.chunk_allocations;
+    size_t matrix_allocations = matrix_get_allocation_count();
+
+    params.epochs = 3;
+    backpropagate(net, dataset, &params, NULL);
+    gann_evaluate(net, dataset);
+    calculate_mse(net, dataset);
+    gann_predict(net, dataset->images->data[0]);
+
+    gann_arena_get_stats(scratch, &stats);
+    mu_assert("Warm training or inference grew the scratch arena", stats.chunk_allocations == chunk_allocations);
+    mu_assert("Warm training or inference allocated heap matrices", matrix_get_allocation_count() == matrix_allocations);
+    mu_assert("Library calls left scratch memory allocated", stats.used == 0);
+
+    nn_free(net);
+    free_dataset(dataset);
+    return NULL;
+}
@@ -2,10 +2,13 @@
 #include "gann.h"
 #include "data_loader.h"
 #include "backpropagation.h"
+#include "gann_simd.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 extern const double TEST_EPSILON;
+int mnist_available(const char* test_name);
 
 const char* test_calculate_mse() {
     // 1. Setup
@@ -72,8 +75,11 @@ const char* test_backprop_early_stopping() {
         .early_stopping_threshold = 0.01
     };
 
-    // 3. Create and train the network
+    // 3. Create and train the network. Whether one epoch fits the training set
+    // depends on the initial weights, so they are drawn from a fixed seed of
+    // their own, whatever the dataset helpers took from rand().
     NeuralNetwork* net = nn_create(params.num_layers, params.architecture, params.activation_hidden, params.activation_output);
+    gann_seed_rng(12345);
     nn_init(net);
     nn_init_optimizer_state(net);
 
@@ -243,3 +249,241 @@ const char* test_backprop_overfit_single_instance_rmsprop() {
 
     return NULL;
 }
+
+// Test that the hot loops built on the `_into` API allocate nothing per sample once warmed up
+const char* test_into_api_zero_allocations() {
+    gann_seed_rng(4242);
+    Dataset* small = create_dummy_dataset(8);
+    Dataset* large = create_dummy_dataset(64);
+    mu_assert("Failed to create dummy datasets", small != NULL && large != NULL);
+
+    const int ARCHITECTURE[] = {small->images->cols, 16, 8, small->labels->cols};
+    NeuralNetwork* net = nn_create(4, ARCHITECTURE, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+
+    // Forward pass: after one warm-up pass, reusing the buffers allocates nothing.
+    Matrix* input = create_matrix(1, large->images->cols);
+    Matrix** layer_outputs = nn_create_layer_buffers(net, 1);
+    mu_assert("Failed to create layer buffers", input != NULL && layer_outputs != NULL);
+    mu_assert("Warm-up forward pass failed", nn_forward_pass_into(net, input, layer_outputs));
+    size_t before = matrix_get_allocation_count();
+    for (int i = 0; i < large->num_items; i++) {
+        mu_assert("matrix_get_row_into failed", matrix_get_row_into(input, large->images, i));
+        mu_assert("nn_forward_pass_into failed", nn_forward_pass_into(net, input, layer_outputs));
+    }
+    mu_assert("nn_forward_pass_into allocated matrices", matrix_get_allocation_count() == before);
+
+    Matrix* expected = nn_forward_pass(net, input);
+    const Matrix* output = layer_outputs[net->num_layers - 2];
+    for (int j = 0; j < output->cols; j++) {
+        mu_assert("nn_forward_pass_into disagrees with nn_forward_pass", fabs(output->data[0][j] - expected->data[0][j]) < TEST_EPSILON);
+    }
+    free_matrix(expected);
+
+    // calculate_mse and backpropagate allocate a fixed set of buffers per call,
+    // so an 8x larger dataset must not allocate a single extra matrix.
+    before = matrix_get_allocation_count();
+    calculate_mse(net, small);
+    size_t small_count = matrix_get_allocation_count() - before;
+    before = matrix_get_allocation_count();
+    calculate_mse(net, large);
+    mu_assert("calculate_mse allocates per sample", matrix_get_allocation_count() - before == small_count);
+
+    GannBackpropParams params = {
+        .learning_rate = 0.01,
+        .epochs = 1,
+        .batch_size = 4,
+        .optimizer_type = SGD,
+        .logging = false
+    };
+    before = matrix_get_allocation_count();
+    backpropagate(net, small, &params, NULL);
+    small_count = matrix_get_allocation_count() - before;
+    before = matrix_get_allocation_count();
+    backpropagate(net, large, &params, NULL);
+    mu_assert("backpropagate allocates per sample or per batch", matrix_get_allocation_count() - before == small_count);
+
+    free_matrix(input);
+    nn_free_layer_buffers(layer_outputs, net->num_layers);
+    nn_free(net);
+    free_dataset(small);
+    free_dataset(large);
+    return NULL;
+}
+
+// The fast sigmoid must not change what a trained network predicts on MNIST.
+const char* test_fast_sigmoid_mnist_accuracy() {
+    if (!mnist_available(__func__)) return NULL;
+    Dataset* train = load_mnist_dataset("data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte");
+    Dataset* test = load_mnist_dataset("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte");
+    mu_assert("Failed to load MNIST", train != NULL && test != NULL);
+
+    const int ARCHITECTURE[] = {MNIST_IMAGE_SIZE, 64, MNIST_NUM_CLASSES};
+    GannBackpropParams params = {
+        .architecture = ARCHITECTURE,
+        .num_layers = 3,
+        .learning_rate = 0.001,
+        .epochs = 1,
+        .batch_size = 32,
+        .activation_hidden = SIGMOID,
+        .activation_output = SIGMOID,
+        .optimizer_type = ADAM,
+        .beta1 = 0.9,
+        .beta2 = 0.999,
+        .epsilon = 1e-8,
+        .logging = false
+    };
+
+    gann_seed_rng(2024);
+    NeuralNetwork* net = gann_train_with_backprop(&params, train, NULL);
+    mu_assert("Training with the exact sigmoid failed", net != NULL);
+    double exact_accuracy = gann_evaluate(net, test);
+    mu_assert("Failed to select the fast sigmoid", gann_simd_set_sigmoid_mode(GANN_SIGMOID_FAST));
+    double fast_accuracy = gann_evaluate(net, test);
+    mu_assert("Network did not learn MNIST", exact_accuracy > 0.85);
+    // At most 10 of the 10000 test images may change class.
+    mu_assert("Fast sigmoid changed inference accuracy", fabs(fast_accuracy - exact_accuracy) <= 0.001);
+
+    // Training with the fast sigmoid reaches the same accuracy.
+    gann_seed_rng(2024);
+    NeuralNetwork* fast_net = gann_train_with_backprop(&params, train, NULL);
+    gann_simd_set_sigmoid_mode(GANN_SIGMOID_EXACT);
+    mu_assert("Training with the fast sigmoid failed", fast_net != NULL);
+    double fast_trained_accuracy = gann_evaluate(fast_net, test);
+    mu_assert("Fast sigmoid changed training accuracy", fabs(fast_trained_accuracy - exact_accuracy) <= 0.01);
+
+    nn_free(net);
+    nn_free(fast_net);
+    free_dataset(train);
+    free_dataset(test);
+    return NULL;
+}
+
+// Training, evaluation and the MSE skip zero pixels in the first layer; they
+// must agree with a copy of the dataset whose zeros are replaced by a
+// negligible value, which keeps every image on the dense kernels.
+const char* test_backprop_skips_zero_pixels() {
+    gann_seed_rng(2024);
+    Dataset* dataset = create_dummy_dataset(48);
+    Dataset* dense = create_dummy_dataset(48);
+    mu_assert("Failed to create dummy datasets", dataset != NULL && dense != NULL);
+    // Zero about 80% of the pixels so the sparse path runs; one image stays dense.
+    for (int i = 0; i < dataset->num_items; i++) {
+        for (int j = 0; j < dataset->images->cols; j++) {
+            if (i > 0 && (i + j) % 5 != 0) dataset->images->data[i][j] = 0.0;
+            gann_real pixel = dataset->images->data[i][j];
+            dense->images->data[i][j] = pixel != 0.0 ? pixel : (gann_real)1e-30;
+        }
+    }
+    matrix_copy_data(dense->labels, dataset->labels);
+
+    const int architecture[] = {dataset->images->cols, 16, 8, dataset->labels->cols};
+    GannBackpropParams params = {
+        .learning_rate = 0.05, .epochs = 2, .batch_size = 8, .optimizer_type = ADAM, .logging = false
+    };
+    NeuralNetwork* nets[2];
+    for (int sparse = 1; sparse >= 0; sparse--) {
+        gann_seed_rng(99);
+        nets[sparse] = nn_create(4, architecture, RELU, SIGMOID);
+        mu_assert("Failed to create network", nets[sparse] != NULL);
+        nn_init(nets[sparse]);
+        backpropagate(nets[sparse], sparse ? dataset : dense, &params, NULL);
+    }
+    for (int l = 0; l < nets[0]->num_layers - 1; l++) {
+        for (int r = 0; r < nets[0]->weights[l]->rows; r++) {
+            for (int c = 0; c < nets[0]->weights[l]->cols; c++) {
+                mu_assert("Skipping zero pixels changed the trained weights", fabs(nets[0]->weights[l]->data[r][c] - nets[1]->weights[l]->data[r][c]) < TEST_EPSILON);
+            }
+        }
+    }
+
+    mu_assert("Skipping zero pixels changed the MSE", fabs(calculate_mse(nets[1], dataset) - calculate_mse(nets[1], dense)) < TEST_EPSILON);
+    mu_assert("Skipping zero pixels changed the accuracy", gann_evaluate(nets[1], dataset) == gann_evaluate(nets[1], dense));
+
+    nn_free(nets[0]);
+    nn_free(nets[1]);
+    free_dataset(dense);
+    free_dataset(dataset);
+    return NULL;
+}
+
+// Backpropagation through a softmax output layer minimizes the cross-entropy,
+// which calculate_cross_entropy reports.
+const char* test_softmax_cross_entropy() {
+    gann_seed_rng(24);
+    Dataset* dataset = create_dummy_dataset(32);
+    mu_assert("Failed to create dummy dataset", dataset != NULL);
+    const int architecture[] = {MNIST_IMAGE_SIZE, 32, MNIST_NUM_CLASSES};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SOFTMAX);
+    mu_assert("Failed to create network", net != NULL);
+
+    // With every parameter zero, each of the ten outputs is 0.1
+    size_t count = 0;
+    gann_real* parameters = nn_get_parameters(net, &count);
+    memset(parameters, 0, count * sizeof(gann_real));
+    mu_assert("Uniform outputs should cost log(10)", fabs(calculate_cross_entropy(net, dataset) - log(10.0)) < TEST_EPSILON);
+    mu_assert("Uniform outputs have the wrong MSE", fabs(calculate_mse(net, dataset) - (0.81 + 9 * 0.01) / 10) < TEST_EPSILON);
+
+    nn_init(net);
+    nn_init_optimizer_state(net);
+    double initial_loss = calculate_cross_entropy(net, dataset);
+    GannBackpropParams params = {
+        .learning_rate = 0.01, .epochs = 30, .batch_size = 8, .optimizer_type = ADAM,
+        .beta1 = 0.9, .beta2 = 0.999, .epsilon = 1e-8, .logging = false
+    };
+    backpropagate(net, dataset, &params, NULL);
+    double final_loss = calculate_cross_entropy(net, dataset);
+    mu_assert("Training should reduce the cross-entropy", final_loss < 0.25 * initial_loss);
+    mu_assert("The network should fit most of its training set", gann_evaluate(net, dataset) > 0.8);
+
+    mu_assert("calculate_cross_entropy should reject NULL", calculate_cross_entropy(NULL, dataset) == -1.0);
+
+    nn_free(net);
+    free_dataset(dataset);
+    return NULL;
+}
+
+// The per-sample passes run unchecked, so a dataset that does not fit the
+// network must be turned away by every entry point before any sample runs.
+const char* test_dataset_checked_at_boundary() {
+    Dataset* dataset = create_dummy_dataset(8);
+    mu_assert("Failed to create dummy dataset", dataset != NULL);
+    const int architecture[] = {dataset->images->cols, 6, dataset->labels->cols - 1};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    NeuralNetwork* before = nn_clone(net);
+
+    GannBackpropParams params = { .learning_rate = 0.1, .epochs = 1, .batch_size = 4, .optimizer_type = SGD, .logging = false };
+    backpropagate(net, dataset, &params, NULL);
+    mu_assert("backpropagate accepted labels of the wrong width", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    for (int l = 0; l < net->num_layers - 1; l++) {
+        mu_assert("A rejected dataset changed the weights",
+                  memcmp(net->weights[l]->values, before->weights[l]->values,
+                         (size_t)net->weights[l]->rows * net->weights[l]->cols * sizeof(gann_real)) == 0);
+    }
+    params.batch_size = 0;
+    backpropagate(net, dataset, &params, NULL);
+    mu_assert("backpropagate accepted a zero batch size", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+
+    mu_assert("calculate_mse accepted labels of the wrong width", calculate_mse(net, dataset) < 0.0);
+    mu_assert("gann_evaluate accepted labels of the wrong width", gann_evaluate(net, dataset) == 0.0);
+    mu_assert("Wrong error code from gann_evaluate", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+
+    GannTrainParams train_params = {
+        .architecture = architecture, .num_layers = 3, .population_size = 4, .num_generations = 1,
+        .mutation_rate = 0.1f, .mutation_chance = 0.1f, .activation_hidden = RELU, .activation_output = SIGMOID
+    };
+    mu_assert("gann_train accepted labels of the wrong width", gann_train(&train_params, dataset, NULL) == NULL);
+    mu_assert("Wrong error code from gann_train", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+
+    // The network itself is fine: a prediction succeeds and clears the error.
+    mu_assert("gann_predict failed", gann_predict(net, dataset->images->data[0]) >= 0);
+    mu_assert("gann_predict did not report success", gann_get_last_error() == GANN_SUCCESS);
+
+    nn_free(before);
+    nn_free(net);
+    free_dataset(dataset);
+    return NULL;
+}
@@ -1,6 +1,7 @@
 #include "minunit.h"
 #include "evolution.h"
 #include "crossover.h"
+#include "mutation.h"
 #include <math.h>
 #include <stdlib.h>
 
@@ -172,3 +173,40 @@ const char* test_two_point_crossover() {
 
     return NULL;
 }
+
+// A 16-bit population stays 16-bit through crossover and mutation.
+const char* test_half_population() {
+    int architecture[] = {20, 8, 4};
+    srand(7);
+    NeuralNetwork** population = evo_create_initial_population_with_storage(4, 3, architecture, RELU, SIGMOID, NN_STORAGE_BF16);
+    mu_assert("Failed to create population", population != NULL);
+    for (int i = 0; i < 4; i++) {
+        mu_assert("Population network is not bf16", population[i]->weight_storage == NN_STORAGE_BF16 && population[i]->weights == NULL);
+    }
+
+    NeuralNetwork* child = crossover(population[0], population[1], UNIFORM_CROSSOVER);
+    mu_assert("Crossover failed", child != NULL);
+    mu_assert("Child lost the parents' storage", child->weight_storage == NN_STORAGE_BF16 && child->weights == NULL);
+    for (int r = 0; r < 20; r++) {
+        for (int c = 0; c < 8; c++) {
+            gann_real w = nn_get_weight(child, 0, r, c);
+            mu_assert("Child weight comes from neither parent",
+                      w == nn_get_weight(population[0], 0, r, c) || w == nn_get_weight(population[1], 0, r, c));
+        }
+    }
+
+    NeuralNetwork* before = nn_clone(child);
+    mutate_network(child, 0.5f, 1.0f, GAUSSIAN_MUTATION, 0.5, 0, 0, 0);
+    int changed = 0;
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 4; c++) changed += nn_get_weight(child, 1, r, c) != nn_get_weight(before, 1, r, c);
+    }
+    mu_assert("Mutation did not change the 16-bit weights", changed > 0);
+    mu_assert("Mutation changed the storage", child->weight_storage == NN_STORAGE_BF16);
+
+    nn_free(before);
+    nn_free(child);
+    for (int i = 0; i < 4; i++) nn_free(population[i]);
+    free(population);
+    return NULL;
+}
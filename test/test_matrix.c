@@ -1,12 +1,25 @@
 #include "minunit.h"
 #include "neural_network.h"
 #include "gann_errors.h"
+#include "gann_simd.h"
+#include "gann_threads.h"
+#include "gann_backend.h"
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdint.h>
 
 extern const double TEST_EPSILON;
+int heap_bytes_in_use(size_t* bytes);
+
+// Agreement expected between two kernels that sum the same products in a different order.
+#ifdef GANN_FLOAT32
+#define KERNEL_TOLERANCE 1e-4
+#else
+#define KERNEL_TOLERANCE 1e-9
+#endif
 
 // Test for matrix creation
 const char* test_matrix_creation() {
@@ -26,6 +39,29 @@ const char* test_matrix_creation() {
     return NULL;
 }
 
+// Test that a matrix is backed by one aligned, row-major buffer
+const char* test_matrix_contiguous_storage() {
+    Matrix* m = create_matrix(5, 7);
+    mu_assert("Matrix creation failed to allocate", m != NULL);
+    mu_assert("Dense matrix stride should equal cols", m->stride == 7);
+    mu_assert("Dense matrix should report contiguous", matrix_is_contiguous(m));
+    mu_assert("Element buffer is not aligned", ((uintptr_t)m->values % MATRIX_ALIGNMENT) == 0);
+    for (int i = 0; i < m->rows; i++) {
+        mu_assert("Row pointer does not point into the element buffer", m->data[i] == m->values + i * m->stride);
+    }
+
+    m->data[3][4] = 42.0;
+    mu_assert("data[i][j] and values disagree", m->values[3 * 7 + 4] == 42.0);
+
+    Matrix* copy = matrix_copy(m);
+    mu_assert("matrix_copy failed", copy != NULL);
+    mu_assert("matrix_copy lost data", copy->data[3][4] == 42.0);
+
+    free_matrix(m);
+    free_matrix(copy);
+    return NULL;
+}
+
 // Test for matrix dot product
 const char* test_matrix_dot_product() {
     Matrix* m1 = create_matrix(2, 3);
@@ -58,6 +94,630 @@ const char* test_matrix_dot_product() {
     return NULL;
 }
 
+// Test the blocked GEMM path against a reference triple loop on shapes that
+// exercise partial register tiles and more than one KC block.
+const char* test_matrix_dot_product_blocked() {
+    const int shapes[][3] = { {1, 300, 29}, {3, 17, 5}, {37, 300, 29}, {130, 64, 10} };
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        int m = shapes[s][0], k = shapes[s][1], n = shapes[s][2];
+        Matrix* a = create_matrix(m, k);
+        Matrix* b = create_matrix(k, n);
+        for (int i = 0; i < m; i++) for (int p = 0; p < k; p++) a->data[i][p] = (double)((i * 7 + p * 3) % 11) - 5.0;
+        for (int p = 0; p < k; p++) for (int j = 0; j < n; j++) b->data[p][j] = (double)((p * 5 + j) % 13) / 4.0 - 1.5;
+
+        Matrix* result = dot_product(a, b);
+        mu_assert("Blocked dot product failed", result != NULL);
+        mu_assert("Blocked dot product has wrong shape", result->rows == m && result->cols == n);
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                double expected = 0.0;
+                for (int p = 0; p < k; p++) expected += a->data[i][p] * b->data[p][j];
+                mu_assert("Blocked dot product value mismatch", fabs(result->data[i][j] - expected) < KERNEL_TOLERANCE);
+            }
+        }
+        free_matrix(a);
+        free_matrix(b);
+        free_matrix(result);
+    }
+    return NULL;
+}
+
+// Returns 1 if two matrices have the same shape and agree element-wise within KERNEL_TOLERANCE
+static int matrices_close(const Matrix* x, const Matrix* y) {
+    if (x == NULL || y == NULL || x->rows != y->rows || x->cols != y->cols) return 0;
+    for (int i = 0; i < x->rows; i++) {
+        for (int j = 0; j < x->cols; j++) {
+            if (fabs(x->data[i][j] - y->data[i][j]) >= KERNEL_TOLERANCE) return 0;
+        }
+    }
+    return 1;
+}
+
+// Test the transpose-free products against an explicit transpose followed by dot_product,
+// on shapes that take both the unpacked and the blocked paths.
+const char* test_matrix_dot_product_transposed() {
+    const int shapes[][3] = { {1, 300, 29}, {37, 1, 29}, {37, 300, 29}, {130, 64, 10} };
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        int m = shapes[s][0], k = shapes[s][1], n = shapes[s][2];
+        Matrix* a = create_matrix(k, m);   // used as a^T (m x k)
+        Matrix* b = create_matrix(k, n);
+        Matrix* w = create_matrix(n, k);   // used as w^T (k x n)
+        for (int p = 0; p < k; p++) for (int i = 0; i < m; i++) a->data[p][i] = (double)((i * 7 + p * 3) % 11) - 5.0;
+        for (int p = 0; p < k; p++) for (int j = 0; j < n; j++) b->data[p][j] = (double)((p * 5 + j) % 13) / 4.0 - 1.5;
+        for (int j = 0; j < n; j++) for (int p = 0; p < k; p++) w->data[j][p] = (double)((p + j * 3) % 7) / 2.0 - 1.0;
+
+        Matrix* a_t = matrix_transpose(a);
+        Matrix* w_t = matrix_transpose(w);
+        Matrix* expected_tn = dot_product(a_t, b);
+        Matrix* expected_nt = dot_product(a_t, w_t);
+
+        Matrix* tn = dot_product_tn(a, b);
+        mu_assert("dot_product_tn does not match transpose + dot_product", matrices_close(tn, expected_tn));
+        Matrix* nt = dot_product_nt(a_t, w);
+        mu_assert("dot_product_nt does not match dot_product with a transposed copy", matrices_close(nt, expected_nt));
+
+        // Accumulating twice into a copy of the product gives three times the product.
+        Matrix* acc = matrix_copy(expected_tn);
+        dot_product_tn_accumulate(acc, a, b);
+        mu_assert("dot_product_tn_accumulate should succeed", gann_get_last_error() == GANN_SUCCESS);
+        dot_product_tn_accumulate(acc, a, b);
+        Matrix* expected_acc = matrix_scale(expected_tn, 3.0);
+        mu_assert("dot_product_tn_accumulate does not add to the destination", matrices_close(acc, expected_acc));
+
+        free_matrix(a); free_matrix(b); free_matrix(w);
+        free_matrix(a_t); free_matrix(w_t);
+        free_matrix(expected_tn); free_matrix(expected_nt); free_matrix(expected_acc);
+        free_matrix(tn); free_matrix(nt); free_matrix(acc);
+    }
+
+    Matrix* x = create_matrix(3, 4);
+    Matrix* y = create_matrix(2, 4);
+    Matrix* c = create_matrix(4, 4);
+    mu_assert("dot_product_tn should reject mismatched row counts", dot_product_tn(x, y) == NULL);
+    mu_assert("dot_product_tn should set GANN_ERROR_INVALID_DIMENSIONS", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    dot_product_tn_accumulate(c, x, y);
+    mu_assert("dot_product_tn_accumulate should set GANN_ERROR_INVALID_DIMENSIONS", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    mu_assert("dot_product_nt should reject NULL", dot_product_nt(NULL, y) == NULL);
+    mu_assert("dot_product_nt should set GANN_ERROR_NULL_ARGUMENT", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    free_matrix(x); free_matrix(y); free_matrix(c);
+    return NULL;
+}
+
+// Test that the destination-passing API matches the allocating API, supports
+// in-place use and reports shape errors without allocating
+const char* test_matrix_into_operations() {
+    Matrix* a = create_matrix(3, 5);
+    Matrix* b = create_matrix(3, 5);
+    Matrix* w = create_matrix(5, 4);
+    for (int i = 0; i < 3; i++) for (int j = 0; j < 5; j++) { a->data[i][j] = i - j * 0.5; b->data[i][j] = (i + 1) * 0.25 + j; }
+    for (int i = 0; i < 5; i++) for (int j = 0; j < 4; j++) w->data[i][j] = (i * 4 + j) % 7 - 3.0;
+
+    Matrix* dest = create_matrix(3, 5);
+    Matrix* prod = create_matrix(3, 4);
+    size_t before = matrix_get_allocation_count();
+
+    Matrix* expected = dot_product(a, w);
+    mu_assert("dot_product_into failed", dot_product_into(prod, a, w));
+    mu_assert("dot_product_into does not match dot_product", matrices_close(prod, expected));
+    free_matrix(expected);
+
+    expected = matrix_add(a, b);
+    mu_assert("matrix_add_into failed", matrix_add_into(dest, a, b));
+    mu_assert("matrix_add_into does not match matrix_add", matrices_close(dest, expected));
+    free_matrix(expected);
+
+    expected = matrix_subtract(a, b);
+    mu_assert("matrix_subtract_into failed", matrix_subtract_into(dest, a, b));
+    mu_assert("matrix_subtract_into does not match matrix_subtract", matrices_close(dest, expected));
+    free_matrix(expected);
+
+    expected = matrix_elementwise_multiply(a, b);
+    mu_assert("matrix_elementwise_multiply_into failed", matrix_elementwise_multiply_into(dest, a, b));
+    mu_assert("matrix_elementwise_multiply_into does not match", matrices_close(dest, expected));
+    // In place: dest = a, then dest *= b
+    mu_assert("matrix_copy_into failed", matrix_copy_into(dest, a));
+    mu_assert("matrix_elementwise_multiply_inplace failed", matrix_elementwise_multiply_inplace(dest, b));
+    mu_assert("matrix_elementwise_multiply_inplace does not match", matrices_close(dest, expected));
+    free_matrix(expected);
+
+    expected = matrix_scale(a, -2.5);
+    matrix_copy_into(dest, a);
+    mu_assert("matrix_scale_inplace failed", matrix_scale_inplace(dest, -2.5));
+    mu_assert("matrix_scale_inplace does not match matrix_scale", matrices_close(dest, expected));
+    free_matrix(expected);
+
+    Matrix* row = create_matrix(1, 5);
+    mu_assert("matrix_get_row_into failed", matrix_get_row_into(row, b, 2));
+    for (int j = 0; j < 5; j++) mu_assert("matrix_get_row_into copied the wrong row", row->data[0][j] == b->data[2][j]);
+
+    size_t allocated = matrix_get_allocation_count() - before;
+    mu_assert("Only the allocating reference calls and the row buffer should allocate", allocated == 6);
+
+    // Error handling
+    mu_assert("dot_product_into should reject a destination of the wrong shape", !dot_product_into(dest, a, w));
+    mu_assert("dot_product_into should set GANN_ERROR_INVALID_DIMENSIONS", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    Matrix* square = create_matrix(5, 5);
+    mu_assert("dot_product_into should reject a destination that aliases an operand", !dot_product_into(square, square, square));
+    mu_assert("dot_product_into should set GANN_ERROR_INVALID_PARAM for aliasing", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    free_matrix(square);
+    mu_assert("matrix_add_into should reject NULL", !matrix_add_into(NULL, a, b));
+    mu_assert("matrix_add_into should set GANN_ERROR_NULL_ARGUMENT", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("matrix_get_row_into should reject an out-of-range row", !matrix_get_row_into(row, b, 3));
+    mu_assert("matrix_get_row_into should set GANN_ERROR_INDEX_OUT_OF_BOUNDS", gann_get_last_error() == GANN_ERROR_INDEX_OUT_OF_BOUNDS);
+
+    free_matrix(a); free_matrix(b); free_matrix(w);
+    free_matrix(dest); free_matrix(prod); free_matrix(row);
+    return NULL;
+}
+
+// Test that views address rows, row ranges and sub-blocks in place and that the
+// view kernels match the same operations on copies
+const char* test_matrix_views() {
+    Matrix* m = create_matrix(6, 8);
+    for (int i = 0; i < 6; i++) for (int j = 0; j < 8; j++) m->data[i][j] = i * 10 + j;
+
+    MatrixView whole = matrix_view(m);
+    mu_assert("Whole view has the wrong shape", whole.rows == 6 && whole.cols == 8 && whole.stride == 8 && whole.values == m->values);
+    MatrixView row = matrix_view_row(m, 4);
+    mu_assert("Row view should point into the matrix", row.values == m->data[4] && row.rows == 1 && row.cols == 8);
+    MatrixView rows = matrix_view_rows(m, 2, 3);
+    mu_assert("Row range view has the wrong shape", rows.values == m->data[2] && rows.rows == 3 && rows.cols == 8);
+    MatrixView block = matrix_view_block(m, 1, 2, 4, 3);
+    mu_assert("Block view has the wrong shape", block.rows == 4 && block.cols == 3 && block.stride == 8);
+    mu_assert("Block view starts at the wrong element", block.values[0] == 12.0 && block.values[2 * block.stride + 1] == 33.0);
+
+    // Out-of-range requests produce empty views that the kernels reject.
+    MatrixView bad = matrix_view_block(m, 3, 0, 4, 8);
+    mu_assert("Out-of-range block should be empty", bad.values == NULL);
+    mu_assert("Out-of-range block should set GANN_ERROR_INDEX_OUT_OF_BOUNDS", gann_get_last_error() == GANN_ERROR_INDEX_OUT_OF_BOUNDS);
+    mu_assert("Negative row should give an empty view", matrix_view_row(m, -1).values == NULL);
+
+    // A product on a strided block equals the product on a dense copy of it.
+    Matrix* block_copy = create_matrix(4, 3);
+    mu_assert("matrix_copy_view_into failed", matrix_copy_view_into(block_copy, block));
+    mu_assert("matrix_copy_view_into copied the wrong elements", block_copy->data[3][2] == 44.0);
+    Matrix* w = create_matrix(3, 5);
+    for (int i = 0; i < 3; i++) for (int j = 0; j < 5; j++) w->data[i][j] = (i + 2 * j) % 5 - 2.0;
+    Matrix* expected = dot_product(block_copy, w);
+    Matrix* prod = create_matrix(4, 5);
+    mu_assert("dot_product_view_into failed", dot_product_view_into(prod, block, matrix_view(w)));
+    mu_assert("dot_product_view_into on a block does not match", matrices_close(prod, expected));
+    mu_assert("dot_product_view_into should reject an empty view", !dot_product_view_into(prod, bad, matrix_view(w)));
+    mu_assert("An empty view should be reported as GANN_ERROR_NULL_ARGUMENT", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    Matrix* square = create_matrix(4, 4);
+    Matrix* right = create_matrix(2, 4);
+    mu_assert("dot_product_view_into should reject a destination overlapping an operand",
+              !dot_product_view_into(square, matrix_view_block(square, 0, 1, 4, 2), matrix_view(right)));
+    mu_assert("Overlap should set GANN_ERROR_INVALID_PARAM", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    free_matrix(square);
+    free_matrix(right);
+
+    // Element-wise kernels on two row views
+    Matrix* diff = create_matrix(1, 8);
+    mu_assert("matrix_subtract_view_into failed", matrix_subtract_view_into(diff, matrix_view_row(m, 5), matrix_view_row(m, 1)));
+    for (int j = 0; j < 8; j++) mu_assert("matrix_subtract_view_into value mismatch", diff->data[0][j] == 40.0);
+
+    // A row-range view of a wider matrix feeds the transposed accumulate directly.
+    Matrix* grad = create_matrix(8, 5);
+    Matrix* rhs = create_matrix(3, 5);
+    for (int i = 0; i < 3; i++) for (int j = 0; j < 5; j++) rhs->data[i][j] = i - j;
+    Matrix* rows_copy = create_matrix(3, 8);
+    matrix_copy_view_into(rows_copy, rows);
+    Matrix* expected_tn = dot_product_tn(rows_copy, rhs);
+    mu_assert("dot_product_tn_view_accumulate failed", dot_product_tn_view_accumulate(grad, rows, matrix_view(rhs)));
+    mu_assert("dot_product_tn_view_accumulate does not match", matrices_close(grad, expected_tn));
+
+    // A minibatch view feeds a whole forward pass; each output row matches the single-row pass.
+    int architecture[] = {8, 4, 3};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    nn_init(net);
+    Matrix** batch_outputs = nn_create_layer_buffers(net, 3);
+    Matrix** row_outputs = nn_create_layer_buffers(net, 1);
+    mu_assert("Minibatch forward pass failed", nn_forward_pass_view_into(net, rows, batch_outputs));
+    for (int r = 0; r < 3; r++) {
+        mu_assert("Single-row forward pass failed", nn_forward_pass_view_into(net, matrix_view_row(m, 2 + r), row_outputs));
+        for (int j = 0; j < 3; j++) {
+            mu_assert("Minibatch forward pass disagrees with the single-row pass",
+                      fabs(batch_outputs[1]->data[r][j] - row_outputs[1]->data[0][j]) < 1e-12);
+        }
+    }
+    nn_free_layer_buffers(batch_outputs, net->num_layers);
+    nn_free_layer_buffers(row_outputs, net->num_layers);
+    nn_free(net);
+
+    free_matrix(m); free_matrix(block_copy); free_matrix(w); free_matrix(expected); free_matrix(prod);
+    free_matrix(diff); free_matrix(grad); free_matrix(rhs); free_matrix(rows_copy); free_matrix(expected_tn);
+    return NULL;
+}
+
+// Runs the dispatched kernels at one SIMD level on fixed inputs and returns the
+// concatenated results (product + bias, Hadamard product, then each activation).
+static Matrix* run_simd_kernels(const Matrix* a, const Matrix* b, const Matrix* bias) {
+    Matrix* z = dot_product(a, b);
+    if (!z) return NULL;
+    add_bias(z, bias);
+    Matrix* h = matrix_elementwise_multiply(z, z);
+    Matrix* out = create_matrix(5, z->rows * z->cols);
+    if (!h || !out) {
+        free_matrix(z);
+        if (h) free_matrix(h);
+        if (out) free_matrix(out);
+        return NULL;
+    }
+    const ActivationType types[] = { SIGMOID, RELU, LEAKY_RELU };
+    memcpy(out->data[0], z->values, (size_t)z->rows * z->cols * sizeof(gann_real));
+    memcpy(out->data[1], h->values, (size_t)z->rows * z->cols * sizeof(gann_real));
+    for (int t = 0; t < 3; t++) {
+        Matrix* act = matrix_copy(z);
+        nn_apply_activation(act, types[t]);
+        memcpy(out->data[2 + t], act->values, (size_t)z->rows * z->cols * sizeof(gann_real));
+        free_matrix(act);
+    }
+    free_matrix(z);
+    free_matrix(h);
+    return out;
+}
+
+// Test that every SIMD level this CPU supports computes the same results as the portable kernels
+const char* test_simd_dispatch_consistency() {
+    GannSimdLevel saved = gann_simd_get_level();
+    GannSimdLevel best = gann_simd_get_best_level();
+    mu_assert("Active SIMD level exceeds what the CPU supports", saved <= best);
+    mu_assert("Portable kernels must always be available", gann_simd_set_level(GANN_SIMD_SCALAR) == 1);
+    mu_assert("Scalar level has the wrong name", strcmp(gann_simd_level_name(GANN_SIMD_SCALAR), "scalar") == 0);
+    if (best < GANN_SIMD_AVX512) {
+        mu_assert("Setting an unsupported level should fail", gann_simd_set_level((GannSimdLevel)(best + 1)) == 0);
+        mu_assert("A failed set should leave the level unchanged", gann_simd_get_level() == GANN_SIMD_SCALAR);
+    }
+
+    // Odd sizes leave remainders at every vector width and register tile.
+    Matrix* a = create_matrix(37, 67);
+    Matrix* b = create_matrix(67, 29);
+    Matrix* bias = create_matrix(1, 29);
+    for (int i = 0; i < 37; i++) for (int p = 0; p < 67; p++) a->data[i][p] = (double)((i * 7 + p * 3) % 11) / 8.0 - 0.6;
+    for (int p = 0; p < 67; p++) for (int j = 0; j < 29; j++) b->data[p][j] = (double)((p * 5 + j) % 13) / 16.0 - 0.4;
+    for (int j = 0; j < 29; j++) bias->data[0][j] = (double)(j % 5) - 2.0;
+
+    Matrix* reference = run_simd_kernels(a, b, bias);
+    mu_assert("Scalar kernels failed", reference != NULL);
+    for (int level = GANN_SIMD_SSE2; level <= (int)best; level++) {
+        mu_assert("Supported SIMD level was rejected", gann_simd_set_level((GannSimdLevel)level) == 1);
+        mu_assert("SIMD level did not take effect", gann_simd_get_level() == (GannSimdLevel)level);
+        Matrix* result = run_simd_kernels(a, b, bias);
+        mu_assert("SIMD kernels failed", result != NULL);
+        for (int i = 0; i < result->rows; i++) {
+            for (int j = 0; j < result->cols; j++) {
+                mu_assert("SIMD kernels disagree with the portable kernels", fabs(result->data[i][j] - reference->data[i][j]) < KERNEL_TOLERANCE);
+            }
+        }
+        free_matrix(result);
+    }
+
+    gann_simd_set_level(saved);
+    free_matrix(reference);
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(bias);
+    return NULL;
+}
+
+// Products large enough to be split across threads must give bit-identical results
+// for every thread count, including shapes that leave partial tiles in each strip.
+const char* test_gemm_thread_determinism() {
+    int saved = gann_get_num_threads();
+    GannGemmBackend saved_backend = gann_gemm_get_backend();
+    gann_gemm_set_backend(GANN_GEMM_BUILTIN); // The guarantee is the built-in engine's
+    mu_assert("Thread count must be at least 1", saved >= 1);
+    mu_assert("Zero threads should be rejected", gann_set_num_threads(0) == 0);
+    mu_assert("Too many threads should be rejected", gann_set_num_threads(GANN_MAX_THREADS + 1) == 0);
+    mu_assert("A rejected count should leave the setting unchanged", gann_get_num_threads() == saved);
+
+    // {m, k, n}: a tall batch (split along M) and a wide layer (split along N)
+    const int shapes[][3] = { {253, 331, 131}, {37, 300, 517} };
+    for (int s = 0; s < 2; s++) {
+        int m = shapes[s][0], k = shapes[s][1], n = shapes[s][2];
+        Matrix* a = create_matrix(m, k);
+        Matrix* b = create_matrix(k, n);
+        Matrix* bt = create_matrix(n, k);
+        Matrix* at = create_matrix(k, m);
+        for (int i = 0; i < m; i++) for (int p = 0; p < k; p++) a->data[i][p] = at->data[p][i] = (gann_real)sin(i * 0.37 + p * 0.11);
+        for (int p = 0; p < k; p++) for (int j = 0; j < n; j++) b->data[p][j] = bt->data[j][p] = (gann_real)cos(p * 0.23 - j * 0.07);
+
+        gann_set_num_threads(1);
+        Matrix* nn_ref = dot_product(a, b);
+        Matrix* tn_ref = dot_product_tn(at, b);
+        Matrix* nt_ref = dot_product_nt(a, bt);
+        mu_assert("Single-threaded products failed", nn_ref && tn_ref && nt_ref);
+        size_t bytes = (size_t)m * n * sizeof(gann_real);
+        for (int threads = 2; threads <= 5; threads++) {
+            mu_assert("Valid thread count was rejected", gann_set_num_threads(threads) == 1);
+            mu_assert("Thread count did not take effect", gann_get_num_threads() == threads);
+            Matrix* nn = dot_product(a, b);
+            Matrix* tn = dot_product_tn(at, b);
+            Matrix* nt = dot_product_nt(a, bt);
+            mu_assert("Multi-threaded products failed", nn && tn && nt);
+            mu_assert("dot_product depends on the thread count", memcmp(nn->values, nn_ref->values, bytes) == 0);
+            mu_assert("dot_product_tn depends on the thread count", memcmp(tn->values, tn_ref->values, bytes) == 0);
+            mu_assert("dot_product_nt depends on the thread count", memcmp(nt->values, nt_ref->values, bytes) == 0);
+            free_matrix(nn);
+            free_matrix(tn);
+            free_matrix(nt);
+        }
+        free_matrix(nn_ref);
+        free_matrix(tn_ref);
+        free_matrix(nt_ref);
+        free_matrix(a);
+        free_matrix(b);
+        free_matrix(at);
+        free_matrix(bt);
+    }
+
+    // Workers stopped by a new thread count free their packing buffers
+    Matrix* a = create_matrix(253, 331);
+    Matrix* b = create_matrix(331, 131);
+    Matrix* c = create_matrix(253, 131);
+    mu_assert("dot_product_into failed", dot_product_into(c, a, b));
+    size_t before = 0, after = 0;
+    int measured = heap_bytes_in_use(&before);
+    for (int restart = 0; restart < 10; restart++) {
+        gann_set_num_threads(2 + restart % 2);
+        mu_assert("dot_product_into failed", dot_product_into(c, a, b));
+    }
+    measured = measured && heap_bytes_in_use(&after);
+    mu_assert("Restarted workers leaked their packing buffers", !measured || after < before + (1 << 20));
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(c);
+
+    gann_set_num_threads(saved);
+    gann_gemm_set_backend(saved_backend);
+    return NULL;
+}
+
+// The external BLAS backend, when compiled in, must agree with the built-in kernels;
+// otherwise selecting it must fail and leave the built-in backend active.
+const char* test_gemm_backend_selection() {
+    GannGemmBackend saved = gann_gemm_get_backend();
+    mu_assert("Backend has the wrong name", strcmp(gann_gemm_backend_name(GANN_GEMM_BUILTIN), "builtin") == 0);
+    mu_assert("Backend has the wrong name", strcmp(gann_gemm_backend_name(GANN_GEMM_CBLAS), "cblas") == 0);
+    mu_assert("Built-in backend must always be available", gann_gemm_set_backend(GANN_GEMM_BUILTIN) == 1);
+    mu_assert("Unknown backends should be rejected", gann_gemm_set_backend((GannGemmBackend)7) == 0);
+
+    Matrix* a = create_matrix(45, 70);
+    Matrix* b = create_matrix(70, 33);
+    Matrix* at = create_matrix(70, 45);
+    Matrix* bt = create_matrix(33, 70);
+    for (int i = 0; i < 45; i++) for (int p = 0; p < 70; p++) a->data[i][p] = at->data[p][i] = (gann_real)((i * 7 + p * 3) % 11) / 8 - 0.6;
+    for (int p = 0; p < 70; p++) for (int j = 0; j < 33; j++) b->data[p][j] = bt->data[j][p] = (gann_real)((p * 5 + j) % 13) / 16 - 0.4;
+
+    Matrix* nn_ref = dot_product(a, b);
+    Matrix* tn_ref = dot_product_tn(at, b);
+    Matrix* nt_ref = dot_product_nt(a, bt);
+    mu_assert("Built-in products failed", nn_ref && tn_ref && nt_ref);
+
+    if (gann_gemm_set_backend(GANN_GEMM_CBLAS)) {
+        mu_assert("CBLAS backend did not take effect", gann_gemm_get_backend() == GANN_GEMM_CBLAS);
+        Matrix* nn = dot_product(a, b);
+        Matrix* tn = dot_product_tn(at, b);
+        Matrix* nt = dot_product_nt(a, bt);
+        mu_assert("CBLAS dot_product disagrees with the built-in kernels", matrices_close(nn, nn_ref));
+        mu_assert("CBLAS dot_product_tn disagrees with the built-in kernels", matrices_close(tn, tn_ref));
+        mu_assert("CBLAS dot_product_nt disagrees with the built-in kernels", matrices_close(nt, nt_ref));
+        // Accumulation: C += A^T * B twice equals 2 * (A^T * B)
+        dot_product_tn_accumulate(tn, at, b);
+        matrix_scale_inplace(tn_ref, 2.0);
+        mu_assert("CBLAS accumulation disagrees with the built-in kernels", matrices_close(tn, tn_ref));
+        free_matrix(nn);
+        free_matrix(tn);
+        free_matrix(nt);
+    } else {
+        mu_assert("A failed set should leave the backend unchanged", gann_gemm_get_backend() == GANN_GEMM_BUILTIN);
+    }
+
+    gann_gemm_set_backend(saved);
+    free_matrix(nn_ref);
+    free_matrix(tn_ref);
+    free_matrix(nt_ref);
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(at);
+    free_matrix(bt);
+    return NULL;
+}
+
+// The three sparse products must match the dense ones, and the CSR conversion
+// must round-trip and drop exactly the elements at or below the threshold.
+// A batch computes exactly what the products compute one at a time, whether
+// the left operand is shared or not, on the row path (one row) and the packed
+// path, for widths that fit many B blocks in the packing buffer and for one that
+// does not fit at all, and for any thread count.
+const char* test_matrix_batch_products() {
+    int saved_threads = gann_get_num_threads();
+    // {m, k, n}
+    const int shapes[][3] = { {53, 300, 37}, {1, 300, 37}, {9, 20, 2100} };
+    const int count = 12;
+    for (int s = 0; s < 3; s++) {
+        int m = shapes[s][0], k = shapes[s][1], n = shapes[s][2];
+        Matrix* inputs = create_matrix(count * m, k);
+        Matrix* weights = create_matrix(count * k, n);
+        Matrix* stacked = create_matrix(count * m, n);
+        mu_assert("Failed to create matrices", inputs && weights && stacked);
+        for (int i = 0; i < count * m; i++) for (int p = 0; p < k; p++) inputs->data[i][p] = (gann_real)sin(i * 0.37 + p * 0.11);
+        for (int p = 0; p < count * k; p++) for (int j = 0; j < n; j++) weights->data[p][j] = (gann_real)cos(p * 0.23 - j * 0.07);
+
+        Matrix* expected_shared[12];
+        Matrix* expected_own[12];
+        Matrix* dest[12];
+        MatrixView shared_a[12], own_a[12], b[12];
+        for (int t = 0; t < count; t++) {
+            shared_a[t] = matrix_view_rows(inputs, 0, m);
+            own_a[t] = matrix_view_rows(inputs, t * m, m);
+            b[t] = matrix_view_rows(weights, t * k, k);
+            expected_shared[t] = create_matrix(m, n);
+            expected_own[t] = create_matrix(m, n);
+            dest[t] = create_matrix(m, n);
+            mu_assert("dot_product_view_into failed", dot_product_view_into(expected_shared[t], shared_a[t], b[t]) &&
+                                                      dot_product_view_into(expected_own[t], own_a[t], b[t]));
+        }
+        size_t bytes = (size_t)m * n * sizeof(gann_real);
+
+        for (int threads = 1; threads <= 3; threads += 2) {
+            mu_assert("gann_set_num_threads failed", gann_set_num_threads(threads));
+            mu_assert("Shared-A batch failed", dot_product_batch_into(count, dest, shared_a, b));
+            for (int t = 0; t < count; t++) {
+                mu_assert("Shared-A batch differs from the single product", memcmp(dest[t]->values, expected_shared[t]->values, bytes) == 0);
+            }
+            mu_assert("Batch failed", dot_product_batch_into(count, dest, own_a, b));
+            for (int t = 0; t < count; t++) {
+                mu_assert("Batch differs from the single product", memcmp(dest[t]->values, expected_own[t]->values, bytes) == 0);
+            }
+
+            mu_assert("Shared-A strided batch failed",
+                      dot_product_batch_strided_into(count, stacked, shared_a[0], 0, b[0], (size_t)k * weights->stride));
+            for (int t = 0; t < count; t++) {
+                mu_assert("Strided batch differs", memcmp(stacked->data[t * m], expected_shared[t]->values, bytes) == 0);
+            }
+            mu_assert("Strided batch failed",
+                      dot_product_batch_strided_into(count, stacked, own_a[0], (size_t)m * inputs->stride, b[0], (size_t)k * weights->stride));
+            for (int t = 0; t < count; t++) {
+                mu_assert("Strided batch differs", memcmp(stacked->data[t * m], expected_own[t]->values, bytes) == 0);
+            }
+        }
+
+        for (int t = 0; t < count; t++) {
+            free_matrix(expected_shared[t]);
+            free_matrix(expected_own[t]);
+            free_matrix(dest[t]);
+        }
+        free_matrix(inputs);
+        free_matrix(weights);
+        free_matrix(stacked);
+    }
+    gann_set_num_threads(saved_threads);
+
+    // With a square B the left operands have the shape of the results.
+    Matrix* a = create_matrix(4, 5);
+    Matrix* b = create_matrix(5, 5);
+    Matrix* c = create_matrix(4, 5);
+    Matrix* wrong = create_matrix(4, 6);
+    MatrixView av[2] = { matrix_view(a), matrix_view(a) };
+    MatrixView bv[2] = { matrix_view(b), matrix_view(wrong) };
+    Matrix* dests[2] = { c, c };
+    mu_assert("An empty batch should succeed", dot_product_batch_into(0, NULL, NULL, NULL));
+    mu_assert("Mixed shapes should be rejected", !dot_product_batch_into(2, dests, av, bv));
+    mu_assert("Wrong error for mixed shapes", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    bv[1] = matrix_view(b);
+    av[1] = matrix_view(c);
+    mu_assert("An operand overlapping a result should be rejected", !dot_product_batch_into(2, dests, av, bv));
+    mu_assert("Wrong error for an overlap", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("A wrong stacked shape should be rejected", !dot_product_batch_strided_into(2, c, matrix_view(a), 0, matrix_view(b), 0));
+    mu_assert("Wrong error for a stacked shape", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    mu_assert("A NULL operand should be rejected", !dot_product_batch_into(1, dests, NULL, bv));
+    mu_assert("Wrong error for a NULL operand", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(c);
+    free_matrix(wrong);
+    return NULL;
+}
+
+const char* test_sparse_matrix() {
+    const int m = 13, k = 70, n = 37;
+    Matrix* a = create_matrix(m, k);
+    Matrix* b = create_matrix(k, n);
+    Matrix* d = create_matrix(m, n);
+    Matrix* expected = create_matrix(m, n);
+    Matrix* result = create_matrix(m, n);
+    mu_assert("Failed to allocate sparse test matrices", a && b && d && expected && result);
+    // About a third of a and b are zeros; row 3 of a is empty.
+    for (int i = 0; i < m; i++) {
+        for (int p = 0; p < k; p++) a->data[i][p] = (i == 3 || (i + p) % 3 == 0) ? 0.0 : sin(0.3 * i + 0.7 * p);
+    }
+    for (int p = 0; p < k; p++) {
+        for (int j = 0; j < n; j++) b->data[p][j] = ((p * j) % 3 == 1) ? 0.0 : cos(0.2 * p - 0.5 * j);
+    }
+    for (int i = 0; i < m; i++) {
+        for (int j = 0; j < n; j++) d->data[i][j] = sin(i + 0.1 * j);
+    }
+
+    SparseMatrix* sa = sparse_matrix_from_dense(a, 0.0);
+    SparseMatrix* sb = sparse_matrix_from_dense(b, 0.0);
+    mu_assert("sparse_matrix_from_dense failed", sa != NULL && sb != NULL);
+    mu_assert("Empty row should have no entries", sa->row_start[3] == sa->row_start[4]);
+    Matrix* round_trip = sparse_matrix_to_dense(sa);
+    mu_assert("sparse_matrix_to_dense failed", round_trip != NULL);
+    int nonzeros = 0;
+    for (int i = 0; i < m; i++) {
+        for (int p = 0; p < k; p++) {
+            nonzeros += a->data[i][p] != 0.0;
+            mu_assert("CSR round trip changed an element", round_trip->data[i][p] == a->data[i][p]);
+        }
+    }
+    mu_assert("Wrong number of stored elements", sa->nnz == nonzeros);
+    mu_assert("Wrong density", fabs(sparse_matrix_density(sa) - (double)nonzeros / (m * k)) < 1e-12);
+    free_matrix(round_trip);
+
+    GannSimdLevel saved = gann_simd_get_level();
+    for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+        gann_simd_set_level((GannSimdLevel)level);
+        // sparse x dense
+        mu_assert("dot_product_into failed", dot_product_into(expected, a, b));
+        mu_assert("sparse_dot_product_into failed", sparse_dot_product_into(result, sa, matrix_view(b)));
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) mu_assert("Sparse x dense disagrees with the dense product", fabs(result->data[i][j] - expected->data[i][j]) < TEST_EPSILON);
+        }
+        // dense x sparse
+        mu_assert("dot_product_sparse_into failed", dot_product_sparse_into(result, matrix_view(a), sb));
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) mu_assert("Dense x sparse disagrees with the dense product", fabs(result->data[i][j] - expected->data[i][j]) < TEST_EPSILON);
+        }
+        // c += a^T * d, starting from the dense result
+        Matrix* grad = create_matrix(k, n);
+        Matrix* sparse_grad = create_matrix(k, n);
+        mu_assert("Failed to allocate gradient matrices", grad && sparse_grad);
+        for (int p = 0; p < k; p++) {
+            for (int j = 0; j < n; j++) grad->data[p][j] = sparse_grad->data[p][j] = 0.01 * (p - j);
+        }
+        dot_product_tn_accumulate(grad, a, d);
+        mu_assert("sparse_dot_product_tn_accumulate failed", sparse_dot_product_tn_accumulate(sparse_grad, sa, matrix_view(d)));
+        for (int p = 0; p < k; p++) {
+            for (int j = 0; j < n; j++) mu_assert("Sparse transposed accumulate disagrees with the dense one", fabs(sparse_grad->data[p][j] - grad->data[p][j]) < TEST_EPSILON);
+        }
+        free_matrix(grad);
+        free_matrix(sparse_grad);
+    }
+    gann_simd_set_level(saved);
+
+    // A positive threshold prunes by magnitude.
+    SparseMatrix* pruned = sparse_matrix_from_dense(b, 0.5);
+    mu_assert("Pruning conversion failed", pruned != NULL);
+    for (int p = 0; p < k; p++) {
+        for (int q = pruned->row_start[p]; q < pruned->row_start[p + 1]; q++) {
+            mu_assert("Pruned matrix kept a small element", fabs(pruned->values[q]) > 0.5);
+            mu_assert("Pruned matrix changed an element", pruned->values[q] == b->data[p][pruned->col_index[q]]);
+        }
+    }
+    mu_assert("Pruning kept too much", pruned->nnz < sb->nnz);
+
+    mu_assert("Negative threshold should be rejected", sparse_matrix_from_dense(b, -1.0) == NULL);
+    mu_assert("Wrong error code for a negative threshold", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("Mismatched sparse product should fail", !sparse_dot_product_into(result, sb, matrix_view(b)));
+    mu_assert("Wrong error code for a mismatched sparse product", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    mu_assert("NULL sparse operand should fail", !dot_product_sparse_into(result, matrix_view(a), NULL));
+    mu_assert("Wrong error code for a NULL sparse operand", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+
+    free_sparse_matrix(pruned);
+    free_sparse_matrix(sa);
+    free_sparse_matrix(sb);
+    free_sparse_matrix(NULL);
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(d);
+    free_matrix(expected);
+    free_matrix(result);
+    return NULL;
+}
+
 // Test for matrix error handling
 const char* test_matrix_errors() {
     // --- Suppress stderr for this test ---
@@ -1,11 +1,19 @@
 #include "minunit.h"
 #include "neural_network.h"
 #include "mutation.h"
+#include "crossover.h"
 #include "gann_errors.h"
+#include "gann_simd.h"
+#include "backpropagation.h"
+#include "gann.h"
+#include "gann_plan.h"
+#include "gann_arena.h"
 #include <math.h>
+#include <string.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 
 extern const double TEST_EPSILON;
 
@@ -122,6 +130,243 @@ const char* test_nn_linear_activation() {
     return NULL;
 }
 
+// The fused layer kernel must give the same results as running the product,
+// the bias addition and the activation as separate passes.
+const char* test_nn_layer_forward_fused() {
+    const ActivationType activations[] = {SIGMOID, RELU, LEAKY_RELU, LINEAR};
+    // 1 row takes the unpacked path; 37 rows and 300 inputs take the blocked
+    // path with edge tiles and more than one rank update.
+    const int shapes[][3] = {{1, 300, 131}, {37, 300, 131}, {9, 20, 7}};
+    GannSimdLevel saved = gann_simd_get_level();
+
+    for (int s = 0; s < 3; s++) {
+        int rows = shapes[s][0];
+        int architecture[] = {shapes[s][1], shapes[s][2]};
+        Matrix* input = create_matrix(rows, architecture[0]);
+        Matrix* output = create_matrix(rows, architecture[1]);
+        Matrix* z = create_matrix(rows, architecture[1]);
+        mu_assert("Failed to allocate fused layer test matrices", input && output && z);
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < architecture[0]; j++) input->data[i][j] = sin(0.37 * i + 0.11 * j);
+        }
+
+        for (int a = 0; a < 4; a++) {
+            NeuralNetwork* net = nn_create(2, architecture, activations[a], activations[a]);
+            mu_assert("Failed to create network", net != NULL);
+            nn_init(net);
+            Matrix* expected_z = dot_product(input, net->weights[0]);
+            mu_assert("dot_product failed", expected_z != NULL);
+            add_bias(expected_z, net->biases[0]);
+            Matrix* expected = matrix_copy(expected_z);
+            nn_apply_activation(expected, activations[a]);
+
+            for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+                gann_simd_set_level((GannSimdLevel)level);
+                mu_assert("nn_layer_forward_into failed", nn_layer_forward_into(net, 0, matrix_view(input), output, z));
+                for (int i = 0; i < rows; i++) {
+                    for (int j = 0; j < architecture[1]; j++) {
+                        mu_assert("Fused layer output disagrees with the unfused passes", fabs(output->data[i][j] - expected->data[i][j]) < TEST_EPSILON);
+                        mu_assert("Fused layer z disagrees with the unfused passes", fabs(z->data[i][j] - expected_z->data[i][j]) < TEST_EPSILON);
+                    }
+                }
+            }
+            gann_simd_set_level(saved);
+            free_matrix(expected);
+            free_matrix(expected_z);
+            nn_free(net);
+        }
+        free_matrix(input);
+        free_matrix(output);
+        free_matrix(z);
+    }
+
+    int architecture[] = {4, 3};
+    NeuralNetwork* net = nn_create(2, architecture, RELU, RELU);
+    Matrix* input = create_matrix(2, 4);
+    Matrix* output = create_matrix(2, 3);
+    mu_assert("nn_layer_forward_into should reject an invalid layer", !nn_layer_forward_into(net, 1, matrix_view(input), output, NULL));
+    mu_assert("Wrong error code for an invalid layer", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("nn_layer_forward_into should reject a mismatched output", !nn_layer_forward_into(net, 0, matrix_view(input), input, NULL));
+    mu_assert("Wrong error code for a mismatched output", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    mu_assert("nn_layer_forward_into should reject z aliasing the output", !nn_layer_forward_into(net, 0, matrix_view(input), output, output));
+    mu_assert("Wrong error code for z aliasing the output", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    nn_free(net);
+    free_matrix(input);
+    free_matrix(output);
+    return NULL;
+}
+
+// The vectorized activations and derivatives must match their textbook formulas
+// at every SIMD level, and the fast sigmoid must stay within its documented error.
+const char* test_activation_kernels() {
+    const ActivationType activations[] = {SIGMOID, RELU, LEAKY_RELU, LINEAR};
+    const int n = 2003; // odd, so every vector width leaves a tail
+    GannSimdLevel saved = gann_simd_get_level();
+    mu_assert("The default sigmoid mode should be exact", gann_simd_get_sigmoid_mode() == GANN_SIGMOID_EXACT);
+    mu_assert("Invalid sigmoid mode should be rejected", gann_simd_set_sigmoid_mode((GannSigmoidMode)7) == 0);
+    mu_assert("Fast mode has the wrong name", strcmp(gann_simd_sigmoid_mode_name(GANN_SIGMOID_FAST), "fast") == 0);
+
+    Matrix* x = create_matrix(1, n);
+    Matrix* y = create_matrix(1, n);
+    mu_assert("Failed to allocate activation test matrices", x && y);
+    // Covers the saturated ranges (including inputs beyond exp's range) and both signs of zero.
+    for (int i = 0; i < n; i++) x->data[0][i] = (i < 6) ? (double[]){-1000, -745, 0, -0.0, 710, 1000}[i] : -40.0 + 80.0 * i / n;
+
+    for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+        gann_simd_set_level((GannSimdLevel)level);
+        for (int a = 0; a < 4; a++) {
+            matrix_copy_into(y, x);
+            nn_apply_activation(y, activations[a]);
+            for (int i = 0; i < n; i++) {
+                double v = x->data[0][i];
+                double expected = (activations[a] == SIGMOID) ? 1.0 / (1.0 + exp(-v))
+                                : (activations[a] == RELU) ? (v > 0 ? v : 0)
+                                : (activations[a] == LEAKY_RELU) ? (v > 0 ? v : 0.01 * v) : v;
+                mu_assert("Activation kernel disagrees with its formula", fabs(y->data[0][i] - expected) <= TEST_EPSILON * fmax(1.0, fabs(expected)));
+            }
+
+            matrix_copy_into(y, x);
+            nn_apply_activation_derivative(y, activations[a]);
+            for (int i = 0; i < n; i++) {
+                double v = x->data[0][i];
+                double s = 1.0 / (1.0 + exp(-v));
+                double expected = (activations[a] == SIGMOID) ? s * (1 - s)
+                                : (activations[a] == RELU) ? (v > 0 ? 1 : 0)
+                                : (activations[a] == LEAKY_RELU) ? (v > 0 ? 1 : 0.01) : 1;
+                mu_assert("Activation derivative kernel disagrees with its formula", fabs(y->data[0][i] - expected) <= TEST_EPSILON);
+            }
+        }
+
+        mu_assert("Failed to select the fast sigmoid", gann_simd_set_sigmoid_mode(GANN_SIGMOID_FAST));
+        matrix_copy_into(y, x);
+        nn_apply_activation(y, SIGMOID);
+        for (int i = 0; i < n; i++) {
+            double expected = 1.0 / (1.0 + exp(-x->data[0][i]));
+            mu_assert("Fast sigmoid exceeds its documented error", fabs(y->data[0][i] - expected) <= 2e-5);
+        }
+        matrix_copy_into(y, x);
+        nn_apply_activation_derivative(y, SIGMOID);
+        for (int i = 0; i < n; i++) {
+            double s = 1.0 / (1.0 + exp(-x->data[0][i]));
+            mu_assert("Fast sigmoid derivative exceeds its documented error", fabs(y->data[0][i] - s * (1 - s)) <= 2e-5);
+        }
+        gann_simd_set_sigmoid_mode(GANN_SIGMOID_EXACT);
+    }
+
+    gann_simd_set_level(saved);
+    free_matrix(x);
+    free_matrix(y);
+    return NULL;
+}
+
+// The sparse first layer must match the dense one wherever it runs, and fall
+// back to it for dense inputs.
+const char* test_nn_sparse_first_layer() {
+    const ActivationType activations[] = {SIGMOID, RELU, LEAKY_RELU, LINEAR};
+    const int inputs = 300, outputs = 131;
+    GannSimdLevel saved = gann_simd_get_level();
+    Matrix* input = create_matrix(1, inputs);
+    Matrix* output = create_matrix(1, outputs);
+    Matrix* z = create_matrix(1, outputs);
+    Matrix* expected = create_matrix(1, outputs);
+    Matrix* expected_z = create_matrix(1, outputs);
+    int columns[300];
+    mu_assert("Failed to allocate sparse layer test matrices", input && output && z && expected && expected_z);
+
+    // An empty row, a sparse one (1 in 7), one exactly at the 80% switch, and a
+    // full one that takes the dense fallback.
+    for (int s = 0; s < 4; s++) {
+        int count = 0;
+        for (int j = 0; j < inputs; j++) {
+            int nonzero = (s == 1) ? j % 7 == 0 : (s == 2) ? j % 5 != 0 : (s == 3);
+            input->data[0][j] = nonzero ? sin(0.11 * j) + 1.5 : 0.0;
+            if (nonzero) columns[count++] = j;
+        }
+        for (int a = 0; a < 4; a++) {
+            // Two layers exercise the output activation, three the hidden one.
+            int architecture[] = {inputs, outputs, 5};
+            NeuralNetwork* net = nn_create(2 + a % 2, architecture, activations[a], activations[(a + 1) % 4]);
+            mu_assert("Failed to create network", net != NULL);
+            nn_init(net);
+            mu_assert("nn_layer_forward_into failed", nn_layer_forward_into(net, 0, matrix_view(input), expected, expected_z));
+            for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+                gann_simd_set_level((GannSimdLevel)level);
+                mu_assert("nn_layer_forward_sparse_into failed", nn_layer_forward_sparse_into(net, matrix_view(input), columns, count, output, z));
+                for (int j = 0; j < outputs; j++) {
+                    mu_assert("Sparse layer output disagrees with the dense layer", fabs(output->data[0][j] - expected->data[0][j]) < TEST_EPSILON);
+                    mu_assert("Sparse layer z disagrees with the dense layer", fabs(z->data[0][j] - expected_z->data[0][j]) < TEST_EPSILON);
+                }
+            }
+            gann_simd_set_level(saved);
+            nn_free(net);
+        }
+    }
+
+    int architecture[] = {inputs, outputs};
+    NeuralNetwork* net = nn_create(2, architecture, RELU, RELU);
+    nn_init(net);
+    columns[0] = inputs;
+    mu_assert("nn_layer_forward_sparse_into should reject an out-of-range column", !nn_layer_forward_sparse_into(net, matrix_view(input), columns, 1, output, NULL));
+    mu_assert("Wrong error code for an out-of-range column", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("nn_layer_forward_sparse_into should reject a NULL column list", !nn_layer_forward_sparse_into(net, matrix_view(input), NULL, 1, output, NULL));
+    mu_assert("Wrong error code for a NULL column list", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    Matrix* wrong = create_matrix(1, outputs + 1);
+    mu_assert("nn_layer_forward_sparse_into should reject a mismatched output", !nn_layer_forward_sparse_into(net, matrix_view(input), columns, 0, wrong, NULL));
+    mu_assert("Wrong error code for a mismatched output", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    free_matrix(wrong);
+    nn_free(net);
+    free_matrix(input);
+    free_matrix(output);
+    free_matrix(z);
+    free_matrix(expected);
+    free_matrix(expected_z);
+    return NULL;
+}
+
+// A layer run with a pruned sparse copy of its weights must match the dense
+// layer run with the same pruned weights.
+const char* test_nn_pruned_layer() {
+    int architecture[] = {90, 45, 10};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Matrix* input = create_matrix(6, 90);
+    Matrix* output = create_matrix(6, 45);
+    Matrix* z = create_matrix(6, 45);
+    Matrix* expected_z = create_matrix(6, 45);
+    mu_assert("Failed to allocate pruned layer test matrices", input && output && z && expected_z);
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < 90; j++) input->data[i][j] = (j % 4 == 0) ? 0.0 : sin(0.5 * i + 0.13 * j);
+    }
+
+    SparseMatrix* pruned = sparse_matrix_from_dense(net->weights[0], 0.05);
+    mu_assert("Failed to prune weights", pruned != NULL);
+    Matrix* dense = sparse_matrix_to_dense(pruned);
+    mu_assert("Failed to expand pruned weights", dense != NULL);
+    matrix_copy_into(net->weights[0], dense);
+    mu_assert("nn_layer_forward_into failed", nn_layer_forward_into(net, 0, matrix_view(input), output, expected_z));
+    Matrix* expected = matrix_copy(output);
+    mu_assert("nn_layer_forward_pruned_into failed", nn_layer_forward_pruned_into(net, 0, pruned, matrix_view(input), output, z));
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < 45; j++) {
+            mu_assert("Pruned layer output disagrees with the dense layer", fabs(output->data[i][j] - expected->data[i][j]) < TEST_EPSILON);
+            mu_assert("Pruned layer z disagrees with the dense layer", fabs(z->data[i][j] - expected_z->data[i][j]) < TEST_EPSILON);
+        }
+    }
+    mu_assert("Pruned weights of the wrong layer should be rejected", !nn_layer_forward_pruned_into(net, 1, pruned, matrix_view(output), z, NULL));
+    mu_assert("Wrong error code for pruned weights of the wrong layer", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+
+    free_sparse_matrix(pruned);
+    free_matrix(dense);
+    free_matrix(expected);
+    free_matrix(expected_z);
+    free_matrix(input);
+    free_matrix(output);
+    free_matrix(z);
+    nn_free(net);
+    return NULL;
+}
+
 // Test for neural network error handling
 const char* test_nn_errors() {
     // --- Suppress stderr for this test ---
@@ -201,3 +446,601 @@ const char* test_gaussian_mutation() {
 
     return NULL;
 }
+
+// A 16-bit network computes what a native network holding the rounded weights
+// computes, on the packed path (a batch) and the row path (single inputs).
+const char* test_nn_weight_storage() {
+    srand(16);
+    int architecture[] = {300, 40, 10};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Matrix* batch = create_matrix(20, 300);
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 300; j++) batch->data[i][j] = (gann_real)rand() / RAND_MAX;
+    }
+
+    const NNWeightStorage storages[] = { NN_STORAGE_FP16, NN_STORAGE_BF16 };
+    const double precision[] = { 1.0 / 2048, 1.0 / 256 }; // half an ulp, relative
+    for (int s = 0; s < 2; s++) {
+        NeuralNetwork* half = nn_clone(net);
+        mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(half, storages[s]) == 1);
+        mu_assert("16-bit network should not hold native weights", half->weights == NULL && half->weights_16 != NULL);
+        NeuralNetwork* rounded = nn_clone(half);
+        mu_assert("nn_clone should keep the weight storage", rounded->weight_storage == storages[s] && rounded->weights == NULL);
+        mu_assert("Widening failed", nn_set_weight_storage(rounded, NN_STORAGE_NATIVE) == 1);
+
+        for (int l = 0; l < 2; l++) {
+            for (int r = 0; r < architecture[l]; r++) {
+                for (int c = 0; c < architecture[l + 1]; c++) {
+                    gann_real w = net->weights[l]->data[r][c];
+                    mu_assert("Widening should be exact", rounded->weights[l]->data[r][c] == nn_get_weight(half, l, r, c));
+                    mu_assert("Stored weight is not the nearest value", fabs(nn_get_weight(half, l, r, c) - w) <= fabs(w) * precision[s] + 1e-7);
+                }
+            }
+        }
+
+        Matrix* expected = nn_forward_pass(rounded, batch);
+        Matrix* actual = nn_forward_pass(half, batch);
+        mu_assert("Batch forward pass failed", expected != NULL && actual != NULL);
+        for (int i = 0; i < 20; i++) {
+            for (int j = 0; j < 10; j++) {
+                mu_assert("Batch outputs differ", fabs(expected->data[i][j] - actual->data[i][j]) < TEST_EPSILON);
+            }
+            Matrix* row = matrix_get_row(batch, i);
+            Matrix* single = nn_forward_pass(half, row);
+            mu_assert("Row forward pass failed", single != NULL);
+            for (int j = 0; j < 10; j++) {
+                mu_assert("Row outputs differ", fabs(expected->data[i][j] - single->data[0][j]) < TEST_EPSILON);
+            }
+            free_matrix(single);
+            free_matrix(row);
+        }
+        free_matrix(expected);
+        free_matrix(actual);
+
+        nn_set_weight(half, 1, 3, 7, 0.1);
+        mu_assert("nn_set_weight should round to the storage", fabs(nn_get_weight(half, 1, 3, 7) - 0.1) <= 0.1 * precision[s]);
+
+        // 16-bit weights cannot be trained.
+        Dataset* data = create_dummy_dataset(4);
+        GannBackpropParams params = { .architecture = architecture, .num_layers = 3, .learning_rate = 0.01, .epochs = 1,
+                                      .batch_size = 2, .activation_hidden = RELU, .activation_output = SIGMOID, .optimizer_type = SGD };
+        backpropagate(half, data, &params, NULL);
+        mu_assert("backpropagate should reject 16-bit weights", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+        free_dataset(data);
+
+        nn_free(rounded);
+        nn_free(half);
+    }
+
+    mu_assert("An unknown storage should be rejected", nn_set_weight_storage(net, (NNWeightStorage)7) == 0);
+    mu_assert("Wrong error code for an unknown storage", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("nn_init_optimizer_state failed", nn_init_optimizer_state(net) == 1);
+    mu_assert("Narrowing a network with an optimizer state should fail", nn_set_weight_storage(net, NN_STORAGE_BF16) == 0);
+    mu_assert("A failed narrowing should leave the weights", net->weight_storage == NN_STORAGE_NATIVE && net->weights != NULL);
+    mu_assert("nn_create_with_storage should reject an unknown storage",
+              nn_create_with_storage(3, architecture, RELU, SIGMOID, (NNWeightStorage)-1) == NULL);
+
+    free_matrix(batch);
+    nn_free(net);
+    return NULL;
+}
+
+// Every SIMD level widens all 65536 bit patterns of both formats the same way,
+// on the row path (one input) and on the packed path (a batch).
+const char* test_half_kernels_agree() {
+    // Eight inputs so that the batch takes the packed path; only the first is
+    // nonzero, and only the first row of weights holds the bit patterns.
+    int architecture[] = {8, 65536};
+    const NNWeightStorage storages[] = { NN_STORAGE_FP16, NN_STORAGE_BF16 };
+    Matrix* input = create_matrix(8, 8);
+    for (int i = 0; i < 8; i++) input->data[i][0] = 1.0;
+    Matrix* row = matrix_get_row(input, 0);
+    GannSimdLevel saved = gann_simd_get_level();
+    for (int s = 0; s < 2; s++) {
+        NeuralNetwork* net = nn_create_with_storage(2, architecture, LINEAR, LINEAR, storages[s]);
+        mu_assert("Failed to create network", net != NULL);
+        memset(net->weights_16[0], 0, (size_t)8 * 65536 * sizeof(uint16_t));
+        for (int j = 0; j < 65536; j++) net->weights_16[0][j] = (uint16_t)j;
+        Matrix* reference = NULL;
+        for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+            gann_simd_set_level((GannSimdLevel)level);
+            Matrix* single = nn_forward_pass(net, row);
+            Matrix* batch = nn_forward_pass(net, input);
+            mu_assert("Forward pass failed", single != NULL && batch != NULL);
+            for (int i = 0; i < 8; i++) {
+                mu_assert("Batch rows differ", memcmp(batch->data[i], single->data[0], 65536 * sizeof(gann_real)) == 0);
+            }
+            if (reference == NULL) {
+                reference = single;
+                mu_assert("1.0 should be exact", reference->data[0][storages[s] == NN_STORAGE_BF16 ? 0x3f80 : 0x3c00] == 1.0);
+            } else {
+                mu_assert("Widening differs between SIMD levels", memcmp(reference->data[0], single->data[0], 65536 * sizeof(gann_real)) == 0);
+                free_matrix(single);
+            }
+            free_matrix(batch);
+        }
+        free_matrix(reference);
+        nn_free(net);
+    }
+    gann_simd_set_level(saved);
+    free_matrix(row);
+    free_matrix(input);
+    return NULL;
+}
+
+// Batches of any size must reproduce the one-row-at-a-time forward pass,
+// including the last, shorter batch and inputs read through a strided view.
+const char* test_nn_forward_pass_batch() {
+    const int architecture[] = {37, 29, 11, 6};
+    const int rows = 150;
+    srand(19);
+    NeuralNetwork* net = nn_create(4, architecture, LEAKY_RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Matrix* storage = create_matrix(rows, 40);
+    Matrix* outputs = create_matrix(rows, 6);
+    Matrix* expected = create_matrix(rows, 6);
+    Matrix** layer_outputs = nn_create_layer_buffers(net, 1);
+    mu_assert("Failed to allocate batch test matrices", storage && outputs && expected && layer_outputs);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < 40; j++) storage->data[i][j] = sin(0.37 * i + 0.11 * j);
+    }
+    MatrixView inputs = matrix_view_block(storage, 0, 2, rows, 37);
+
+    for (int i = 0; i < rows; i++) {
+        mu_assert("nn_forward_pass_view_into failed", nn_forward_pass_view_into(net, matrix_view_block(storage, i, 2, 1, 37), layer_outputs));
+        memcpy(expected->data[i], layer_outputs[2]->values, 6 * sizeof(gann_real));
+    }
+
+    const int batch_sizes[] = {1, 7, NN_DEFAULT_FORWARD_BATCH_SIZE, 1000};
+    mu_assert("Wrong default batch size", nn_get_forward_batch_size() == NN_DEFAULT_FORWARD_BATCH_SIZE);
+    for (int b = 0; b < 4; b++) {
+        mu_assert("nn_set_forward_batch_size failed", nn_set_forward_batch_size(batch_sizes[b]));
+        mu_assert("nn_get_forward_batch_size disagrees", nn_get_forward_batch_size() == batch_sizes[b]);
+        memset(outputs->values, 0, (size_t)rows * 6 * sizeof(gann_real));
+        mu_assert("nn_forward_pass_batch failed", nn_forward_pass_batch(net, inputs, outputs));
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < 6; j++) {
+                mu_assert("Batched output disagrees with the single-row pass", fabs(outputs->data[i][j] - expected->data[i][j]) < TEST_EPSILON);
+            }
+        }
+    }
+
+    // nn_forward_pass takes any number of rows through the same path.
+    Matrix* block = create_matrix(rows, 37);
+    for (int i = 0; i < rows; i++) memcpy(block->data[i], storage->data[i] + 2, 37 * sizeof(gann_real));
+    Matrix* whole = nn_forward_pass(net, block);
+    mu_assert("nn_forward_pass failed on many rows", whole != NULL && whole->rows == rows && whole->cols == 6);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < 6; j++) {
+            mu_assert("nn_forward_pass disagrees with the single-row pass", fabs(whole->data[i][j] - expected->data[i][j]) < TEST_EPSILON);
+        }
+    }
+
+    mu_assert("A zero batch size should be rejected", !nn_set_forward_batch_size(0));
+    mu_assert("Wrong error code for a zero batch size", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("nn_set_forward_batch_size failed", nn_set_forward_batch_size(NN_DEFAULT_FORWARD_BATCH_SIZE));
+    mu_assert("A NULL output should be rejected", !nn_forward_pass_batch(net, inputs, NULL));
+    mu_assert("Wrong error code for a NULL output", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("A mismatched input should be rejected", !nn_forward_pass_batch(net, matrix_view(storage), outputs));
+    mu_assert("Wrong error code for a mismatched input", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    MatrixView short_inputs = matrix_view_block(storage, 0, 2, rows - 1, 37);
+    mu_assert("Too many output rows should be rejected", !nn_forward_pass_batch(net, short_inputs, outputs));
+    mu_assert("Wrong error code for mismatched output rows", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+
+    free_matrix(whole);
+    free_matrix(block);
+    nn_free_layer_buffers(layer_outputs, net->num_layers);
+    free_matrix(storage);
+    free_matrix(outputs);
+    free_matrix(expected);
+    nn_free(net);
+    return NULL;
+}
+
+// Once created, a context runs predictions without a single heap allocation
+// and computes what the allocating entry points compute, for dense inputs and
+// for mostly blank ones that take the sparse first layer.
+const char* test_inference_context() {
+    const int architecture[] = {50, 40, 70, 5};
+    srand(20);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Matrix* inputs = create_matrix(20, 50);
+    mu_assert("Failed to create inputs", inputs != NULL);
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 50; j++) inputs->data[i][j] = (i % 2 && j % 6) ? 0.0 : cos(0.3 * i + 0.17 * j);
+    }
+
+    for (int storage = NN_STORAGE_NATIVE; storage <= NN_STORAGE_BF16; storage++) {
+        mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(net, (NNWeightStorage)storage));
+        GannInferenceContext* ctx = gann_inference_context_create(net);
+        mu_assert("gann_inference_context_create failed", ctx != NULL);
+        for (int i = 0; i < 20; i++) {
+            Matrix* row = matrix_get_row(inputs, i);
+            Matrix* expected = nn_forward_pass(net, row);
+            const gann_real* output = nn_forward_ctx(ctx, inputs->data[i]);
+            mu_assert("nn_forward_ctx failed", output != NULL && gann_get_last_error() == GANN_SUCCESS);
+            for (int j = 0; j < 5; j++) {
+                mu_assert("nn_forward_ctx disagrees with nn_forward_pass", fabs(output[j] - expected->data[0][j]) < TEST_EPSILON);
+            }
+            mu_assert("gann_predict_ctx disagrees with gann_predict",
+                      gann_predict_ctx(ctx, inputs->data[i]) == gann_predict(net, inputs->data[i]));
+            free_matrix(expected);
+            free_matrix(row);
+        }
+
+        GannArenaStats stats;
+        gann_arena_get_stats(gann_scratch_arena(), &stats);
+        size_t chunk_allocations = stats.chunk_allocations;
+        size_t matrices = matrix_get_allocation_count();
+        for (int r = 0; r < 100; r++) {
+            mu_assert("gann_predict_ctx failed", gann_predict_ctx(ctx, inputs->data[r % 20]) >= 0);
+        }
+        gann_arena_get_stats(gann_scratch_arena(), &stats);
+        mu_assert("gann_predict_ctx allocated matrices", matrix_get_allocation_count() == matrices);
+        mu_assert("gann_predict_ctx grew the scratch arena", stats.chunk_allocations == chunk_allocations);
+        gann_inference_context_free(ctx);
+    }
+
+    // A context keeps the sigmoid mode it was created with
+    GannInferenceContext* ctx = gann_inference_context_create(net);
+    mu_assert("gann_inference_context_create failed", ctx != NULL);
+    gann_real exact[5];
+    memcpy(exact, nn_forward_ctx(ctx, inputs->data[0]), sizeof(exact));
+    mu_assert("Failed to select the fast sigmoid", gann_simd_set_sigmoid_mode(GANN_SIGMOID_FAST));
+    const gann_real* output = nn_forward_ctx(ctx, inputs->data[0]);
+    GannInferenceContext* fast_ctx = gann_inference_context_create(net);
+    mu_assert("gann_inference_context_create failed", fast_ctx != NULL);
+    const gann_real* fast = nn_forward_ctx(fast_ctx, inputs->data[0]);
+    gann_simd_set_sigmoid_mode(GANN_SIGMOID_EXACT);
+    mu_assert("A later sigmoid mode changed an existing context", memcmp(output, exact, sizeof(exact)) == 0);
+    mu_assert("A context created in fast mode should use the fast sigmoid", memcmp(fast, exact, sizeof(exact)) != 0);
+    gann_inference_context_free(fast_ctx);
+    gann_inference_context_free(ctx);
+
+    mu_assert("A NULL network should be rejected", gann_inference_context_create(NULL) == NULL);
+    mu_assert("Wrong error code for a NULL network", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("A NULL context should be rejected", nn_forward_ctx(NULL, inputs->data[0]) == NULL);
+    mu_assert("gann_predict_ctx should fail without a context", gann_predict_ctx(NULL, inputs->data[0]) == -1);
+    mu_assert("Wrong error code for a NULL context", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    gann_inference_context_free(NULL);
+
+    free_matrix(inputs);
+    nn_free(net);
+    return NULL;
+}
+
+// gann_predict_batch ranks each row's outputs, agrees with gann_predict for
+// k = 1 at every kernel level and batch boundary, and allocates nothing.
+const char* test_predict_batch() {
+    const int architecture[] = {20, 30, 37};
+    const int n = 70;
+    srand(25);
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SOFTMAX);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    gann_real* inputs = (gann_real*)malloc(n * 20 * sizeof(gann_real));
+    int* classes = (int*)malloc(n * 37 * sizeof(int));
+    int* top_classes = (int*)malloc(n * 5 * sizeof(int));
+    gann_real* scores = (gann_real*)malloc(n * 37 * sizeof(gann_real));
+    mu_assert("Failed to allocate test buffers", inputs && classes && top_classes && scores);
+    for (int i = 0; i < n * 20; i++) inputs[i] = sin(0.37 * i) * (i % 3 ? 1.0 : 4.0);
+    Matrix* input_matrix = matrix_wrap(inputs, n, 20);
+    Matrix* expected = nn_forward_pass(net, input_matrix);
+    mu_assert("Failed to compute the expected outputs", expected != NULL);
+
+    int saved_batch_size = nn_get_forward_batch_size();
+    GannSimdLevel saved = gann_simd_get_level();
+    nn_set_forward_batch_size(16);
+    for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+        gann_simd_set_level((GannSimdLevel)level);
+        // A full ranking, then the best 5 and the best 1 of it
+        mu_assert("gann_predict_batch failed", gann_predict_batch(net, inputs, n, 37, classes, scores));
+        mu_assert("gann_predict_batch did not report success", gann_get_last_error() == GANN_SUCCESS);
+        for (int i = 0; i < n; i++) {
+            int seen[37] = {0};
+            for (int j = 0; j < 37; j++) {
+                int c = classes[i * 37 + j];
+                mu_assert("A class is out of range", c >= 0 && c < 37 && !seen[c]);
+                seen[c] = 1;
+                mu_assert("A score is not its class's output", fabs(scores[i * 37 + j] - expected->data[i][c]) < TEST_EPSILON);
+                mu_assert("The scores are not in order", j == 0 || scores[i * 37 + j] <= scores[i * 37 + j - 1]);
+            }
+        }
+        mu_assert("gann_predict_batch failed without scores", gann_predict_batch(net, inputs, n, 5, top_classes, NULL));
+        for (int i = 0; i < n; i++) {
+            mu_assert("The top 5 differ from the full ranking", memcmp(top_classes + i * 5, classes + i * 37, 5 * sizeof(int)) == 0);
+        }
+        mu_assert("gann_predict_batch failed for k = 1", gann_predict_batch(net, inputs, n, 1, top_classes, NULL));
+        for (int i = 0; i < n; i++) {
+            mu_assert("The best class disagrees with gann_predict", top_classes[i] == gann_predict(net, inputs + i * 20));
+        }
+    }
+    gann_simd_set_level(saved);
+    nn_set_forward_batch_size(saved_batch_size);
+
+    GannArenaStats stats;
+    gann_arena_get_stats(gann_scratch_arena(), &stats);
+    size_t chunk_allocations = stats.chunk_allocations;
+    size_t matrices = matrix_get_allocation_count();
+    for (int r = 0; r < 20; r++) {
+        mu_assert("gann_predict_batch failed", gann_predict_batch(net, inputs, n, 5, top_classes, scores));
+    }
+    gann_arena_get_stats(gann_scratch_arena(), &stats);
+    mu_assert("gann_predict_batch allocated matrices", matrix_get_allocation_count() == matrices);
+    mu_assert("gann_predict_batch grew the scratch arena", stats.chunk_allocations == chunk_allocations);
+    mu_assert("gann_predict_batch left scratch memory allocated", stats.used == 0);
+
+    // Equal scores keep the lower class first
+    size_t count = 0;
+    gann_real* parameters = nn_get_parameters(net, &count);
+    memset(parameters, 0, count * sizeof(gann_real));
+    mu_assert("gann_predict_batch failed on equal scores", gann_predict_batch(net, inputs, 1, 5, top_classes, NULL));
+    for (int j = 0; j < 5; j++) mu_assert("Equal scores are out of class order", top_classes[j] == j);
+
+    mu_assert("A NULL network should be rejected", gann_predict_batch(NULL, inputs, n, 1, classes, NULL) == 0);
+    mu_assert("Wrong error code for a NULL network", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("k = 0 should be rejected", gann_predict_batch(net, inputs, n, 0, classes, NULL) == 0);
+    mu_assert("Wrong error code for k = 0", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("k above the class count should be rejected", gann_predict_batch(net, inputs, n, 38, classes, NULL) == 0);
+    mu_assert("n = 0 should be rejected", gann_predict_batch(net, inputs, 0, 1, classes, NULL) == 0);
+
+    free_matrix(expected);
+    free_matrix(input_matrix);
+    free(scores);
+    free(top_classes);
+    free(classes);
+    free(inputs);
+    nn_free(net);
+    return NULL;
+}
+
+// Reference softmax of one row, in double.
+static void reference_softmax(int n, const gann_real* x, double* out) {
+    double max = x[0], sum = 0.0;
+    for (int j = 1; j < n; j++) max = x[j] > max ? x[j] : max;
+    for (int j = 0; j < n; j++) sum += out[j] = exp(x[j] - max);
+    for (int j = 0; j < n; j++) out[j] /= sum;
+}
+
+// Returns 1 if every row of `outputs` is the softmax of the same row of `logits`.
+static int rows_are_softmax(const Matrix* outputs, const Matrix* logits) {
+    double expected[32];
+    for (int i = 0; i < outputs->rows; i++) {
+        reference_softmax(logits->cols, logits->data[i], expected);
+        for (int j = 0; j < outputs->cols; j++) {
+            if (!(fabs(outputs->data[i][j] - expected[j]) < TEST_EPSILON)) return 0;
+        }
+    }
+    return 1;
+}
+
+// Softmax normalizes each row without overflowing, at every kernel level and
+// through every forward path, and is refused for hidden layers.
+const char* test_softmax_activation() {
+    // Widths that leave a partial vector, and logits far beyond exp's range
+    Matrix* logits = create_matrix(3, 13);
+    mu_assert("Failed to create matrix", logits != NULL);
+    for (int j = 0; j < 13; j++) {
+        logits->data[0][j] = 0.25 * j - 1.0;
+        logits->data[1][j] = 1000.0 + j;
+        logits->data[2][j] = (j == 12) ? 5.0 : -1000.0;
+    }
+    GannSimdLevel saved = gann_simd_get_level();
+    for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+        gann_simd_set_level((GannSimdLevel)level);
+        Matrix* outputs = matrix_copy(logits);
+        nn_apply_activation(outputs, SOFTMAX);
+        mu_assert("nn_apply_activation failed", gann_get_last_error() == GANN_SUCCESS);
+        mu_assert("Softmax disagrees with the reference", rows_are_softmax(outputs, logits));
+        for (int i = 0; i < 3; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < 13; j++) sum += outputs->data[i][j];
+            mu_assert("A softmax row should sum to 1", fabs(sum - 1.0) < TEST_EPSILON);
+        }
+        free_matrix(outputs);
+    }
+    gann_simd_set_level(saved);
+    free_matrix(logits);
+
+    const int architecture[] = {20, 30, 11};
+    mu_assert("A softmax hidden layer should be rejected", nn_create(3, architecture, SOFTMAX, SOFTMAX) == NULL);
+    mu_assert("Wrong error code for a softmax hidden layer", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+
+    // The same network with a linear output layer gives the logits
+    srand(24);
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SOFTMAX);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Matrix* inputs = create_matrix(40, 20);
+    for (int i = 0; i < 40; i++) {
+        for (int j = 0; j < 20; j++) inputs->data[i][j] = (i % 2 && j % 8) ? 0.0 : 3.0 * sin(0.4 * i + 0.7 * j);
+    }
+    for (int storage = NN_STORAGE_NATIVE; storage <= NN_STORAGE_BF16; storage++) {
+        mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(net, (NNWeightStorage)storage));
+        net->activation_output = LINEAR;
+        Matrix* batch_logits = nn_forward_pass(net, inputs);
+        net->activation_output = SOFTMAX;
+        mu_assert("Failed to compute the logits", batch_logits != NULL);
+
+        // Blocked and row products
+        Matrix* batch = nn_forward_pass(net, inputs);
+        mu_assert("The batched pass is not a softmax", batch != NULL && rows_are_softmax(batch, batch_logits));
+        GannInferenceContext* ctx = gann_inference_context_create(net);
+        GannPlan* plan = nn_compile(net, NULL);
+        Matrix* planned = create_matrix(40, 11);
+        mu_assert("gann_plan_run failed", plan && gann_plan_run(plan, matrix_view(inputs), planned, NULL));
+        mu_assert("The plan is not a softmax", rows_are_softmax(planned, batch_logits));
+        for (int i = 0; i < 40; i++) {
+            Matrix* row = matrix_get_row(inputs, i);
+            Matrix* single = nn_forward_pass(net, row);
+            Matrix* single_logits = matrix_get_row(batch_logits, i);
+            mu_assert("The single-row pass is not a softmax", rows_are_softmax(single, single_logits));
+            const gann_real* output = nn_forward_ctx(ctx, inputs->data[i]);
+            for (int j = 0; j < 11; j++) {
+                mu_assert("The context pass is not a softmax", fabs(output[j] - single->data[0][j]) < TEST_EPSILON);
+            }
+            free_matrix(single_logits);
+            free_matrix(single);
+            free_matrix(row);
+        }
+        free_matrix(planned);
+        gann_plan_free(plan);
+        gann_inference_context_free(ctx);
+        free_matrix(batch);
+        free_matrix(batch_logits);
+    }
+
+    free_matrix(inputs);
+    nn_free(net);
+    return NULL;
+}
+
+#define SHARED_THREADS 4
+#define SHARED_ROUNDS 25
+
+typedef struct {
+    const NeuralNetwork* net;
+    const Matrix* inputs;
+    const Matrix* expected; // Single-threaded outputs, one row per input
+    int failures;
+} SharedInferenceJob;
+
+// Predicts every input SHARED_ROUNDS times through a context of its own.
+static void* shared_inference_worker(void* arg) {
+    SharedInferenceJob* job = (SharedInferenceJob*)arg;
+    GannInferenceContext* ctx = gann_inference_context_create(job->net);
+    if (!ctx) {
+        job->failures++;
+        return NULL;
+    }
+    int outputs = job->expected->cols;
+    for (int r = 0; r < SHARED_ROUNDS; r++) {
+        for (int i = 0; i < job->inputs->rows; i++) {
+            const gann_real* output = nn_forward_ctx(ctx, job->inputs->data[i]);
+            if (!output || memcmp(output, job->expected->data[i], outputs * sizeof(gann_real)) != 0) job->failures++;
+        }
+    }
+    gann_inference_context_free(ctx);
+    return NULL;
+}
+
+// Threads sharing one network through their own contexts compute exactly what
+// a single thread computes.
+const char* test_inference_context_threads() {
+    const int architecture[] = {60, 48, 32, 10};
+    srand(23);
+    NeuralNetwork* net = nn_create(4, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Matrix* inputs = create_matrix(64, 60);
+    Matrix* expected = create_matrix(64, 10);
+    mu_assert("Failed to create matrices", inputs != NULL && expected != NULL);
+    // Half the rows are mostly blank, so both first-layer kernels run
+    for (int i = 0; i < 64; i++) {
+        for (int j = 0; j < 60; j++) inputs->data[i][j] = (i % 2 && j % 7) ? 0.0 : sin(0.21 * i + 0.13 * j);
+    }
+
+    for (int storage = NN_STORAGE_NATIVE; storage <= NN_STORAGE_BF16; storage++) {
+        mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(net, (NNWeightStorage)storage));
+        GannInferenceContext* ctx = gann_inference_context_create(net);
+        mu_assert("gann_inference_context_create failed", ctx != NULL);
+        for (int i = 0; i < 64; i++) {
+            const gann_real* output = nn_forward_ctx(ctx, inputs->data[i]);
+            mu_assert("nn_forward_ctx failed", output != NULL);
+            memcpy(expected->data[i], output, 10 * sizeof(gann_real));
+        }
+        gann_inference_context_free(ctx);
+
+        pthread_t threads[SHARED_THREADS];
+        SharedInferenceJob jobs[SHARED_THREADS];
+        for (int t = 0; t < SHARED_THREADS; t++) {
+            jobs[t] = (SharedInferenceJob){ net, inputs, expected, 0 };
+            mu_assert("Failed to start a thread", pthread_create(&threads[t], NULL, shared_inference_worker, &jobs[t]) == 0);
+        }
+        int failures = 0;
+        for (int t = 0; t < SHARED_THREADS; t++) {
+            pthread_join(threads[t], NULL);
+            failures += jobs[t].failures;
+        }
+        mu_assert("Concurrent predictions disagree with single-threaded ones", failures == 0);
+    }
+
+    free_matrix(expected);
+    free_matrix(inputs);
+    nn_free(net);
+    return NULL;
+}
+
+// Weights and biases are views into one flat buffer that clones, crossover and
+// mutation treat as a genome.
+const char* test_nn_flat_parameters() {
+    const int architecture[] = {4, 3, 2};
+    srand(21);
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+
+    size_t count = 0;
+    gann_real* params = nn_get_parameters(net, &count);
+    mu_assert("nn_get_parameters failed", params != NULL && gann_get_last_error() == GANN_SUCCESS);
+    mu_assert("Wrong parameter count", count == 4 * 3 + 3 + 3 * 2 + 2);
+    for (size_t k = 0; k < count; k++) params[k] = (gann_real)k;
+    // Layer by layer: the weights row-major, then the biases
+    mu_assert("Layer 0 weights are not at the start", net->weights[0]->data[1][2] == 5 && net->weights[0]->data[3][0] == 9);
+    mu_assert("Layer 0 biases do not follow its weights", net->biases[0]->data[0][0] == 12);
+    mu_assert("Layer 1 weights do not follow layer 0", net->weights[1]->data[2][1] == 20);
+    mu_assert("Layer 1 biases are not at the end", net->biases[1]->data[0][1] == 22);
+
+    NeuralNetwork* copy = nn_clone(net);
+    mu_assert("nn_clone failed", copy != NULL);
+    size_t copy_count = 0;
+    gann_real* copy_params = nn_get_parameters(copy, &copy_count);
+    mu_assert("The clone shares its parent's parameters", copy_params != params);
+    mu_assert("The clone's parameters differ",
+              copy_count == count && memcmp(copy_params, params, count * sizeof(gann_real)) == 0);
+
+    mutate_network(copy, 0.1f, 1.0f, GAUSSIAN_MUTATION, 0.5, 0, 0, 0);
+    int unchanged = 0;
+    for (size_t k = 0; k < count; k++) unchanged += copy_params[k] == params[k];
+    mu_assert("Mutation missed genes", unchanged == 0);
+
+    for (int type = UNIFORM_CROSSOVER; type <= TWO_POINT_CROSSOVER; type++) {
+        NeuralNetwork* child = crossover(net, copy, (CrossoverType)type);
+        mu_assert("crossover failed", child != NULL);
+        gann_real* genes = nn_get_parameters(child, NULL);
+        for (size_t k = 0; k < count; k++) {
+            mu_assert("A child gene comes from neither parent", genes[k] == params[k] || genes[k] == copy_params[k]);
+        }
+        nn_free(child);
+    }
+
+    // 16-bit weights are not gann_real values, but they still recombine
+    mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(copy, NN_STORAGE_BF16));
+    mu_assert("A 16-bit network has no gann_real genome", nn_get_parameters(copy, &copy_count) == NULL);
+    mu_assert("Wrong error code for a 16-bit network", gann_get_last_error() == GANN_ERROR_INVALID_PARAM && copy_count == 0);
+    mu_assert("Parents of different storages should not recombine", crossover(net, copy, UNIFORM_CROSSOVER) == NULL);
+    NeuralNetwork* other = nn_clone(copy);
+    mutate_network(other, 0.1f, 1.0f, GAUSSIAN_MUTATION, 0.5, 0, 0, 0);
+    NeuralNetwork* child = crossover(copy, other, SINGLE_POINT_CROSSOVER);
+    mu_assert("16-bit crossover failed", child != NULL && child->weight_storage == NN_STORAGE_BF16);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 3; c++) {
+            gann_real w = nn_get_weight(child, 0, r, c);
+            mu_assert("A 16-bit child weight comes from neither parent",
+                      w == nn_get_weight(copy, 0, r, c) || w == nn_get_weight(other, 0, r, c));
+        }
+    }
+
+    mu_assert("nn_get_parameters should reject NULL", nn_get_parameters(NULL, NULL) == NULL);
+    mu_assert("Wrong error code for NULL", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+
+    nn_free(child);
+    nn_free(other);
+    nn_free(copy);
+    nn_free(net);
+    return NULL;
+}
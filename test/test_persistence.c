@@ -1,8 +1,10 @@
 #include "minunit.h"
 #include "neural_network.h"
 #include "gann_errors.h"
+#include "gann.h"
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -53,6 +55,123 @@ const char* test_save_and_load_network() {
     return NULL;
 }
 
+// Both file precisions round-trip, and a float32 file is half the payload of a float64 one
+const char* test_save_and_load_precisions() {
+    int architecture[] = {4, 5, 3};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    net->weights[1]->data[2][1] = 0.1;
+    net->biases[1]->data[0][2] = -1.0 / 3.0;
+
+    const NNFileFormat formats[] = { NN_FILE_FLOAT64, NN_FILE_FLOAT32 };
+    const char* paths[] = { "test_network_f64.dat", "test_network_f32.dat" };
+    long sizes[2];
+    for (int f = 0; f < 2; f++) {
+        mu_assert("nn_save_as failed", nn_save_as(net, paths[f], formats[f]) == 1);
+        FILE* file = fopen(paths[f], "rb");
+        mu_assert("Saved file is missing", file != NULL);
+        fseek(file, 0, SEEK_END);
+        sizes[f] = ftell(file);
+        fclose(file);
+
+        NeuralNetwork* loaded = nn_load(paths[f]);
+        mu_assert("nn_load failed", loaded != NULL);
+        mu_assert("Loaded network has wrong activations", loaded->activation_hidden == RELU && loaded->activation_output == SIGMOID);
+        // A float32 file rounds each parameter to the nearest float
+        double tolerance = formats[f] == NN_FILE_FLOAT32 ? 1e-7 : TEST_EPSILON;
+        for (int i = 0; i < net->num_layers - 1; i++) {
+            for (int r = 0; r < net->weights[i]->rows; r++) {
+                for (int c = 0; c < net->weights[i]->cols; c++) {
+                    mu_assert("Loaded weight differs", fabs(net->weights[i]->data[r][c] - loaded->weights[i]->data[r][c]) < tolerance);
+                }
+            }
+            for (int c = 0; c < net->biases[i]->cols; c++) {
+                mu_assert("Loaded bias differs", fabs(net->biases[i]->data[0][c] - loaded->biases[i]->data[0][c]) < tolerance);
+            }
+        }
+        nn_free(loaded);
+        remove(paths[f]);
+    }
+
+    // 4*5 + 5 + 5*3 + 3 = 43 parameters; the float32 file adds a 12-byte tag
+    mu_assert("float32 payload should be half the float64 payload", sizes[0] - sizes[1] == 43 * 4 - 12);
+
+    mu_assert("nn_save_as should reject an unknown format", nn_save_as(net, paths[0], (NNFileFormat)42) == 0);
+    mu_assert("nn_save_as should set GANN_ERROR_INVALID_PARAM", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+
+    nn_free(net);
+    return NULL;
+}
+
+// A 16-bit network is saved in its own format and reloads with the same bits;
+// a float64 network can also be written to a 16-bit file.
+const char* test_save_and_load_half() {
+    gann_seed_rng(5);
+    int architecture[] = {64, 32, 10};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    mu_assert("nn_save_as failed", nn_save_as(net, "test_network_f64.dat", NN_FILE_FLOAT64) == 1);
+
+    const NNWeightStorage storages[] = { NN_STORAGE_FP16, NN_STORAGE_BF16 };
+    const NNFileFormat formats[] = { NN_FILE_FLOAT16, NN_FILE_BFLOAT16 };
+    for (int f = 0; f < 2; f++) {
+        NeuralNetwork* half = nn_clone(net);
+        mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(half, storages[f]) == 1);
+        mu_assert("nn_save failed", nn_save(half, "test_network_16.dat") == 1);
+        NeuralNetwork* loaded = nn_load("test_network_16.dat");
+        mu_assert("nn_load failed", loaded != NULL);
+        mu_assert("Loaded network lost its storage", loaded->weight_storage == storages[f]);
+        for (int l = 0; l < 2; l++) {
+            size_t count = (size_t)architecture[l] * architecture[l + 1];
+            mu_assert("Reloaded weights differ", memcmp(half->weights_16[l], loaded->weights_16[l], count * sizeof(uint16_t)) == 0);
+            mu_assert("Reloaded biases differ",
+                      memcmp(half->biases[l]->values, loaded->biases[l]->values, architecture[l + 1] * sizeof(gann_real)) == 0);
+        }
+        // The round trip is exact, so the outputs are too
+        Matrix* input = create_matrix(1, 64);
+        for (int j = 0; j < 64; j++) input->data[0][j] = sin(0.37 * j);
+        Matrix* before = nn_forward_pass(half, input);
+        Matrix* after = nn_forward_pass(loaded, input);
+        mu_assert("nn_forward_pass failed", before != NULL && after != NULL);
+        mu_assert("Saving and loading changed the outputs", memcmp(before->values, after->values, 10 * sizeof(gann_real)) == 0);
+        free_matrix(before);
+        free_matrix(after);
+        free_matrix(input);
+        nn_free(loaded);
+
+        // Saving the native network in the same format rounds the same way.
+        mu_assert("nn_save_as failed", nn_save_as(net, "test_network_16b.dat", formats[f]) == 1);
+        loaded = nn_load("test_network_16b.dat");
+        mu_assert("nn_load failed", loaded != NULL && loaded->weight_storage == storages[f]);
+        for (int l = 0; l < 2; l++) {
+            size_t count = (size_t)architecture[l] * architecture[l + 1];
+            mu_assert("Narrowed file differs", memcmp(half->weights_16[l], loaded->weights_16[l], count * sizeof(uint16_t)) == 0);
+        }
+        nn_free(loaded);
+
+        // Only the weights are stored in 16 bits; the biases keep their precision.
+        FILE* file = fopen("test_network_16.dat", "rb");
+        fseek(file, 0, SEEK_END);
+        long half_size = ftell(file);
+        fclose(file);
+        file = fopen("test_network_f64.dat", "rb");
+        fseek(file, 0, SEEK_END);
+        long full_size = ftell(file);
+        fclose(file);
+        // 64*32 + 32*10 = 2368 weights and 32 + 10 = 42 biases; the 16-bit file adds a 20-byte tag
+        mu_assert("16-bit file has the wrong size", full_size - half_size == 2368 * 6 + 42 * (8 - (long)sizeof(gann_real)) - 20);
+
+        nn_free(half);
+        remove("test_network_16.dat");
+        remove("test_network_16b.dat");
+    }
+
+    nn_free(net);
+    remove("test_network_f64.dat");
+    return NULL;
+}
+
 // Test for persistence error handling
 const char* test_persistence_errors() {
     // --- Suppress stderr for this test ---
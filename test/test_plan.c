@@ -0,0 +1,180 @@
+#include "minunit.h"
+#include "gann_plan.h"
+#include "gann_simd.h"
+#include "gann_errors.h"
+#include "gann_arena.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern const double TEST_EPSILON;
+
+// Returns 1 if `plan` computes what nn_forward_pass computes for `net` on `inputs`.
+static int plan_matches(const GannPlan* plan, const NeuralNetwork* net, const Matrix* inputs, void* workspace) {
+    Matrix* expected = nn_forward_pass(net, inputs);
+    Matrix* outputs = create_matrix(inputs->rows, expected->cols);
+    int ok = gann_plan_run(plan, matrix_view(inputs), outputs, workspace) && gann_get_last_error() == GANN_SUCCESS;
+    for (int i = 0; ok && i < inputs->rows; i++) {
+        for (int j = 0; j < expected->cols; j++) {
+            if (fabs(outputs->data[i][j] - expected->data[i][j]) > TEST_EPSILON) ok = 0;
+        }
+    }
+    free_matrix(outputs);
+    free_matrix(expected);
+    return ok;
+}
+
+// Plans agree with nn_forward_pass for every batch size, input count, weight
+// storage and kernel level, and keep the kernels they were compiled for.
+const char* test_plan_matches_forward_pass() {
+    const int architecture[] = {50, 40, 70, 5};
+    const int tiny[] = {3, 2};
+    srand(22);
+    NeuralNetwork* nets[2] = { nn_create(4, architecture, RELU, SIGMOID), nn_create(2, tiny, LEAKY_RELU, LINEAR) };
+    mu_assert("Failed to create networks", nets[0] != NULL && nets[1] != NULL);
+    nn_init(nets[0]);
+    nn_init(nets[1]);
+    Matrix* inputs[2] = { create_matrix(150, 50), create_matrix(150, 3) };
+    for (int n = 0; n < 2; n++) {
+        for (int i = 0; i < 150; i++) {
+            for (int j = 0; j < inputs[n]->cols; j++) inputs[n]->data[i][j] = (i % 3 && j % 5) ? 0.0 : sin(0.7 * i + 0.3 * j);
+        }
+    }
+    const int batch_sizes[] = {1, 4, 64};
+    const int row_counts[] = {1, 7, 150};
+    const NNWeightStorage storages[] = {NN_STORAGE_NATIVE, NN_STORAGE_BF16};
+
+    GannSimdLevel saved = gann_simd_get_level();
+    for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+        gann_simd_set_level((GannSimdLevel)level);
+        for (int s = 0; s < 2; s++) {
+            for (int n = 0; n < 2; n++) {
+                mu_assert("nn_set_weight_storage failed", nn_set_weight_storage(nets[n], storages[s]));
+                for (int b = 0; b < 3; b++) {
+                    GannPlanOptions options = { .max_batch_size = batch_sizes[b] };
+                    GannPlan* plan = nn_compile(nets[n], &options);
+                    mu_assert("nn_compile failed", plan != NULL && gann_get_last_error() == GANN_SUCCESS);
+                    void* workspace = malloc(gann_plan_workspace_size(plan));
+                    for (int r = 0; r < 3; r++) {
+                        Matrix* rows = create_matrix(row_counts[r], inputs[n]->cols);
+                        matrix_copy_view_into(rows, matrix_view_rows(inputs[n], 0, row_counts[r]));
+                        mu_assert("The plan disagrees with nn_forward_pass", plan_matches(plan, nets[n], rows, workspace));
+                        mu_assert("The plan disagrees without a workspace", plan_matches(plan, nets[n], rows, NULL));
+                        free_matrix(rows);
+                    }
+                    free(workspace);
+                    gann_plan_free(plan);
+                }
+            }
+        }
+    }
+    gann_simd_set_level(saved);
+
+    // Only layers that fill a register tile are packed
+    GannPlan* single = nn_compile(nets[0], &(GannPlanOptions){ .max_batch_size = 1 });
+    GannPlan* batched = nn_compile(nets[0], NULL);
+    GannPlan* tiny_plan = nn_compile(nets[1], NULL);
+    mu_assert("nn_compile failed", single != NULL && batched != NULL && tiny_plan != NULL);
+    mu_assert("A single-row plan should use the row kernel", strcmp(gann_plan_layer_kernel(single, 0), "rows") == 0);
+    mu_assert("A batched plan should pack its weights", strcmp(gann_plan_layer_kernel(batched, 2), "packed") == 0);
+    mu_assert("A layer with 3 inputs should use the row kernel", strcmp(gann_plan_layer_kernel(tiny_plan, 0), "rows") == 0);
+    mu_assert("An invalid layer has no kernel", gann_plan_layer_kernel(batched, 3) == NULL);
+
+    // A plan owns its weights and keeps the kernels it was packed for
+    GannPlan* plan = nn_compile(nets[0], NULL);
+    NeuralNetwork* copy = nn_clone(nets[0]);
+    nn_free(nets[0]);
+    gann_simd_set_level(GANN_SIMD_SCALAR);
+    mu_assert("The plan depends on its network", plan_matches(plan, copy, inputs[0], NULL));
+    gann_simd_set_level(saved);
+
+    gann_plan_free(plan);
+    gann_plan_free(single);
+    gann_plan_free(batched);
+    gann_plan_free(tiny_plan);
+    nn_free(copy);
+    nn_free(nets[1]);
+    free_matrix(inputs[0]);
+    free_matrix(inputs[1]);
+    return NULL;
+}
+
+// Runs with a caller's workspace never allocate, and bad arguments are rejected.
+const char* test_plan_run() {
+    const int architecture[] = {40, 30, 10};
+    srand(23);
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    GannPlan* plan = nn_compile(net, &(GannPlanOptions){ .max_batch_size = 16 });
+    mu_assert("nn_compile failed", plan != NULL);
+    mu_assert("The plan needs a workspace", gann_plan_workspace_size(plan) > 0);
+    Matrix* inputs = create_matrix(40, 40);
+    Matrix* outputs = create_matrix(40, 10);
+    Matrix* output = create_matrix(1, 10);
+    for (int i = 0; i < 40; i++) {
+        for (int j = 0; j < 40; j++) inputs->data[i][j] = cos(0.11 * i * j);
+    }
+
+    void* workspace = malloc(gann_plan_workspace_size(plan) + 1);
+    // Any alignment will do
+    void* unaligned = (char*)workspace + 1;
+    GannArenaStats stats;
+    gann_arena_get_stats(gann_scratch_arena(), &stats);
+    size_t chunk_allocations = stats.chunk_allocations;
+    size_t matrices = matrix_get_allocation_count();
+    for (int r = 0; r < 50; r++) {
+        mu_assert("gann_plan_run failed", gann_plan_run(plan, matrix_view(inputs), outputs, unaligned));
+        mu_assert("gann_plan_run failed on one row", gann_plan_run(plan, matrix_view_row(inputs, r % 40), output, unaligned));
+    }
+    gann_arena_get_stats(gann_scratch_arena(), &stats);
+    mu_assert("gann_plan_run allocated matrices", matrix_get_allocation_count() == matrices);
+    mu_assert("gann_plan_run grew the scratch arena", stats.chunk_allocations == chunk_allocations);
+
+    // A plan keeps the sigmoid mode it was compiled with
+    Matrix* exact = create_matrix(40, 10);
+    Matrix* fast = create_matrix(40, 10);
+    mu_assert("gann_plan_run failed", gann_plan_run(plan, matrix_view(inputs), exact, workspace));
+    mu_assert("Failed to select the fast sigmoid", gann_simd_set_sigmoid_mode(GANN_SIGMOID_FAST));
+    int ran = gann_plan_run(plan, matrix_view(inputs), outputs, workspace);
+    GannPlan* fast_plan = nn_compile(net, &(GannPlanOptions){ .max_batch_size = 16 });
+    int fast_ran = fast_plan && gann_plan_run(fast_plan, matrix_view(inputs), fast, workspace);
+    gann_simd_set_sigmoid_mode(GANN_SIGMOID_EXACT);
+    mu_assert("gann_plan_run failed", ran && fast_ran);
+    int unchanged = 1, differs = 0;
+    for (int i = 0; i < 40; i++) {
+        unchanged &= memcmp(outputs->data[i], exact->data[i], 10 * sizeof(gann_real)) == 0;
+        differs |= memcmp(fast->data[i], exact->data[i], 10 * sizeof(gann_real)) != 0;
+    }
+    mu_assert("A later sigmoid mode changed a compiled plan", unchanged);
+    mu_assert("A plan compiled in fast mode should use the fast sigmoid", differs);
+    gann_plan_free(fast_plan);
+    free_matrix(fast);
+    free_matrix(exact);
+
+    mu_assert("A NULL plan should be rejected", gann_plan_run(NULL, matrix_view(inputs), outputs, workspace) == 0);
+    mu_assert("Wrong error code for a NULL plan", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("Too few outputs should be rejected",
+              gann_plan_run(plan, matrix_view_rows(inputs, 0, 39), outputs, workspace) == 0);
+    mu_assert("Wrong error code for mismatched outputs", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    Matrix* overlapping = matrix_wrap(inputs->values, 40, 10);
+    mu_assert("Overlapping outputs should be rejected", gann_plan_run(plan, matrix_view(inputs), overlapping, workspace) == 0);
+    mu_assert("Wrong error code for overlapping outputs", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    free_matrix(overlapping);
+    mu_assert("nn_compile should reject NULL", nn_compile(NULL, NULL) == NULL);
+    mu_assert("Wrong error code for NULL", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("nn_compile should reject a negative batch size",
+              nn_compile(net, &(GannPlanOptions){ .max_batch_size = -1 }) == NULL);
+    mu_assert("Wrong error code for a negative batch size", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+    mu_assert("A NULL plan needs no workspace", gann_plan_workspace_size(NULL) == 0);
+    gann_plan_free(NULL);
+
+    free(workspace);
+    free_matrix(output);
+    free_matrix(outputs);
+    free_matrix(inputs);
+    gann_plan_free(plan);
+    nn_free(net);
+    return NULL;
+}
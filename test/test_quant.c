@@ -0,0 +1,203 @@
+#include "minunit.h"
+#include "gann.h"
+#include "gann_quant.h"
+#include "gann_simd.h"
+#include "data_loader.h"
+#include "backpropagation.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+extern const double TEST_EPSILON;
+int mnist_available(const char* test_name);
+
+// A trained MNIST network keeps its accuracy when quantized to int8.
+const char* test_quantized_mnist_accuracy() {
+    if (!mnist_available(__func__)) return NULL;
+    Dataset* train = load_mnist_dataset("data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte");
+    Dataset* test = load_mnist_dataset("data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte");
+    mu_assert("Failed to load MNIST", train != NULL && test != NULL);
+
+    const int ARCHITECTURE[] = {MNIST_IMAGE_SIZE, 64, MNIST_NUM_CLASSES};
+    GannBackpropParams params = {
+        .architecture = ARCHITECTURE,
+        .num_layers = 3,
+        .learning_rate = 0.001,
+        .epochs = 1,
+        .batch_size = 32,
+        .activation_hidden = RELU,
+        .activation_output = SIGMOID,
+        .optimizer_type = ADAM,
+        .beta1 = 0.9,
+        .beta2 = 0.999,
+        .epsilon = 1e-8,
+        .logging = false
+    };
+    gann_seed_rng(2025);
+    NeuralNetwork* net = gann_train_with_backprop(&params, train, NULL);
+    mu_assert("Training failed", net != NULL);
+
+    QuantizedNetwork* qnet = qnn_quantize(net, train, 1000);
+    mu_assert("qnn_quantize failed", qnet != NULL);
+    double accuracy = gann_evaluate(net, test);
+    double quantized_accuracy = qnn_evaluate(qnet, test);
+    mu_assert("Network did not learn MNIST", accuracy > 0.85);
+    mu_assert("Quantization lost more than 0.5% accuracy", quantized_accuracy >= accuracy - 0.005);
+
+    // Individual predictions agree and the outputs stay close.
+    int agree = 0;
+    double max_error = 0.0;
+    gann_real output[MNIST_NUM_CLASSES];
+    for (int i = 0; i < 1000; i++) {
+        agree += gann_predict(net, test->images->data[i]) == qnn_predict(qnet, test->images->data[i]);
+        Matrix* row = matrix_get_row(test->images, i);
+        Matrix* expected = nn_forward_pass(net, row);
+        mu_assert("qnn_forward failed", qnn_forward(qnet, test->images->data[i], output));
+        for (int j = 0; j < MNIST_NUM_CLASSES; j++) max_error = fmax(max_error, fabs(output[j] - expected->data[0][j]));
+        free_matrix(expected);
+        free_matrix(row);
+    }
+    mu_assert("Quantized predictions disagree too often", agree >= 990);
+    mu_assert("Quantized outputs drift too far", max_error < 0.05);
+
+    qnn_free(qnet);
+    nn_free(net);
+    free_dataset(train);
+    free_dataset(test);
+    return NULL;
+}
+
+// Every integer kernel computes the same sums, so with activations that are
+// identical at every SIMD level the outputs match bit for bit. The odd layer
+// sizes exercise the input padding and the partial block of output neurons.
+const char* test_quantized_kernels_agree() {
+    gann_seed_rng(31);
+    const int architecture[] = {70, 13, 5};
+    NeuralNetwork* net = nn_create(3, architecture, LEAKY_RELU, LINEAR);
+    mu_assert("Failed to create network", net != NULL);
+    nn_init(net);
+    Dataset* data = create_dummy_dataset(20);
+    mu_assert("Failed to create dummy dataset", data != NULL);
+    Matrix* images = create_matrix(20, 70);
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 70; j++) images->data[i][j] = 2.0 * data->images->data[i][j] - 1.0; // signed inputs
+    }
+    free_matrix(data->images);
+    data->images = images;
+
+    QuantizedNetwork* qnet = qnn_quantize(net, data, 0);
+    mu_assert("qnn_quantize failed", qnet != NULL);
+    int num_layers = 0;
+    const int* qarch = qnn_get_architecture(qnet, &num_layers);
+    mu_assert("Wrong quantized architecture", num_layers == 3 && qarch[0] == 70 && qarch[1] == 13 && qarch[2] == 5);
+
+    gann_real reference[20][5];
+    GannSimdLevel saved = gann_simd_get_level();
+    for (int level = GANN_SIMD_SCALAR; level <= (int)gann_simd_get_best_level(); level++) {
+        gann_simd_set_level((GannSimdLevel)level);
+        for (int i = 0; i < 20; i++) {
+            gann_real output[5];
+            mu_assert("qnn_forward failed", qnn_forward(qnet, images->data[i], output));
+            if (level == GANN_SIMD_SCALAR) {
+                mu_assert("Scalar level should use the scalar kernel", strcmp(qnn_kernel_name(), "scalar") == 0);
+                memcpy(reference[i], output, sizeof(output));
+            } else {
+                mu_assert("Integer kernels disagree", memcmp(reference[i], output, sizeof(output)) == 0);
+            }
+        }
+    }
+    gann_simd_set_level(saved);
+
+    // Each output stays within a few quantization steps of the float network.
+    for (int i = 0; i < 20; i++) {
+        Matrix* row = matrix_get_row(images, i);
+        Matrix* expected = nn_forward_pass(net, row);
+        for (int j = 0; j < 5; j++) {
+            mu_assert("Quantized output too far from the float output", fabs(reference[i][j] - expected->data[0][j]) < 0.1);
+        }
+        free_matrix(expected);
+        free_matrix(row);
+    }
+
+    qnn_free(qnet);
+    nn_free(net);
+    free_dataset(data);
+    return NULL;
+}
+
+const char* test_quantized_persistence() {
+    gann_seed_rng(77);
+    const int architecture[] = {MNIST_IMAGE_SIZE, 24, MNIST_NUM_CLASSES};
+    NeuralNetwork* net = nn_create(3, architecture, RELU, SIGMOID);
+    nn_init(net);
+    Dataset* data = create_dummy_dataset(16);
+    QuantizedNetwork* qnet = qnn_quantize(net, data, 8);
+    mu_assert("qnn_quantize failed", qnet != NULL);
+
+    const char* path = "test_network.q8";
+    mu_assert("qnn_save failed", qnn_save(qnet, path));
+    QuantizedNetwork* loaded = qnn_load(path);
+    mu_assert("qnn_load failed", loaded != NULL);
+    for (int i = 0; i < 16; i++) {
+        gann_real a[MNIST_NUM_CLASSES], b[MNIST_NUM_CLASSES];
+        mu_assert("qnn_forward failed", qnn_forward(qnet, data->images->data[i], a) && qnn_forward(loaded, data->images->data[i], b));
+        mu_assert("Reloaded network computes different outputs", memcmp(a, b, sizeof(a)) == 0);
+    }
+
+    // A quantized file is about an eighth of the float64 file.
+    FILE* file = fopen(path, "rb");
+    fseek(file, 0, SEEK_END);
+    long quantized_size = ftell(file);
+    fclose(file);
+    mu_assert("nn_save_as failed", nn_save_as(net, "test_network_f64.dat", NN_FILE_FLOAT64));
+    file = fopen("test_network_f64.dat", "rb");
+    fseek(file, 0, SEEK_END);
+    long float_size = ftell(file);
+    fclose(file);
+    mu_assert("Quantized file is not much smaller", quantized_size * 6 < float_size);
+
+    // Neither loader accepts the other's format; a truncated file is rejected.
+    mu_assert("qnn_load accepted a float network", qnn_load("test_network_f64.dat") == NULL);
+    mu_assert("Wrong error code for a float network", gann_get_last_error() == GANN_ERROR_INVALID_FILE_FORMAT);
+    mu_assert("nn_load accepted a quantized network", nn_load(path) == NULL);
+
+    // Activations a network cannot have are rejected: a hidden softmax, then an unknown output
+    const ActivationType bad_activations[2] = { SOFTMAX, (ActivationType)99 };
+    for (int field = 0; field < 2; field++) {
+        mu_assert("qnn_save failed", qnn_save(qnet, path));
+        file = fopen(path, "r+b");
+        // The activations follow the magic, the version and the layer count
+        fseek(file, 12 + field * (long)sizeof(ActivationType), SEEK_SET);
+        fwrite(&bad_activations[field], sizeof(ActivationType), 1, file);
+        fclose(file);
+        mu_assert("qnn_load accepted an invalid activation", qnn_load(path) == NULL);
+        mu_assert("Wrong error code for an invalid activation", gann_get_last_error() == GANN_ERROR_INVALID_FILE_FORMAT);
+    }
+    mu_assert("qnn_save failed", qnn_save(qnet, path));
+    mu_assert("truncate failed", truncate(path, quantized_size - 1) == 0);
+    mu_assert("qnn_load accepted a truncated file", qnn_load(path) == NULL);
+    mu_assert("Wrong error code for a truncated file", gann_get_last_error() == GANN_ERROR_INVALID_FILE_FORMAT);
+    remove(path);
+    remove("test_network_f64.dat");
+
+    mu_assert("qnn_predict should fail for NULL", qnn_predict(NULL, data->images->data[0]) == -1);
+    mu_assert("Wrong error code for NULL", gann_get_last_error() == GANN_ERROR_NULL_ARGUMENT);
+    mu_assert("qnn_quantize should reject a negative sample count", qnn_quantize(net, data, -1) == NULL);
+    mu_assert("Wrong error code for a negative sample count", gann_get_last_error() == GANN_ERROR_INVALID_PARAM);
+
+    // A dataset that claims more items than its matrices hold is rejected, not read past its end
+    data->num_items = 17;
+    mu_assert("qnn_evaluate accepted too few rows", qnn_evaluate(qnet, data) == 0.0);
+    mu_assert("Wrong error code for too few rows", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    mu_assert("qnn_quantize accepted too few rows", qnn_quantize(net, data, 0) == NULL);
+    mu_assert("Wrong error code for too few calibration rows", gann_get_last_error() == GANN_ERROR_INVALID_DIMENSIONS);
+    data->num_items = 16;
+
+    qnn_free(qnet);
+    qnn_free(loaded);
+    qnn_free(NULL);
+    nn_free(net);
+    free_dataset(data);
+    return NULL;
+}
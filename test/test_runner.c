@@ -1,37 +1,120 @@
 #include "minunit.h"
 #include "test_suites.h"
+#include <stdio.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 int tests_run = 0;
+// Exact comparisons allow for the rounding of the element type the library was built with.
+#ifdef GANN_FLOAT32
+const double TEST_EPSILON = 1e-5;
+#else
 const double TEST_EPSILON = 1e-9;
+#endif
+
+// The MNIST files are not part of the repository. Tests that train on them
+// pass without running when they are missing, so the rest of the suite still runs.
+int mnist_available(const char* test_name) {
+    const char* files[] = { "data/train-images.idx3-ubyte", "data/train-labels.idx1-ubyte",
+                            "data/t10k-images.idx3-ubyte", "data/t10k-labels.idx1-ubyte" };
+    for (int i = 0; i < 4; i++) {
+        if (access(files[i], R_OK) != 0) {
+            printf("    Skipping %s: %s not found\n", test_name, files[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Stores the bytes the C library's heap has handed out in `bytes`. Returns 0
+// where the C library cannot report it (it needs glibc 2.33), so that tests
+// can skip heap checks there.
+int heap_bytes_in_use(size_t* bytes) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    // Large blocks are mapped separately from the heap proper, so count both.
+    struct mallinfo2 info = mallinfo2();
+    *bytes = info.uordblks + info.hblkhd;
+    return 1;
+#else
+    (void)bytes;
+    return 0;
+#endif
+}
 
 const char* all_suites() {
     // Run tests from test_matrix.c
     mu_run_test(test_matrix_creation);
+    mu_run_test(test_matrix_contiguous_storage);
     mu_run_test(test_matrix_dot_product);
+    mu_run_test(test_matrix_dot_product_blocked);
+    mu_run_test(test_matrix_dot_product_transposed);
+    mu_run_test(test_matrix_into_operations);
+    mu_run_test(test_matrix_views);
+    mu_run_test(test_simd_dispatch_consistency);
+    mu_run_test(test_gemm_thread_determinism);
+    mu_run_test(test_gemm_backend_selection);
+    mu_run_test(test_matrix_batch_products);
+    mu_run_test(test_sparse_matrix);
     mu_run_test(test_matrix_errors);
 
+    // Run tests from test_arena.c
+    mu_run_test(test_arena_alloc_and_reset);
+    mu_run_test(test_arena_growth);
+    mu_run_test(test_scratch_arena_steady_state);
+
     // Run tests from test_neural_network.c
     mu_run_test(test_nn_creation);
     mu_run_test(test_nn_forward_pass);
     mu_run_test(test_gaussian_mutation);
     mu_run_test(test_nn_errors);
     mu_run_test(test_nn_linear_activation);
+    mu_run_test(test_nn_layer_forward_fused);
+    mu_run_test(test_activation_kernels);
+    mu_run_test(test_nn_sparse_first_layer);
+    mu_run_test(test_nn_pruned_layer);
+    mu_run_test(test_nn_weight_storage);
+    mu_run_test(test_half_kernels_agree);
+    mu_run_test(test_nn_forward_pass_batch);
+    mu_run_test(test_inference_context);
+    mu_run_test(test_inference_context_threads);
+    mu_run_test(test_softmax_activation);
+    mu_run_test(test_predict_batch);
+    mu_run_test(test_nn_flat_parameters);
 
     // Run tests from test_persistence.c
     mu_run_test(test_save_and_load_network);
+    mu_run_test(test_save_and_load_precisions);
+    mu_run_test(test_save_and_load_half);
     mu_run_test(test_persistence_errors);
 
     // Run tests from test_evolution.c
     mu_run_test(test_crossover);
     mu_run_test(test_single_point_crossover);
     mu_run_test(test_two_point_crossover);
+    mu_run_test(test_half_population);
 
     // Run tests from test_backpropagation.c
     mu_run_test(test_calculate_mse);
     mu_run_test(test_backprop_overfit_single_instance);
     mu_run_test(test_backprop_overfit_single_instance_adam);
     mu_run_test(test_backprop_overfit_single_instance_rmsprop);
+    mu_run_test(test_into_api_zero_allocations);
     mu_run_test(test_backprop_early_stopping);
+    mu_run_test(test_fast_sigmoid_mnist_accuracy);
+    mu_run_test(test_backprop_skips_zero_pixels);
+    mu_run_test(test_dataset_checked_at_boundary);
+    mu_run_test(test_softmax_cross_entropy);
+
+    // Run tests from test_quant.c
+    mu_run_test(test_quantized_mnist_accuracy);
+    mu_run_test(test_quantized_kernels_agree);
+    mu_run_test(test_quantized_persistence);
+
+    // Run tests from test_plan.c
+    mu_run_test(test_plan_matches_forward_pass);
+    mu_run_test(test_plan_run);
 
     // Run tests from test_optimizers.c
     mu_run_test(optimizers_test_suite);
@@ -3,31 +3,75 @@
 
 // test_matrix.c
 const char* test_matrix_creation();
+const char* test_matrix_contiguous_storage();
 const char* test_matrix_dot_product();
+const char* test_matrix_dot_product_blocked();
+const char* test_matrix_dot_product_transposed();
+const char* test_matrix_into_operations();
+const char* test_matrix_views();
+const char* test_simd_dispatch_consistency();
+const char* test_gemm_thread_determinism();
+const char* test_gemm_backend_selection();
+const char* test_matrix_batch_products();
+const char* test_sparse_matrix();
 const char* test_matrix_errors();
 
+// test_arena.c
+const char* test_arena_alloc_and_reset();
+const char* test_arena_growth();
+const char* test_scratch_arena_steady_state();
+
 // test_neural_network.c
 const char* test_nn_creation();
 const char* test_nn_forward_pass();
 const char* test_gaussian_mutation();
 const char* test_nn_errors();
 const char* test_nn_linear_activation();
+const char* test_nn_layer_forward_fused();
+const char* test_activation_kernels();
+const char* test_nn_sparse_first_layer();
+const char* test_nn_pruned_layer();
+const char* test_nn_weight_storage();
+const char* test_half_kernels_agree();
+const char* test_nn_forward_pass_batch();
+const char* test_inference_context();
+const char* test_inference_context_threads();
+const char* test_softmax_activation();
+const char* test_predict_batch();
+const char* test_nn_flat_parameters();
 
 // test_persistence.c
 const char* test_save_and_load_network();
+const char* test_save_and_load_precisions();
+const char* test_save_and_load_half();
 const char* test_persistence_errors();
 
 // test_evolution.c
 const char* test_crossover();
 const char* test_single_point_crossover();
 const char* test_two_point_crossover();
+const char* test_half_population();
 
 // test_backpropagation.c
 const char* test_calculate_mse();
 const char* test_backprop_overfit_single_instance();
 const char* test_backprop_overfit_single_instance_adam();
 const char* test_backprop_overfit_single_instance_rmsprop();
+const char* test_into_api_zero_allocations();
 const char* test_backprop_early_stopping();
+const char* test_fast_sigmoid_mnist_accuracy();
+const char* test_backprop_skips_zero_pixels();
+const char* test_dataset_checked_at_boundary();
+const char* test_softmax_cross_entropy();
+
+// test_quant.c
+const char* test_quantized_mnist_accuracy();
+const char* test_quantized_kernels_agree();
+const char* test_quantized_persistence();
+
+// test_plan.c
+const char* test_plan_matches_forward_pass();
+const char* test_plan_run();
 
 // test_optimizers.c
 const char* test_sgd_update();